@@ -14,6 +14,7 @@ See the Mulan PSL v2 for more details. */
 #include <benchmark/benchmark.h>
 #include <inttypes.h>
 
+#include "common/lang/list.h"
 #include "common/lang/stdexcept.h"
 #include "common/log/log.h"
 #include "common/math/integer_generator.h"
@@ -36,6 +37,10 @@ struct Stat
   int64_t not_exist_count      = 0;
   int64_t delete_other_count   = 0;
 
+  int64_t lookup_success_count   = 0;
+  int64_t lookup_not_found_count = 0;
+  int64_t lookup_other_count     = 0;
+
   int64_t scan_success_count     = 0;
   int64_t scan_open_failed_count = 0;
   int64_t mismatch_count         = 0;
@@ -150,6 +155,21 @@ public:
     }
   }
 
+  void Lookup(uint32_t value, Stat &stat)
+  {
+    const char *key = reinterpret_cast<const char *>(&value);
+
+    list<RID> rids;
+    RC        rc = handler_.get_entry(key, sizeof(value), rids);
+    if (rc != RC::SUCCESS) {
+      stat.lookup_other_count++;
+    } else if (rids.empty()) {
+      stat.lookup_not_found_count++;
+    } else {
+      stat.lookup_success_count++;
+    }
+  }
+
   void Scan(uint32_t begin, uint32_t end, Stat &stat)
   {
     const char *begin_key = reinterpret_cast<const char *>(&begin);
@@ -208,7 +228,7 @@ BENCHMARK_DEFINE_F(InsertionBenchmark, Insertion)(State &state)
   state.counters["other"]     = Counter(stat.insert_other_count, Counter::kIsRate);
 }
 
-BENCHMARK_REGISTER_F(InsertionBenchmark, Insertion)->Threads(10);
+BENCHMARK_REGISTER_F(InsertionBenchmark, Insertion)->ThreadRange(1, 32)->UseRealTime();
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -247,7 +267,7 @@ BENCHMARK_DEFINE_F(DeletionBenchmark, Deletion)(State &state)
   state.counters["other"]     = Counter(stat.delete_other_count, Counter::kIsRate);
 }
 
-BENCHMARK_REGISTER_F(DeletionBenchmark, Deletion)->Threads(10)->Arg(4 * 10000);
+BENCHMARK_REGISTER_F(DeletionBenchmark, Deletion)->Arg(4 * 10000)->ThreadRange(1, 32)->UseRealTime();
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -290,7 +310,7 @@ BENCHMARK_DEFINE_F(ScanBenchmark, Scan)(State &state)
   state.counters["other"]                 = Counter(stat.scan_other_count, Counter::kIsRate);
 }
 
-BENCHMARK_REGISTER_F(ScanBenchmark, Scan)->Threads(10)->Arg(4 * 10000);
+BENCHMARK_REGISTER_F(ScanBenchmark, Scan)->Arg(4 * 10000)->ThreadRange(1, 32)->UseRealTime();
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -344,7 +364,72 @@ BENCHMARK_DEFINE_F(MixtureBenchmark, Mixture)(State &state)
       {"scan_open_failed", Counter(stat.scan_open_failed_count, Counter::kIsRate)}});
 }
 
-BENCHMARK_REGISTER_F(MixtureBenchmark, Mixture)->Threads(10)->Arg(4 * 10000);
+BENCHMARK_REGISTER_F(MixtureBenchmark, Mixture)->Arg(4 * 10000)->ThreadRange(1, 32)->UseRealTime();
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief 点查询和插入混合的场景
+ * @details 第一个参数是预先插入的数据量，第二个参数是点查询所占的百分比。
+ * 查询和插入的数据都分布在整个数据范围内，插入的大多是新数据。
+ */
+class ReadInsertBenchmark : public BenchmarkBase
+{
+public:
+  string Name() const override { return "read_insert"; }
+
+  void SetUp(const State &state) override
+  {
+    if (0 != state.thread_index()) {
+      return;
+    }
+
+    BenchmarkBase::SetUp(state);
+
+    // 预先插入偶数，插入操作插入奇数
+    uint32_t max = static_cast<uint32_t>(state.range(0));
+    for (uint32_t value = 0; value < max; value++) {
+      uint32_t    even_value = value * 2;
+      const char *key        = reinterpret_cast<const char *>(&even_value);
+      RID         rid(even_value, even_value);
+
+      [[maybe_unused]] RC rc = handler_.insert_entry(key, &rid);
+      ASSERT(rc == RC::SUCCESS, "failed to insert entry into btree. key=%" PRIu32, even_value);
+    }
+  }
+};
+
+BENCHMARK_DEFINE_F(ReadInsertBenchmark, ReadInsert)(State &state)
+{
+  const uint32_t max          = static_cast<uint32_t>(state.range(0));
+  const int64_t  read_percent = state.range(1);
+
+  IntegerGenerator data_generator(0, max - 1);
+  IntegerGenerator operation_generator(0, 99);
+  Stat             stat;
+
+  for (auto _ : state) {
+    uint32_t value = static_cast<uint32_t>(data_generator.next());
+    if (operation_generator.next() < read_percent) {
+      Lookup(value * 2, stat);
+    } else {
+      Insert(value * 2 + 1, stat);
+    }
+  }
+
+  state.counters.insert({{"lookup_success", Counter(stat.lookup_success_count, Counter::kIsRate)},
+      {"lookup_not_found", Counter(stat.lookup_not_found_count, Counter::kIsRate)},
+      {"lookup_other", Counter(stat.lookup_other_count, Counter::kIsRate)},
+      {"insert_success", Counter(stat.insert_success_count, Counter::kIsRate)},
+      {"insert_duplicate", Counter(stat.duplicate_count, Counter::kIsRate)},
+      {"insert_other", Counter(stat.insert_other_count, Counter::kIsRate)}});
+}
+
+BENCHMARK_REGISTER_F(ReadInsertBenchmark, ReadInsert)
+    ->Args({4 * 10000, 95})
+    ->Args({4 * 10000, 50})
+    ->ThreadRange(1, 32)
+    ->UseRealTime();
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -0,0 +1,187 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <benchmark/benchmark.h>
+
+#include "common/lang/list.h"
+#include "common/lang/stdexcept.h"
+#include "common/log/log.h"
+#include "common/math/integer_generator.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "storage/buffer/double_write_buffer.h"
+#include "storage/clog/vacuous_log_handler.h"
+#include "storage/index/bplus_tree.h"
+
+using namespace std;
+using namespace common;
+using namespace benchmark;
+
+/**
+ * @brief 字符串索引的树高和点查性能
+ * @details 键值是有很长公共前缀的字符串，类似URL或者路径。内部节点做了前缀压缩和后缀截断，
+ * 一个内部页面能放更多的子节点，树更矮。数据按照乱序插入，与平时建表后插入数据的情况一样。
+ * 行数通过参数指定，构建好的树在多次运行之间复用。
+ * 除了吞吐量，还会输出树高(height)、内部页面个数(internal_pages)和内部页面的平均子节点个数(fanout)。
+ */
+class StringIndexBenchmark : public Fixture
+{
+public:
+  static constexpr int ATTR_LENGTH = 64;
+
+  ~StringIndexBenchmark() override { TearDownTree(); }
+
+  string Name() const { return "bplus_tree_string_index"; }
+
+  static void make_key(int64_t i, char *key)
+  {
+    memset(key, 0, ATTR_LENGTH);
+    snprintf(key, ATTR_LENGTH, "https://www.example.com/catalog/item/%04ld/%012ld", i % 1000, i);
+  }
+
+  void SetUp(const State &state) override
+  {
+    if (0 != state.thread_index()) {
+      return;
+    }
+
+    const int64_t row_num = state.range(0);
+    if (row_num == row_num_) {
+      return;
+    }
+
+    TearDownTree();
+
+    string log_name       = this->Name() + ".log";
+    string btree_filename = this->Name() + ".btree";
+    LoggerFactory::init_default(log_name.c_str(), LOG_LEVEL_INFO);
+    ::remove(btree_filename.c_str());
+
+    bpm_ = make_unique<BufferPoolManager>();
+    bpm_->init(make_unique<VacuousDoubleWriteBuffer>());
+    RC rc = handler_.create(log_handler_, *bpm_, btree_filename.c_str(), AttrType::CHARS, ATTR_LENGTH);
+    if (OB_FAIL(rc)) {
+      throw runtime_error("failed to create btree handler");
+    }
+
+    // 步长与行数互质，每一行恰好插入一次，并且是乱序的
+    int64_t step = 7919;
+    while (row_num % step == 0) {
+      step += 2;
+    }
+
+    char key[ATTR_LENGTH];
+    for (int64_t i = 0; i < row_num; i++) {
+      const int64_t value = i * step % row_num;
+      const RID     rid(static_cast<PageNum>(value / 1000 + 1), static_cast<SlotNum>(value % 1000));
+      make_key(value, key);
+      rc = handler_.insert_entry(key, &rid);
+      if (OB_FAIL(rc)) {
+        throw runtime_error("failed to insert entry");
+      }
+    }
+
+    row_num_ = row_num;
+    collect_tree_stat();
+    LOG_INFO("test %s setup done. rows=%ld, height=%d, internal pages=%ld, fanout=%.1f",
+             Name().c_str(), row_num_, height_, internal_page_num_, fanout_);
+  }
+
+  void TearDownTree()
+  {
+    if (row_num_ < 0) {
+      return;
+    }
+
+    handler_.close();
+    bpm_.reset();
+    row_num_ = -1;
+  }
+
+  void set_counters(State &state)
+  {
+    state.counters["height"]         = height_;
+    state.counters["internal_pages"] = static_cast<double>(internal_page_num_);
+    state.counters["fanout"]         = fanout_;
+  }
+
+protected:
+  /// 逐层遍历内部节点，统计树高和内部节点的个数
+  void collect_tree_stat()
+  {
+    BplusTreeMiniTransaction mtr(handler_);
+    DiskBufferPool          &buffer_pool = handler_.buffer_pool();
+
+    vector<PageNum> level{handler_.file_header().root_page};
+    int64_t         child_num = 0;
+    height_                   = 0;
+    internal_page_num_        = 0;
+    while (!level.empty()) {
+      height_++;
+      vector<PageNum> next_level;
+      for (PageNum page_num : level) {
+        Frame *frame = nullptr;
+        if (OB_FAIL(buffer_pool.get_this_page(page_num, &frame))) {
+          throw runtime_error("failed to get page");
+        }
+
+        IndexNodeHandler node(mtr, handler_.file_header(), frame);
+        if (!node.is_leaf()) {
+          InternalIndexNodeHandler internal_node(mtr, handler_.file_header(), frame);
+          for (int i = 0; i < internal_node.size(); i++) {
+            next_level.push_back(internal_node.value_at(i));
+          }
+          internal_page_num_++;
+          child_num += internal_node.size();
+        }
+        buffer_pool.unpin_page(frame);
+      }
+      level.swap(next_level);
+    }
+    fanout_ = internal_page_num_ == 0 ? 0 : static_cast<double>(child_num) / internal_page_num_;
+  }
+
+protected:
+  VacuousLogHandler             log_handler_;
+  unique_ptr<BufferPoolManager> bpm_;
+  BplusTreeHandler              handler_;
+
+  int64_t row_num_           = -1;
+  int     height_            = 0;
+  int64_t internal_page_num_ = 0;
+  double  fanout_            = 0;
+};
+
+BENCHMARK_DEFINE_F(StringIndexBenchmark, PointLookup)(State &state)
+{
+  IntegerGenerator generator(0, static_cast<int>(state.range(0) - 1));
+  char             key[ATTR_LENGTH];
+  int64_t          not_found_count = 0;
+  list<RID>        rids;
+  for (auto _ : state) {
+    make_key(generator.next(), key);
+    rids.clear();
+    RC rc = handler_.get_entry(key, strlen(key), rids);
+    if (OB_FAIL(rc) || rids.size() != 1) {
+      not_found_count++;
+    }
+  }
+
+  set_counters(state);
+  state.counters["not_found"] = Counter(not_found_count, Counter::kIsRate);
+}
+
+// 2000万行的数据需要比较长的时间来构建，可以通过 --benchmark_filter 只运行小数据量的测试
+BENCHMARK_REGISTER_F(StringIndexBenchmark, PointLookup)
+    ->Arg(1000 * 1000)
+    ->Arg(20 * 1000 * 1000)
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,171 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <benchmark/benchmark.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "common/io/io.h"
+#include "common/lang/mutex.h"
+#include "common/lang/stdexcept.h"
+#include "common/log/log.h"
+#include "common/math/integer_generator.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "storage/buffer/double_write_buffer.h"
+#include "storage/clog/vacuous_log_handler.h"
+
+using namespace std;
+using namespace common;
+using namespace benchmark;
+
+/**
+ * @brief 多线程随机读取同一个数据文件的页面
+ * @details 数据文件的页面数是 buffer pool 页帧数的 PAGE_NUM_RATIO 倍，大部分读取都需要从磁盘加载页面。
+ * SeekRead 模拟原来 lseek + readn 的方式，必须在文件级别加锁；PositionalRead 使用 pread，不需要加锁；
+ * BufferPoolRead 通过 buffer pool 读取页面。
+ */
+static constexpr int POOL_FRAME_NUM = DEFAULT_ITEM_NUM_PER_POOL;
+static constexpr int PAGE_NUM_RATIO = 8;
+
+class RandomReadBenchmark : public Fixture
+{
+public:
+  string Name() const { return "buffer_pool_random_read"; }
+
+  string filename() const { return this->Name() + ".bp"; }
+
+  void SetUp(const State &state) override
+  {
+    if (0 != state.thread_index()) {
+      return;
+    }
+
+    string log_name = this->Name() + ".log";
+    LoggerFactory::init_default(log_name.c_str(), LOG_LEVEL_INFO);
+
+    bpm_ = make_unique<BufferPoolManager>(POOL_FRAME_NUM * BP_PAGE_SIZE);
+    bpm_->init(make_unique<VacuousDoubleWriteBuffer>());
+
+    string filename = this->filename();
+    ::remove(filename.c_str());
+
+    RC rc = bpm_->create_file(filename.c_str());
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to create buffer pool file. filename=%s, rc=%s", filename.c_str(), strrc(rc));
+      throw runtime_error("failed to create buffer pool file.");
+    }
+
+    rc = bpm_->open_file(log_handler_, filename.c_str(), buffer_pool_);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to open buffer pool file. filename=%s, rc=%s", filename.c_str(), strrc(rc));
+      throw runtime_error("failed to open buffer pool file.");
+    }
+
+    page_num_ = POOL_FRAME_NUM * PAGE_NUM_RATIO;
+    for (int i = 1; i < page_num_; i++) {
+      Frame *frame = nullptr;
+      rc           = buffer_pool_->allocate_page(&frame);
+      if (OB_FAIL(rc)) {
+        LOG_WARN("failed to allocate page. rc=%s", strrc(rc));
+        throw runtime_error("failed to allocate page.");
+      }
+      frame->mark_dirty();
+      buffer_pool_->unpin_page(frame);
+    }
+    buffer_pool_->flush_all_pages();
+
+    fd_ = ::open(filename.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+      throw runtime_error("failed to open data file.");
+    }
+    LOG_INFO("test %s setup done. threads=%d, page num=%d", this->Name().c_str(), state.threads(), page_num_);
+  }
+
+  void TearDown(const State &state) override
+  {
+    if (0 != state.thread_index()) {
+      return;
+    }
+
+    ::close(fd_);
+    fd_ = -1;
+    buffer_pool_->close_file();
+    buffer_pool_ = nullptr;
+    bpm_.reset();
+    LOG_INFO("test %s teardown done. threads=%d", this->Name().c_str(), state.threads());
+  }
+
+protected:
+  unique_ptr<BufferPoolManager> bpm_;
+  VacuousLogHandler             log_handler_;
+  DiskBufferPool               *buffer_pool_ = nullptr;
+  int                           fd_          = -1;
+  int                           page_num_    = 0;
+  mutex                         seek_lock_;
+};
+
+BENCHMARK_DEFINE_F(RandomReadBenchmark, SeekRead)(State &state)
+{
+  IntegerGenerator generator(1, page_num_ - 1);
+  Page             page;
+  int64_t          failed_count = 0;
+  for (auto _ : state) {
+    int64_t offset = static_cast<int64_t>(generator.next()) * BP_PAGE_SIZE;
+
+    lock_guard<mutex> guard(seek_lock_);
+    if (lseek(fd_, offset, SEEK_SET) == -1 || readn(fd_, &page, BP_PAGE_SIZE) != 0) {
+      failed_count++;
+    }
+  }
+
+  state.counters["failed"] = Counter(failed_count, Counter::kIsRate);
+}
+
+BENCHMARK_REGISTER_F(RandomReadBenchmark, SeekRead)->ThreadRange(1, 16)->UseRealTime();
+
+BENCHMARK_DEFINE_F(RandomReadBenchmark, PositionalRead)(State &state)
+{
+  IntegerGenerator generator(1, page_num_ - 1);
+  Page             page;
+  int64_t          failed_count = 0;
+  for (auto _ : state) {
+    int64_t offset = static_cast<int64_t>(generator.next()) * BP_PAGE_SIZE;
+    if (preadn(fd_, &page, BP_PAGE_SIZE, offset) != 0) {
+      failed_count++;
+    }
+  }
+
+  state.counters["failed"] = Counter(failed_count, Counter::kIsRate);
+}
+
+BENCHMARK_REGISTER_F(RandomReadBenchmark, PositionalRead)->ThreadRange(1, 16)->UseRealTime();
+
+BENCHMARK_DEFINE_F(RandomReadBenchmark, BufferPoolRead)(State &state)
+{
+  IntegerGenerator generator(1, page_num_ - 1);
+  int64_t          failed_count = 0;
+  for (auto _ : state) {
+    Frame *frame = nullptr;
+    RC     rc    = buffer_pool_->get_this_page(generator.next(), &frame);
+    if (OB_FAIL(rc)) {
+      failed_count++;
+      continue;
+    }
+    buffer_pool_->unpin_page(frame);
+  }
+
+  state.counters["failed"] = Counter(failed_count, Counter::kIsRate);
+}
+
+BENCHMARK_REGISTER_F(RandomReadBenchmark, BufferPoolRead)->ThreadRange(1, 16)->UseRealTime();
+
+////////////////////////////////////////////////////////////////////////////////
+
+BENCHMARK_MAIN();
@@ -0,0 +1,118 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <benchmark/benchmark.h>
+
+#include "common/lang/algorithm.h"
+#include "common/lang/chrono.h"
+#include "common/lang/filesystem.h"
+#include "common/lang/stdexcept.h"
+#include "common/log/log.h"
+#include "storage/clog/disk_log_handler.h"
+#include "storage/clog/log_replayer.h"
+
+using namespace std;
+using namespace common;
+using namespace benchmark;
+
+class NoopLogReplayer : public LogReplayer
+{
+public:
+  RC replay(const LogEntry &) override { return RC::SUCCESS; }
+};
+
+/**
+ * @brief 模拟 sysbench 的提交过程：每个会话写一条提交日志，然后等待日志落盘
+ * @details 统计每秒提交次数(commits)和提交延迟的 p99
+ */
+class GroupCommitBenchmark : public Fixture
+{
+public:
+  void SetUp(const State &state) override
+  {
+    if (0 != state.thread_index()) {
+      return;
+    }
+
+    LoggerFactory::init_default("group_commit.log", LOG_LEVEL_INFO);
+
+    filesystem::remove_all(directory_);
+    handler_ = make_unique<DiskLogHandler>();
+
+    NoopLogReplayer replayer;
+    if (OB_FAIL(handler_->init(directory_)) || OB_FAIL(handler_->replay(replayer, 0)) ||
+        OB_FAIL(handler_->start())) {
+      throw runtime_error("failed to start disk log handler");
+    }
+  }
+
+  void TearDown(const State &state) override
+  {
+    if (0 != state.thread_index()) {
+      return;
+    }
+
+    handler_->stop();
+    handler_->await_termination();
+    handler_.reset();
+    filesystem::remove_all(directory_);
+  }
+
+  /// 写一条提交日志并等待它落盘，返回提交延迟
+  RC Commit(int64_t &latency_us)
+  {
+    auto begin = chrono::steady_clock::now();
+
+    LSN lsn = 0;
+    RC  rc  = handler_->append(lsn, LogModule::Id::TRANSACTION, vector<char>(payload_size_));
+    if (OB_SUCC(rc)) {
+      rc = handler_->wait_lsn(lsn);
+    }
+
+    latency_us = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - begin).count();
+    return rc;
+  }
+
+protected:
+  const char                *directory_    = "group_commit_clog";
+  const int                  payload_size_ = 64;
+  unique_ptr<DiskLogHandler> handler_;
+};
+
+BENCHMARK_DEFINE_F(GroupCommitBenchmark, Commit)(State &state)
+{
+  vector<int64_t> latencies;
+  int64_t         failed_count = 0;
+
+  for (auto _ : state) {
+    int64_t latency_us = 0;
+    if (OB_FAIL(Commit(latency_us))) {
+      failed_count++;
+    }
+    latencies.push_back(latency_us);
+  }
+
+  int64_t p99_us = 0;
+  if (!latencies.empty()) {
+    size_t p99_index = latencies.size() * 99 / 100;
+    nth_element(latencies.begin(), latencies.begin() + p99_index, latencies.end());
+    p99_us = latencies[p99_index];
+  }
+
+  state.counters["commits"]    = Counter(static_cast<double>(latencies.size()), Counter::kIsRate);
+  state.counters["failed"]     = Counter(static_cast<double>(failed_count), Counter::kIsRate);
+  state.counters["p99_lat_us"] = Counter(static_cast<double>(p99_us), Counter::kAvgThreads);
+}
+
+BENCHMARK_REGISTER_F(GroupCommitBenchmark, Commit)->ThreadRange(1, 64)->UseRealTime();
+
+////////////////////////////////////////////////////////////////////////////////
+
+BENCHMARK_MAIN();
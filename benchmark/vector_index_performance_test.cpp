@@ -0,0 +1,238 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <benchmark/benchmark.h>
+
+#include "common/lang/algorithm.h"
+#include "common/lang/filesystem.h"
+#include "common/lang/queue.h"
+#include "common/lang/random.h"
+#include "common/lang/stdexcept.h"
+#include "common/log/log.h"
+#include "common/math/vector_distance.h"
+#include "sql/parser/parse_defs.h"
+#include "storage/db/db.h"
+#include "storage/index/hnsw_index.h"
+#include "storage/index/ivfflat_index.h"
+#include "storage/record/record_scanner.h"
+#include "storage/table/table.h"
+#include "storage/trx/vacuous_trx.h"
+
+using namespace std;
+using namespace common;
+using namespace benchmark;
+
+/**
+ * @brief 比较向量索引的召回率和查询速度
+ * @details 表中有 RECORD_NUM 条 DIMENSION 维的向量，数据分布在 CLUSTER_NUM 个簇中，查询向量使用同样的分布。
+ * BruteForce 扫描整张表计算距离，结果作为标准答案；Ivfflat 的参数是 probes，Hnsw 的参数是 ef_search。
+ * 每个测试输出 recall(top TOP_K 的平均召回率)和 qps。
+ */
+static constexpr int RECORD_NUM  = 20000;
+static constexpr int DIMENSION   = 64;
+static constexpr int CLUSTER_NUM = 64;
+static constexpr int QUERY_NUM   = 200;
+static constexpr int TOP_K       = 10;
+
+static const char *DB_PATH = "vector_index_performance_db";
+
+/// 所有测试共用一份数据和索引，创建索引比较耗时，只在第一次使用时创建
+struct VectorIndexContext
+{
+  unique_ptr<Db>        db;
+  Table                *table   = nullptr;
+  IvfflatIndex         *ivfflat = nullptr;
+  HnswIndex            *hnsw    = nullptr;
+  vector<vector<float>> queries;
+  vector<vector<RID>>   answers;
+};
+
+static unique_ptr<VectorIndexContext> context;
+
+static void create_index(Table *table, const char *name, IndexType type, const map<string, string> &params)
+{
+  const FieldMeta *field = table->table_meta().field("v");
+  IndexMeta        index_meta;
+  VacuousTrx       trx;
+  RC               rc = index_meta.init(name, {field}, type, params);
+  if (OB_SUCC(rc)) {
+    rc = table->create_index(&trx, {field}, index_meta);
+  }
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to create index. name=%s, rc=%s", name, strrc(rc));
+    throw runtime_error("failed to create index");
+  }
+}
+
+/// 扫描整张表，返回最近的 limit 条数据
+static vector<RID> brute_force(Table *table, const float *query, size_t limit)
+{
+  const int offset = table->table_meta().field("v")->offset();
+
+  VacuousTrx     trx;
+  RecordScanner *scanner = nullptr;
+  RC             rc      = table->get_record_scanner(scanner, &trx, ReadWriteMode::READ_ONLY);
+  if (OB_FAIL(rc)) {
+    throw runtime_error("failed to create record scanner");
+  }
+
+  auto compare = [](const pair<float, RID> &left, const pair<float, RID> &right) { return left.first < right.first; };
+  priority_queue<pair<float, RID>, vector<pair<float, RID>>, decltype(compare)> heap(compare);
+
+  Record record;
+  while (OB_SUCC(rc = scanner->next(record))) {
+    const float distance = l2_distance(reinterpret_cast<const float *>(record.data() + offset), query, DIMENSION);
+    if (heap.size() < limit) {
+      heap.emplace(distance, record.rid());
+    } else if (distance < heap.top().first) {
+      heap.pop();
+      heap.emplace(distance, record.rid());
+    }
+  }
+  scanner->close_scan();
+  delete scanner;
+
+  vector<RID> result(heap.size());
+  for (int i = static_cast<int>(heap.size()) - 1; i >= 0; i--) {
+    result[i] = heap.top().second;
+    heap.pop();
+  }
+  return result;
+}
+
+static void init_context()
+{
+  filesystem::remove_all(DB_PATH);
+  filesystem::create_directories(DB_PATH);
+
+  context     = make_unique<VectorIndexContext>();
+  context->db = make_unique<Db>();
+  RC rc       = context->db->init("vector_index", DB_PATH, "vacuous", "vacuous");
+  if (OB_FAIL(rc)) {
+    throw runtime_error("failed to init db");
+  }
+
+  AttrInfoSqlNode attrs[] = {{AttrType::VECTORS, "v", DIMENSION * sizeof(float)}};
+  rc                      = context->db->create_table("t", attrs, {});
+  if (OB_FAIL(rc)) {
+    throw runtime_error("failed to create table");
+  }
+  Table *table   = context->db->find_table("t");
+  context->table = table;
+
+  mt19937                          random(0);
+  uniform_real_distribution<float> center_distribution(-1.0f, 1.0f);
+  normal_distribution<float>       noise(0.0f, 0.2f);
+  vector<float>                    centers(CLUSTER_NUM * DIMENSION);
+  for (float &value : centers) {
+    value = center_distribution(random);
+  }
+  auto random_vector = [&](float *vec) {
+    const float *center = centers.data() + (random() % CLUSTER_NUM) * DIMENSION;
+    for (int d = 0; d < DIMENSION; d++) {
+      vec[d] = center[d] + noise(random);
+    }
+  };
+
+  const int offset = table->table_meta().field("v")->offset();
+  for (int i = 0; i < RECORD_NUM; i++) {
+    Record record;
+    record.new_record(table->table_meta().record_size());
+    random_vector(reinterpret_cast<float *>(record.data() + offset));
+    rc = table->insert_record(record);
+    if (OB_FAIL(rc)) {
+      throw runtime_error("failed to insert record");
+    }
+  }
+
+  create_index(table, "v_ivfflat", IndexType::IVFFLAT, {{"lists", "128"}});
+  create_index(table, "v_hnsw", IndexType::HNSW, {{"m", "16"}, {"ef_construction", "100"}});
+  context->ivfflat = static_cast<IvfflatIndex *>(table->find_index("v_ivfflat"));
+  context->hnsw    = static_cast<HnswIndex *>(table->find_index("v_hnsw"));
+
+  for (int i = 0; i < QUERY_NUM; i++) {
+    vector<float> query(DIMENSION);
+    random_vector(query.data());
+    context->answers.push_back(brute_force(table, query.data(), TOP_K));
+    context->queries.push_back(std::move(query));
+  }
+  LOG_INFO("vector index benchmark context created. records=%d, dimension=%d", RECORD_NUM, DIMENSION);
+}
+
+class VectorIndexBenchmark : public Fixture
+{
+public:
+  string Name() const { return "vector_index_performance"; }
+
+  void SetUp(const State &state) override
+  {
+    if (context == nullptr) {
+      string log_name = this->Name() + ".log";
+      LoggerFactory::init_default(log_name.c_str(), LOG_LEVEL_INFO);
+      init_context();
+    }
+  }
+
+protected:
+  /// 依次使用每个查询向量，统计召回率和 qps
+  template <typename SearchFunc>
+  void run(State &state, SearchFunc search)
+  {
+    int64_t query_index = 0;
+    int64_t hit         = 0;
+    for (auto _ : state) {
+      const int          i      = static_cast<int>(query_index++ % QUERY_NUM);
+      const vector<RID> &answer = context->answers[i];
+      const vector<RID>  result = search(context->queries[i]);
+      for (const RID &rid : result) {
+        hit += find(answer.begin(), answer.end(), rid) != answer.end() ? 1 : 0;
+      }
+    }
+
+    state.counters["recall"] = static_cast<double>(hit) / (query_index * TOP_K);
+    state.counters["qps"]    = Counter(static_cast<double>(query_index), Counter::kIsRate);
+  }
+};
+
+BENCHMARK_DEFINE_F(VectorIndexBenchmark, BruteForce)(State &state)
+{
+  run(state, [](const vector<float> &query) { return brute_force(context->table, query.data(), TOP_K); });
+}
+
+BENCHMARK_REGISTER_F(VectorIndexBenchmark, BruteForce)->Unit(kMillisecond);
+
+BENCHMARK_DEFINE_F(VectorIndexBenchmark, Ivfflat)(State &state)
+{
+  context->ivfflat->set_probes(static_cast<int>(state.range(0)));
+  run(state, [](const vector<float> &query) { return context->ivfflat->ann_search(query, TOP_K); });
+}
+
+BENCHMARK_REGISTER_F(VectorIndexBenchmark, Ivfflat)->Arg(1)->Arg(4)->Arg(16)->Arg(32)->Unit(kMicrosecond);
+
+BENCHMARK_DEFINE_F(VectorIndexBenchmark, Hnsw)(State &state)
+{
+  context->hnsw->set_ef_search(static_cast<int>(state.range(0)));
+  run(state, [](const vector<float> &query) { return context->hnsw->ann_search(query, TOP_K); });
+}
+
+BENCHMARK_REGISTER_F(VectorIndexBenchmark, Hnsw)->Arg(16)->Arg(32)->Arg(64)->Arg(128)->Unit(kMicrosecond);
+
+////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv)
+{
+  Initialize(&argc, argv);
+  RunSpecifiedBenchmarks();
+  Shutdown();
+
+  context.reset();
+  filesystem::remove_all(DB_PATH);
+  return 0;
+}
@@ -20,6 +20,8 @@ See the Mulan PSL v2 for more details. */
 #include "common/lang/string.h"
 #include "common/lang/vector.h"
 
+struct iovec;
+
 namespace common {
 
 /**
@@ -77,4 +79,53 @@ int writen(int fd, const void *buf, int size);
  */
 int readn(int fd, void *buf, int size);
 
+/**
+ * @brief 从指定的位置开始，一次性写入所有指定数据
+ * @details 使用 pwrite 写入，不会修改文件的偏移量，多个线程可以同时写同一个文件的不同位置
+ *
+ * @param fd 写入的描述符
+ * @param buf 写入的数据
+ * @param size 写入多少数据
+ * @param offset 在文件中的偏移量
+ * @return int 0 表示成功，否则返回errno
+ */
+int pwriten(int fd, const void *buf, int size, int64_t offset);
+
+/**
+ * @brief 从指定的位置开始，一次性读取指定长度的数据
+ * @details 使用 pread 读取，不会修改文件的偏移量，多个线程可以同时读同一个文件的不同位置
+ *
+ * @param fd 读取的描述符
+ * @param buf 读取到这里
+ * @param size 读取的数据长度
+ * @param offset 在文件中的偏移量
+ * @return int 返回0表示成功。-1 表示读取到文件尾，并且没有读到size大小数据，其它表示errno
+ */
+int preadn(int fd, void *buf, int size, int64_t offset);
+
+/**
+ * @brief 从指定的位置开始，一次性写入多块数据
+ * @details 使用 pwritev 写入，不会修改文件的偏移量。如果只写入了一部分，会继续写入剩下的数据。
+ * 写入过程中会修改iov的内容
+ *
+ * @param fd 写入的描述符
+ * @param iov 写入的数据块
+ * @param iovcnt 数据块的个数，不能超过 IOV_MAX
+ * @param offset 在文件中的偏移量
+ * @return int 0 表示成功，否则返回errno
+ */
+int pwritevn(int fd, struct iovec *iov, int iovcnt, int64_t offset);
+
+/**
+ * @brief 从指定的位置开始，一次性读取多块数据
+ * @details 使用 preadv 读取，不会修改文件的偏移量。读取过程中会修改iov的内容
+ *
+ * @param fd 读取的描述符
+ * @param iov 读取到这些数据块
+ * @param iovcnt 数据块的个数，不能超过 IOV_MAX
+ * @param offset 在文件中的偏移量
+ * @return int 返回0表示成功。-1 表示读取到文件尾，并且没有读满所有数据块，其它表示errno
+ */
+int preadvn(int fd, struct iovec *iov, int iovcnt, int64_t offset);
+
 }  // namespace common
@@ -0,0 +1,435 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "common/io/io.h"
+#include "common/io/io_backend.h"
+#include "common/lang/algorithm.h"
+#include "common/lang/string.h"
+#include "common/log/log.h"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define MINIOB_HAVE_IO_URING 1
+#endif
+#endif
+
+namespace common {
+
+int IoBackend::read(int fd, void *buf, int size, int64_t offset)
+{
+  struct iovec iov{buf, static_cast<size_t>(size)};
+  IoRequest    request;
+  request.type   = IoRequest::Type::READ;
+  request.fd     = fd;
+  request.iov    = &iov;
+  request.iovcnt = 1;
+  request.offset = offset;
+  return submit_and_wait(&request, 1);
+}
+
+int IoBackend::write(int fd, const void *buf, int size, int64_t offset)
+{
+  struct iovec iov{const_cast<void *>(buf), static_cast<size_t>(size)};
+  IoRequest    request;
+  request.type   = IoRequest::Type::WRITE;
+  request.fd     = fd;
+  request.iov    = &iov;
+  request.iovcnt = 1;
+  request.offset = offset;
+  return submit_and_wait(&request, 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// SyncIoBackend
+int SyncIoBackend::submit_and_wait(IoRequest *requests, int count)
+{
+  int first_error = 0;
+  for (int i = 0; i < count; i++) {
+    IoRequest &request = requests[i];
+    if (request.type == IoRequest::Type::READ) {
+      request.result = preadvn(request.fd, request.iov, request.iovcnt, request.offset);
+    } else {
+      request.result = pwritevn(request.fd, request.iov, request.iovcnt, request.offset);
+    }
+
+    if (request.result != 0 && first_error == 0) {
+      first_error = request.result;
+    }
+  }
+  return first_error;
+}
+
+int SyncIoBackend::sync(int fd, bool data_only)
+{
+#ifdef __MACH__
+  int ret = ::fsync(fd);
+#else
+  int ret = data_only ? ::fdatasync(fd) : ::fsync(fd);
+#endif
+  return ret == 0 ? 0 : errno;
+}
+
+#ifdef MINIOB_HAVE_IO_URING
+////////////////////////////////////////////////////////////////////////////////
+// UringIoBackend
+
+/// 每个线程的 io_uring 队列深度，超过这个数量的请求分多次提交
+static constexpr unsigned URING_QUEUE_DEPTH = 64;
+
+/**
+ * @brief 一个 io_uring 实例
+ * @details 直接使用系统调用，不依赖 liburing。io_uring 的提交队列不能被多个线程同时使用，
+ * 所以每个线程创建一个自己的实例
+ */
+class UringQueue
+{
+public:
+  UringQueue() = default;
+  ~UringQueue() { destroy(); }
+
+  /// @return int 0 表示成功，否则返回errno
+  int init(unsigned entries)
+  {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (fd < 0) {
+      return errno;
+    }
+    ring_fd_ = fd;
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+      sq_ring_size_ = cq_ring_size_ = max(sq_ring_size_, cq_ring_size_);
+    }
+
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+      sq_ring_ = nullptr;
+      return errno;
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+      cq_ring_ = sq_ring_;
+    } else {
+      cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+      if (cq_ring_ == MAP_FAILED) {
+        cq_ring_ = nullptr;
+        return errno;
+      }
+    }
+
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+      return errno;
+    }
+    sqes_ = static_cast<struct io_uring_sqe *>(sqes);
+
+    char *sq_ptr = static_cast<char *>(sq_ring_);
+    sq_tail_     = reinterpret_cast<unsigned *>(sq_ptr + params.sq_off.tail);
+    sq_mask_     = *reinterpret_cast<unsigned *>(sq_ptr + params.sq_off.ring_mask);
+    sq_array_    = reinterpret_cast<unsigned *>(sq_ptr + params.sq_off.array);
+    sq_entries_  = params.sq_entries;
+
+    char *cq_ptr = static_cast<char *>(cq_ring_);
+    cq_head_     = reinterpret_cast<unsigned *>(cq_ptr + params.cq_off.head);
+    cq_tail_     = reinterpret_cast<unsigned *>(cq_ptr + params.cq_off.tail);
+    cq_mask_     = *reinterpret_cast<unsigned *>(cq_ptr + params.cq_off.ring_mask);
+    cqes_        = reinterpret_cast<struct io_uring_cqe *>(cq_ptr + params.cq_off.cqes);
+    return 0;
+  }
+
+  unsigned capacity() const { return sq_entries_; }
+
+  /// 获取一个空闲的提交项，调用者保证没有超过队列容量
+  struct io_uring_sqe *next_sqe()
+  {
+    unsigned tail  = *sq_tail_;
+    unsigned index = tail & sq_mask_;
+
+    struct io_uring_sqe *sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sq_array_[index] = index;
+    // 内核看到新的 tail 时，提交项的内容必须已经写好
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    return sqe;
+  }
+
+  /**
+   * @brief 提交 to_submit 个请求，并至少等待 wait_nr 个请求完成
+   * @return int 0 表示成功，否则返回errno
+   */
+  int enter(unsigned to_submit, unsigned wait_nr)
+  {
+    while (to_submit > 0 || wait_nr > 0) {
+      long ret = syscall(__NR_io_uring_enter, ring_fd_, to_submit, wait_nr, IORING_ENTER_GETEVENTS, nullptr, 0);
+      if (ret < 0) {
+        if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+          continue;
+        }
+        return errno;
+      }
+      to_submit -= static_cast<unsigned>(ret);
+      wait_nr = 0;
+    }
+    return 0;
+  }
+
+  /// 取出一个完成的请求，没有时返回false
+  bool pop_cqe(struct io_uring_cqe &cqe)
+  {
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+      return false;
+    }
+
+    cqe = cqes_[head & cq_mask_];
+    __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+    return true;
+  }
+
+private:
+  void destroy()
+  {
+    if (sqes_ != nullptr) {
+      munmap(sqes_, sqes_size_);
+      sqes_ = nullptr;
+    }
+    if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+      munmap(cq_ring_, cq_ring_size_);
+    }
+    cq_ring_ = nullptr;
+    if (sq_ring_ != nullptr) {
+      munmap(sq_ring_, sq_ring_size_);
+      sq_ring_ = nullptr;
+    }
+    if (ring_fd_ >= 0) {
+      ::close(ring_fd_);
+      ring_fd_ = -1;
+    }
+  }
+
+private:
+  int ring_fd_ = -1;
+
+  void  *sq_ring_      = nullptr;
+  size_t sq_ring_size_ = 0;
+  void  *cq_ring_      = nullptr;
+  size_t cq_ring_size_ = 0;
+
+  struct io_uring_sqe *sqes_      = nullptr;
+  size_t               sqes_size_ = 0;
+
+  unsigned *sq_tail_    = nullptr;
+  unsigned  sq_mask_    = 0;
+  unsigned *sq_array_   = nullptr;
+  unsigned  sq_entries_ = 0;
+
+  unsigned            *cq_head_ = nullptr;
+  unsigned            *cq_tail_ = nullptr;
+  unsigned             cq_mask_ = 0;
+  struct io_uring_cqe *cqes_    = nullptr;
+};
+
+/**
+ * @brief 使用 io_uring 的后端
+ * @details 一批请求会尽量一起提交给内核，同时执行。读写的数据没有达到请求的长度时，剩下的部分同步完成
+ */
+class UringIoBackend : public IoBackend
+{
+public:
+  const char *name() const override { return "io_uring"; }
+
+  int submit_and_wait(IoRequest *requests, int count) override
+  {
+    UringQueue *queue = thread_queue();
+    if (nullptr == queue) {
+      return sync_backend_.submit_and_wait(requests, count);
+    }
+
+    int      first_error = 0;
+    int      next        = 0;
+    int      completed   = 0;
+    unsigned inflight    = 0;
+    while (completed < count) {
+      unsigned to_submit = 0;
+      for (; next < count && inflight < queue->capacity(); next++, inflight++, to_submit++) {
+        IoRequest           &request = requests[next];
+        struct io_uring_sqe *sqe     = queue->next_sqe();
+        sqe->opcode    = (request.type == IoRequest::Type::READ) ? IORING_OP_READV : IORING_OP_WRITEV;
+        sqe->fd        = request.fd;
+        sqe->addr      = reinterpret_cast<uint64_t>(request.iov);
+        sqe->len       = static_cast<uint32_t>(request.iovcnt);
+        sqe->off       = static_cast<uint64_t>(request.offset);
+        sqe->user_data = static_cast<uint64_t>(next);
+      }
+
+      int ret = queue->enter(to_submit, 1);
+      if (ret != 0) {
+        // 提交失败时已经提交的请求可能还在执行，不能让调用者释放缓冲区
+        LOG_PANIC("failed to enter io_uring. error=%s", strerror(ret));
+        abort();
+      }
+
+      struct io_uring_cqe cqe;
+      while (queue->pop_cqe(cqe)) {
+        IoRequest &request = requests[cqe.user_data];
+        request.result     = complete(request, cqe.res);
+        if (request.result != 0 && first_error == 0) {
+          first_error = request.result;
+        }
+        inflight--;
+        completed++;
+      }
+    }
+    return first_error;
+  }
+
+  int sync(int fd, bool data_only) override
+  {
+    UringQueue *queue = thread_queue();
+    if (nullptr == queue) {
+      return sync_backend_.sync(fd, data_only);
+    }
+
+    struct io_uring_sqe *sqe = queue->next_sqe();
+    sqe->opcode              = IORING_OP_FSYNC;
+    sqe->fd                  = fd;
+    sqe->fsync_flags         = data_only ? IORING_FSYNC_DATASYNC : 0;
+
+    int ret = queue->enter(1, 1);
+    if (ret != 0) {
+      LOG_PANIC("failed to enter io_uring. error=%s", strerror(ret));
+      abort();
+    }
+
+    struct io_uring_cqe cqe;
+    while (!queue->pop_cqe(cqe)) {
+      queue->enter(0, 1);
+    }
+    return cqe.res < 0 ? -cqe.res : 0;
+  }
+
+  /// 当前线程使用的队列，创建失败时返回nullptr，使用同步方式
+  static UringQueue *thread_queue()
+  {
+    static thread_local unique_ptr<UringQueue> queue;
+    static thread_local bool                   failed = false;
+    if (queue || failed) {
+      return queue.get();
+    }
+
+    auto new_queue = make_unique<UringQueue>();
+    int  ret       = new_queue->init(URING_QUEUE_DEPTH);
+    if (ret != 0) {
+      LOG_WARN("failed to create io_uring, fallback to sync io. error=%s", strerror(ret));
+      failed = true;
+      return nullptr;
+    }
+    queue = std::move(new_queue);
+    return queue.get();
+  }
+
+private:
+  /// 处理一个完成的请求，返回请求的结果
+  int complete(IoRequest &request, int res)
+  {
+    if (res < 0) {
+      return -res;
+    }
+
+    // 跳过已经完成的部分
+    size_t done = static_cast<size_t>(res);
+    while (request.iovcnt > 0 && done >= request.iov->iov_len) {
+      done -= request.iov->iov_len;
+      request.iov++;
+      request.iovcnt--;
+    }
+    if (request.iovcnt == 0) {
+      return 0;
+    }
+    if (res == 0 && request.type == IoRequest::Type::READ) {
+      return -1;  // end of file
+    }
+
+    request.iov->iov_base = static_cast<char *>(request.iov->iov_base) + done;
+    request.iov->iov_len -= done;
+    request.offset += res;
+
+    IoRequest remain = request;
+    return sync_backend_.submit_and_wait(&remain, 1);
+  }
+
+private:
+  SyncIoBackend sync_backend_;
+};
+#endif  // MINIOB_HAVE_IO_URING
+
+////////////////////////////////////////////////////////////////////////////////
+unique_ptr<IoBackend> IoBackend::create(const char *name)
+{
+  if (0 == strcasecmp(name, "sync")) {
+    return make_unique<SyncIoBackend>();
+  }
+
+  if (0 == strcasecmp(name, "io_uring")) {
+#ifdef MINIOB_HAVE_IO_URING
+    if (nullptr == UringIoBackend::thread_queue()) {
+      return nullptr;
+    }
+    return make_unique<UringIoBackend>();
+#else
+    LOG_WARN("io_uring is not supported on this platform");
+    return nullptr;
+#endif
+  }
+
+  LOG_WARN("unknown io backend: %s", name);
+  return nullptr;
+}
+
+/**
+ * @details 不会释放。静态对象(比如测试框架持有的缓冲池)在进程退出析构时可能还要刷页面，
+ * 不能依赖静态对象之间的析构顺序
+ */
+static unique_ptr<IoBackend> &global_backend()
+{
+  static unique_ptr<IoBackend> *backend = new unique_ptr<IoBackend>(make_unique<SyncIoBackend>());
+  return *backend;
+}
+
+int IoBackend::init(const char *name)
+{
+  unique_ptr<IoBackend> backend = create(name);
+  if (!backend) {
+    LOG_WARN("io backend %s is not available, use sync io", name);
+    global_backend() = make_unique<SyncIoBackend>();
+    return -1;
+  }
+
+  global_backend() = std::move(backend);
+  LOG_INFO("use io backend %s", global_backend()->name());
+  return 0;
+}
+
+IoBackend &IoBackend::instance() { return *global_backend(); }
+
+}  // namespace common
@@ -0,0 +1,110 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <stdint.h>
+#include <sys/uio.h>
+
+#include "common/lang/memory.h"
+
+namespace common {
+
+/**
+ * @brief 一次读写请求
+ * @details 从文件的 offset 位置开始，读取或写入 iov 描述的多块数据。不依赖文件偏移量
+ */
+struct IoRequest
+{
+  enum class Type
+  {
+    READ,
+    WRITE,
+  };
+
+  Type          type   = Type::READ;
+  int           fd     = -1;
+  struct iovec *iov    = nullptr;
+  int           iovcnt = 0;
+  int64_t       offset = 0;
+
+  /// 请求完成后的结果。0 表示成功，-1 表示读取到文件尾，其它表示errno
+  int result = 0;
+};
+
+/**
+ * @brief 文件读写的后端
+ * @details 存储层的页面读写和日志写入都通过这个接口完成。
+ * 同步实现 SyncIoBackend 使用 pread/pwrite，一个请求完成后再处理下一个；
+ * io_uring 实现 UringIoBackend 会把一批请求一起提交给内核，同时有多个请求在执行。
+ * 请求中的数据块在请求完成后才能释放。
+ * 全局使用的后端通过 IoBackend::init 在启动时指定，然后使用 IoBackend::instance 获取。
+ */
+class IoBackend
+{
+public:
+  IoBackend()          = default;
+  virtual ~IoBackend() = default;
+
+  virtual const char *name() const = 0;
+
+  /**
+   * @brief 提交一批请求，并等待全部完成
+   * @details 每个请求的结果记录在 IoRequest::result 中，即使前面的请求失败，后面的请求也会执行
+   * 调用时可能会修改请求中 iov 的内容
+   * @return int 0 表示所有请求都成功，否则返回第一个失败请求的结果
+   */
+  virtual int submit_and_wait(IoRequest *requests, int count) = 0;
+
+  /**
+   * @brief 将文件的数据刷到磁盘
+   * @param data_only 为true时只保证数据落盘，相当于 fdatasync
+   * @return int 0 表示成功，否则返回errno
+   */
+  virtual int sync(int fd, bool data_only) = 0;
+
+  /// 从 offset 开始读取 size 字节，返回值与 preadn 相同
+  int read(int fd, void *buf, int size, int64_t offset);
+
+  /// 从 offset 开始写入 size 字节，返回值与 pwriten 相同
+  int write(int fd, const void *buf, int size, int64_t offset);
+
+public:
+  /**
+   * @brief 按照名字创建后端
+   * @param name sync 或 io_uring
+   * @return 名字不合法或者当前系统不支持时返回nullptr
+   */
+  static unique_ptr<IoBackend> create(const char *name);
+
+  /**
+   * @brief 设置全局使用的后端
+   * @details 需要在启动多线程之前调用。指定的后端不可用时，使用同步后端
+   * @return int 0 表示使用了指定的后端，否则表示回退到了同步后端
+   */
+  static int init(const char *name);
+
+  /// 全局使用的后端，默认是同步后端
+  static IoBackend &instance();
+};
+
+/**
+ * @brief 使用 pread/pwrite 的同步后端
+ */
+class SyncIoBackend : public IoBackend
+{
+public:
+  const char *name() const override { return "sync"; }
+
+  int submit_and_wait(IoRequest *requests, int count) override;
+  int sync(int fd, bool data_only) override;
+};
+
+}  // namespace common
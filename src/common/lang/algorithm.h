@@ -12,7 +12,9 @@ See the Mulan PSL v2 for more details. */
 
 #include <algorithm>
 
+using std::binary_search;
 using std::max;
 using std::min;
+using std::sort;
 using std::swap;
 using std::transform;
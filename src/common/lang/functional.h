@@ -14,6 +14,7 @@ See the Mulan PSL v2 for more details. */
 
 using std::equal_to;
 using std::function;
+using std::greater;
 using std::hash;
 // using std::bind; // conflict with socket::bind
 using std::ref;
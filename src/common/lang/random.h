@@ -13,5 +13,7 @@ See the Mulan PSL v2 for more details. */
 #include <random>
 
 using std::mt19937;
+using std::normal_distribution;
 using std::random_device;
-using std::uniform_int_distribution;
\ No newline at end of file
+using std::uniform_int_distribution;
+using std::uniform_real_distribution;
\ No newline at end of file
@@ -0,0 +1,134 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <math.h>
+
+#include "common/math/vector_distance.h"
+#include "common/math/simd_util.h"
+
+namespace common {
+
+#if defined(USE_SIMD)
+
+/// 把8个float加起来
+static float mm256_reduce_add_ps(__m256 value)
+{
+  __m128 low  = _mm256_castps256_ps128(value);
+  __m128 high = _mm256_extractf128_ps(value, 1);
+  low         = _mm_add_ps(low, high);
+  low         = _mm_hadd_ps(low, low);
+  low         = _mm_hadd_ps(low, low);
+  return _mm_cvtss_f32(low);
+}
+
+float l2_distance_square(const float *left, const float *right, int dim)
+{
+  __m256 sum = _mm256_setzero_ps();
+  int    i   = 0;
+  for (; i + SIMD_WIDTH <= dim; i += SIMD_WIDTH) {
+    __m256 diff = _mm256_sub_ps(_mm256_loadu_ps(left + i), _mm256_loadu_ps(right + i));
+    sum         = _mm256_add_ps(sum, _mm256_mul_ps(diff, diff));
+  }
+
+  float result = mm256_reduce_add_ps(sum);
+  for (; i < dim; i++) {
+    const float diff = left[i] - right[i];
+    result += diff * diff;
+  }
+  return result;
+}
+
+float inner_product(const float *left, const float *right, int dim)
+{
+  __m256 sum = _mm256_setzero_ps();
+  int    i   = 0;
+  for (; i + SIMD_WIDTH <= dim; i += SIMD_WIDTH) {
+    sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(left + i), _mm256_loadu_ps(right + i)));
+  }
+
+  float result = mm256_reduce_add_ps(sum);
+  for (; i < dim; i++) {
+    result += left[i] * right[i];
+  }
+  return result;
+}
+
+float cosine_distance(const float *left, const float *right, int dim)
+{
+  __m256 dot        = _mm256_setzero_ps();
+  __m256 left_norm  = _mm256_setzero_ps();
+  __m256 right_norm = _mm256_setzero_ps();
+  int    i          = 0;
+  for (; i + SIMD_WIDTH <= dim; i += SIMD_WIDTH) {
+    __m256 l   = _mm256_loadu_ps(left + i);
+    __m256 r   = _mm256_loadu_ps(right + i);
+    dot        = _mm256_add_ps(dot, _mm256_mul_ps(l, r));
+    left_norm  = _mm256_add_ps(left_norm, _mm256_mul_ps(l, l));
+    right_norm = _mm256_add_ps(right_norm, _mm256_mul_ps(r, r));
+  }
+
+  float dot_sum        = mm256_reduce_add_ps(dot);
+  float left_norm_sum  = mm256_reduce_add_ps(left_norm);
+  float right_norm_sum = mm256_reduce_add_ps(right_norm);
+  for (; i < dim; i++) {
+    dot_sum += left[i] * right[i];
+    left_norm_sum += left[i] * left[i];
+    right_norm_sum += right[i] * right[i];
+  }
+
+  if (left_norm_sum == 0 || right_norm_sum == 0) {
+    return 1.0f;
+  }
+  return 1.0f - dot_sum / sqrtf(left_norm_sum * right_norm_sum);
+}
+
+#else  // USE_SIMD
+
+float l2_distance_square(const float *left, const float *right, int dim)
+{
+  float result = 0;
+  for (int i = 0; i < dim; i++) {
+    const float diff = left[i] - right[i];
+    result += diff * diff;
+  }
+  return result;
+}
+
+float inner_product(const float *left, const float *right, int dim)
+{
+  float result = 0;
+  for (int i = 0; i < dim; i++) {
+    result += left[i] * right[i];
+  }
+  return result;
+}
+
+float cosine_distance(const float *left, const float *right, int dim)
+{
+  float dot_sum        = 0;
+  float left_norm_sum  = 0;
+  float right_norm_sum = 0;
+  for (int i = 0; i < dim; i++) {
+    dot_sum += left[i] * right[i];
+    left_norm_sum += left[i] * left[i];
+    right_norm_sum += right[i] * right[i];
+  }
+
+  if (left_norm_sum == 0 || right_norm_sum == 0) {
+    return 1.0f;
+  }
+  return 1.0f - dot_sum / sqrtf(left_norm_sum * right_norm_sum);
+}
+
+#endif  // USE_SIMD
+
+float l2_distance(const float *left, const float *right, int dim) { return sqrtf(l2_distance_square(left, right, dim)); }
+
+}  // namespace common
@@ -0,0 +1,33 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+namespace common {
+
+/**
+ * @brief 向量距离计算
+ * @details 编译时打开 USE_SIMD 选项时使用 AVX2 指令，一次计算8个float，否则使用标量实现。
+ * 向量的长度不需要是8的倍数。
+ */
+
+/// 欧氏距离
+float l2_distance(const float *left, const float *right, int dim);
+
+/// 欧氏距离的平方，只比较大小时可以省去开方
+float l2_distance_square(const float *left, const float *right, int dim);
+
+/// 内积
+float inner_product(const float *left, const float *right, int dim);
+
+/// 余弦距离，即 1 - 余弦相似度。有一个向量是零向量时返回1
+float cosine_distance(const float *left, const float *right, int dim);
+
+}  // namespace common
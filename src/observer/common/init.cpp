@@ -15,6 +15,7 @@ See the Mulan PSL v2 for more details. */
 #include "common/init.h"
 
 #include "common/conf/ini.h"
+#include "common/io/io_backend.h"
 #include "common/lang/string.h"
 #include "common/lang/iostream.h"
 #include "common/log/log.h"
@@ -136,6 +137,10 @@ int prepare_init_seda()
 
 int init_global_objects(ProcessParam *process_param, Ini &properties)
 {
+  // 文件读写的后端需要在打开数据库之前确定
+  string io_backend = properties.get("IO_BACKEND", "sync", "STORAGE");
+  IoBackend::init(io_backend.c_str());
+
   GCTX.handler_ = new DefaultHandler();
 
   int ret = 0;
@@ -14,21 +14,22 @@ See the Mulan PSL v2 for more details. */
 
 #include "sql/operator/index_scan_physical_operator.h"
 #include "storage/index/index.h"
+#include "storage/table/table.h"
 #include "storage/trx/trx.h"
 
-IndexScanPhysicalOperator::IndexScanPhysicalOperator(Table *table, Index *index, ReadWriteMode mode, const Value *left_value,
-    bool left_inclusive, const Value *right_value, bool right_inclusive)
+IndexScanPhysicalOperator::IndexScanPhysicalOperator(Table *table, Index *index, ReadWriteMode mode,
+    const char *left_key, int left_len, bool left_inclusive, const char *right_key, int right_len, bool right_inclusive)
     : table_(table),
       index_(index),
       mode_(mode),
       left_inclusive_(left_inclusive),
       right_inclusive_(right_inclusive)
 {
-  if (left_value) {
-    left_value_ = *left_value;
+  if (left_key) {
+    left_key_.assign(left_key, left_key + left_len);
   }
-  if (right_value) {
-    right_value_ = *right_value;
+  if (right_key) {
+    right_key_.assign(right_key, right_key + right_len);
   }
 }
 
@@ -38,12 +39,24 @@ RC IndexScanPhysicalOperator::open(Trx *trx)
     return RC::INTERNAL;
   }
 
-  IndexScanner *index_scanner = index_->create_scanner(left_value_.data(),
-      left_value_.length(),
-      left_inclusive_,
-      right_value_.data(),
-      right_value_.length(),
-      right_inclusive_);
+  const char   *left_key      = left_key_.empty() ? nullptr : left_key_.data();
+  const char   *right_key     = right_key_.empty() ? nullptr : right_key_.data();
+  IndexScanner *index_scanner = nullptr;
+  if (reverse_) {
+    index_scanner = index_->create_reverse_scanner(left_key,
+        static_cast<int>(left_key_.size()),
+        left_inclusive_,
+        right_key,
+        static_cast<int>(right_key_.size()),
+        right_inclusive_);
+  } else {
+    index_scanner = index_->create_scanner(left_key,
+        static_cast<int>(left_key_.size()),
+        left_inclusive_,
+        right_key,
+        static_cast<int>(right_key_.size()),
+        right_inclusive_);
+  }
   if (nullptr == index_scanner) {
     LOG_WARN("failed to create index scanner");
     return RC::INTERNAL;
@@ -52,26 +65,41 @@ RC IndexScanPhysicalOperator::open(Trx *trx)
 
   tuple_.set_schema(table_, table_->table_meta().field_metas());
 
-  trx_ = trx;
+  // 只扫描索引时，记录中只有索引包含的字段是有效的，其它字段不会被上层访问
+  read_record_ = !index_only_ || trx->type() != TrxKit::Type::VACUOUS;
+  if (!read_record_) {
+    RC rc = current_record_.new_record(table_->table_meta().record_size());
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to allocate record for index only scan. rc=%s", strrc(rc));
+      return rc;
+    }
+    memset(current_record_.data(), 0, current_record_.len());
+  } else if (batch_size_ > 0) {
+    batch_fetcher_.init(table_, index_scanner_, mode_, batch_size_, bitmap_);
+    batch_records_.clear();
+    batch_pos_ = 0;
+  }
+
+  trx_         = trx;
+  emitted_num_ = 0;
   return RC::SUCCESS;
 }
 
 RC IndexScanPhysicalOperator::next()
 {
   // TODO: 需要适配 lsm-tree 引擎
-  RID rid;
-  RC  rc = RC::SUCCESS;
+  RC rc = RC::SUCCESS;
+  if (limit_ >= 0 && emitted_num_ >= limit_) {
+    return RC::RECORD_EOF;
+  }
 
   bool filter_result = false;
-  while (RC::SUCCESS == (rc = index_scanner_->next_entry(&rid))) {
-    rc = table_->get_record(rid, current_record_);
+  while (true) {
+    rc = fetch_next_record();
     if (OB_FAIL(rc)) {
-      LOG_TRACE("failed to get record. rid=%s, rc=%s", rid.to_string().c_str(), strrc(rc));
-      return rc;
+      break;
     }
 
-    LOG_TRACE("got a record. rid=%s", rid.to_string().c_str());
-
     tuple_.set_record(&current_record_);
     rc = filter(tuple_, filter_result);
     if (OB_FAIL(rc)) {
@@ -89,6 +117,9 @@ RC IndexScanPhysicalOperator::next()
       LOG_TRACE("record invisible");
       continue;
     } else {
+      if (OB_SUCC(rc)) {
+        emitted_num_++;
+      }
       return rc;
     }
   }
@@ -96,6 +127,69 @@ RC IndexScanPhysicalOperator::next()
   return rc;
 }
 
+RC IndexScanPhysicalOperator::fetch_next_record()
+{
+  RID rid;
+  RC  rc = RC::SUCCESS;
+  if (!read_record_) {
+    const char *key = nullptr;
+    rc              = index_scanner_->next_entry(&rid, key);
+    if (OB_SUCC(rc)) {
+      fill_record_from_key(key, rid);
+    }
+    return rc;
+  }
+
+  if (batch_size_ > 0) {
+    return fetch_next_batch_record();
+  }
+
+  rc = index_scanner_->next_entry(&rid);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  rc = table_->get_record(rid, current_record_);
+  if (OB_FAIL(rc)) {
+    LOG_TRACE("failed to get record. rid=%s, rc=%s", rid.to_string().c_str(), strrc(rc));
+    return rc;
+  }
+
+  LOG_TRACE("got a record. rid=%s", rid.to_string().c_str());
+  return rc;
+}
+
+RC IndexScanPhysicalOperator::fetch_next_batch_record()
+{
+  if (batch_pos_ >= batch_records_.size()) {
+    batch_records_.clear();
+    batch_pos_ = 0;
+
+    // 记录会交给上层算子(比如删除)保存，所以每条记录都复制一份
+    RC rc = batch_fetcher_.next_batch([this](Record &record) {
+      Record &copied = batch_records_.emplace_back();
+      copied.set_rid(record.rid());
+      return copied.copy_data(record.data(), record.len());
+    });
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+  }
+
+  current_record_ = std::move(batch_records_[batch_pos_++]);
+  return RC::SUCCESS;
+}
+
+void IndexScanPhysicalOperator::fill_record_from_key(const char *key, const RID &rid)
+{
+  int offset = 0;
+  for (const FieldMeta &field_meta : index_->field_metas()) {
+    memcpy(current_record_.data() + field_meta.offset(), key + offset, field_meta.len());
+    offset += field_meta.len();
+  }
+  current_record_.set_rid(rid);
+}
+
 RC IndexScanPhysicalOperator::close()
 {
   index_scanner_->destroy();
@@ -137,5 +231,19 @@ RC IndexScanPhysicalOperator::filter(RowTuple &tuple, bool &result)
 
 string IndexScanPhysicalOperator::param() const
 {
-  return string(index_->index_meta().name()) + " ON " + table_->name();
+  string param = string(index_->index_meta().name()) + " ON " + table_->name();
+  if (index_only_) {
+    param += " INDEX ONLY";
+  } else if (bitmap_) {
+    param += " BITMAP";
+  } else if (batch_size_ > 0) {
+    param += " BATCH " + to_string(batch_size_);
+  }
+  if (reverse_) {
+    param += " REVERSE";
+  }
+  if (limit_ >= 0) {
+    param += " LIMIT " + to_string(limit_);
+  }
+  return param;
 }
@@ -16,17 +16,22 @@ See the Mulan PSL v2 for more details. */
 
 #include "sql/expr/tuple.h"
 #include "sql/operator/physical_operator.h"
+#include "sql/operator/rid_batch_fetcher.h"
 #include "storage/record/record_manager.h"
 
 /**
  * @brief 索引扫描物理算子
  * @ingroup PhysicalOperator
+ * @details 扫描的范围使用索引的键值表示，多个字段的索引，键值是各个字段的值拼接起来的。
+ * 如果索引包含了查询用到的所有字段，可以设置为只扫描索引(index only)，直接从索引的键值中取出字段的值，
+ * 不需要再根据RID读取记录。
+ * 需要读取记录时，可以按批读取：一批RID按照页面排序后再读取记录，减少页面的固定次数，这时输出的顺序不再是索引的顺序。
  */
 class IndexScanPhysicalOperator : public PhysicalOperator
 {
 public:
-  IndexScanPhysicalOperator(Table *table, Index *index, ReadWriteMode mode, const Value *left_value,
-      bool left_inclusive, const Value *right_value, bool right_inclusive);
+  IndexScanPhysicalOperator(Table *table, Index *index, ReadWriteMode mode, const char *left_key, int left_len,
+      bool left_inclusive, const char *right_key, int right_len, bool right_inclusive);
 
   virtual ~IndexScanPhysicalOperator() = default;
 
@@ -42,6 +47,43 @@ public:
 
   void set_predicates(vector<unique_ptr<Expression>> &&exprs);
 
+  /**
+   * @brief 设置是否只扫描索引
+   * @details 需要判断记录可见性的事务(比如MVCC)，可见性信息保存在记录中，这时仍然会读取记录
+   */
+  void set_index_only(bool index_only) { index_only_ = index_only; }
+  bool index_only() const { return index_only_; }
+
+  /**
+   * @brief 按批读取记录
+   * @param batch_size 每批读取的记录数。小于等于0表示按照索引的顺序逐条读取
+   * @param bitmap     先读出范围内所有的RID再按页面顺序读取记录，适合范围比较大的扫描
+   */
+  void set_batch_fetch(int batch_size, bool bitmap)
+  {
+    batch_size_ = batch_size;
+    bitmap_     = bitmap;
+  }
+
+  /**
+   * @brief 按照键值从大到小扫描
+   * @details 需要索引支持反向扫描。按批读取记录时输出的不是索引的顺序，需要有序时不要按批读取
+   */
+  void set_reverse(bool reverse) { reverse_ = reverse; }
+
+  /// 最多输出的记录数，负数表示不限制
+  void set_limit(int limit) { limit_ = limit; }
+
+private:
+  /// 读取下一条记录，放到 current_record_ 中
+  RC fetch_next_record();
+
+  /// 从当前批次的记录中取出下一条，当前批次已经取完时读取下一批
+  RC fetch_next_batch_record();
+
+  /// 把索引键值中各个字段的值放到当前记录对应的位置上
+  void fill_record_from_key(const char *key, const RID &rid);
+
 private:
   // 与TableScanPhysicalOperator代码相同，可以优化
   RC filter(RowTuple &tuple, bool &result);
@@ -56,10 +98,23 @@ private:
   Record   current_record_;
   RowTuple tuple_;
 
-  Value left_value_;
-  Value right_value_;
-  bool  left_inclusive_  = false;
-  bool  right_inclusive_ = false;
+  vector<char> left_key_;
+  vector<char> right_key_;
+  bool         left_inclusive_  = false;
+  bool         right_inclusive_ = false;
+  bool         reverse_         = false;
+
+  int limit_       = -1;
+  int emitted_num_ = 0;  ///< 已经输出的记录数
+
+  bool index_only_  = false;  ///< 优化器认为可以只扫描索引
+  bool read_record_ = true;   ///< 执行时是否需要读取记录
+
+  int             batch_size_ = 0;
+  bool            bitmap_     = false;
+  RidBatchFetcher batch_fetcher_;
+  vector<Record>  batch_records_;  ///< 当前批次读取出来的记录
+  size_t          batch_pos_ = 0;
 
   vector<unique_ptr<Expression>> predicates_;
 };
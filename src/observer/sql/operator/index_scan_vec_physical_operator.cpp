@@ -0,0 +1,156 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "sql/operator/index_scan_vec_physical_operator.h"
+#include "sql/expr/expression.h"
+#include "storage/index/index.h"
+#include "storage/table/table.h"
+#include "storage/trx/trx.h"
+
+IndexScanVecPhysicalOperator::IndexScanVecPhysicalOperator(Table *table, Index *index, ReadWriteMode mode,
+    const char *left_key, int left_len, bool left_inclusive, const char *right_key, int right_len, bool right_inclusive)
+    : table_(table),
+      index_(index),
+      mode_(mode),
+      left_inclusive_(left_inclusive),
+      right_inclusive_(right_inclusive)
+{
+  if (left_key) {
+    left_key_.assign(left_key, left_key + left_len);
+  }
+  if (right_key) {
+    right_key_.assign(right_key, right_key + right_len);
+  }
+}
+
+RC IndexScanVecPhysicalOperator::open(Trx *trx)
+{
+  if (nullptr == table_ || nullptr == index_) {
+    return RC::INTERNAL;
+  }
+
+  index_scanner_ = index_->create_scanner(left_key_.empty() ? nullptr : left_key_.data(),
+      static_cast<int>(left_key_.size()),
+      left_inclusive_,
+      right_key_.empty() ? nullptr : right_key_.data(),
+      static_cast<int>(right_key_.size()),
+      right_inclusive_);
+  if (nullptr == index_scanner_) {
+    LOG_WARN("failed to create index scanner");
+    return RC::INTERNAL;
+  }
+
+  const TableMeta &table_meta = table_->table_meta();
+  for (int i = 0; i < table_meta.field_num(); ++i) {
+    all_columns_.add_column(make_unique<Column>(*table_meta.field(i)), table_meta.field(i)->field_id());
+    filterd_columns_.add_column(make_unique<Column>(*table_meta.field(i)), table_meta.field(i)->field_id());
+  }
+
+  // 一批RID读出来的记录要能放到一个 Chunk 中
+  batch_fetcher_.init(table_, index_scanner_, mode_, all_columns_.capacity(), bitmap_);
+  trx_ = trx;
+  return RC::SUCCESS;
+}
+
+RC IndexScanVecPhysicalOperator::append_record(Record &record)
+{
+  RC rc = trx_->visit_record(table_, record, mode_);
+  if (rc == RC::RECORD_INVISIBLE) {
+    return RC::SUCCESS;
+  } else if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  const TableMeta &table_meta = table_->table_meta();
+  for (int i = 0; i < all_columns_.column_num(); i++) {
+    rc = all_columns_.column(i).append_one(record.data() + table_meta.field(i)->offset());
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to append record to chunk. rid=%s, rc=%s", record.rid().to_string().c_str(), strrc(rc));
+      return rc;
+    }
+  }
+  return rc;
+}
+
+RC IndexScanVecPhysicalOperator::next(Chunk &chunk)
+{
+  RC rc = RC::SUCCESS;
+
+  all_columns_.reset_data();
+  filterd_columns_.reset_data();
+
+  // 一批记录可能都不可见，这时继续读取下一批
+  while (all_columns_.rows() == 0) {
+    rc = batch_fetcher_.next_batch([this](Record &record) { return append_record(record); });
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+  }
+
+  select_.assign(all_columns_.rows(), 1);
+  if (predicates_.empty()) {
+    chunk.reference(all_columns_);
+    return rc;
+  }
+
+  rc = filter(all_columns_);
+  if (OB_FAIL(rc)) {
+    LOG_TRACE("filtered failed=%s", strrc(rc));
+    return rc;
+  }
+
+  for (int i = 0; i < all_columns_.rows(); i++) {
+    if (select_[i] == 0) {
+      continue;
+    }
+    for (int j = 0; j < all_columns_.column_num(); j++) {
+      filterd_columns_.column(j).append_one(
+          (char *)all_columns_.column(filterd_columns_.column_ids(j)).get_value(i).data());
+    }
+  }
+  chunk.reference(filterd_columns_);
+  return rc;
+}
+
+RC IndexScanVecPhysicalOperator::close()
+{
+  if (index_scanner_ != nullptr) {
+    index_scanner_->destroy();
+    index_scanner_ = nullptr;
+  }
+  batch_fetcher_.reset();
+  return RC::SUCCESS;
+}
+
+string IndexScanVecPhysicalOperator::param() const
+{
+  string param = string(index_->index_meta().name()) + " ON " + table_->name();
+  if (bitmap_) {
+    param += " BITMAP";
+  }
+  return param;
+}
+
+void IndexScanVecPhysicalOperator::set_predicates(vector<unique_ptr<Expression>> &&exprs)
+{
+  predicates_ = std::move(exprs);
+}
+
+RC IndexScanVecPhysicalOperator::filter(Chunk &chunk)
+{
+  RC rc = RC::SUCCESS;
+  for (unique_ptr<Expression> &expr : predicates_) {
+    rc = expr->eval(chunk, select_);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+  }
+  return rc;
+}
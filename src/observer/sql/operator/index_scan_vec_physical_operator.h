@@ -0,0 +1,73 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/sys/rc.h"
+#include "sql/operator/physical_operator.h"
+#include "sql/operator/rid_batch_fetcher.h"
+#include "storage/common/chunk.h"
+
+class Table;
+class Index;
+class IndexScanner;
+
+/**
+ * @brief 索引扫描物理算子(vectorized)
+ * @ingroup PhysicalOperator
+ * @details 每次从索引中读取一批RID，按照页面排序后读取记录，每个页面只访问一次，读出来的记录组成一个 Chunk。
+ * 一批RID的个数不超过 Chunk 的容量，输出的顺序不是索引的顺序。
+ */
+class IndexScanVecPhysicalOperator : public PhysicalOperator
+{
+public:
+  IndexScanVecPhysicalOperator(Table *table, Index *index, ReadWriteMode mode, const char *left_key, int left_len,
+      bool left_inclusive, const char *right_key, int right_len, bool right_inclusive);
+
+  virtual ~IndexScanVecPhysicalOperator() = default;
+
+  PhysicalOperatorType type() const override { return PhysicalOperatorType::INDEX_SCAN_VEC; }
+
+  string param() const override;
+
+  RC open(Trx *trx) override;
+  RC next(Chunk &chunk) override;
+  RC close() override;
+
+  void set_predicates(vector<unique_ptr<Expression>> &&exprs);
+
+  /// 先读出范围内所有的RID再按页面顺序读取记录，参考 RidBatchFetcher
+  void set_bitmap(bool bitmap) { bitmap_ = bitmap; }
+
+private:
+  /// 把一条记录的各个字段追加到 all_columns_ 中，当前事务不可见的记录跳过
+  RC append_record(Record &record);
+
+  RC filter(Chunk &chunk);
+
+private:
+  Trx          *trx_           = nullptr;
+  Table        *table_         = nullptr;
+  Index        *index_         = nullptr;
+  ReadWriteMode mode_          = ReadWriteMode::READ_WRITE;
+  IndexScanner *index_scanner_ = nullptr;
+
+  vector<char> left_key_;
+  vector<char> right_key_;
+  bool         left_inclusive_  = false;
+  bool         right_inclusive_ = false;
+  bool         bitmap_          = false;
+
+  RidBatchFetcher                batch_fetcher_;
+  Chunk                          all_columns_;
+  Chunk                          filterd_columns_;
+  vector<uint8_t>                select_;
+  vector<unique_ptr<Expression>> predicates_;
+};
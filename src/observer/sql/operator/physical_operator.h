@@ -38,6 +38,7 @@ enum class PhysicalOperatorType
   TABLE_SCAN,
   TABLE_SCAN_VEC,
   INDEX_SCAN,
+  INDEX_SCAN_VEC,
   NESTED_LOOP_JOIN,
   HASH_JOIN,
   EXPLAIN,
@@ -0,0 +1,89 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "sql/operator/rid_batch_fetcher.h"
+#include "common/lang/algorithm.h"
+#include "common/log/log.h"
+#include "storage/index/index.h"
+#include "storage/table/table.h"
+
+void RidBatchFetcher::init(Table *table, IndexScanner *scanner, ReadWriteMode mode, int batch_size, bool bitmap)
+{
+  table_      = table;
+  scanner_    = scanner;
+  mode_       = mode;
+  batch_size_ = max(1, batch_size);
+  bitmap_     = bitmap;
+  reset();
+}
+
+void RidBatchFetcher::reset()
+{
+  rids_.clear();
+  rid_pos_     = 0;
+  scanner_eof_ = false;
+}
+
+RC RidBatchFetcher::fill_rids()
+{
+  rids_.clear();
+  rid_pos_ = 0;
+
+  RC  rc = RC::SUCCESS;
+  RID rid;
+  while (bitmap_ || static_cast<int>(rids_.size()) < batch_size_) {
+    rc = scanner_->next_entry(&rid);
+    if (OB_FAIL(rc)) {
+      break;
+    }
+    rids_.push_back(rid);
+  }
+
+  if (rc == RC::RECORD_EOF) {
+    scanner_eof_ = true;
+    rc           = RC::SUCCESS;
+  } else if (OB_FAIL(rc)) {
+    LOG_WARN("failed to fetch rid from index scanner. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  sort(rids_.begin(), rids_.end(), [](const RID &left, const RID &right) {
+    return RID::compare(&left, &right) < 0;
+  });
+  LOG_TRACE("fetched a batch of rids. num=%d, bitmap=%d", static_cast<int>(rids_.size()), bitmap_);
+  return rc;
+}
+
+RC RidBatchFetcher::next_batch(const function<RC(Record &)> &visitor)
+{
+  if (rid_pos_ >= rids_.size()) {
+    if (scanner_eof_) {
+      return RC::RECORD_EOF;
+    }
+
+    RC rc = fill_rids();
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+    if (rids_.empty()) {
+      return RC::RECORD_EOF;
+    }
+  }
+
+  const int rid_num = static_cast<int>(min(rids_.size() - rid_pos_, static_cast<size_t>(batch_size_)));
+  RC        rc      = table_->visit_records(rids_.data() + rid_pos_, rid_num, mode_, visitor);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to visit records. table=%s, rc=%s", table_->name(), strrc(rc));
+    return rc;
+  }
+
+  rid_pos_ += rid_num;
+  return rc;
+}
@@ -0,0 +1,66 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/lang/functional.h"
+#include "common/lang/vector.h"
+#include "common/sys/rc.h"
+#include "common/types.h"
+#include "storage/record/record.h"
+
+class Table;
+class IndexScanner;
+
+/**
+ * @brief 按照页面顺序批量读取索引扫描出来的记录
+ * @ingroup PhysicalOperator
+ * @details 按照索引的顺序逐条读取记录时，相邻的两条记录通常在不同的页面上，同一个页面会被反复地固定和释放。
+ * 这里先从索引中读取一批RID，按照页面号排序之后再读取记录，一批数据中每个页面只访问一次。
+ * 范围比较大时，可以使用bitmap模式，类似 PostgreSQL 的 bitmap heap scan：先把范围内所有的RID读出来排好序，
+ * 再按批读取记录，整个扫描过程中每个页面只访问一次。
+ * 读出来的记录不再是索引的顺序。
+ */
+class RidBatchFetcher
+{
+public:
+  RidBatchFetcher()  = default;
+  ~RidBatchFetcher() = default;
+
+  /**
+   * @param batch_size 每批最多读取多少条记录
+   * @param bitmap     是否先读取范围内所有的RID
+   */
+  void init(Table *table, IndexScanner *scanner, ReadWriteMode mode, int batch_size, bool bitmap);
+
+  /**
+   * @brief 读取下一批记录
+   * @details 传给visitor的记录直接指向页面中的数据，只在visitor执行期间有效
+   * @return 没有更多的记录时返回RECORD_EOF
+   */
+  RC next_batch(const function<RC(Record &)> &visitor);
+
+  void reset();
+
+private:
+  /// 从索引中读取下一批RID，并按照页面排序
+  RC fill_rids();
+
+private:
+  Table        *table_      = nullptr;
+  IndexScanner *scanner_    = nullptr;
+  ReadWriteMode mode_       = ReadWriteMode::READ_ONLY;
+  int           batch_size_ = 0;
+  bool          bitmap_     = false;
+
+  vector<RID> rids_;
+  size_t      rid_pos_     = 0;
+  bool        scanner_eof_ = false;
+};
@@ -57,6 +57,13 @@ public:
   void set_predicates(vector<unique_ptr<Expression>> &&exprs);
   auto predicates() -> vector<unique_ptr<Expression>> & { return predicates_; }
 
+  /**
+   * @brief 查询中用到的当前表的字段，包括输出的字段和过滤条件中的字段
+   * @details 如果某个索引包含了所有这些字段，就可以只扫描索引。为空表示不知道用到了哪些字段
+   */
+  void set_referenced_fields(vector<const FieldMeta *> &&fields) { referenced_fields_ = std::move(fields); }
+  const vector<const FieldMeta *> &referenced_fields() const { return referenced_fields_; }
+
 private:
   Table        *table_ = nullptr;
   ReadWriteMode mode_  = ReadWriteMode::READ_WRITE;
@@ -66,4 +73,6 @@ private:
   // 不包含复杂的表达式运算，比如加减乘除、或者conjunction expression
   // 如果有多个表达式，他们的关系都是 AND
   vector<unique_ptr<Expression>> predicates_;
+
+  vector<const FieldMeta *> referenced_fields_;
 };
@@ -22,6 +22,8 @@ RC TableScanPhysicalOperator::open(Trx *trx)
 {
   RC rc = table_->get_record_scanner(record_scanner_, trx, mode_);
   if (rc == RC::SUCCESS) {
+    // 全表扫描会按顺序访问所有页面，不需要再检测访问模式
+    record_scanner_->hint_sequential_scan();
     tuple_.set_schema(table_, table_->table_meta().field_metas());
   }
   trx_ = trx;
@@ -21,6 +21,7 @@ RC TableScanVecPhysicalOperator::open(Trx *trx)
     LOG_WARN("failed to get chunk scanner", strrc(rc));
     return rc;
   }
+  chunk_scanner_.hint_sequential_scan();
   // TODO: don't need to fetch all columns from record manager
   for (int i = 0; i < table_->table_meta().field_num(); ++i) {
     all_columns_.add_column(
@@ -15,10 +15,13 @@ See the Mulan PSL v2 for more details. */
 #pragma once
 
 #include "common/lang/memory.h"
+#include "common/lang/vector.h"
 #include "common/sys/rc.h"
 #include "common/type/attr_type.h"
 
 class Stmt;
+class Table;
+class FieldMeta;
 class CalcStmt;
 class SelectStmt;
 class FilterStmt;
@@ -45,5 +48,11 @@ private:
 
   RC create_group_by_plan(SelectStmt *select_stmt, unique_ptr<LogicalOperator> &logical_operator);
 
+  /**
+   * @brief 找出查询中用到的某个表的所有字段
+   * @details 包括输出的表达式、过滤条件和分组表达式中的字段，用来判断能否只扫描索引
+   */
+  RC collect_referenced_fields(SelectStmt *select_stmt, const Table *table, vector<const FieldMeta *> &fields);
+
   int implicit_cast_cost(AttrType from, AttrType to);
 };
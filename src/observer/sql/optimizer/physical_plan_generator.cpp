@@ -12,6 +12,9 @@ See the Mulan PSL v2 for more details. */
 // Created by Wangyunlai on 2022/12/14.
 //
 
+#include "common/conf/ini.h"
+#include "common/lang/limits.h"
+#include "common/lang/string.h"
 #include "common/log/log.h"
 #include "sql/expr/expression.h"
 #include "session/session.h"
@@ -26,6 +29,7 @@ See the Mulan PSL v2 for more details. */
 #include "sql/operator/group_by_vec_physical_operator.h"
 #include "sql/operator/hash_join_physical_operator.h"
 #include "sql/operator/index_scan_physical_operator.h"
+#include "sql/operator/index_scan_vec_physical_operator.h"
 #include "sql/operator/insert_logical_operator.h"
 #include "sql/operator/insert_physical_operator.h"
 #include "sql/operator/join_logical_operator.h"
@@ -43,6 +47,8 @@ See the Mulan PSL v2 for more details. */
 #include "sql/operator/scalar_group_by_physical_operator.h"
 #include "sql/operator/table_scan_vec_physical_operator.h"
 #include "sql/optimizer/physical_plan_generator.h"
+#include "storage/index/index.h"
+#include "storage/table/table.h"
 
 using namespace std;
 
@@ -121,67 +127,303 @@ RC PhysicalPlanGenerator::create_vec(LogicalOperator &logical_operator, unique_p
 
 
 
-RC PhysicalPlanGenerator::create_plan(TableGetLogicalOperator &table_get_oper, unique_ptr<PhysicalOperator> &oper, Session* session)
+/**
+ * @brief 把等值条件中的值追加到索引的键值中
+ * @param pad 是否把字符串补齐到字段的长度。只有一个字段的索引，由索引扫描时补齐
+ * @return 值的类型与字段的类型不同，或者字符串比字段还长时，不能用来查找索引，返回false
+ */
+static bool append_key_value(const FieldMeta &field_meta, const Value &value, bool pad, string &key)
+{
+  if (value.attr_type() != field_meta.type()) {
+    return false;
+  }
+
+  if (!pad) {
+    key.append(value.data(), value.length());
+    return true;
+  }
+
+  if (value.length() > field_meta.len()) {
+    return false;
+  }
+  key.append(value.data(), value.length());
+  key.append(field_meta.len() - value.length(), '\0');
+  return true;
+}
+
+/**
+ * @brief 使用字段的最小值或最大值填充索引的键值
+ * @details 只有前面几个字段有等值条件时，后面的字段使用最小值和最大值作为扫描的范围
+ */
+static bool append_key_bound(const FieldMeta &field_meta, bool max_bound, string &key)
+{
+  switch (field_meta.type()) {
+    case AttrType::INTS: {
+      const int value = max_bound ? numeric_limits<int>::max() : numeric_limits<int>::min();
+      key.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    } break;
+    case AttrType::FLOATS: {
+      const float value = max_bound ? numeric_limits<float>::infinity() : -numeric_limits<float>::infinity();
+      key.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    } break;
+    case AttrType::CHARS: {
+      key.append(field_meta.len(), max_bound ? '\xff' : '\0');
+    } break;
+    default: {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief 表扫描选中的索引以及扫描的范围
+ */
+struct IndexScanChoice
+{
+  Index *index      = nullptr;
+  int    match_num  = 0;      ///< 从索引的第一个字段开始，有等值条件的字段个数
+  int    field_num  = 0;      ///< 索引的字段个数
+  bool   index_only = false;  ///< 索引是否包含了查询用到的所有字段
+  string left_key;
+  string right_key;
+};
+
+/**
+ * @brief 根据等值条件选择索引
+ * @details 没有可用的索引时，choice.index 是空指针
+ * @param order_field 不为空时，要求扫描的结果按照这个字段排序，只考虑这个字段前面的字段都有等值条件的B+树索引。
+ * 这时可以没有等值条件，扫描整个索引
+ */
+static void choose_index(TableGetLogicalOperator &table_get_oper, IndexScanChoice &choice,
+    const char *order_field = nullptr)
 {
   vector<unique_ptr<Expression>> &predicates = table_get_oper.predicates();
-  // 看看是否有可以用于索引查找的表达式
-  Table *table = table_get_oper.table();
+  Table                          *table      = table_get_oper.table();
 
-  Index     *index      = nullptr;
-  ValueExpr *value_expr = nullptr;
+  // 简单处理，就找等值查询
+  vector<pair<const char *, const Value *>> equal_values;
   for (auto &expr : predicates) {
-    if (expr->type() == ExprType::COMPARISON) {
-      auto comparison_expr = static_cast<ComparisonExpr *>(expr.get());
-      // 简单处理，就找等值查询
-      if (comparison_expr->comp() != EQUAL_TO) {
-        continue;
-      }
+    if (expr->type() != ExprType::COMPARISON) {
+      continue;
+    }
 
-      unique_ptr<Expression> &left_expr  = comparison_expr->left();
-      unique_ptr<Expression> &right_expr = comparison_expr->right();
-      // 左右比较的一边最少是一个值
-      if (left_expr->type() != ExprType::VALUE && right_expr->type() != ExprType::VALUE) {
-        continue;
+    auto comparison_expr = static_cast<ComparisonExpr *>(expr.get());
+    if (comparison_expr->comp() != EQUAL_TO) {
+      continue;
+    }
+
+    unique_ptr<Expression> &left_expr  = comparison_expr->left();
+    unique_ptr<Expression> &right_expr = comparison_expr->right();
+    if (left_expr->type() == ExprType::FIELD && right_expr->type() == ExprType::VALUE) {
+      equal_values.emplace_back(static_cast<FieldExpr *>(left_expr.get())->field_name(),
+          &static_cast<ValueExpr *>(right_expr.get())->get_value());
+    } else if (right_expr->type() == ExprType::FIELD && left_expr->type() == ExprType::VALUE) {
+      equal_values.emplace_back(static_cast<FieldExpr *>(right_expr.get())->field_name(),
+          &static_cast<ValueExpr *>(left_expr.get())->get_value());
+    }
+  }
+
+  auto find_equal_value = [&equal_values](const char *field_name) -> const Value * {
+    for (auto &[name, value] : equal_values) {
+      if (0 == strcmp(name, field_name)) {
+        return value;
+      }
+    }
+    return nullptr;
+  };
+
+  // 只读的查询，用到的字段都在索引中时，可以只扫描索引
+  const vector<const FieldMeta *> &referenced_fields = table_get_oper.referenced_fields();
+  auto is_covering_index = [&](Index *index) {
+    if (table_get_oper.read_write_mode() != ReadWriteMode::READ_ONLY || referenced_fields.empty()) {
+      return false;
+    }
+    for (const FieldMeta *field_meta : referenced_fields) {
+      if (!index->index_meta().contains_field(field_meta->name())) {
+        return false;
       }
+    }
+    return true;
+  };
+
+  // 索引的字段从第一个开始，有等值条件的越多越好。相同时优先使用覆盖了所有字段的索引，再相同时优先使用哈希索引。
+  // 哈希索引只能做等值查找，所有字段都有等值条件时才能使用
+  const TableMeta &table_meta = table->table_meta();
+  for (int i = 0; i < table_meta.index_num(); i++) {
+    Index *candidate = table->find_index(table_meta.index(i)->name());
+    if (nullptr == candidate || candidate->is_vector_index()) {
+      continue;
+    }
+
+    const vector<FieldMeta> &field_metas = candidate->field_metas();
+    const bool               pad         = field_metas.size() > 1;
 
-      FieldExpr *field_expr = nullptr;
-      if (left_expr->type() == ExprType::FIELD) {
-        ASSERT(right_expr->type() == ExprType::VALUE, "right expr should be a value expr while left is field expr");
-        field_expr = static_cast<FieldExpr *>(left_expr.get());
-        value_expr = static_cast<ValueExpr *>(right_expr.get());
-      } else if (right_expr->type() == ExprType::FIELD) {
-        ASSERT(left_expr->type() == ExprType::VALUE, "left expr should be a value expr while right is a field expr");
-        field_expr = static_cast<FieldExpr *>(right_expr.get());
-        value_expr = static_cast<ValueExpr *>(left_expr.get());
+    string key;
+    int    candidate_match_num = 0;
+    for (const FieldMeta &field_meta : field_metas) {
+      const Value *value = find_equal_value(field_meta.name());
+      if (nullptr == value || !append_key_value(field_meta, *value, pad, key)) {
+        break;
       }
+      candidate_match_num++;
+    }
 
-      if (field_expr == nullptr) {
+    const bool is_hash = candidate->index_meta().type() == IndexType::HASH;
+    if (order_field != nullptr) {
+      int order_pos = -1;
+      for (size_t j = 0; j < field_metas.size() && order_pos < 0; j++) {
+        if (0 == strcmp(field_metas[j].name(), order_field)) {
+          order_pos = static_cast<int>(j);
+        }
+      }
+      if (candidate->index_meta().type() != IndexType::BPLUS_TREE || order_pos < 0 || order_pos > candidate_match_num) {
         continue;
       }
+    } else if (candidate_match_num == 0 || (is_hash && candidate_match_num < static_cast<int>(field_metas.size()))) {
+      continue;
+    }
 
-      const Field &field = field_expr->field();
-      index              = table->find_index_by_field(field.field_name());
-      if (nullptr != index) {
-        break;
-      }
+    // 没有等值条件时扫描整个索引
+    string candidate_left_key  = key;
+    string candidate_right_key = key;
+    bool   bounded             = true;
+    for (size_t j = candidate_match_num; candidate_match_num > 0 && j < field_metas.size() && bounded; j++) {
+      bounded = append_key_bound(field_metas[j], false /*max_bound*/, candidate_left_key) &&
+                append_key_bound(field_metas[j], true /*max_bound*/, candidate_right_key);
+    }
+    if (!bounded) {
+      continue;
+    }
+
+    const bool covering    = is_covering_index(candidate);
+    const bool chosen_hash = choice.index != nullptr && choice.index->index_meta().type() == IndexType::HASH;
+    if (choice.index == nullptr || candidate_match_num > choice.match_num ||
+        (candidate_match_num == choice.match_num && covering && !choice.index_only) ||
+        (candidate_match_num == choice.match_num && covering == choice.index_only && is_hash && !chosen_hash)) {
+      choice.index      = candidate;
+      choice.match_num  = candidate_match_num;
+      choice.field_num  = static_cast<int>(field_metas.size());
+      choice.index_only = covering;
+      choice.left_key.swap(candidate_left_key);
+      choice.right_key.swap(candidate_right_key);
     }
   }
+}
+
+/**
+ * @brief 索引扫描读取记录的方式
+ * @details 只扫描索引时不读取记录。扫描范围只用到了索引的前几个字段时，范围可能比较大，使用bitmap模式
+ * 先读出所有的RID，整个扫描中每个页面只访问一次。否则按批读取记录，批大小是0时按照索引的顺序逐条读取
+ */
+static void choose_fetch_mode(const IndexScanChoice &choice, int &batch_size, bool &bitmap)
+{
+  int config_batch_size = 0;
+  int config_bitmap     = 0;
+  common::str_to_val(common::get_properties()->get("INDEX_SCAN_BATCH_SIZE", "256", "STORAGE"), config_batch_size);
+  common::str_to_val(common::get_properties()->get("INDEX_SCAN_BITMAP", "1", "STORAGE"), config_bitmap);
+
+  batch_size = 0;
+  bitmap     = false;
+  if (choice.index_only || config_batch_size <= 0) {
+    return;
+  }
 
-  if (index != nullptr) {
-    ASSERT(value_expr != nullptr, "got an index but value expr is null ?");
+  batch_size = config_batch_size;
+  bitmap     = config_bitmap != 0 && choice.match_num < choice.field_num;
+}
 
-    const Value               &value           = value_expr->get_value();
+/**
+ * @brief 判断是否只求同一个字段的最大值，或者只求同一个字段的最小值
+ * @param[out] field_name 字段名
+ * @param[out] max 求的是最大值还是最小值
+ */
+static bool is_single_min_max(const vector<Expression *> &aggregate_expressions, const char *&field_name, bool &max)
+{
+  field_name = nullptr;
+  for (Expression *expr : aggregate_expressions) {
+    if (expr->type() != ExprType::AGGREGATION) {
+      return false;
+    }
+
+    auto                     *aggregate_expr = static_cast<AggregateExpr *>(expr);
+    const AggregateExpr::Type type           = aggregate_expr->aggregate_type();
+    if ((type != AggregateExpr::Type::MAX && type != AggregateExpr::Type::MIN) ||
+        aggregate_expr->child()->type() != ExprType::FIELD) {
+      return false;
+    }
+
+    const char *name   = static_cast<FieldExpr *>(aggregate_expr->child().get())->field_name();
+    const bool  is_max = type == AggregateExpr::Type::MAX;
+    if (field_name == nullptr) {
+      field_name = name;
+      max        = is_max;
+    } else if (0 != strcmp(field_name, name) || max != is_max) {
+      return false;
+    }
+  }
+  return field_name != nullptr;
+}
+
+/**
+ * @brief 求最大值或最小值时，按照索引的顺序扫描，只返回第一条满足条件的记录
+ * @details 求最大值时反向扫描。没有按照这个字段排序的索引时，oper 是空的
+ */
+static void create_min_max_scan(
+    TableGetLogicalOperator &table_get_oper, const char *field_name, bool max, unique_ptr<PhysicalOperator> &oper)
+{
+  IndexScanChoice choice;
+  choose_index(table_get_oper, choice, field_name);
+  if (choice.index == nullptr) {
+    return;
+  }
+
+  auto index_scan_oper = make_unique<IndexScanPhysicalOperator>(table_get_oper.table(),
+      choice.index,
+      table_get_oper.read_write_mode(),
+      choice.left_key.empty() ? nullptr : choice.left_key.data(),
+      static_cast<int>(choice.left_key.size()),
+      true /*left_inclusive*/,
+      choice.right_key.empty() ? nullptr : choice.right_key.data(),
+      static_cast<int>(choice.right_key.size()),
+      true /*right_inclusive*/);
+  index_scan_oper->set_index_only(choice.index_only);
+  index_scan_oper->set_reverse(max);
+  index_scan_oper->set_limit(1);
+  index_scan_oper->set_predicates(std::move(table_get_oper.predicates()));
+  oper = std::move(index_scan_oper);
+  LOG_TRACE("use index scan for %s. index=%s, field=%s", max ? "max" : "min", choice.index->index_meta().name(), field_name);
+}
+
+RC PhysicalPlanGenerator::create_plan(TableGetLogicalOperator &table_get_oper, unique_ptr<PhysicalOperator> &oper, Session* session)
+{
+  vector<unique_ptr<Expression>> &predicates = table_get_oper.predicates();
+  Table                          *table      = table_get_oper.table();
+
+  IndexScanChoice choice;
+  choose_index(table_get_oper, choice);
+
+  if (choice.index != nullptr) {
     IndexScanPhysicalOperator *index_scan_oper = new IndexScanPhysicalOperator(table,
-        index,
+        choice.index,
         table_get_oper.read_write_mode(),
-        &value,
+        choice.left_key.data(),
+        static_cast<int>(choice.left_key.size()),
         true /*left_inclusive*/,
-        &value,
+        choice.right_key.data(),
+        static_cast<int>(choice.right_key.size()),
         true /*right_inclusive*/);
 
+    int  batch_size = 0;
+    bool bitmap     = false;
+    choose_fetch_mode(choice, batch_size, bitmap);
+
+    index_scan_oper->set_index_only(choice.index_only);
+    index_scan_oper->set_batch_fetch(batch_size, bitmap);
     index_scan_oper->set_predicates(std::move(predicates));
     oper = unique_ptr<PhysicalOperator>(index_scan_oper);
-    LOG_TRACE("use index scan");
+    LOG_TRACE("use index scan. index=%s, matched fields=%d, index only=%d, batch size=%d, bitmap=%d",
+              choice.index->index_meta().name(), choice.match_num, choice.index_only, batch_size, bitmap);
   } else {
     auto table_scan_oper = new TableScanPhysicalOperator(table, table_get_oper.read_write_mode());
     table_scan_oper->set_predicates(std::move(predicates));
@@ -348,6 +590,27 @@ RC PhysicalPlanGenerator::create_plan(GroupByLogicalOperator &logical_oper, uniq
   RC rc = RC::SUCCESS;
 
   vector<unique_ptr<Expression>> &group_by_expressions = logical_oper.group_by_expressions();
+
+  ASSERT(logical_oper.children().size() == 1, "group by operator should have 1 child");
+
+  // 没有分组，只求一个字段的最大值或者最小值时，按照索引的顺序扫描，第一条满足条件的记录就是结果
+  LogicalOperator             &child_oper = *logical_oper.children().front();
+  unique_ptr<PhysicalOperator> child_physical_oper;
+  const char                  *min_max_field = nullptr;
+  bool                         max           = false;
+  if (group_by_expressions.empty() && child_oper.type() == LogicalOperatorType::TABLE_GET &&
+      is_single_min_max(logical_oper.aggregate_expressions(), min_max_field, max)) {
+    create_min_max_scan(static_cast<TableGetLogicalOperator &>(child_oper), min_max_field, max, child_physical_oper);
+  }
+
+  if (!child_physical_oper) {
+    rc = create(child_oper, child_physical_oper, session);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to create child physical operator of group by operator. rc=%s", strrc(rc));
+      return rc;
+    }
+  }
+
   unique_ptr<GroupByPhysicalOperator> group_by_oper;
   if (group_by_expressions.empty()) {
     group_by_oper = make_unique<ScalarGroupByPhysicalOperator>(std::move(logical_oper.aggregate_expressions()));
@@ -356,16 +619,6 @@ RC PhysicalPlanGenerator::create_plan(GroupByLogicalOperator &logical_oper, uniq
         std::move(logical_oper.aggregate_expressions()));
   }
 
-  ASSERT(logical_oper.children().size() == 1, "group by operator should have 1 child");
-
-  LogicalOperator             &child_oper = *logical_oper.children().front();
-  unique_ptr<PhysicalOperator> child_physical_oper;
-  rc = create(child_oper, child_physical_oper, session);
-  if (OB_FAIL(rc)) {
-    LOG_WARN("failed to create child physical operator of group by operator. rc=%s", strrc(rc));
-    return rc;
-  }
-
   group_by_oper->add_child(std::move(child_physical_oper));
 
   oper = std::move(group_by_oper);
@@ -376,6 +629,34 @@ RC PhysicalPlanGenerator::create_vec_plan(TableGetLogicalOperator &table_get_ope
 {
   vector<unique_ptr<Expression>> &predicates = table_get_oper.predicates();
   Table *table = table_get_oper.table();
+
+  // 向量化执行时总是读取记录，每批RID的个数由 Chunk 的容量决定
+  IndexScanChoice choice;
+  choose_index(table_get_oper, choice);
+  if (choice.index != nullptr) {
+    choice.index_only = false;
+
+    int  batch_size = 0;
+    bool bitmap     = false;
+    choose_fetch_mode(choice, batch_size, bitmap);
+
+    auto index_scan_oper = new IndexScanVecPhysicalOperator(table,
+        choice.index,
+        table_get_oper.read_write_mode(),
+        choice.left_key.data(),
+        static_cast<int>(choice.left_key.size()),
+        true /*left_inclusive*/,
+        choice.right_key.data(),
+        static_cast<int>(choice.right_key.size()),
+        true /*right_inclusive*/);
+    index_scan_oper->set_bitmap(bitmap);
+    index_scan_oper->set_predicates(std::move(predicates));
+    oper = unique_ptr<PhysicalOperator>(index_scan_oper);
+    LOG_TRACE("use vectorized index scan. index=%s, matched fields=%d, bitmap=%d",
+              choice.index->index_meta().name(), choice.match_num, bitmap);
+    return RC::SUCCESS;
+  }
+
   TableScanVecPhysicalOperator *table_scan_oper = new TableScanVecPhysicalOperator(table, table_get_oper.read_write_mode());
   table_scan_oper->set_predicates(std::move(predicates));
   oper = unique_ptr<PhysicalOperator>(table_scan_oper);
@@ -16,6 +16,7 @@ See the Mulan PSL v2 for more details. */
 
 #include "common/lang/string.h"
 #include "common/lang/vector.h"
+#include "common/lang/map.h"
 #include "common/lang/memory.h"
 #include "common/value.h"
 #include "common/lang/utility.h"
@@ -185,13 +186,15 @@ struct AnalyzeTableSqlNode
  * @brief 描述一个create index语句
  * @ingroup SQLParser
  * @details 创建索引时，需要指定索引名，表名，字段名。
- * 正常的SQL语句中，一个索引可能包含了多个字段，这里仅支持一个字段。
+ * 一个索引可以包含多个字段，字段的顺序就是它们在索引键值中的顺序。
  */
 struct CreateIndexSqlNode
 {
-  string index_name;      ///< Index name
-  string relation_name;   ///< Relation name
-  string attribute_name;  ///< Attribute name
+  string              index_name;            ///< Index name
+  string              relation_name;         ///< Relation name
+  vector<string>      attribute_names;       ///< Attribute names
+  bool                vector_index = false;  ///< CREATE VECTOR INDEX
+  map<string, string> params;                ///< WITH (name=value, ...) 中的索引参数
 };
 
 /**
@@ -96,6 +96,7 @@ UnboundAggregateExpr *create_aggregate_expression(const char *aggregate_name,
         VALUES
         FROM
         WHERE
+        WITH
         AND
         SET
         ON
@@ -131,6 +132,8 @@ UnboundAggregateExpr *create_aggregate_expression(const char *aggregate_name,
   vector<RelAttrSqlNode> *                   rel_attr_list;
   vector<string> *                           relation_list;
   vector<string> *                           key_list;
+  pair<string, string> *                     index_param;
+  map<string, string> *                      index_param_list;
   char *                                     cstring;
   int                                        number;
   float                                      floats;
@@ -158,6 +161,8 @@ UnboundAggregateExpr *create_aggregate_expression(const char *aggregate_name,
 %type <cstring>             storage_format
 %type <key_list>            primary_key
 %type <key_list>            attr_list
+%type <index_param>         index_param
+%type <index_param_list>    index_param_list
 %type <relation_list>       rel_list
 %type <expression>          expression
 %type <expression_list>     expression_list
@@ -285,13 +290,63 @@ desc_table_stmt:
     ;
 
 create_index_stmt:    /*create index 语句的语法解析树*/
-    CREATE INDEX ID ON ID LBRACE ID RBRACE
+    CREATE INDEX ID ON ID LBRACE attr_list RBRACE
     {
       $$ = new ParsedSqlNode(SCF_CREATE_INDEX);
       CreateIndexSqlNode &create_index = $$->create_index;
       create_index.index_name = $3;
       create_index.relation_name = $5;
-      create_index.attribute_name = $7;
+      create_index.attribute_names.swap(*$7);
+      delete $7;
+    }
+    | CREATE INDEX ID ON ID LBRACE attr_list RBRACE WITH LBRACE index_param_list RBRACE
+    {
+      $$ = new ParsedSqlNode(SCF_CREATE_INDEX);
+      CreateIndexSqlNode &create_index = $$->create_index;
+      create_index.index_name = $3;
+      create_index.relation_name = $5;
+      create_index.attribute_names.swap(*$7);
+      create_index.params.swap(*$11);
+      delete $7;
+      delete $11;
+    }
+    | CREATE VECTOR_T INDEX ID ON ID LBRACE attr_list RBRACE WITH LBRACE index_param_list RBRACE
+    {
+      $$ = new ParsedSqlNode(SCF_CREATE_INDEX);
+      CreateIndexSqlNode &create_index = $$->create_index;
+      create_index.index_name = $4;
+      create_index.relation_name = $6;
+      create_index.attribute_names.swap(*$8);
+      create_index.vector_index = true;
+      create_index.params.swap(*$12);
+      delete $8;
+      delete $12;
+    }
+    ;
+
+index_param_list:
+    index_param
+    {
+      $$ = new map<string, string>;
+      $$->insert(std::move(*$1));
+      delete $1;
+    }
+    | index_param_list COMMA index_param
+    {
+      $$ = $1;
+      (*$$)[$3->first] = std::move($3->second);
+      delete $3;
+    }
+    ;
+
+index_param:
+    ID EQ ID
+    {
+      $$ = new pair<string, string>($1, $3);
+    }
+    | ID EQ NUMBER
+    {
+      $$ = new pair<string, string>($1, to_string($3));
     }
     ;
 
@@ -354,6 +409,10 @@ attr_def:
       $$->type = (AttrType)$2;
       $$->name = $1;
       $$->length = $4;
+      // 向量类型括号中是维度，每一维是一个 float
+      if ($$->type == AttrType::VECTORS) {
+        $$->length = $4 * sizeof(float);
+      }
     }
     | ID type
     {
@@ -13,6 +13,7 @@ See the Mulan PSL v2 for more details. */
 //
 
 #include "sql/stmt/create_index_stmt.h"
+#include "common/lang/algorithm.h"
 #include "common/lang/string.h"
 #include "common/log/log.h"
 #include "storage/db/db.h"
@@ -26,10 +27,9 @@ RC CreateIndexStmt::create(Db *db, const CreateIndexSqlNode &create_index, Stmt
   stmt = nullptr;
 
   const char *table_name = create_index.relation_name.c_str();
-  if (is_blank(table_name) || is_blank(create_index.index_name.c_str()) ||
-      is_blank(create_index.attribute_name.c_str())) {
-    LOG_WARN("invalid argument. db=%p, table_name=%p, index name=%s, attribute name=%s",
-        db, table_name, create_index.index_name.c_str(), create_index.attribute_name.c_str());
+  if (is_blank(table_name) || is_blank(create_index.index_name.c_str()) || create_index.attribute_names.empty()) {
+    LOG_WARN("invalid argument. db=%p, table_name=%p, index name=%s, attribute num=%d",
+        db, table_name, create_index.index_name.c_str(), static_cast<int>(create_index.attribute_names.size()));
     return RC::INVALID_ARGUMENT;
   }
 
@@ -40,11 +40,21 @@ RC CreateIndexStmt::create(Db *db, const CreateIndexSqlNode &create_index, Stmt
     return RC::SCHEMA_TABLE_NOT_EXIST;
   }
 
-  const FieldMeta *field_meta = table->table_meta().field(create_index.attribute_name.c_str());
-  if (nullptr == field_meta) {
-    LOG_WARN("no such field in table. db=%s, table=%s, field name=%s", 
-             db->name(), table_name, create_index.attribute_name.c_str());
-    return RC::SCHEMA_FIELD_NOT_EXIST;
+  vector<const FieldMeta *> field_metas;
+  for (const string &attribute_name : create_index.attribute_names) {
+    const FieldMeta *field_meta = table->table_meta().field(attribute_name.c_str());
+    if (nullptr == field_meta) {
+      LOG_WARN("no such field in table. db=%s, table=%s, field name=%s",
+               db->name(), table_name, attribute_name.c_str());
+      return RC::SCHEMA_FIELD_NOT_EXIST;
+    }
+
+    if (find(field_metas.begin(), field_metas.end(), field_meta) != field_metas.end()) {
+      LOG_WARN("duplicate field in index. db=%s, table=%s, field name=%s",
+               db->name(), table_name, attribute_name.c_str());
+      return RC::INVALID_ARGUMENT;
+    }
+    field_metas.push_back(field_meta);
   }
 
   Index *index = table->find_index(create_index.index_name.c_str());
@@ -53,6 +63,44 @@ RC CreateIndexStmt::create(Db *db, const CreateIndexSqlNode &create_index, Stmt
     return RC::SCHEMA_INDEX_NAME_REPEAT;
   }
 
-  stmt = new CreateIndexStmt(table, field_meta, create_index.index_name);
+  // 索引的类型通过参数 type 指定，其它参数由索引自己解释。参数的名字和值都不区分大小写。
+  // 向量索引默认是 ivfflat，普通索引默认是B+树，也可以是哈希索引
+  map<string, string> params;
+  for (const auto &[name, value] : create_index.params) {
+    string lower_name  = name;
+    string lower_value = value;
+    transform(lower_name.begin(), lower_name.end(), lower_name.begin(), ::tolower);
+    transform(lower_value.begin(), lower_value.end(), lower_value.begin(), ::tolower);
+    params[lower_name] = lower_value;
+  }
+
+  const char *default_type = create_index.vector_index ? "ivfflat" : "bplus_tree";
+  auto        type_iter    = params.find("type");
+  IndexType   index_type   = index_type_from_name(type_iter == params.end() ? default_type : type_iter->second.c_str());
+  if (type_iter != params.end()) {
+    params.erase(type_iter);
+  }
+
+  const bool is_vector_type = index_type == IndexType::IVFFLAT || index_type == IndexType::HNSW;
+  if (index_type == IndexType::UNKNOWN || is_vector_type != create_index.vector_index) {
+    LOG_WARN("invalid index type. db=%s, table=%s, index=%s, vector index=%d",
+             db->name(), table_name, create_index.index_name.c_str(), create_index.vector_index);
+    return RC::INVALID_ARGUMENT;
+  }
+  if (!create_index.vector_index && !params.empty()) {
+    LOG_WARN("unknown index params. db=%s, table=%s, index=%s, param=%s",
+             db->name(), table_name, create_index.index_name.c_str(), params.begin()->first.c_str());
+    return RC::INVALID_ARGUMENT;
+  }
+
+  IndexMeta index_meta;
+  RC        rc = index_meta.init(create_index.index_name.c_str(), field_metas, index_type, params);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to init index meta. db=%s, table=%s, index=%s, rc=%s",
+             db->name(), table_name, create_index.index_name.c_str(), strrc(rc));
+    return rc;
+  }
+
+  stmt = new CreateIndexStmt(table, field_metas, index_meta);
   return RC::SUCCESS;
 }
@@ -12,9 +12,12 @@ See the Mulan PSL v2 for more details. */
 // Created by Meiyi & Longda on 2021/4/13.
 //
 #include <errno.h>
+#include <limits.h>
 #include <string.h>
+#include <sys/uio.h>
 
 #include "common/io/io.h"
+#include "common/io/io_backend.h"
 #include "common/lang/mutex.h"
 #include "common/lang/algorithm.h"
 #include "common/log/log.h"
@@ -40,147 +43,304 @@ string BPFileHeader::to_string() const
 
 BPFrameManager::BPFrameManager(const char *name) : allocator_(name) {}
 
-RC BPFrameManager::init(int pool_num)
+RC BPFrameManager::init(int pool_num, int shard_num /* = DEFAULT_SHARD_NUM */)
 {
   int ret = allocator_.init(false, pool_num);
-  if (ret == 0) {
-    return RC::SUCCESS;
+  if (ret != 0) {
+    return RC::NOMEM;
   }
-  return RC::NOMEM;
+
+  shard_num = max(shard_num, 1);
+  shards_.clear();
+  for (int i = 0; i < shard_num; i++) {
+    shards_.push_back(make_unique<FrameShard>(allocator_));
+  }
+  return RC::SUCCESS;
 }
 
 RC BPFrameManager::cleanup()
 {
-  if (frames_.count() > 0) {
+  if (frame_num() > 0) {
     return RC::INTERNAL;
   }
 
-  frames_.destroy();
+  shards_.clear();
   return RC::SUCCESS;
 }
 
-int BPFrameManager::purge_frames(int count, function<RC(Frame *frame)> purger)
+BPFrameManager::FrameShard &BPFrameManager::shard(const FrameId &frame_id)
 {
-  lock_guard<mutex> lock_guard(lock_);
+  // 同一个文件中连续的页面会落在不同的分片上
+  size_t hash = frame_id.hash();
+  hash ^= hash >> 32;
+  return *shards_[hash % shards_.size()];
+}
 
-  vector<Frame *> frames_can_purge;
+int BPFrameManager::purge_frames(int count, function<RC(Frame *frame)> purger)
+{
   if (count <= 0) {
     count = 1;
   }
-  frames_can_purge.reserve(count);
 
-  auto purge_finder = [&frames_can_purge, count](const FrameId &frame_id, Frame *const frame) {
-    if (frame->can_purge()) {
-      frame->pin();
-      frames_can_purge.push_back(frame);
-      if (frames_can_purge.size() >= static_cast<size_t>(count)) {
-        return false;  // false to break the progress
-      }
-    }
-    return true;  // true continue to look up
-  };
+  const uint32_t start_shard = next_purge_shard_.fetch_add(1);
+  int            freed_count = 0;
+  for (size_t i = 0; i < shards_.size() && freed_count < count; i++) {
+    FrameShard &shard = *shards_[(start_shard + i) % shards_.size()];
+    freed_count += shard.purge(count - freed_count, purger);
+  }
+  LOG_DEBUG("purge frame done. number=%d", freed_count);
+  return freed_count;
+}
 
-  frames_.foreach_reverse(purge_finder);
-  LOG_INFO("purge frames find %ld pages total", frames_can_purge.size());
+int BPFrameManager::purge_clean_frames(int count, int shard_begin /* = -1 */, int shard_step /* = 1 */)
+{
+  vector<FrameShard *> shards;
+  if (shard_begin < 0) {
+    const uint32_t start_shard = next_purge_shard_.fetch_add(1);
+    for (size_t i = 0; i < shards_.size(); i++) {
+      shards.push_back(shards_[(start_shard + i) % shards_.size()].get());
+    }
+  } else {
+    for (size_t i = shard_begin; i < shards_.size(); i += shard_step) {
+      shards.push_back(shards_[i].get());
+    }
+  }
 
-  /// 当前还在frameManager的锁内，而 purger 是一个非常耗时的操作
-  /// 他需要把脏页数据刷新到磁盘上去，所以这里会极大地降低并发度
   int freed_count = 0;
-  for (Frame *frame : frames_can_purge) {
-    RC rc = purger(frame);
-    if (RC::SUCCESS == rc) {
-      free_internal(frame->frame_id(), frame);
-      freed_count++;
-    } else {
-      frame->unpin();
-      LOG_WARN("failed to purge frame. frame_id=%s, rc=%s", 
-               frame->frame_id().to_string().c_str(), strrc(rc));
-    }
+  for (size_t i = 0; i < shards.size() && freed_count < count; i++) {
+    freed_count += shards[i]->purge(count - freed_count, nullptr, true /*clean_only*/);
   }
-  LOG_INFO("purge frame done. number=%d", freed_count);
   return freed_count;
 }
 
+void BPFrameManager::collect_dirty_frames(
+    int max_count, vector<Frame *> &frames, int shard_begin /* = 0 */, int shard_step /* = 1 */)
+{
+  for (size_t i = shard_begin; i < shards_.size() && static_cast<int>(frames.size()) < max_count; i += shard_step) {
+    shards_[i]->collect_dirty(max_count - static_cast<int>(frames.size()), frames);
+  }
+}
+
 Frame *BPFrameManager::get(int buffer_pool_id, PageNum page_num)
 {
-  FrameId                     frame_id(buffer_pool_id, page_num);
+  FrameId frame_id(buffer_pool_id, page_num);
+  return shard(frame_id).get(frame_id);
+}
+
+bool BPFrameManager::contains(int buffer_pool_id, PageNum page_num)
+{
+  FrameId frame_id(buffer_pool_id, page_num);
+  return shard(frame_id).contains(frame_id);
+}
+
+Frame *BPFrameManager::alloc(int buffer_pool_id, PageNum page_num, bool write_latched /* = false */)
+{
+  FrameId frame_id(buffer_pool_id, page_num);
+  return shard(frame_id).alloc(frame_id, write_latched);
+}
 
+RC BPFrameManager::free(int buffer_pool_id, PageNum page_num, Frame *frame)
+{
+  FrameId frame_id(buffer_pool_id, page_num);
+  return shard(frame_id).free(frame_id, frame);
+}
+
+list<Frame *> BPFrameManager::find_list(int buffer_pool_id)
+{
+  list<Frame *> frames;
+  for (auto &shard : shards_) {
+    shard->find_list(buffer_pool_id, frames);
+  }
+  return frames;
+}
+
+size_t BPFrameManager::frame_num() const
+{
+  size_t num = 0;
+  for (auto &shard : shards_) {
+    num += shard->frame_num();
+  }
+  return num;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Frame *BPFrameManager::FrameShard::get(const FrameId &frame_id)
+{
   lock_guard<mutex> lock_guard(lock_);
   return get_internal(frame_id);
 }
 
-Frame *BPFrameManager::get_internal(const FrameId &frame_id)
+bool BPFrameManager::FrameShard::contains(const FrameId &frame_id)
 {
-  Frame *frame = nullptr;
-  (void)frames_.get(frame_id, frame);
-  if (frame != nullptr) {
-    frame->pin();
-    LOG_DEBUG("got a frame. frame=%s", frame->to_string().c_str());
+  lock_guard<mutex> lock_guard(lock_);
+  return slot_index_.find(frame_id) != slot_index_.end();
+}
+
+Frame *BPFrameManager::FrameShard::get_internal(const FrameId &frame_id)
+{
+  auto iter = slot_index_.find(frame_id);
+  if (iter == slot_index_.end()) {
+    return nullptr;
   }
+
+  ClockSlot &slot = slots_[iter->second];
+  slot.referenced = true;
+
+  Frame *frame = slot.frame;
+  frame->pin();
+  LOG_DEBUG("got a frame. frame=%s", frame->to_string().c_str());
   return frame;
 }
 
-Frame *BPFrameManager::alloc(int buffer_pool_id, PageNum page_num)
+Frame *BPFrameManager::FrameShard::alloc(const FrameId &frame_id, bool write_latched)
 {
-  FrameId frame_id(buffer_pool_id, page_num);
-
   lock_guard<mutex> lock_guard(lock_);
 
-  Frame                      *frame = get_internal(frame_id);
+  Frame *frame = get_internal(frame_id);
   if (frame != nullptr) {
     return frame;
   }
 
   frame = allocator_.alloc();
-  if (frame != nullptr) {
-    ASSERT(frame->pin_count() == 0, "got an invalid frame that pin count is not 0. frame=%s", 
-           frame->to_string().c_str());
-    frame->set_buffer_pool_id(buffer_pool_id);
-    frame->set_page_num(page_num);
-    frame->pin();
-    frames_.put(frame_id, frame);
-    LOG_DEBUG("allocate a new frame. frame=%s", frame->to_string().c_str());
+  if (frame == nullptr) {
+    return nullptr;
+  }
+
+  ASSERT(frame->pin_count() == 0, "got an invalid frame that pin count is not 0. frame=%s", 
+         frame->to_string().c_str());
+  frame->set_buffer_pool_id(frame_id.buffer_pool_id());
+  frame->set_page_num(frame_id.page_num());
+  frame->pin();
+  if (write_latched) {
+    // 页帧还没有放到映射表中，其它线程拿不到，这里加锁不会阻塞
+    frame->write_latch();
+  }
+
+  int slot_index = 0;
+  if (!free_slots_.empty()) {
+    slot_index = free_slots_.back();
+    free_slots_.pop_back();
+  } else {
+    slot_index = static_cast<int>(slots_.size());
+    slots_.emplace_back();
   }
+  slots_[slot_index] = ClockSlot{frame, false /*referenced*/};
+  slot_index_.emplace(frame_id, slot_index);
+
+  LOG_DEBUG("allocate a new frame. frame=%s", frame->to_string().c_str());
   return frame;
 }
 
-RC BPFrameManager::free(int buffer_pool_id, PageNum page_num, Frame *frame)
+RC BPFrameManager::FrameShard::free(const FrameId &frame_id, Frame *frame)
 {
-  FrameId frame_id(buffer_pool_id, page_num);
-
   lock_guard<mutex> lock_guard(lock_);
   return free_internal(frame_id, frame);
 }
 
-RC BPFrameManager::free_internal(const FrameId &frame_id, Frame *frame)
+RC BPFrameManager::FrameShard::free_internal(const FrameId &frame_id, Frame *frame)
 {
-  Frame                *frame_source = nullptr;
-  [[maybe_unused]] bool found        = frames_.get(frame_id, frame_source);
+  auto                  iter         = slot_index_.find(frame_id);
+  [[maybe_unused]] bool found        = iter != slot_index_.end();
+  Frame                *frame_source = found ? slots_[iter->second].frame : nullptr;
   ASSERT(found && frame == frame_source && frame->pin_count() == 1,
       "failed to free frame. found=%d, frameId=%s, frame_source=%p, frame=%p, pinCount=%d, lbt=%s",
       found, frame_id.to_string().c_str(), frame_source, frame, frame->pin_count(), lbt());
 
   frame->set_page_num(-1);
   frame->unpin();
-  frames_.remove(frame_id);
+
+  slots_[iter->second] = ClockSlot();
+  free_slots_.push_back(iter->second);
+  slot_index_.erase(iter);
+
   allocator_.free(frame);
   return RC::SUCCESS;
 }
 
-list<Frame *> BPFrameManager::find_list(int buffer_pool_id)
+int BPFrameManager::FrameShard::purge(int count, function<RC(Frame *frame)> purger, bool clean_only /* = false */)
 {
   lock_guard<mutex> lock_guard(lock_);
 
-  list<Frame *> frames;
-  auto               fetcher = [&frames, buffer_pool_id](const FrameId &frame_id, Frame *const frame) -> bool {
+  vector<Frame *> frames_can_purge;
+  frames_can_purge.reserve(count);
+
+  // 访问过的页面第一次遇到时只清除访问标记，所以最多转两圈
+  const size_t slot_num = slots_.size();
+  for (size_t step = 0; step < slot_num * 2 && frames_can_purge.size() < static_cast<size_t>(count); step++) {
+    ClockSlot &slot = slots_[hand_];
+    hand_           = (hand_ + 1) % slot_num;
+
+    if (slot.frame == nullptr || !slot.frame->can_purge()) {
+      continue;
+    }
+
+    if (slot.referenced) {
+      slot.referenced = false;
+      continue;
+    }
+
+    // 没有被pin住的页面不会有人修改，可以直接检查是否为脏页
+    if (clean_only && slot.frame->dirty()) {
+      continue;
+    }
+
+    slot.frame->pin();
+    frames_can_purge.push_back(slot.frame);
+  }
+
+  /// 当前还在分片的锁内，而 purger 是一个非常耗时的操作
+  /// 他需要把脏页数据刷新到磁盘上去，不过只会影响当前分片的页面
+  int freed_count = 0;
+  for (Frame *frame : frames_can_purge) {
+    RC rc = clean_only ? RC::SUCCESS : purger(frame);
+    if (RC::SUCCESS == rc) {
+      free_internal(frame->frame_id(), frame);
+      freed_count++;
+    } else {
+      frame->unpin();
+      LOG_WARN("failed to purge frame. frame_id=%s, rc=%s", 
+               frame->frame_id().to_string().c_str(), strrc(rc));
+    }
+  }
+  return freed_count;
+}
+
+void BPFrameManager::FrameShard::collect_dirty(int max_count, vector<Frame *> &frames)
+{
+  lock_guard<mutex> lock_guard(lock_);
+
+  // 从CLOCK指针的位置开始找，这些页面最先被淘汰。不修改指针和访问标记
+  const size_t slot_num = slots_.size();
+  int          count    = 0;
+  for (size_t step = 0; step < slot_num && count < max_count; step++) {
+    ClockSlot &slot = slots_[(hand_ + step) % slot_num];
+    if (slot.frame == nullptr || slot.referenced || !slot.frame->can_purge() || !slot.frame->dirty()) {
+      continue;
+    }
+
+    slot.frame->pin();
+    frames.push_back(slot.frame);
+    count++;
+  }
+}
+
+void BPFrameManager::FrameShard::find_list(int buffer_pool_id, list<Frame *> &frames)
+{
+  lock_guard<mutex> lock_guard(lock_);
+  for (const auto &[frame_id, slot_index] : slot_index_) {
     if (buffer_pool_id == frame_id.buffer_pool_id()) {
+      Frame *frame = slots_[slot_index].frame;
       frame->pin();
       frames.push_back(frame);
     }
-    return true;
-  };
-  frames_.foreach (fetcher);
-  return frames;
+  }
+}
+
+size_t BPFrameManager::FrameShard::frame_num()
+{
+  lock_guard<mutex> lock_guard(lock_);
+  return slot_index_.size();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -239,7 +399,7 @@ RC DiskBufferPool::open_file(const char *file_name)
   file_desc_ = fd;
 
   Page header_page;
-  int ret = readn(file_desc_, &header_page, sizeof(header_page));
+  int ret = preadn(file_desc_, &header_page, sizeof(header_page), 0);
   if (ret != 0) {
     LOG_ERROR("Failed to read first page of %s, due to %s.", file_name, strerror(errno));
     close(fd);
@@ -283,6 +443,9 @@ RC DiskBufferPool::close_file()
     return rc;
   }
 
+  // 页面清理线程可能pin住了当前文件的页面
+  unique_lock<shared_mutex> cleaner_guard(bp_manager_.page_cleaner().close_lock());
+
   hdr_frame_->unpin();
 
   // TODO: 理论上是在回放时回滚未提交事务，但目前没有undo log，因此不下刷数据page，只通过redo log回放
@@ -306,6 +469,7 @@ RC DiskBufferPool::close_file()
   }
   LOG_INFO("Successfully close file %d:%s.", file_desc_, file_name_.c_str());
   file_desc_ = -1;
+  cleaner_guard.unlock();
 
   bp_manager_.close_file(file_name_.c_str());
   return RC::SUCCESS;
@@ -325,10 +489,19 @@ RC DiskBufferPool::get_this_page(PageNum page_num, Frame **frame)
 
   scoped_lock lock_guard(lock_);  // 直接加了一把大锁，其实可以根据访问的页面来细化提高并行度
 
+  // 等锁的时候，其它线程可能已经把这个页面加载进来了。不能再从磁盘加载一次，否则会覆盖内存中的修改
+  used_match_frame = frame_manager_.get(id(), page_num);
+  if (used_match_frame != nullptr) {
+    used_match_frame->access();
+    *frame = used_match_frame;
+    return RC::SUCCESS;
+  }
+
   // Allocate one page and load the data into this page
+  // 页帧在加载完成之前一直持有写锁，其它线程通过 frame_manager_ 拿到这个页帧后，需要等待加载完成才能访问
   Frame *allocated_frame = nullptr;
 
-  rc = allocate_frame(page_num, &allocated_frame);
+  rc = allocate_frame(page_num, &allocated_frame, true /*write_latched*/);
   if (rc != RC::SUCCESS) {
     LOG_ERROR("Failed to alloc frame %s:%d, due to failed to alloc page.", file_name_.c_str(), page_num);
     return rc;
@@ -338,7 +511,9 @@ RC DiskBufferPool::get_this_page(PageNum page_num, Frame **frame)
   // allocated_frame->pin(); // pined in manager::get
   allocated_frame->access();
 
-  if ((rc = load_page(page_num, allocated_frame)) != RC::SUCCESS) {
+  rc = load_page(page_num, allocated_frame);
+  allocated_frame->write_unlatch();
+  if (OB_FAIL(rc)) {
     LOG_ERROR("Failed to load page %s:%d", file_name_.c_str(), page_num);
     purge_frame(page_num, allocated_frame);
     return rc;
@@ -348,6 +523,144 @@ RC DiskBufferPool::get_this_page(PageNum page_num, Frame **frame)
   return RC::SUCCESS;
 }
 
+RC DiskBufferPool::read_ahead(PageNum start_page, int max_count, PageNum &end_page)
+{
+  // 不能让预读把缓冲池中其它的页面都挤出去
+  max_count = min(max_count, static_cast<int>(frame_manager_.total_frame_num() / 4));
+  end_page  = start_page;
+  if (max_count <= 0) {
+    return RC::SUCCESS;
+  }
+
+  scoped_lock lock_guard(lock_);
+
+  common::Bitmap bitmap(file_header_->bitmap, file_header_->page_count);
+
+  vector<PageNum> page_nums;
+  PageNum         page_num = max(start_page, 0);
+  for (int i = 0; i < max_count; i++, page_num++) {
+    page_num = bitmap.next_setted_bit(page_num);
+    if (page_num < 0) {
+      end_page = file_header_->page_count;
+      break;
+    }
+    end_page = page_num + 1;
+    page_nums.push_back(page_num);
+  }
+
+  RC rc = load_pages(page_nums);
+  LOG_TRACE("read ahead done. file=%s, start page=%d, end page=%d, rc=%s",
+            file_name_.c_str(), start_page, end_page, strrc(rc));
+  return rc;
+}
+
+RC DiskBufferPool::prefetch_pages(span<const PageNum> page_nums)
+{
+  const size_t max_count = frame_manager_.total_frame_num() / 4;
+  if (page_nums.size() > max_count) {
+    page_nums = page_nums.first(max_count);
+  }
+  if (page_nums.empty()) {
+    return RC::SUCCESS;
+  }
+
+  scoped_lock lock_guard(lock_);
+
+  // 调用者拿到页号以后页面可能已经被释放了，只读取还在使用的页面
+  common::Bitmap  bitmap(file_header_->bitmap, file_header_->page_count);
+  vector<PageNum> valid_page_nums;
+  for (PageNum page_num : page_nums) {
+    if (page_num >= 0 && page_num < file_header_->page_count && bitmap.get_bit(page_num)) {
+      valid_page_nums.push_back(page_num);
+    }
+  }
+
+  return load_pages(valid_page_nums);
+}
+
+RC DiskBufferPool::load_pages(span<const PageNum> page_nums)
+{
+  vector<Frame *> frames;
+  for (PageNum page_num : page_nums) {
+    if (frame_manager_.contains(id(), page_num)) {
+      continue;
+    }
+
+    Frame *frame = nullptr;
+    RC     rc    = allocate_frame(page_num, &frame, true /*write_latched*/);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to allocate frame for read ahead. file=%s, page=%d, rc=%s", file_name_.c_str(), page_num, strrc(rc));
+      break;
+    }
+    frame->set_buffer_pool_id(id());
+
+    // double write buffer 中的页面比磁盘上的新
+    if (OB_SUCC(dblwr_manager_.read_page(this, page_num, frame->page()))) {
+      frame->write_unlatch();
+      frame->unpin();
+      continue;
+    }
+    frames.push_back(frame);
+  }
+
+  if (frames.empty()) {
+    return RC::SUCCESS;
+  }
+
+  // 页号连续的页面合并成一个读请求
+  vector<struct iovec>      iovs(frames.size());
+  vector<common::IoRequest> requests;
+  vector<size_t>            request_begins;
+  for (size_t begin = 0; begin < frames.size();) {
+    const PageNum begin_page_num = frames[begin]->page_num();
+
+    size_t end = begin;
+    while (end < frames.size() && end - begin < static_cast<size_t>(IOV_MAX) &&
+           frames[end]->page_num() == begin_page_num + static_cast<PageNum>(end - begin)) {
+      iovs[end] = iovec{&frames[end]->page(), BP_PAGE_SIZE};
+      end++;
+    }
+
+    common::IoRequest request;
+    request.type   = common::IoRequest::Type::READ;
+    request.fd     = file_desc_;
+    request.iov    = &iovs[begin];
+    request.iovcnt = static_cast<int>(end - begin);
+    request.offset = static_cast<int64_t>(begin_page_num) * BP_PAGE_SIZE;
+    requests.push_back(request);
+    request_begins.push_back(begin);
+    begin = end;
+  }
+
+  common::IoBackend::instance().submit_and_wait(requests.data(), static_cast<int>(requests.size()));
+
+  RC rc = RC::SUCCESS;
+  for (size_t i = 0; i < requests.size(); i++) {
+    const size_t begin = request_begins[i];
+    const size_t end   = (i + 1 < requests.size()) ? request_begins[i + 1] : frames.size();
+    const bool   ok    = requests[i].result == 0;
+    if (!ok) {
+      LOG_WARN("failed to read ahead pages. file=%s, page=%d, count=%d, ret=%d",
+               file_name_.c_str(), frames[begin]->page_num(), static_cast<int>(end - begin), requests[i].result);
+      rc = RC::IOERR_READ;
+    }
+
+    for (size_t j = begin; j < end; j++) {
+      Frame *frame = frames[j];
+      frame->write_unlatch();
+      if (ok) {
+        frame->unpin();
+      } else {
+        purge_frame(frame->page_num(), frame);
+      }
+    }
+  }
+
+  LOG_TRACE("load pages done. file=%s, loaded pages=%d, requests=%d",
+            file_name_.c_str(), static_cast<int>(frames.size()), static_cast<int>(requests.size()));
+  return rc;
+}
+
 RC DiskBufferPool::allocate_page(Frame **frame)
 {
   RC rc = RC::SUCCESS;
@@ -580,6 +893,70 @@ RC DiskBufferPool::flush_all_pages()
   return RC::SUCCESS;
 }
 
+RC DiskBufferPool::collect_dirty_pages(vector<pair<PageNum, LSN>> &dirty_pages)
+{
+  // 先拿到页号再逐个加锁检查，避免长时间pin住所有页面导致其它线程无法淘汰页面
+  vector<PageNum> page_nums;
+  for (Frame *frame : frame_manager_.find_list(id())) {
+    page_nums.push_back(frame->page_num());
+    frame->unpin();
+  }
+
+  for (PageNum page_num : page_nums) {
+    Frame *frame = frame_manager_.get(id(), page_num);
+    if (frame == nullptr) {
+      continue;
+    }
+
+    bool dirty   = false;
+    LSN  rec_lsn = 0;
+    if (frame == hdr_frame_) {
+      // 文件头页面的修改都是在 lock_ 保护下进行的
+      scoped_lock lock_guard(lock_);
+      dirty   = frame->dirty();
+      rec_lsn = frame->rec_lsn();
+    } else {
+      frame->read_latch();
+      dirty   = frame->dirty();
+      rec_lsn = frame->rec_lsn();
+      frame->read_unlatch();
+    }
+    frame->unpin();
+
+    if (dirty) {
+      dirty_pages.emplace_back(page_num, rec_lsn);
+    }
+  }
+  return RC::SUCCESS;
+}
+
+RC DiskBufferPool::flush_dirty_page(PageNum page_num)
+{
+  Frame *frame = frame_manager_.get(id(), page_num);
+  if (frame == nullptr) {
+    return RC::SUCCESS;
+  }
+
+  RC rc = flush_dirty_frame(*frame);
+  frame->unpin();
+  return rc;
+}
+
+RC DiskBufferPool::flush_dirty_frame(Frame &frame)
+{
+  RC rc = RC::SUCCESS;
+  if (&frame == hdr_frame_) {
+    rc = flush_page(frame);
+  } else {
+    frame.read_latch();
+    if (frame.dirty()) {
+      rc = flush_page(frame);
+    }
+    frame.read_unlatch();
+  }
+  return rc;
+}
+
 RC DiskBufferPool::recover_page(PageNum page_num)
 {
   int byte = 0, bit = 0;
@@ -596,17 +973,57 @@ RC DiskBufferPool::recover_page(PageNum page_num)
   return RC::SUCCESS;
 }
 
-RC DiskBufferPool::write_page(PageNum page_num, Page &page)
+RC DiskBufferPool::write_pages(vector<pair<PageNum, Page *>> &pages)
 {
-  scoped_lock lock_guard(wr_lock_);
-  int64_t     offset = ((int64_t)page_num) * sizeof(Page);
-  if (lseek(file_desc_, offset, SEEK_SET) == -1) {
-    LOG_ERROR("Failed to write page %lld of %d due to failed to seek %s.", offset, file_desc_, strerror(errno));
-    return RC::IOERR_SEEK;
+  sort(pages.begin(), pages.end(), [](const pair<PageNum, Page *> &a, const pair<PageNum, Page *> &b) {
+    return a.first < b.first;
+  });
+
+  // 连续的页面合并成一个请求，所有请求一起提交给IO后端
+  vector<struct iovec>      iovs(pages.size());
+  vector<common::IoRequest> requests;
+  for (size_t begin = 0; begin < pages.size();) {
+    const PageNum begin_page_num = pages[begin].first;
+
+    size_t end = begin;
+    while (end < pages.size() && end - begin < static_cast<size_t>(IOV_MAX) &&
+           pages[end].first == begin_page_num + static_cast<PageNum>(end - begin)) {
+      iovs[end] = iovec{pages[end].second, sizeof(Page)};
+      end++;
+    }
+
+    common::IoRequest request;
+    request.type   = common::IoRequest::Type::WRITE;
+    request.fd     = file_desc_;
+    request.iov    = &iovs[begin];
+    request.iovcnt = static_cast<int>(end - begin);
+    request.offset = static_cast<int64_t>(begin_page_num) * sizeof(Page);
+    requests.push_back(request);
+    begin = end;
+  }
+
+  common::IoBackend::instance().submit_and_wait(requests.data(), static_cast<int>(requests.size()));
+
+  RC rc = RC::SUCCESS;
+  for (const common::IoRequest &request : requests) {
+    if (request.result != 0) {
+      LOG_ERROR("Failed to write pages %lld of %d due to %s.", request.offset, file_desc_, strerror(request.result));
+      rc = RC::IOERR_WRITE;
+    }
   }
 
-  if (writen(file_desc_, &page, sizeof(Page)) != 0) {
-    LOG_ERROR("Failed to write page %lld of %d due to %s.", offset, file_desc_, strerror(errno));
+  LOG_TRACE("write_pages: buffer_pool_id:%d, page count=%d, request count=%d",
+            id(), static_cast<int>(pages.size()), static_cast<int>(requests.size()));
+  return rc;
+}
+
+RC DiskBufferPool::write_page(PageNum page_num, Page &page)
+{
+  // 按照位置写入，不需要移动文件偏移量，写不同页面时不用互斥
+  int64_t offset = ((int64_t)page_num) * sizeof(Page);
+  int     ret    = common::IoBackend::instance().write(file_desc_, &page, sizeof(Page), offset);
+  if (ret != 0) {
+    LOG_ERROR("Failed to write page %lld of %d due to %s.", offset, file_desc_, strerror(ret));
     return RC::IOERR_WRITE;
   }
 
@@ -614,6 +1031,32 @@ RC DiskBufferPool::write_page(PageNum page_num, Page &page)
   return RC::SUCCESS;
 }
 
+RC DiskBufferPool::sync_file()
+{
+  int ret = common::IoBackend::instance().sync(file_desc_, true /*data_only*/);
+  if (ret != 0) {
+    LOG_ERROR("Failed to sync file %s due to %s.", file_name_.c_str(), strerror(ret));
+    return RC::IOERR_SYNC;
+  }
+  return RC::SUCCESS;
+}
+
+RC DiskBufferPool::force_all_pages()
+{
+  RC rc = flush_all_pages();
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  rc = dblwr_manager_.flush_page();
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to flush double write buffer. file=%s, rc=%s", file_name_.c_str(), strrc(rc));
+    return rc;
+  }
+
+  return sync_file();
+}
+
 RC DiskBufferPool::redo_allocate_page(LSN lsn, PageNum page_num)
 {
   if (hdr_frame_->lsn() >= lsn) {
@@ -685,7 +1128,7 @@ RC DiskBufferPool::redo_deallocate_page(LSN lsn, PageNum page_num)
   return RC::SUCCESS;
 }
 
-RC DiskBufferPool::allocate_frame(PageNum page_num, Frame **buffer)
+RC DiskBufferPool::allocate_frame(PageNum page_num, Frame **buffer, bool write_latched /* = false */)
 {
   auto purger = [this](Frame *frame) {
     if (!frame->dirty()) {
@@ -705,8 +1148,9 @@ RC DiskBufferPool::allocate_frame(PageNum page_num, Frame **buffer)
     return rc;
   };
 
+  PageCleaner &page_cleaner = bp_manager_.page_cleaner();
   while (true) {
-    Frame *frame = frame_manager_.alloc(id(), page_num);
+    Frame *frame = frame_manager_.alloc(id(), page_num, write_latched);
     if (frame != nullptr) {
       *buffer = frame;
       LOG_DEBUG("allocate frame %p, page num %d, frame=%s", frame, page_num, frame->to_string().c_str());
@@ -714,6 +1158,15 @@ RC DiskBufferPool::allocate_frame(PageNum page_num, Frame **buffer)
     }
 
     LOG_TRACE("frames are all allocated, so we should purge some frames to get one free frame");
+    page_cleaner.stat().foreground_purges++;
+    page_cleaner.wakeup();
+
+    // 优先淘汰干净的页面，不需要等待写磁盘
+    if (frame_manager_.purge_clean_frames(1 /*count*/) > 0) {
+      continue;
+    }
+
+    page_cleaner.stat().foreground_stalls++;
     (void)frame_manager_.purge_frames(1 /*count*/, purger);
   }
   return RC::BUFFERPOOL_NOBUF;
@@ -740,18 +1193,12 @@ RC DiskBufferPool::load_page(PageNum page_num, Frame *frame)
     return rc;
   }
 
-  scoped_lock lock_guard(wr_lock_);
-  int64_t          offset = ((int64_t)page_num) * BP_PAGE_SIZE;
-  if (lseek(file_desc_, offset, SEEK_SET) == -1) {
-    LOG_ERROR("Failed to load page %s:%d, due to failed to lseek:%s.", file_name_.c_str(), page_num, strerror(errno));
-
-    return RC::IOERR_SEEK;
-  }
-
-  int ret = readn(file_desc_, &page, BP_PAGE_SIZE);
+  // 按照位置读取，不需要移动文件偏移量，多个线程可以同时读取同一个文件的不同页面
+  int64_t offset = ((int64_t)page_num) * BP_PAGE_SIZE;
+  int     ret    = common::IoBackend::instance().read(file_desc_, &page, BP_PAGE_SIZE, offset);
   if (ret != 0) {
     LOG_ERROR("Failed to load page %s, file_desc:%d, page num:%d, due to failed to read data:%s, ret=%d, page count=%d",
-              file_name_.c_str(), file_desc_, page_num, strerror(errno), ret, file_header_->allocated_pages);
+              file_name_.c_str(), file_desc_, page_num, ret > 0 ? strerror(ret) : "end of file", ret, file_header_->allocated_pages);
     return RC::IOERR_READ;
   }
 
@@ -778,6 +1225,8 @@ BufferPoolManager::BufferPoolManager(int memory_size /* = 0 */)
 
 BufferPoolManager::~BufferPoolManager()
 {
+  page_cleaner_.stop();
+
   unordered_map<string, DiskBufferPool *> tmp_bps;
   tmp_bps.swap(buffer_pools_);
 
@@ -821,13 +1270,7 @@ RC BufferPoolManager::create_file(const char *file_name)
 
   char *bitmap = file_header->bitmap;
   bitmap[0] |= 0x01;
-  if (lseek(fd, 0, SEEK_SET) == -1) {
-    LOG_ERROR("Failed to seek file %s to position 0, due to %s .", file_name, strerror(errno));
-    close(fd);
-    return RC::IOERR_SEEK;
-  }
-
-  if (writen(fd, (char *)&page, BP_PAGE_SIZE) != 0) {
+  if (pwriten(fd, (char *)&page, BP_PAGE_SIZE, 0) != 0) {
     LOG_ERROR("Failed to write header to file %s, due to %s.", file_name, strerror(errno));
     close(fd);
     return RC::IOERR_WRITE;
@@ -880,13 +1323,17 @@ RC BufferPoolManager::close_file(const char *_file_name)
     return RC::INTERNAL;
   }
 
-  id_to_buffer_pools_.erase(iter->second->id());
-
   DiskBufferPool *bp = iter->second;
   buffer_pools_.erase(iter);
   lock_.unlock();
 
+  // 关闭文件时淘汰的脏页可能写满 double write buffer，写回数据文件时还需要按照 id 找到这个 buffer pool
+  const int32_t buffer_pool_id = bp->id();
   delete bp;
+
+  lock_.lock();
+  id_to_buffer_pools_.erase(buffer_pool_id);
+  lock_.unlock();
   return RC::SUCCESS;
 }
 
@@ -894,17 +1341,71 @@ RC BufferPoolManager::flush_page(Frame &frame)
 {
   int buffer_pool_id = frame.buffer_pool_id();
 
-  scoped_lock lock_guard(lock_);
-  auto             iter = id_to_buffer_pools_.find(buffer_pool_id);
-  if (iter == id_to_buffer_pools_.end()) {
-    LOG_WARN("unknown buffer pool of id %d", buffer_pool_id);
-    return RC::INTERNAL;
+  // 刷页面时不能持有 lock_：写 double write buffer 时可能需要反过来获取 lock_ 查找 buffer pool
+  DiskBufferPool *bp = nullptr;
+  RC              rc = get_buffer_pool(buffer_pool_id, bp);
+  if (OB_FAIL(rc)) {
+    return rc;
   }
 
-  DiskBufferPool *bp = iter->second;
   return bp->flush_page(frame);
 }
 
+RC BufferPoolManager::flush_dirty_pages(int max_flush_count, LSN &min_rec_lsn)
+{
+  struct DirtyPage
+  {
+    DiskBufferPool *buffer_pool;
+    PageNum         page_num;
+    LSN             rec_lsn;
+  };
+
+  vector<DiskBufferPool *> buffer_pools;
+  lock_.lock();
+  for (auto &[id, buffer_pool] : id_to_buffer_pools_) {
+    buffer_pools.push_back(buffer_pool);
+  }
+  lock_.unlock();
+
+  vector<DirtyPage> dirty_pages;
+  for (DiskBufferPool *buffer_pool : buffer_pools) {
+    vector<pair<PageNum, LSN>> pages;
+    RC                         rc = buffer_pool->collect_dirty_pages(pages);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to collect dirty pages. buffer pool=%s, rc=%s", buffer_pool->filename(), strrc(rc));
+      return rc;
+    }
+
+    for (auto &[page_num, rec_lsn] : pages) {
+      dirty_pages.push_back(DirtyPage{buffer_pool, page_num, rec_lsn});
+    }
+  }
+
+  // recLSN 最小的页面最影响检查点的推进，优先刷新
+  sort(dirty_pages.begin(), dirty_pages.end(), [](const DirtyPage &a, const DirtyPage &b) {
+    return a.rec_lsn < b.rec_lsn;
+  });
+
+  int flush_count = 0;
+  for (const DirtyPage &dirty_page : dirty_pages) {
+    if (max_flush_count < 0 || flush_count < max_flush_count) {
+      RC rc = dirty_page.buffer_pool->flush_dirty_page(dirty_page.page_num);
+      if (OB_SUCC(rc)) {
+        flush_count++;
+        continue;
+      }
+
+      LOG_WARN("failed to flush dirty page. buffer pool=%s, page num=%d, rc=%s",
+               dirty_page.buffer_pool->filename(), dirty_page.page_num, strrc(rc));
+    }
+
+    min_rec_lsn = min(min_rec_lsn, dirty_page.rec_lsn);
+  }
+
+  LOG_DEBUG("flush dirty pages done. dirty pages=%d, flushed=%d", static_cast<int>(dirty_pages.size()), flush_count);
+  return RC::SUCCESS;
+}
+
 RC BufferPoolManager::get_buffer_pool(int32_t id, DiskBufferPool *&bp)
 {
   bp = nullptr;
@@ -26,16 +26,19 @@ See the Mulan PSL v2 for more details. */
 #include <optional>
 
 #include "common/lang/bitmap.h"
-#include "common/lang/lru_cache.h"
+#include "common/lang/atomic.h"
 #include "common/lang/mutex.h"
 #include "common/lang/memory.h"
+#include "common/lang/span.h"
 #include "common/lang/unordered_map.h"
+#include "common/lang/vector.h"
 #include "common/mm/mem_pool.h"
 #include "common/sys/rc.h"
 #include "common/types.h"
 #include "storage/buffer/frame.h"
 #include "storage/buffer/page.h"
 #include "storage/buffer/buffer_pool_log.h"
+#include "storage/buffer/page_cleaner.h"
 
 class BufferPoolManager;
 class DiskBufferPool;
@@ -83,13 +86,26 @@ struct BPFileHeader
  * 当内存中的页帧不够用时，需要从内存中淘汰一些页帧，以便为新的页帧腾出空间。
  * 这个管理器负责为所有的BufferPool提供页帧管理服务，也就是所有的BufferPool磁盘文件
  * 在访问时都使用这个管理器映射到内存。
+ *
+ * 所有的页帧按照FrameId哈希到多个分片(shard)中，每个分片有自己的锁、页帧映射表和淘汰策略，
+ * 不同表、不同页面的访问大部分时候不会竞争同一把锁。页帧内存是所有分片共享的，只有内存池
+ * 耗尽时才需要淘汰页面。
  */
 class BPFrameManager
 {
+public:
+  /// 默认的分片个数
+  static const int DEFAULT_SHARD_NUM = 16;
+
 public:
   BPFrameManager(const char *tag);
 
-  RC init(int pool_num);
+  /**
+   * @brief 初始化
+   * @param pool_num 内存池的个数，每个内存池有 DEFAULT_ITEM_NUM_PER_POOL 个页帧
+   * @param shard_num 分片的个数
+   */
+  RC init(int pool_num, int shard_num = DEFAULT_SHARD_NUM);
   RC cleanup();
 
   /**
@@ -101,6 +117,12 @@ public:
    */
   Frame *get(int buffer_pool_id, PageNum page_num);
 
+  /**
+   * @brief 页面是否在内存中
+   * @details 与 get 不同，不会pin住页帧，也不算作一次访问
+   */
+  bool contains(int buffer_pool_id, PageNum page_num);
+
   /**
    * @brief 列出所有指定文件的页面
    *
@@ -114,9 +136,11 @@ public:
    *
    * @param buffer_pool_id buffer Pool标识
    * @param page_num 页面编号
+   * @param write_latched 新分配的页帧是否在对其它线程可见之前就加上写锁。
+   *        加载页面数据时使用，防止其它线程读到还没有加载完成的页面。已经存在的页帧不会加锁
    * @return Frame* 页帧指针
    */
-  Frame *alloc(int buffer_pool_id, PageNum page_num);
+  Frame *alloc(int buffer_pool_id, PageNum page_num, bool write_latched = false);
 
   /**
    * 尽管frame中已经包含了buffer_pool_id和page_num，但是依然要求
@@ -127,23 +151,43 @@ public:
   /**
    * 如果不能从空闲链表中分配新的页面，就使用这个接口，
    * 尝试从pin count=0的页面中淘汰一些
+   * @details 每次从不同的分片开始淘汰，只会锁住正在淘汰的分片。当前分片找不到足够的
+   * 页面时，继续从下一个分片中淘汰
    * @param count 想要purge多少个页面
    * @param purger 需要在释放frame之前，对页面做些什么操作。当前是刷新脏数据到磁盘
    * @return 返回本次清理了多少个页面
    */
   int purge_frames(int count, function<RC(Frame *frame)> purger);
 
-  size_t frame_num() const { return frames_.count(); }
+  /**
+   * @brief 只淘汰干净的页帧，不会写磁盘
+   * @param count 想要淘汰多少个页帧
+   * @param shard_begin 从哪个分片开始。小于0时，与 purge_frames 一样每次从不同的分片开始，遍历所有分片
+   * @param shard_step 每隔多少个分片处理一个。清理线程使用这两个参数划分各自负责的分片
+   * @return 返回淘汰了多少个页帧
+   */
+  int purge_clean_frames(int count, int shard_begin = -1, int shard_step = 1);
+
+  /**
+   * @brief 收集即将被淘汰的脏页
+   * @details 只收集没有被pin住，并且最近没有被再次访问的脏页。返回的页帧都已经pin住，调用者需要unpin
+   * @param max_count 最多收集多少个页面
+   * @param frames 收集到的页帧
+   */
+  void collect_dirty_frames(int max_count, vector<Frame *> &frames, int shard_begin = 0, int shard_step = 1);
+
+  size_t frame_num() const;
+
+  /// 内存池中还没有分配出去的页帧个数
+  size_t free_frame_num() { return allocator_.get_size() - allocator_.get_used_num(); }
+
+  int shard_num() const { return static_cast<int>(shards_.size()); }
 
   /**
    * 测试使用。返回已经从内存申请的个数
    */
   size_t total_frame_num() const { return allocator_.get_size(); }
 
-private:
-  Frame *get_internal(const FrameId &frame_id);
-  RC     free_internal(const FrameId &frame_id, Frame *frame);
-
 private:
   class BPFrameIdHasher
   {
@@ -151,12 +195,53 @@ private:
     size_t operator()(const FrameId &frame_id) const { return frame_id.hash(); }
   };
 
-  using FrameLruCache  = common::LruCache<FrameId, Frame *, BPFrameIdHasher>;
   using FrameAllocator = common::MemPoolSimple<Frame>;
 
-  mutex          lock_;
-  FrameLruCache  frames_;
-  FrameAllocator allocator_;
+  /**
+   * @brief 页帧管理器的一个分片
+   * @details 使用CLOCK算法淘汰页面。与普通的CLOCK不同，页面第一次载入时不设置访问标记，
+   * 只有再次访问时才会设置，相当于LRU-2的近似：只被顺序扫描访问过一次的页面会被优先淘汰，
+   * 不会把经常访问的热点页面挤出去。
+   */
+  class FrameShard
+  {
+  public:
+    explicit FrameShard(FrameAllocator &allocator) : allocator_(allocator) {}
+
+    Frame *get(const FrameId &frame_id);
+    bool   contains(const FrameId &frame_id);
+    Frame *alloc(const FrameId &frame_id, bool write_latched);
+    RC     free(const FrameId &frame_id, Frame *frame);
+    int    purge(int count, function<RC(Frame *frame)> purger, bool clean_only = false);
+    void   collect_dirty(int max_count, vector<Frame *> &frames);
+    void   find_list(int buffer_pool_id, list<Frame *> &frames);
+    size_t frame_num();
+
+  private:
+    Frame *get_internal(const FrameId &frame_id);
+    RC     free_internal(const FrameId &frame_id, Frame *frame);
+
+  private:
+    struct ClockSlot
+    {
+      Frame *frame      = nullptr;
+      bool   referenced = false;  ///< 第一次载入之后是否又访问过
+    };
+
+    mutex                                        lock_;
+    unordered_map<FrameId, int, BPFrameIdHasher> slot_index_;  ///< 页帧在 slots_ 中的位置
+    vector<ClockSlot>                            slots_;
+    vector<int>                                  free_slots_;
+    size_t                                       hand_ = 0;  ///< CLOCK 的指针
+    FrameAllocator                              &allocator_;
+  };
+
+  FrameShard &shard(const FrameId &frame_id);
+
+private:
+  vector<unique_ptr<FrameShard>> shards_;
+  atomic<uint32_t>               next_purge_shard_{0};
+  FrameAllocator                 allocator_;
 };
 
 /**
@@ -207,6 +292,25 @@ public:
    */
   RC get_this_page(PageNum page_num, Frame **frame);
 
+  /**
+   * @brief 预读页面
+   * @details 从 start_page 开始找到最多 max_count 个已经分配的页面，把其中不在内存中的页面一次读进来。
+   * 页号连续的页面合并成一个读请求，所有请求一起提交给IO后端。
+   * 预读的页面不会被pin住，也不算访问过，如果后面没有用到，会被优先淘汰。
+   * @param start_page 从这个页面开始查找
+   * @param max_count 最多预读的页面数，不会超过页帧总数的1/4
+   * @param end_page 返回预读范围的结束位置，不包含
+   */
+  RC read_ahead(PageNum start_page, int max_count, PageNum &end_page);
+
+  /**
+   * @brief 预读指定的页面
+   * @details 与 read_ahead 相同，只是页面由调用者给出，不要求连续，比如B+树后面的几个叶子页面。
+   * 没有分配的页面会被忽略
+   * @param page_nums 要预读的页面，最多读取页帧总数的1/4
+   */
+  RC prefetch_pages(span<const PageNum> page_nums);
+
   /**
    * @brief 在指定文件中分配一个新的页面，并将其放入缓冲区，返回页面句柄指针。
    * @details 分配页面时，如果文件中有空闲页，就直接分配一个空闲页；
@@ -255,6 +359,25 @@ public:
    */
   RC flush_all_pages();
 
+  /**
+   * @brief 收集当前缓冲池中的脏页，也就是模糊检查点使用的脏页表
+   * @details 每个页面都在加锁的情况下读取状态，不会读到修改了一半的页面。
+   * @param dirty_pages 返回脏页的页号和对应的recLSN
+   */
+  RC collect_dirty_pages(vector<pair<PageNum, LSN>> &dirty_pages);
+
+  /**
+   * @brief 检查点刷新一个脏页到double write buffer
+   * @details 与flush_page不同，这里会对页面加读锁，不会刷出修改了一半的页面。
+   * 如果页面已经不在内存中，说明已经写回过了，直接返回成功。
+   */
+  RC flush_dirty_page(PageNum page_num);
+
+  /**
+   * @brief 与 flush_dirty_page 相同，但是页面已经由调用者pin住了
+   */
+  RC flush_dirty_frame(Frame &frame);
+
   /**
    * 回放日志时处理page0中已被认定为不存在的page
    */
@@ -265,6 +388,25 @@ public:
    */
   RC write_page(PageNum page_num, Page &page);
 
+  /**
+   * @brief 批量刷新页面到磁盘
+   * @details 页面按照页号排序，页号连续的页面合并成一个写请求，所有请求一起提交给IO后端
+   * @param pages 要写入的页号和页面数据，会被重新排序
+   */
+  RC write_pages(vector<pair<PageNum, Page *>> &pages);
+
+  /**
+   * @brief 将数据文件中已经写入的内容落盘
+   */
+  RC sync_file();
+
+  /**
+   * @brief 把所有的页面写入数据文件并落盘
+   * @details flush_all_pages 只是把页面交给 double write buffer。没有记录日志的页面修改，
+   * 需要在记录后续的日志之前调用这个接口，保证页面已经持久化
+   */
+  RC force_all_pages();
+
   RC redo_allocate_page(LSN lsn, PageNum page_num);
   RC redo_deallocate_page(LSN lsn, PageNum page_num);
 
@@ -274,7 +416,11 @@ public:
   const char *filename() const { return file_name_.c_str(); }
 
 protected:
-  RC allocate_frame(PageNum page_num, Frame **buf);
+  /**
+   * @brief 为指定页面分配一个页帧，内存不够时会淘汰其它页面
+   * @param write_latched 参考 BPFrameManager::alloc
+   */
+  RC allocate_frame(PageNum page_num, Frame **buf, bool write_latched = false);
 
   /**
    * 刷新指定页面到磁盘(flush)，并且释放关联的Frame
@@ -287,6 +433,12 @@ protected:
    */
   RC load_page(PageNum page_num, Frame *frame);
 
+  /**
+   * @brief 把不在内存中的页面一次读进来，read_ahead 和 prefetch_pages 使用
+   * @details 调用者需要持有 lock_
+   */
+  RC load_pages(span<const PageNum> page_nums);
+
   /**
    * 如果页面是脏的，就将数据刷新到磁盘
    */
@@ -307,8 +459,8 @@ private:
 
   string file_name_;  /// 文件名
 
+  /// 读写页面使用 pread/pwrite，不依赖文件偏移量，所以文件读写不需要再加锁
   common::Mutex lock_;
-  common::Mutex wr_lock_;
 
 private:
   friend class BufferPoolIterator;
@@ -332,8 +484,18 @@ public:
 
   RC flush_page(Frame &frame);
 
+  /**
+   * @brief 模糊检查点刷新脏页
+   * @details 按照recLSN从小到大，把最多 max_flush_count 个脏页刷新到double write buffer，
+   * 刷新过程中不阻塞其它的读写操作。
+   * @param max_flush_count 本次最多刷新的页面数。小于0表示刷新所有脏页
+   * @param min_rec_lsn 返回没有刷新的脏页中最小的recLSN。没有剩余的脏页时不修改
+   */
+  RC flush_dirty_pages(int max_flush_count, LSN &min_rec_lsn);
+
   BPFrameManager    &get_frame_manager() { return frame_manager_; }
   DoubleWriteBuffer *get_dblwr_buffer() { return dblwr_buffer_.get(); }
+  PageCleaner       &page_cleaner() { return page_cleaner_; }
 
   /**
    * @brief 根据ID获取对应的BufferPool对象
@@ -348,6 +510,8 @@ private:
 
   unique_ptr<DoubleWriteBuffer> dblwr_buffer_;
 
+  PageCleaner page_cleaner_{*this};
+
   common::Mutex                            lock_;
   unordered_map<string, DiskBufferPool *>  buffer_pools_;
   unordered_map<int32_t, DiskBufferPool *> id_to_buffer_pools_;
@@ -12,39 +12,27 @@ See the Mulan PSL v2 for more details. */
 // Created by Wenbin1002 on 2024/04/16
 //
 #include <fcntl.h>
+#include <limits.h>
 
 #include "storage/buffer/double_write_buffer.h"
 #include "storage/buffer/disk_buffer_pool.h"
 #include "common/io/io.h"
+#include "common/io/io_backend.h"
+#include "common/lang/algorithm.h"
 #include "common/log/log.h"
 #include "common/math/crc.h"
 
 using namespace common;
 
-struct DoubleWritePage
-{
-public:
-  DoubleWritePage() = default;
-  DoubleWritePage(int32_t buffer_pool_id, PageNum page_num, int32_t page_index, Page &page);
-
-public:
-  DoubleWritePageKey key;
-  int32_t            page_index = -1; /// 页面在double write buffer文件中的页索引
-  bool               valid = true; /// 表示页面是否有效，在页面被删除时，需要同时标记磁盘上的值。
-  Page               page;
-
-  static const int32_t SIZE;
-};
-
-DoubleWritePage::DoubleWritePage(int32_t buffer_pool_id, PageNum page_num, int32_t page_index, Page &_page)
-  : key{buffer_pool_id, page_num}, page_index(page_index), page(_page)
+DoubleWritePage::DoubleWritePage(int32_t buffer_pool_id, PageNum page_num, Page &_page)
+  : key{buffer_pool_id, page_num}, page(_page)
 {}
 
 const int32_t DoubleWritePage::SIZE = sizeof(DoubleWritePage);
 
 const int32_t DoubleWriteBufferHeader::SIZE = sizeof(DoubleWriteBufferHeader);
 
-DiskDoubleWriteBuffer::DiskDoubleWriteBuffer(BufferPoolManager &bp_manager, int max_pages /*=16*/) 
+DiskDoubleWriteBuffer::DiskDoubleWriteBuffer(BufferPoolManager &bp_manager, int max_pages /*=64*/) 
   : max_pages_(max_pages), bp_manager_(bp_manager)
 {
 }
@@ -74,106 +62,160 @@ RC DiskDoubleWriteBuffer::open_file(const char *filename)
 
 RC DiskDoubleWriteBuffer::flush_page()
 {
-  sync();
+  scoped_lock lock_guard(lock_);
+  return flush_page_internal();
+}
 
+RC DiskDoubleWriteBuffer::flush_page_internal()
+{
+  vector<DoubleWritePage *> pages;
+  pages.reserve(dblwr_pages_.size());
   for (const auto &pair : dblwr_pages_) {
-    RC rc = write_page(pair.second);
-    if (rc != RC::SUCCESS) {
-      return rc;
-    }
-    pair.second->valid = false;
-    write_page_internal(pair.second);
-    delete pair.second;
+    pages.push_back(pair.second);
   }
 
-  dblwr_pages_.clear();
-  header_.page_cnt = 0;
+  RC rc = flush_pages_internal(pages);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
 
+  for (DoubleWritePage *dblwr_page : pages) {
+    delete dblwr_page;
+  }
+  dblwr_pages_.clear();
   return RC::SUCCESS;
 }
 
-RC DiskDoubleWriteBuffer::add_page(DiskBufferPool *bp, PageNum page_num, Page &page)
+RC DiskDoubleWriteBuffer::flush_pages_internal(vector<DoubleWritePage *> &pages)
 {
-  scoped_lock lock_guard(lock_);
-  DoubleWritePageKey key{bp->id(), page_num};
-  auto iter = dblwr_pages_.find(key);
-  if (iter != dblwr_pages_.end()) {
-    iter->second->page = page;
-    LOG_TRACE("[cache hit]add page into double write buffer. buffer_pool_id:%d,page_num:%d,lsn=%d, dwb size=%d",
-              bp->id(), page_num, page.lsn, static_cast<int>(dblwr_pages_.size()));
-    return write_page_internal(iter->second);
+  if (pages.empty()) {
+    return RC::SUCCESS;
   }
 
-  int64_t          page_cnt   = dblwr_pages_.size();
-  DoubleWritePage *dblwr_page = new DoubleWritePage(bp->id(), page_num, page_cnt, page);
-  dblwr_pages_.insert(pair<DoubleWritePageKey, DoubleWritePage *>(key, dblwr_page));
-  LOG_TRACE("insert page into double write buffer. buffer_pool_id:%d,page_num:%d,lsn=%d, dwb size:%d",
-            bp->id(), page_num, page.lsn, static_cast<int>(dblwr_pages_.size()));
+  sort(pages.begin(), pages.end(), [](const DoubleWritePage *a, const DoubleWritePage *b) {
+    if (a->key.buffer_pool_id != b->key.buffer_pool_id) {
+      return a->key.buffer_pool_id < b->key.buffer_pool_id;
+    }
+    return a->key.page_num < b->key.page_num;
+  });
 
-  RC rc = write_page_internal(dblwr_page);
+  // 先把整批页面写到 double write buffer 文件中并落盘，之后写数据文件时出现页面断裂也可以恢复
+  RC rc = write_batch(pages);
   if (OB_FAIL(rc)) {
-    LOG_WARN("failed to write page into double write buffer. rc=%s buffer_pool_id:%d,page_num:%d,lsn=%d.",
-        strrc(rc), bp->id(), page_num, page.lsn);
     return rc;
   }
 
-  if (page_cnt + 1 > header_.page_cnt) {
-    header_.page_cnt = page_cnt + 1;
-    if (lseek(file_desc_, 0, SEEK_SET) == -1) {
-      LOG_ERROR("Failed to add page header due to failed to seek %s.", strerror(errno));
-      return RC::IOERR_SEEK;
-    }
+  // 同一个文件的页面已经按照页号排好序，写完一个文件后落盘一次
+  for (size_t begin = 0; begin < pages.size();) {
+    const int32_t buffer_pool_id = pages[begin]->key.buffer_pool_id;
 
-    if (writen(file_desc_, &header_, sizeof(header_)) != 0) {
-      LOG_ERROR("Failed to add page header due to %s.", strerror(errno));
-      return RC::IOERR_WRITE;
+    vector<pair<PageNum, Page *>> file_pages;
+    size_t                        end = begin;
+    for (; end < pages.size() && pages[end]->key.buffer_pool_id == buffer_pool_id; end++) {
+      file_pages.emplace_back(pages[end]->key.page_num, &pages[end]->page);
     }
-  }
+    begin = end;
 
-  if (static_cast<int>(dblwr_pages_.size()) >= max_pages_) {
-    RC rc = flush_page();
-    if (rc != RC::SUCCESS) {
-      LOG_ERROR("Failed to flush pages in double write buffer");
+    DiskBufferPool *disk_buffer = nullptr;
+    rc                          = bp_manager_.get_buffer_pool(buffer_pool_id, disk_buffer);
+    ASSERT(OB_SUCC(rc) && disk_buffer != nullptr, "failed to get disk buffer pool of %d", buffer_pool_id);
+
+    rc = disk_buffer->write_pages(file_pages);
+    if (OB_SUCC(rc)) {
+      rc = disk_buffer->sync_file();
+    }
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to write pages to buffer pool. buffer_pool_id=%d, rc=%s", buffer_pool_id, strrc(rc));
       return rc;
     }
   }
 
+  // 页面都已经写到数据文件并落盘，这一批页面不再需要恢复。
+  // 清空文件头不需要落盘，重启时重复写入这批页面也不会出错，下一批页面落盘时会一起覆盖掉
+  header_.page_cnt = 0;
+  int ret          = pwriten(file_desc_, &header_, sizeof(header_), 0);
+  if (ret != 0) {
+    LOG_ERROR("Failed to reset double write buffer header due to %s.", strerror(ret));
+    return RC::IOERR_WRITE;
+  }
+
+  LOG_TRACE("double write buffer flush pages done. page count=%d", static_cast<int>(pages.size()));
   return RC::SUCCESS;
 }
 
-RC DiskDoubleWriteBuffer::write_page_internal(DoubleWritePage *page)
+RC DiskDoubleWriteBuffer::write_batch(vector<DoubleWritePage *> &pages)
 {
-  int32_t page_index = page->page_index;
-  int64_t offset = page_index * DoubleWritePage::SIZE + DoubleWriteBufferHeader::SIZE;
-  if (lseek(file_desc_, offset, SEEK_SET) == -1) {
-    LOG_ERROR("Failed to add page %lld of %d due to failed to seek %s.", offset, file_desc_, strerror(errno));
-    return RC::IOERR_SEEK;
+  // 文件头和所有页面在文件中是连续存放的，一次顺序写入
+  header_.page_cnt = static_cast<int32_t>(pages.size());
+
+  vector<struct iovec> iovs;
+  iovs.reserve(pages.size() + 1);
+  iovs.push_back(iovec{&header_, sizeof(header_)});
+  for (size_t i = 0; i < pages.size(); i++) {
+    pages[i]->page_index = static_cast<int32_t>(i);
+    iovs.push_back(iovec{pages[i], static_cast<size_t>(DoubleWritePage::SIZE)});
   }
 
-  if (writen(file_desc_, page, DoubleWritePage::SIZE) != 0) {
-    LOG_ERROR("Failed to add page %lld of %d due to %s.", offset, file_desc_, strerror(errno));
+  vector<IoRequest> requests;
+  int64_t           offset = 0;
+  for (size_t begin = 0; begin < iovs.size();) {
+    const size_t end = min(iovs.size(), begin + static_cast<size_t>(IOV_MAX));
+
+    IoRequest request;
+    request.type   = IoRequest::Type::WRITE;
+    request.fd     = file_desc_;
+    request.iov    = &iovs[begin];
+    request.iovcnt = static_cast<int>(end - begin);
+    request.offset = offset;
+    requests.push_back(request);
+
+    for (size_t i = begin; i < end; i++) {
+      offset += iovs[i].iov_len;
+    }
+    begin = end;
+  }
+
+  int ret = IoBackend::instance().submit_and_wait(requests.data(), static_cast<int>(requests.size()));
+  if (ret != 0) {
+    LOG_ERROR("Failed to write pages into double write buffer due to %s. page count=%d",
+              strerror(ret), static_cast<int>(pages.size()));
     return RC::IOERR_WRITE;
   }
 
+  ret = IoBackend::instance().sync(file_desc_, true /*data_only*/);
+  if (ret != 0) {
+    LOG_ERROR("Failed to sync double write buffer due to %s.", strerror(ret));
+    return RC::IOERR_SYNC;
+  }
   return RC::SUCCESS;
 }
 
-RC DiskDoubleWriteBuffer::write_page(DoubleWritePage *dblwr_page)
+RC DiskDoubleWriteBuffer::add_page(DiskBufferPool *bp, PageNum page_num, Page &page)
 {
-  DiskBufferPool *disk_buffer = nullptr;
-  // skip invalid page
-  if (!dblwr_page->valid) {
-    LOG_TRACE("double write buffer write page invalid. buffer_pool_id:%d,page_num:%d,lsn=%d",
-              dblwr_page->key.buffer_pool_id, dblwr_page->key.page_num, dblwr_page->page.lsn);
+  scoped_lock lock_guard(lock_);
+  DoubleWritePageKey key{bp->id(), page_num};
+  auto iter = dblwr_pages_.find(key);
+  if (iter != dblwr_pages_.end()) {
+    iter->second->page = page;
+    LOG_TRACE("[cache hit]add page into double write buffer. buffer_pool_id:%d,page_num:%d,lsn=%d, dwb size=%d",
+              bp->id(), page_num, page.lsn, static_cast<int>(dblwr_pages_.size()));
     return RC::SUCCESS;
   }
-  RC rc = bp_manager_.get_buffer_pool(dblwr_page->key.buffer_pool_id, disk_buffer);
-  ASSERT(OB_SUCC(rc) && disk_buffer != nullptr, "failed to get disk buffer pool of %d", dblwr_page->key.buffer_pool_id);
 
-  LOG_TRACE("double write buffer write page. buffer_pool_id:%d,page_num:%d,lsn=%d",
-            dblwr_page->key.buffer_pool_id, dblwr_page->key.page_num, dblwr_page->page.lsn);
+  DoubleWritePage *dblwr_page = new DoubleWritePage(bp->id(), page_num, page);
+  dblwr_pages_.insert(pair<DoubleWritePageKey, DoubleWritePage *>(key, dblwr_page));
+  LOG_TRACE("insert page into double write buffer. buffer_pool_id:%d,page_num:%d,lsn=%d, dwb size:%d",
+            bp->id(), page_num, page.lsn, static_cast<int>(dblwr_pages_.size()));
 
-  return disk_buffer->write_page(dblwr_page->key.page_num, dblwr_page->page);
+  if (static_cast<int>(dblwr_pages_.size()) >= max_pages_) {
+    RC rc = flush_page_internal();
+    if (rc != RC::SUCCESS) {
+      LOG_ERROR("Failed to flush pages in double write buffer");
+      return rc;
+    }
+  }
+
+  return RC::SUCCESS;
 }
 
 RC DiskDoubleWriteBuffer::read_page(DiskBufferPool *bp, PageNum page_num, Page &page)
@@ -203,28 +245,16 @@ RC DiskDoubleWriteBuffer::clear_pages(DiskBufferPool *buffer_pool)
     return false;
   };
 
-  lock_.lock();
+  scoped_lock lock_guard(lock_);
   erase_if(dblwr_pages_, remove_pred);
-  lock_.unlock();
 
   LOG_INFO("clear pages in double write buffer. file name=%s, page count=%d",
            buffer_pool->filename(), spec_pages.size());
 
-  // 页面从小到大排序，防止出现小页面还没有写入，而页面编号更大的seek失败的情况
-  sort(spec_pages.begin(), spec_pages.end(), [](DoubleWritePage *a, DoubleWritePage *b) {
-    return a->key.page_num < b->key.page_num;
-  });
-
-  RC rc = RC::SUCCESS;
-  for (DoubleWritePage *dbl_page : spec_pages) {
-    rc = buffer_pool->write_page(dbl_page->key.page_num, dbl_page->page);
-    if (OB_FAIL(rc)) {
-      LOG_WARN("Failed to write page %s:%d to disk buffer pool. rc=%s",
-               buffer_pool->filename(), dbl_page->key.page_num, strrc(rc));
-      break;
-    }
-    dbl_page->valid = false;
-    write_page_internal(dbl_page);
+  // 这个文件的页面单独作为一批写入，同样先写 double write buffer 文件
+  RC rc = flush_pages_internal(spec_pages);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("Failed to write pages to disk buffer pool. file=%s, rc=%s", buffer_pool->filename(), strrc(rc));
   }
 
   for_each(spec_pages.begin(), spec_pages.end(), [](DoubleWritePage *dbl_page) { delete dbl_page; });
@@ -244,12 +274,7 @@ RC DiskDoubleWriteBuffer::load_pages()
     return RC::BUFFERPOOL_OPEN;
   }
 
-  if (lseek(file_desc_, 0, SEEK_SET) == -1) {
-    LOG_ERROR("Failed to load page header, due to failed to lseek:%s.", strerror(errno));
-    return RC::IOERR_SEEK;
-  }
-
-  int ret = readn(file_desc_, &header_, sizeof(header_));
+  int ret = preadn(file_desc_, &header_, sizeof(header_), 0);
   if (ret != 0 && ret != -1) {
     LOG_ERROR("Failed to load page header, file_desc:%d, due to failed to read data:%s, ret=%d",
                 file_desc_, strerror(errno), ret);
@@ -259,16 +284,11 @@ RC DiskDoubleWriteBuffer::load_pages()
   for (int page_num = 0; page_num < header_.page_cnt; page_num++) {
     int64_t offset = ((int64_t)page_num) * DoubleWritePage::SIZE + DoubleWriteBufferHeader::SIZE;
 
-    if (lseek(file_desc_, offset, SEEK_SET) == -1) {
-      LOG_ERROR("Failed to load page %d, offset=%ld, due to failed to lseek:%s.", page_num, offset, strerror(errno));
-      return RC::IOERR_SEEK;
-    }
-
     auto dblwr_page = make_unique<DoubleWritePage>();
     Page &page     = dblwr_page->page;
     page.check_sum = (CheckSum)-1;
 
-    ret = readn(file_desc_, dblwr_page.get(), DoubleWritePage::SIZE);
+    ret = preadn(file_desc_, dblwr_page.get(), DoubleWritePage::SIZE, offset);
     if (ret != 0) {
       LOG_ERROR("Failed to load page, file_desc:%d, page num:%d, due to failed to read data:%s, ret=%d, page count=%d",
                 file_desc_, page_num, strerror(errno), ret, page_num);
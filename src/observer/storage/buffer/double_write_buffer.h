@@ -16,12 +16,12 @@ See the Mulan PSL v2 for more details. */
 
 #include "common/lang/mutex.h"
 #include "common/lang/unordered_map.h"
+#include "common/lang/vector.h"
 #include "common/types.h"
 #include "common/sys/rc.h"
 #include "storage/buffer/page.h"
 
 class DiskBufferPool;
-struct DoubleWritePage;
 class BufferPoolManager;
 
 class DoubleWriteBuffer
@@ -41,6 +41,11 @@ public:
    * @brief 清空所有与指定buffer pool关联的页面
    */
   virtual RC clear_pages(DiskBufferPool *bp) = 0;
+
+  /**
+   * @brief 把缓存的页面全部写到数据文件中
+   */
+  virtual RC flush_page() { return RC::SUCCESS; }
 };
 
 struct DoubleWriteBufferHeader
@@ -70,6 +75,24 @@ struct DoubleWritePageKeyHash
   }
 };
 
+/**
+ * @brief double write buffer 文件中保存的页面
+ * @details 文件中先是 DoubleWriteBufferHeader，后面是连续存放的页面
+ */
+struct DoubleWritePage
+{
+public:
+  DoubleWritePage() = default;
+  DoubleWritePage(int32_t buffer_pool_id, PageNum page_num, Page &page);
+
+public:
+  DoubleWritePageKey key;
+  int32_t            page_index = -1;  /// 页面在double write buffer文件中的页索引，刷盘时按照顺序分配
+  Page               page;
+
+  static const int32_t SIZE;
+};
+
 /**
  * @brief 页面二次缓冲区，为了解决页面原子写入的问题
  * @ingroup BufferPool
@@ -79,8 +102,11 @@ struct DoubleWritePageKeyHash
  * DoubleWriteBuffer会先在一个共享磁盘文件中写入页面数据，在确定写入成功后，再写入真实的页面。
  * 当我们从磁盘中读取页面时，会校验页面的checksum，如果校验失败，则说明页面写入不完整，这时候可以从
  * DoubleWriteBuffer中读取数据。
+ * 页面先缓存在内存中，攒够一批后统一写入共享文件并落盘一次，然后再写入各自的数据文件，
+ * 每个数据文件落盘一次。数据文件中的页面写入不完整时，重启后可以用共享文件中的这一批页面覆盖。
+ * 还在内存中的页面丢失后，通过重做日志恢复。
  *
- * @note 每次都要保证，不管在内存中还是在文件中，这里的数据都是最新的，都比Buffer pool中的数据要新
+ * @note 内存中的页面比Buffer pool对应文件中的数据要新，读取页面时需要先查找这里
  */
 class DiskDoubleWriteBuffer : public DoubleWriteBuffer
 {
@@ -89,9 +115,9 @@ public:
    * @brief 构造函数
    *
    * @param bp_manager 关联的buffer pool manager
-   * @param max_pages  内存中保存的最大页面数
+   * @param max_pages  内存中保存的最大页面数，也是一批刷盘的页面数
    */
-  DiskDoubleWriteBuffer(BufferPoolManager &bp_manager, int max_pages = 16);
+  DiskDoubleWriteBuffer(BufferPoolManager &bp_manager, int max_pages = 64);
   virtual ~DiskDoubleWriteBuffer();
 
   /**
@@ -101,19 +127,21 @@ public:
 
   /**
    * 将buffer中的页全部写入磁盘，并且清空buffer
+   * @details 整批页面先一次写入共享表空间并落盘，再按照文件分组、按照页号排序后写入数据文件，
+   * 每个数据文件只落盘一次
    * TODO 目前的解决方案是等buffer装满后再刷盘，可能会导致程序卡住一段时间
    */
-  RC flush_page();
+  RC flush_page() override;
 
   /**
-   * 将页面加入buffer，并且写入磁盘中的共享表空间
+   * 将页面加入buffer，buffer满了之后整批刷盘
    */
   RC add_page(DiskBufferPool *bp, PageNum page_num, Page &page) override;
 
   RC read_page(DiskBufferPool *bp, PageNum page_num, Page &page) override;
 
   /**
-   * @brief 清空所有与指定buffer pool关联的页面
+   * @brief 将与指定buffer pool关联的页面单独作为一批刷盘，并从buffer中删除
    */
   RC clear_pages(DiskBufferPool *bp) override;
 
@@ -124,16 +152,21 @@ public:
 
 private:
   /**
-   * 将buffer中的页面写入对应的磁盘
+   * @brief 与 flush_page 相同，调用者需要持有 lock_
+   */
+  RC flush_page_internal();
+
+  /**
+   * @brief 将一批页面写入共享表空间和数据文件，调用者需要持有 lock_
+   * @details 不会修改 dblwr_pages_，也不会释放页面
    */
-  RC write_page(DoubleWritePage *page);
+  RC flush_pages_internal(vector<DoubleWritePage *> &pages);
 
   /**
-   * 将页面写到当前double write buffer文件中
-   * @details 每次页面更新都应该写入到磁盘中。保证double write buffer
-   * 内存和文件中的数据都是最新的。
+   * @brief 将文件头和一批页面顺序写入共享表空间文件，并执行一次 fdatasync
+   * @details 写入后文件头记录的页面数就是这一批页面数，重启时 load_pages 会加载这些页面
    */
-  RC write_page_internal(DoubleWritePage *page);
+  RC write_batch(vector<DoubleWritePage *> &pages);
 
   /**
    * @brief 将磁盘文件中的内容加载到内存中。在启动时调用
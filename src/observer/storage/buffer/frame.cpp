@@ -75,6 +75,10 @@ void Frame::write_latch(intptr_t xid)
   }
 
   lock_.lock();
+  if (write_latch_depth_++ == 0) {
+    version_.fetch_add(1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+  }
 
 #ifdef DEBUG
   write_locker_ = xid;
@@ -110,6 +114,9 @@ void Frame::write_unlatch(intptr_t xid)
   }
   debug_lock_.unlock();
 
+  if (--write_latch_depth_ == 0) {
+    version_.fetch_add(1, memory_order_release);
+  }
   lock_.unlock();
 }
 
@@ -75,7 +75,7 @@ public:
    * @details 在 MemPoolSimple 分配和释放一个Frame对象时，不会调用构造函数和析构函数，
    * 而是调用reinit和reset。
    */
-  void reinit() {}
+  void reinit() { rec_lsn_ = 0; }
   void reset() {}
 
   void clear_page() { memset(&page_, 0, sizeof(page_)); }
@@ -104,7 +104,21 @@ public:
    * 序列号要小，那就可以从日志中读取这些更大序列号的日志，做重做操作，将页面恢复到最新状态，也就是redo。
    */
   LSN  lsn() const { return page_.lsn; }
-  void set_lsn(LSN lsn) { page_.lsn = lsn; }
+  void set_lsn(LSN lsn)
+  {
+    page_.lsn = lsn;
+    if (rec_lsn_ <= 0) {
+      rec_lsn_ = lsn;
+    }
+  }
+
+  /**
+   * @brief 页面上第一个没有写回磁盘的修改对应的日志序列号(recLSN)
+   * @details 检查点使用它计算重做的起点，恢复时至少要从这个LSN开始重做才能把页面恢复到最新状态。
+   * 如果页面变脏后还没有设置过LSN，说明修改对应的日志还没有写，新日志的LSN一定比页面当前的LSN大。
+   * 需要在持有页面锁的情况下访问。
+   */
+  LSN rec_lsn() const { return rec_lsn_ > 0 ? rec_lsn_ : page_.lsn + 1; }
 
   /**
    * @brief 页面校验和
@@ -132,7 +146,11 @@ public:
    * @brief 重置“脏”标记
    * @details 如果页面已经被写入磁盘文件，则应调用此函数。
    */
-  void clear_dirty() { dirty_ = false; }
+  void clear_dirty()
+  {
+    dirty_   = false;
+    rec_lsn_ = 0;
+  }
   bool dirty() const { return dirty_; }
 
   char *data() { return page_.data; }
@@ -166,12 +184,32 @@ public:
   void read_unlatch();
   void read_unlatch(intptr_t xid);
 
+  /**
+   * @brief 页面的版本号，用于乐观锁
+   * @details 加写锁和释放写锁时版本号都会加一，所以持有写锁期间版本号是奇数。
+   * 不加锁读取页面内容时，先记录版本号，读取之后调用 validate_version 检查，
+   * 版本号没有变化并且不是奇数，说明读取期间没有人修改过这个页面。
+   * 调用者需要pin住页面，防止页帧被淘汰后用来存放其它页面。
+   */
+  uint64_t    version() const { return version_.load(memory_order_acquire); }
+  static bool is_write_latched(uint64_t version) { return (version & 1) != 0; }
+
+  /**
+   * @brief 检查从 version 开始到现在，页面有没有被修改过
+   */
+  bool validate_version(uint64_t version) const
+  {
+    atomic_thread_fence(memory_order_acquire);
+    return version_.load(memory_order_relaxed) == version;
+  }
+
   string to_string() const;
 
 private:
   friend class BufferPool;
 
-  bool          dirty_ = false;
+  bool          dirty_   = false;
+  LSN           rec_lsn_ = 0;  ///< 页面变脏后第一次修改的LSN，写回磁盘后清零
   atomic<int>   pin_count_{0};
   unsigned long acc_time_ = 0;
   FrameId       frame_id_;
@@ -180,6 +218,9 @@ private:
   /// 在非并发编译时，加锁解锁动作将什么都不做
   common::RecursiveSharedMutex lock_;
 
+  atomic<uint64_t> version_{0};          ///< 乐观锁使用的版本号，参考 version()
+  int              write_latch_depth_ = 0;  ///< 写锁重入的次数，只有持有写锁的线程访问
+
   /// 使用一些手段来做测试，提前检测出头疼的死锁问题
   /// 如果编译时没有增加调试选项，这些代码什么都不做
   common::DebugMutex           debug_lock_;
@@ -0,0 +1,174 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/buffer/page_cleaner.h"
+#include "common/lang/algorithm.h"
+#include "common/lang/chrono.h"
+#include "common/lang/sstream.h"
+#include "common/log/log.h"
+#include "common/thread/thread_util.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "storage/buffer/double_write_buffer.h"
+
+/// 没有被前台唤醒时，清理线程检查空闲页帧的间隔
+static const int CLEAN_INTERVAL_MS = 100;
+
+string PageCleaner::Stat::to_string() const
+{
+  stringstream ss;
+  ss << "rounds:" << rounds.load() << ", flushed_pages:" << flushed_pages.load()
+     << ", freed_frames:" << freed_frames.load() << ", foreground_purges:" << foreground_purges.load()
+     << ", foreground_stalls:" << foreground_stalls.load();
+  return ss.str();
+}
+
+PageCleaner::PageCleaner(BufferPoolManager &bp_manager) : bp_manager_(bp_manager) {}
+
+PageCleaner::~PageCleaner() { stop(); }
+
+RC PageCleaner::start(int thread_num, int low_watermark /* = -1 */)
+{
+  if (!threads_.empty()) {
+    LOG_WARN("page cleaner has been started");
+    return RC::INTERNAL;
+  }
+
+  BPFrameManager &frame_manager = bp_manager_.get_frame_manager();
+  if (thread_num <= 0) {
+    LOG_INFO("page cleaner is disabled. thread num=%d", thread_num);
+    return RC::SUCCESS;
+  }
+
+  // 每个线程至少负责一个分片
+  thread_num = min(thread_num, frame_manager.shard_num());
+  if (low_watermark < 0) {
+    low_watermark = static_cast<int>(frame_manager.total_frame_num() / 8);
+  }
+  low_watermark_ = max(low_watermark, 1);
+  thread_num_    = thread_num;
+
+  running_ = true;
+  for (int i = 0; i < thread_num; i++) {
+    threads_.emplace_back(&PageCleaner::thread_func, this, i);
+  }
+
+  LOG_INFO("page cleaner started. thread num=%d, low watermark=%d", thread_num, low_watermark_);
+  return RC::SUCCESS;
+}
+
+void PageCleaner::stop()
+{
+  if (threads_.empty()) {
+    return;
+  }
+
+  {
+    lock_guard<mutex> guard(lock_);
+    running_ = false;
+  }
+  cond_.notify_all();
+
+  for (thread &t : threads_) {
+    t.join();
+  }
+  threads_.clear();
+  LOG_INFO("page cleaner stopped. %s", stat_.to_string().c_str());
+}
+
+void PageCleaner::wakeup() { cond_.notify_all(); }
+
+void PageCleaner::thread_func(int thread_index)
+{
+  string thread_name = "PageCleaner" + std::to_string(thread_index);
+  common::thread_set_name(thread_name.c_str());
+
+  unique_lock<mutex> lock(lock_);
+  while (running_) {
+    cond_.wait_for(lock, chrono::milliseconds(CLEAN_INTERVAL_MS));
+    if (!running_) {
+      break;
+    }
+
+    lock.unlock();
+    clean(low_watermark_, thread_index, thread_num_);
+    lock.lock();
+  }
+}
+
+void PageCleaner::clean(int low_watermark, int shard_begin /* = 0 */, int shard_step /* = 1 */)
+{
+  BPFrameManager &frame_manager = bp_manager_.get_frame_manager();
+
+  shared_lock<shared_mutex> guard(close_lock_);
+
+  const int free_frame_num = static_cast<int>(frame_manager.free_frame_num());
+  if (free_frame_num >= low_watermark) {
+    return;
+  }
+
+  stat_.rounds++;
+
+  // 每个线程负责一部分分片，需要补充的空闲页帧由这些线程分摊
+  const int need_count    = (low_watermark - free_frame_num + shard_step - 1) / shard_step;
+  const int flushed_count = flush_frames(need_count, shard_begin, shard_step);
+  const int freed_count   = frame_manager.purge_clean_frames(need_count, shard_begin, shard_step);
+
+  stat_.flushed_pages += flushed_count;
+  stat_.freed_frames += freed_count;
+  LOG_DEBUG("page cleaner round done. shard begin=%d, free frames=%d, low watermark=%d, flushed=%d, freed=%d",
+            shard_begin, free_frame_num, low_watermark, flushed_count, freed_count);
+}
+
+int PageCleaner::flush_frames(int max_count, int shard_begin, int shard_step)
+{
+  vector<Frame *> frames;
+  bp_manager_.get_frame_manager().collect_dirty_frames(max_count, frames, shard_begin, shard_step);
+  if (frames.empty()) {
+    return 0;
+  }
+
+  // 同一个文件的页面放在一起，按照页号顺序写入
+  sort(frames.begin(), frames.end(), [](const Frame *a, const Frame *b) {
+    if (a->buffer_pool_id() != b->buffer_pool_id()) {
+      return a->buffer_pool_id() < b->buffer_pool_id();
+    }
+    return a->page_num() < b->page_num();
+  });
+
+  int             flushed_count  = 0;
+  DiskBufferPool *buffer_pool    = nullptr;
+  int32_t         buffer_pool_id = -1;
+  for (Frame *frame : frames) {
+    if (frame->buffer_pool_id() != buffer_pool_id) {
+      buffer_pool_id = frame->buffer_pool_id();
+      RC rc          = bp_manager_.get_buffer_pool(buffer_pool_id, buffer_pool);
+      if (OB_FAIL(rc)) {
+        buffer_pool = nullptr;
+      }
+    }
+
+    if (buffer_pool != nullptr) {
+      RC rc = buffer_pool->flush_dirty_frame(*frame);
+      if (OB_SUCC(rc)) {
+        flushed_count++;
+      } else {
+        LOG_WARN("page cleaner failed to flush frame. frame=%s, rc=%s", frame->to_string().c_str(), strrc(rc));
+      }
+    }
+    frame->unpin();
+  }
+
+  // double write buffer 中的页面按照文件和页号排序后写入数据文件
+  RC rc = bp_manager_.get_dblwr_buffer()->flush_page();
+  if (OB_FAIL(rc)) {
+    LOG_WARN("page cleaner failed to flush double write buffer. rc=%s", strrc(rc));
+  }
+  return flushed_count;
+}
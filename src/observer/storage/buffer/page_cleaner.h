@@ -0,0 +1,100 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/lang/atomic.h"
+#include "common/lang/condition_variable.h"
+#include "common/lang/mutex.h"
+#include "common/lang/string.h"
+#include "common/lang/thread.h"
+#include "common/lang/vector.h"
+#include "common/sys/rc.h"
+
+class BufferPoolManager;
+
+/**
+ * @brief 后台页面清理线程
+ * @ingroup BufferPool
+ * @details 内存中的页帧用完时，前台线程需要淘汰页面。如果淘汰的页面是脏页，就要先把它写到磁盘上，
+ * 查询会因此卡住。清理线程在后台维持一定数量的空闲页帧(最低水位)：先把淘汰候选中的脏页按照文件
+ * 和页号排序后批量写回，再淘汰已经干净的页帧。这样前台分配页帧时，大部分时候不需要等待写磁盘。
+ *
+ * 每个清理线程负责一部分页帧分片，线程之间不会竞争同一批页面。
+ */
+class PageCleaner final
+{
+public:
+  /**
+   * @brief 清理线程和前台淘汰的统计信息
+   */
+  struct Stat
+  {
+    atomic<int64_t> rounds{0};             ///< 清理线程执行了多少轮清理
+    atomic<int64_t> flushed_pages{0};      ///< 清理线程写回的脏页数
+    atomic<int64_t> freed_frames{0};       ///< 清理线程淘汰的页帧数
+    atomic<int64_t> foreground_purges{0};  ///< 前台分配页帧时需要自己淘汰页面的次数
+    atomic<int64_t> foreground_stalls{0};  ///< 前台淘汰时找不到干净的页面，只能自己写回脏页的次数
+
+    string to_string() const;
+  };
+
+public:
+  explicit PageCleaner(BufferPoolManager &bp_manager);
+  ~PageCleaner();
+
+  /**
+   * @brief 启动清理线程
+   * @param thread_num 清理线程的个数
+   * @param low_watermark 空闲页帧的最低水位。小于0时使用总页帧数的1/8
+   */
+  RC start(int thread_num, int low_watermark = -1);
+
+  /// @brief 停止所有的清理线程并等待它们退出
+  void stop();
+
+  /// @brief 唤醒清理线程。前台找不到空闲页帧时调用
+  void wakeup();
+
+  /**
+   * @brief 执行一轮清理
+   * @details 清理线程会周期性地调用，测试时也可以直接调用。只处理编号为 shard_begin, shard_begin + shard_step, ...
+   * 的页帧分片
+   * @param low_watermark 空闲页帧的最低水位
+   */
+  void clean(int low_watermark, int shard_begin = 0, int shard_step = 1);
+
+  /**
+   * @brief 关闭buffer pool时需要对这个锁加写锁
+   * @details 清理线程会pin住其它文件的页面，关闭文件时不能有清理线程访问这个文件的页面
+   */
+  shared_mutex &close_lock() { return close_lock_; }
+
+  Stat &stat() { return stat_; }
+
+private:
+  void thread_func(int thread_index);
+
+  /// @brief 把页帧写回磁盘，返回写回了多少个页面。调用者需要持有 close_lock_ 的读锁
+  int flush_frames(int max_count, int shard_begin, int shard_step);
+
+private:
+  BufferPoolManager &bp_manager_;
+
+  mutex              lock_;
+  condition_variable cond_;
+  bool               running_ = false;
+  vector<thread>     threads_;
+  int                thread_num_    = 0;
+  int                low_watermark_ = 0;
+
+  shared_mutex close_lock_;
+  Stat         stat_;
+};
@@ -0,0 +1,60 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/buffer/read_ahead.h"
+#include "common/lang/algorithm.h"
+#include "common/log/log.h"
+#include "storage/buffer/disk_buffer_pool.h"
+
+void ReadAhead::init(DiskBufferPool &buffer_pool, int window /* = DEFAULT_WINDOW */)
+{
+  buffer_pool_ = &buffer_pool;
+  window_      = window;
+  reset();
+}
+
+void ReadAhead::reset()
+{
+  last_page_        = -1;
+  sequential_count_ = 0;
+  read_ahead_end_   = -1;
+}
+
+void ReadAhead::on_access(PageNum page_num)
+{
+  if (nullptr == buffer_pool_ || window_ <= 0) {
+    return;
+  }
+
+  // 文件中可能有释放掉的页面，向后跳过不超过一个窗口的访问也认为是顺序的
+  if (last_page_ >= 0 && page_num > last_page_ && page_num - last_page_ <= window_) {
+    sequential_count_++;
+  } else if (page_num != last_page_) {
+    sequential_count_ = 0;
+    read_ahead_end_   = -1;
+  }
+  last_page_ = page_num;
+
+  if (!sequential_hint_ && sequential_count_ < SEQUENTIAL_THRESHOLD) {
+    return;
+  }
+
+  if (read_ahead_end_ > page_num + window_ / 2) {
+    return;
+  }
+
+  const PageNum start_page = max(page_num, read_ahead_end_);
+  RC            rc         = buffer_pool_->read_ahead(start_page, window_, read_ahead_end_);
+  read_ahead_count_++;
+  if (OB_FAIL(rc)) {
+    // 预读失败不影响正常的读取
+    LOG_TRACE("failed to read ahead. start page=%d, rc=%s", start_page, strrc(rc));
+  }
+}
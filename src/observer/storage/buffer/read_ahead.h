@@ -0,0 +1,59 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/types.h"
+
+class DiskBufferPool;
+
+/**
+ * @brief 顺序预读
+ * @ingroup BufferPool
+ * @details 每个扫描器持有一个，在访问页面之前调用 on_access。连续几次向后访问页面之后，
+ * 认为当前是顺序扫描，一次把后面的一批页面读到内存里，之后的访问就不需要再一个页面一个页面地等待磁盘。
+ * 预读过的页面剩下不到一半时，继续预读下一批。
+ * 调用者确定是顺序扫描时，可以通过 set_sequential_hint 跳过检测，从第一个页面开始预读。
+ */
+class ReadAhead final
+{
+public:
+  /// 一次预读的页面数
+  static constexpr int DEFAULT_WINDOW = 64;
+  /// 连续向后访问多少次之后开始预读
+  static constexpr int SEQUENTIAL_THRESHOLD = 4;
+
+public:
+  ReadAhead() = default;
+
+  void init(DiskBufferPool &buffer_pool, int window = DEFAULT_WINDOW);
+  void reset();
+
+  void set_sequential_hint(bool hint) { sequential_hint_ = hint; }
+
+  /**
+   * @brief 即将访问某个页面
+   * @details 根据访问的模式判断是否需要预读，需要的话会同步读取后面的一批页面
+   */
+  void on_access(PageNum page_num);
+
+  /// 预读操作执行的次数，测试使用
+  int read_ahead_count() const { return read_ahead_count_; }
+
+private:
+  DiskBufferPool *buffer_pool_     = nullptr;
+  int             window_          = 0;
+  bool            sequential_hint_ = false;
+
+  PageNum last_page_        = -1;  ///< 上次访问的页面
+  int     sequential_count_ = 0;   ///< 连续向后访问的次数
+  PageNum read_ahead_end_   = -1;  ///< 已经预读到的位置，不包含
+  int     read_ahead_count_ = 0;
+};
@@ -16,6 +16,7 @@ See the Mulan PSL v2 for more details. */
 #include "storage/clog/disk_log_handler.h"
 #include "storage/clog/log_file.h"
 #include "storage/clog/log_replayer.h"
+#include "common/lang/algorithm.h"
 #include "common/lang/chrono.h"
 
 using namespace common;
@@ -26,7 +27,13 @@ using namespace common;
 RC DiskLogHandler::init(const char *path)
 {
   const int max_entry_number_per_file = 1000;
-  return file_manager_.init(path, max_entry_number_per_file);
+  RC rc = file_manager_.init(path, max_entry_number_per_file);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  // 预分配日志缓冲区。replay 之后会根据最新的LSN重新初始化
+  return entry_buffer_.init(0 /*lsn*/);
 }
 
 RC DiskLogHandler::start()
@@ -49,7 +56,12 @@ RC DiskLogHandler::stop()
     return RC::INTERNAL;
   }
 
-  running_.store(false);
+  {
+    lock_guard guard(flush_mutex_);
+    running_.store(false);
+  }
+  flush_request_cond_.notify_all();
+  flushed_cond_.notify_all();
 
   LOG_INFO("log handler stopped");
   return RC::SUCCESS;
@@ -75,19 +87,38 @@ RC DiskLogHandler::await_termination()
 
 RC DiskLogHandler::replay(LogReplayer &replayer, LSN start_lsn)
 {
-  LSN max_lsn = 0;
-  auto replay_callback = [&replayer, &max_lsn](LogEntry &entry) -> RC {
+  LSN     max_lsn      = 0;
+  int64_t entry_count  = 0;
+  auto    replay_begin = chrono::steady_clock::now();
+
+  auto replay_callback = [&replayer, &max_lsn, &entry_count](LogEntry &entry) -> RC {
     if (entry.lsn() > max_lsn) {
       max_lsn = entry.lsn();
     }
+    entry_count++;
     return replayer.replay(entry);
   };
 
   RC rc = iterate(replay_callback, start_lsn);
+  // 即使遍历失败，也要等待已经分发出去的日志回放结束
+  RC wait_rc = replayer.wait_replay_done();
   if (OB_FAIL(rc)) {
     LOG_WARN("failed to iterate log entries. rc=%s", strrc(rc));
     return rc;
   }
+  if (OB_FAIL(wait_rc)) {
+    LOG_WARN("failed to replay log entries. rc=%s", strrc(wait_rc));
+    return wait_rc;
+  }
+
+  const int64_t elapsed_ms =
+      chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - replay_begin).count();
+  const double entries_per_sec = entry_count * 1000.0 / max(elapsed_ms, int64_t(1));
+
+  // 检查点之前的日志文件可能已经被回收了，LSN 不能从检查点之前重新开始分配
+  if (start_lsn > 0 && max_lsn < start_lsn - 1) {
+    max_lsn = start_lsn - 1;
+  }
 
   rc = entry_buffer_.init(max_lsn);
   if (OB_FAIL(rc)) {
@@ -95,7 +126,8 @@ RC DiskLogHandler::replay(LogReplayer &replayer, LSN start_lsn)
     return rc;
   }
 
-  LOG_INFO("replay clog files done. start lsn=%ld, max_lsn=%ld", start_lsn, max_lsn);
+  LOG_INFO("replay clog files done. start lsn=%ld, max_lsn=%ld, entries=%ld, elapsed=%ldms, entries/sec=%.0f",
+           start_lsn, max_lsn, entry_count, elapsed_ms, entries_per_sec);
   return rc;
 }
 
@@ -133,12 +165,12 @@ RC DiskLogHandler::iterate(function<RC(LogEntry&)> consumer, LSN start_lsn)
   return RC::SUCCESS;
 }
 
-RC DiskLogHandler::_append(LSN &lsn, LogModule module, vector<char> &&data)
+RC DiskLogHandler::_append(LSN &lsn, LogModule module, span<const char> data)
 {
   ASSERT(running_.load(), "log handler is not running. lsn=%ld, module=%s, size=%d", 
         lsn, module.name(), data.size());
 
-  RC rc = entry_buffer_.append(lsn, module, std::move(data));
+  RC rc = entry_buffer_.append(lsn, module, data);
   if (OB_FAIL(rc)) {
     LOG_WARN("failed to append log entry to buffer. rc=%s", strrc(rc));
     return rc;
@@ -147,11 +179,35 @@ RC DiskLogHandler::_append(LSN &lsn, LogModule module, vector<char> &&data)
   return RC::SUCCESS;
 }
 
+RC DiskLogHandler::recycle(LSN check_point_lsn)
+{
+  int removed_count = 0;
+  RC  rc            = file_manager_.remove_files_before(check_point_lsn, removed_count);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to remove log files. check point lsn=%ld, rc=%s", check_point_lsn, strrc(rc));
+    return rc;
+  }
+
+  if (removed_count > 0) {
+    LOG_INFO("recycle log files done. check point lsn=%ld, removed files=%d", check_point_lsn, removed_count);
+  }
+  return RC::SUCCESS;
+}
+
 RC DiskLogHandler::wait_lsn(LSN lsn)
 {
-  // 直接强制等待。在生产系统中，我们可能会使用条件变量来等待。
-  while (running_.load() && current_flushed_lsn() < lsn) {
-    this_thread::sleep_for(chrono::milliseconds(100));
+  if (current_flushed_lsn() >= lsn) {
+    return RC::SUCCESS;
+  }
+
+  {
+    unique_lock lock(flush_mutex_);
+    if (requested_lsn_.load() < lsn) {
+      requested_lsn_.store(lsn);
+    }
+    flush_request_cond_.notify_one();
+
+    flushed_cond_.wait(lock, [this, lsn]() { return current_flushed_lsn() >= lsn || !running_.load(); });
   }
 
   if (current_flushed_lsn() >= lsn) {
@@ -161,12 +217,31 @@ RC DiskLogHandler::wait_lsn(LSN lsn)
   }
 }
 
+void DiskLogHandler::wait_for_flush_request()
+{
+  unique_lock lock(flush_mutex_);
+  flush_request_cond_.wait_for(lock, idle_wait_time_, [this]() {
+    return !running_.load() ||
+           (requested_lsn_.load() > current_flushed_lsn() && entry_buffer_.entry_number() > 0);
+  });
+}
+
+void DiskLogHandler::notify_flushed()
+{
+  {
+    // 加锁是为了避免等待者在检查条件之后、进入等待之前错过通知
+    lock_guard guard(flush_mutex_);
+  }
+  flushed_cond_.notify_all();
+}
+
 void DiskLogHandler::thread_func()
 {
   /*
   这个线程一直不停的循环，检查日志缓冲区中是否有日志在内存中，如果在内存中就刷新到磁盘。
-  这种做法很粗暴简单，与生产数据库的做法不同。生产数据库通常会在内存达到一定量，或者一定时间
-  之后，会刷新一下磁盘。这样做的好处是减少磁盘的IO次数，提高性能。
+  每次刷新时会把缓冲区中积攒的日志一次性写入文件并只刷一次盘(group commit)，
+  在刷盘期间新提交的事务产生的日志会在下一批中一起刷新，这样多个并发事务可以分摊一次刷盘的开销。
+  缓冲区为空时，线程在条件变量上等待，有事务在等待日志落盘时会立即被唤醒。
   */
   thread_set_name("LogHandler");
   LOG_INFO("log handler thread started");
@@ -198,11 +273,13 @@ void DiskLogHandler::thread_func()
       LOG_WARN("failed to flush log entry buffer. rc=%s", strrc(rc));
     }
 
-    if (flush_count == 0 && rc == RC::SUCCESS) {
-      this_thread::sleep_for(chrono::milliseconds(100));
-      continue;
+    if (flush_count > 0) {
+      notify_flushed();
+    } else if (rc == RC::SUCCESS) {
+      wait_for_flush_request();
     }
   }
 
+  notify_flushed();
   LOG_INFO("log handler thread stopped");
 }
@@ -20,6 +20,9 @@ See the Mulan PSL v2 for more details. */
 #include "common/lang/deque.h"
 #include "common/lang/memory.h"
 #include "common/lang/thread.h"
+#include "common/lang/mutex.h"
+#include "common/lang/condition_variable.h"
+#include "common/lang/chrono.h"
 #include "storage/clog/log_module.h"
 #include "storage/clog/log_file.h"
 #include "storage/clog/log_buffer.h"
@@ -32,6 +35,8 @@ class LogReplayer;
  * @ingroup CLog
  * @details 该模块负责日志的写入、读取、回放等功能。
  * 会在后台开启一个线程，一直尝试刷新内存中的日志到磁盘。
+ * 刷盘线程使用组提交(group commit)的方式，每次把缓冲区中积攒的多条日志一次性写入并刷盘，
+ * 然后通过条件变量唤醒等待这些日志落盘的事务。
  * 所有的CLog日志文件都存放在指定的目录下，每个日志文件按照日志条数来划分。
  * 调用的顺序应该是：
  * @code {.cpp}
@@ -92,7 +97,7 @@ public:
 
   /**
    * @brief 等待指定的日志刷盘
-   *
+   * @details 会通知刷盘线程立即刷盘，然后在条件变量上等待，直到刷盘线程把这条日志刷到磁盘
    * @param lsn 想要等待的日志
    */
   RC wait_lsn(LSN lsn) override;
@@ -102,6 +107,12 @@ public:
   /// @brief 当前刷新到哪个日志
   LSN current_flushed_lsn() const { return entry_buffer_.flushed_lsn(); }
 
+  /**
+   * @brief 删除检查点之前的日志文件
+   * @details 正在写入的最后一个日志文件不会删除
+   */
+  RC recycle(LSN check_point_lsn) override;
+
 private:
   /**
    * @brief 在缓存中增加一条日志
@@ -110,7 +121,7 @@ private:
    * @param[in] module  日志模块
    * @param[in] data    日志数据。具体的数据由各个模块自己定义
    */
-  RC _append(LSN &lsn, LogModule module, vector<char> &&data) override;
+  RC _append(LSN &lsn, LogModule module, span<const char> data) override;
 
 private:
   /**
@@ -118,10 +129,28 @@ private:
    */
   void thread_func();
 
+  /**
+   * @brief 刷盘线程在没有日志需要刷新时等待
+   * @details 有事务等待日志落盘或者日志模块停止时会被唤醒，否则最多等待 idle_wait_time_
+   */
+  void wait_for_flush_request();
+
+  /**
+   * @brief 刷盘线程刷新了一批日志后，唤醒等待的事务
+   */
+  void notify_flushed();
+
 private:
   unique_ptr<thread> thread_;          /// 刷新日志的线程
   atomic_bool        running_{false};  /// 是否还要继续运行
 
+  mutex              flush_mutex_;           /// 保护下面两个条件变量
+  condition_variable flush_request_cond_;    /// 通知刷盘线程有事务在等待日志落盘
+  condition_variable flushed_cond_;          /// 通知事务有新的日志落盘了
+  atomic<LSN>        requested_lsn_{0};      /// 事务等待落盘的最大LSN
+
+  static constexpr chrono::milliseconds idle_wait_time_{10};  /// 刷盘线程空闲时最多等待多久
+
   LogFileManager file_manager_;  /// 管理所有的日志文件
   LogEntryBuffer entry_buffer_;  /// 缓存日志
 
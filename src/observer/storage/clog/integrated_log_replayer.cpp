@@ -14,35 +14,241 @@ See the Mulan PSL v2 for more details. */
 
 #include "storage/clog/integrated_log_replayer.h"
 #include "storage/clog/log_entry.h"
+#include "storage/buffer/page.h"
+#include "common/lang/condition_variable.h"
+#include "common/lang/deque.h"
+#include "common/lang/mutex.h"
+#include "common/lang/string.h"
+#include "common/lang/thread.h"
+#include "common/log/log.h"
+#include "common/thread/thread_util.h"
 
-IntegratedLogReplayer::IntegratedLogReplayer(BufferPoolManager &bpm)
-    : buffer_pool_log_replayer_(bpm),
-      record_log_replayer_(bpm),
-      bplus_tree_log_replayer_(bpm),
-      trx_log_replayer_(nullptr)
+/**
+ * @brief 页面日志回放线程
+ * @details 每个线程有一个有界的日志队列，分发线程按照LSN顺序放入日志，回放线程按照顺序取出回放。
+ * 队列满时分发线程会阻塞，避免日志全部堆积在内存中。
+ */
+class IntegratedLogReplayer::ReplayWorker
+{
+public:
+  ReplayWorker(IntegratedLogReplayer &owner, int index) : owner_(owner), index_(index) {}
+  ~ReplayWorker() { stop(); }
+
+  void start() { thread_ = thread(&ReplayWorker::thread_func, this); }
+
+  void stop()
+  {
+    {
+      lock_guard guard(mutex_);
+      running_ = false;
+    }
+    not_empty_cond_.notify_all();
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+
+  /// 放入一条日志。队列满时阻塞等待
+  void push(LogEntry &&entry)
+  {
+    unique_lock lock(mutex_);
+    not_full_cond_.wait(lock, [this]() { return queue_.size() < max_queue_size_; });
+    queue_.emplace_back(std::move(entry));
+    not_empty_cond_.notify_one();
+  }
+
+  /// 等待队列中的日志全部回放完成
+  void wait_idle()
+  {
+    unique_lock lock(mutex_);
+    idle_cond_.wait(lock, [this]() { return queue_.empty() && !busy_; });
+  }
+
+private:
+  void thread_func()
+  {
+    common::thread_set_name(("ReplayWorker" + to_string(index_)).c_str());
+
+    unique_lock lock(mutex_);
+    while (true) {
+      not_empty_cond_.wait(lock, [this]() { return !queue_.empty() || !running_; });
+      if (queue_.empty()) {
+        break;
+      }
+
+      LogEntry entry = std::move(queue_.front());
+      queue_.pop_front();
+      busy_ = true;
+      not_full_cond_.notify_one();
+      lock.unlock();
+
+      // 已经有线程出错时，剩余的日志不再回放，只是丢弃，避免分发线程阻塞
+      if (OB_SUCC(owner_.worker_rc_.load())) {
+        RC rc = owner_.replay_in_place(entry);
+        if (OB_FAIL(rc)) {
+          LOG_WARN("failed to replay log entry in worker %d. entry=%s, rc=%s",
+                   index_, entry.to_string().c_str(), strrc(rc));
+          owner_.set_worker_error(rc);
+        }
+      }
+
+      lock.lock();
+      busy_ = false;
+      if (queue_.empty()) {
+        idle_cond_.notify_all();
+      }
+    }
+  }
+
+private:
+  static constexpr size_t max_queue_size_ = 1024;
+
+  IntegratedLogReplayer &owner_;
+  int                    index_ = 0;
+  thread                 thread_;
+
+  mutex              mutex_;
+  condition_variable not_empty_cond_;
+  condition_variable not_full_cond_;
+  condition_variable idle_cond_;
+  deque<LogEntry>    queue_;
+  bool               running_ = true;
+  bool               busy_    = false;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+IntegratedLogReplayer::IntegratedLogReplayer(BufferPoolManager &bpm, int replay_thread_num /* = 0 */)
+    : IntegratedLogReplayer(bpm, nullptr, replay_thread_num)
 {}
 
-IntegratedLogReplayer::IntegratedLogReplayer(BufferPoolManager &bpm, unique_ptr<LogReplayer> trx_log_replayer)
+IntegratedLogReplayer::IntegratedLogReplayer(
+    BufferPoolManager &bpm, unique_ptr<LogReplayer> trx_log_replayer, int replay_thread_num /* = 0 */)
     : buffer_pool_log_replayer_(bpm),
       record_log_replayer_(bpm),
       bplus_tree_log_replayer_(bpm),
+      hash_index_log_replayer_(bpm),
       trx_log_replayer_(std::move(trx_log_replayer))
-{}
+{
+  for (int i = 0; i < replay_thread_num; i++) {
+    workers_.emplace_back(make_unique<ReplayWorker>(*this, i));
+    workers_.back()->start();
+  }
+
+  if (replay_thread_num > 0) {
+    LOG_INFO("log replayer use %d threads to replay page logs", replay_thread_num);
+  }
+}
+
+IntegratedLogReplayer::~IntegratedLogReplayer()
+{
+  // 需要先停掉回放线程，线程中会访问其它成员
+  workers_.clear();
+}
 
 RC IntegratedLogReplayer::replay(const LogEntry &entry)
+{
+  RC rc = worker_rc_.load();
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  const int worker_index = partition(entry);
+  if (worker_index < 0) {
+    // 事务日志回放时只记录事务的状态，不访问页面，所以不需要等待页面日志回放完成。
+    // 依赖页面内容的回滚操作在 on_done 中执行
+    return replay_in_place(entry);
+  }
+
+  vector<char> data(entry.data(), entry.data() + entry.payload_size());
+  LogEntry     copied_entry;
+  rc = copied_entry.init(entry.lsn(), entry.module(), std::move(data));
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to copy log entry. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  workers_[worker_index]->push(std::move(copied_entry));
+  return RC::SUCCESS;
+}
+
+RC IntegratedLogReplayer::replay_in_place(const LogEntry &entry)
 {
   switch (entry.module().id()) {
     case LogModule::Id::BUFFER_POOL: return buffer_pool_log_replayer_.replay(entry);
     case LogModule::Id::RECORD_MANAGER: return record_log_replayer_.replay(entry);
     case LogModule::Id::BPLUS_TREE: return bplus_tree_log_replayer_.replay(entry);
+    case LogModule::Id::HASH_INDEX: return hash_index_log_replayer_.replay(entry);
     case LogModule::Id::TRANSACTION: return trx_log_replayer_->replay(entry);
     default: return RC::INVALID_ARGUMENT;
   }
 }
 
+int IntegratedLogReplayer::partition(const LogEntry &entry) const
+{
+  if (workers_.empty()) {
+    return -1;
+  }
+
+  int32_t buffer_pool_id = -1;
+  PageNum page_num       = BP_INVALID_PAGE_NUM;
+  switch (entry.module().id()) {
+    case LogModule::Id::BUFFER_POOL: {
+      // 分配、释放页面修改的都是缓冲池的头页面
+      if (entry.payload_size() != sizeof(BufferPoolLogEntry)) {
+        return -1;
+      }
+      buffer_pool_id = reinterpret_cast<const BufferPoolLogEntry *>(entry.data())->buffer_pool_id;
+      page_num       = BP_HEADER_PAGE;
+    } break;
+    case LogModule::Id::RECORD_MANAGER: {
+      if (entry.payload_size() < RecordLogHeader::SIZE) {
+        return -1;
+      }
+      auto log_header = reinterpret_cast<const RecordLogHeader *>(entry.data());
+      buffer_pool_id  = log_header->buffer_pool_id;
+      page_num        = log_header->page_num;
+    } break;
+    case LogModule::Id::BPLUS_TREE:
+    case LogModule::Id::HASH_INDEX: {
+      // 一条B+树或哈希索引日志会修改多个页面，整个索引由同一个线程回放
+      if (entry.payload_size() < static_cast<int32_t>(sizeof(int32_t))) {
+        return -1;
+      }
+      memcpy(&buffer_pool_id, entry.data(), sizeof(buffer_pool_id));
+    } break;
+    default: {
+      return -1;
+    }
+  }
+
+  const uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(buffer_pool_id)) << 32) |
+                       static_cast<uint32_t>(page_num);
+  return static_cast<int>(hash<uint64_t>()(key) % workers_.size());
+}
+
+void IntegratedLogReplayer::set_worker_error(RC rc)
+{
+  RC expected = RC::SUCCESS;
+  worker_rc_.compare_exchange_strong(expected, rc);
+}
+
+RC IntegratedLogReplayer::wait_replay_done()
+{
+  for (auto &worker : workers_) {
+    worker->wait_idle();
+  }
+  return worker_rc_.load();
+}
+
 RC IntegratedLogReplayer::on_done()
 {
-  RC rc = buffer_pool_log_replayer_.on_done();
+  RC rc = wait_replay_done();
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to replay page logs. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  rc = buffer_pool_log_replayer_.on_done();
   if (OB_FAIL(rc)) {
     LOG_WARN("failed to do buffer pool log replay. rc=%s", strrc(rc));
     return rc;
@@ -59,11 +265,19 @@ RC IntegratedLogReplayer::on_done()
     return rc;
   }
 
-  rc = trx_log_replayer_->on_done();
+  rc = hash_index_log_replayer_.on_done();
   if (OB_FAIL(rc)) {
-    LOG_WARN("failed to do mvcc trx log replay. rc=%s", strrc(rc));
+    LOG_WARN("failed to do hash index log replay. rc=%s", strrc(rc));
     return rc;
   }
 
+  if (trx_log_replayer_) {
+    rc = trx_log_replayer_->on_done();
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to do mvcc trx log replay. rc=%s", strrc(rc));
+      return rc;
+    }
+  }
+
   return RC::SUCCESS;
-}
\ No newline at end of file
+}
@@ -18,14 +18,22 @@ See the Mulan PSL v2 for more details. */
 #include "storage/buffer/buffer_pool_log.h"
 #include "storage/record/record_log.h"
 #include "storage/index/bplus_tree_log.h"
+#include "storage/index/hash_index_log.h"
 #include "storage/trx/mvcc_trx_log.h"
+#include "common/lang/atomic.h"
+#include "common/lang/memory.h"
+#include "common/lang/vector.h"
 
 class BufferPoolManager;
 
 /**
  * @brief 整体日志回放类
  * @ingroup Clog
- * @details 负责回放所有日志，是其它各模块日志回放的分发器
+ * @details 负责回放所有日志，是其它各模块日志回放的分发器。
+ * 如果指定了回放线程数，页面级别的日志(buffer pool、record、B+树)会按照 (buffer_pool_id, page_num)
+ * 分发到不同的回放线程上执行，同一个页面的日志总是由同一个线程按照LSN顺序回放。
+ * 一棵B+树或一个哈希索引的一条日志会修改多个页面，所以同一个索引的日志都由同一个线程回放。
+ * 事务日志不涉及页面修改，仍然由调用者线程按照顺序回放。
  */
 class IntegratedLogReplayer : public LogReplayer
 {
@@ -35,26 +43,54 @@ public:
    * @details 在做恢复时，我们通常需要一个 BufferPoolManager 对象，因为恢复过程中需要读取磁盘页。
    * BufferPoolManager 在对应MySQL中，可以类比table space 的管理器。但是在这里，一个表可能会有多个table space(buffer
    * pool)。 比如一个数据文件、多个索引文件。
+   * @param replay_thread_num 页面日志的回放线程数。0表示在调用者线程中串行回放
    */
-  IntegratedLogReplayer(BufferPoolManager &bpm);
+  IntegratedLogReplayer(BufferPoolManager &bpm, int replay_thread_num = 0);
 
   /**
    * @brief 构造函数
    * @details
    * 区别于另一个构造函数，这个构造函数可以指定不同的事务日志回放器。比如进程启动时可以指定选择使用VacuousTrx还是MvccTrx。
    */
-  IntegratedLogReplayer(BufferPoolManager &bpm, unique_ptr<LogReplayer> trx_log_replayer);
-  virtual ~IntegratedLogReplayer() = default;
+  IntegratedLogReplayer(
+      BufferPoolManager &bpm, unique_ptr<LogReplayer> trx_log_replayer, int replay_thread_num = 0);
+  virtual ~IntegratedLogReplayer();
 
   //! @copydoc LogReplayer::replay
   RC replay(const LogEntry &entry) override;
 
+  //! @copydoc LogReplayer::wait_replay_done
+  RC wait_replay_done() override;
+
   //! @copydoc LogReplayer::on_done
   RC on_done() override;
 
+private:
+  class ReplayWorker;
+
+  /**
+   * @brief 在当前线程中回放一条日志
+   */
+  RC replay_in_place(const LogEntry &entry);
+
+  /**
+   * @brief 计算页面级别日志应该由哪个回放线程处理
+   * @return 回放线程的下标。返回-1表示这条日志需要在当前线程中回放
+   */
+  int partition(const LogEntry &entry) const;
+
+  /**
+   * @brief 回放线程出错时调用，只记录第一个错误
+   */
+  void set_worker_error(RC rc);
+
 private:
   BufferPoolLogReplayer   buffer_pool_log_replayer_;  ///< 缓冲池日志回放器
   RecordLogReplayer       record_log_replayer_;       ///< record manager 日志回放器
   BplusTreeLogReplayer    bplus_tree_log_replayer_;   ///< bplus tree 日志回放器
+  HashIndexLogReplayer    hash_index_log_replayer_;   ///< 哈希索引日志回放器
   unique_ptr<LogReplayer> trx_log_replayer_;          ///< trx 日志回放器
+
+  vector<unique_ptr<ReplayWorker>> workers_;                 ///< 页面日志回放线程
+  atomic<RC>                       worker_rc_{RC::SUCCESS};  ///< 回放线程遇到的第一个错误
 };
\ No newline at end of file
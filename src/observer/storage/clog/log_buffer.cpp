@@ -14,93 +14,244 @@ See the Mulan PSL v2 for more details. */
 
 #include "storage/clog/log_buffer.h"
 #include "storage/clog/log_file.h"
-#include "common/lang/chrono.h"
+#include "common/lang/algorithm.h"
+#include "common/lang/thread.h"
 
 using namespace common;
 
 RC LogEntryBuffer::init(LSN lsn, int32_t max_bytes /*= 0*/)
 {
-  current_lsn_.store(lsn);
-  flushed_lsn_.store(lsn);
-
   if (max_bytes > 0) {
     max_bytes_ = max_bytes;
   }
+
+  // 缓冲区至少要能放下一条最大的日志
+  const int64_t capacity = max(static_cast<int64_t>(max_bytes_), static_cast<int64_t>(LogEntry::max_size()));
+  // 每条日志至少有一个日志头，缓冲区中的日志条数不会超过 published_slots_。
+  // 它还需要远小于 reserved_ 中序号的表示范围
+  const int64_t published_slots = capacity / LogHeader::SIZE + 1;
+  ASSERT(published_slots < static_cast<int64_t>(INDEX_MASK / 2), "log buffer is too large. capacity=%ld", capacity);
+
+  if (capacity != capacity_) {
+    ring_            = make_unique<char[]>(capacity);
+    published_       = make_unique<atomic<int64_t>[]>(published_slots);
+    capacity_        = capacity;
+    published_slots_ = published_slots;
+  }
+
+  for (int64_t i = 0; i < published_slots_; i++) {
+    published_[i].store(0);
+  }
+
+  base_lsn_ = lsn;
+  reserved_.store(0);
+  flushed_index_.store(0);
+  flushed_position_.store(0);
+  flushed_lsn_.store(lsn);
   return RC::SUCCESS;
 }
 
-RC LogEntryBuffer::append(LSN &lsn, LogModule::Id module_id, vector<char> &&data)
+RC LogEntryBuffer::append(LSN &lsn, LogModule::Id module_id, span<const char> data)
 {
-  return append(lsn, LogModule(module_id), std::move(data));
+  return append(lsn, LogModule(module_id), data);
 }
 
-RC LogEntryBuffer::append(LSN &lsn, LogModule module, vector<char> &&data)
+RC LogEntryBuffer::append(LSN &lsn, LogModule module, span<const char> data)
 {
-  /// 控制当前buffer使用的内存
-  /// 简单粗暴，强制原地等待
-  /// 但是如果当前想要新插入的日志比较大，不会做控制。所以理论上容纳的最大buffer内存是2*max_bytes_
-  while (bytes_.load() >= max_bytes_) {
-    this_thread::sleep_for(chrono::milliseconds(10));
-  }
+  ASSERT(ring_ != nullptr, "log entry buffer is not initialized");
 
-  LogEntry entry;
-  RC rc = entry.init(lsn, module, std::move(data));
-  if (OB_FAIL(rc)) {
-    LOG_WARN("failed to init log entry. rc=%s", strrc(rc));
-    return rc;
+  if (static_cast<int64_t>(data.size()) > LogEntry::max_payload_size()) {
+    LOG_DEBUG("log entry size is too large. size=%d, max_payload_size=%d", data.size(), LogEntry::max_payload_size());
+    return RC::INVALID_ARGUMENT;
   }
 
-  lock_guard guard(mutex_);
-  lsn = ++current_lsn_;
-  entry.set_lsn(lsn);
+  const int32_t total_size = LogHeader::SIZE + static_cast<int32_t>(data.size());
+
+  int64_t index    = 0;
+  int64_t position = 0;
+  reserve(total_size, index, position);
+
+  /// 控制当前buffer使用的内存
+  /// 在申请之后等待，已经申请的空间一定会被写入，否则刷盘线程无法继续
+  wait_for_space(position + total_size);
+
+  lsn = base_lsn_ + index + 1;
 
-  entries_.push_back(std::move(entry));
-  bytes_ += entry.total_size();
+  LogHeader header;
+  header.lsn       = lsn;
+  header.size      = static_cast<int32_t>(data.size());
+  header.module_id = module.index();
+  copy_in(position, reinterpret_cast<const char *>(&header), LogHeader::SIZE);
+  copy_in(position + LogHeader::SIZE, data.data(), header.size);
+
+  published_[index % published_slots_].store(index + 1, std::memory_order_release);
   return RC::SUCCESS;
 }
 
+void LogEntryBuffer::reserve(int32_t size, int64_t &index, int64_t &position)
+{
+  // 读取参考值一定要在 fetch_add 之前，这样它们一定不大于申请到的序号和位置
+  const int64_t ref_index    = flushed_index_.load();
+  const int64_t ref_position = flushed_position_.load();
+
+  const uint64_t reserved = reserved_.fetch_add((uint64_t(1) << POSITION_BITS) + static_cast<uint64_t>(size));
+  decode(reserved, ref_index, ref_position, index, position);
+}
+
+void LogEntryBuffer::decode(
+    uint64_t reserved, int64_t ref_index, int64_t ref_position, int64_t &index, int64_t &position) const
+{
+  const uint64_t position_bits = reserved & POSITION_MASK;
+  position = ref_position + static_cast<int64_t>((position_bits - static_cast<uint64_t>(ref_position)) & POSITION_MASK);
+
+  // 位置每回绕一次，都会向序号进位一次
+  const uint64_t wraps      = static_cast<uint64_t>(position) >> POSITION_BITS;
+  const uint64_t index_bits = ((reserved >> POSITION_BITS) - wraps) & INDEX_MASK;
+  index = ref_index + static_cast<int64_t>((index_bits - static_cast<uint64_t>(ref_index)) & INDEX_MASK);
+}
+
+void LogEntryBuffer::wait_for_space(int64_t end_position)
+{
+  auto has_space = [this, end_position]() { return end_position - flushed_position_.load() <= capacity_; };
+
+  // 刷盘通常很快，先自旋一小会儿
+  const int spin_times = 100;
+  for (int i = 0; i < spin_times; i++) {
+    if (has_space()) {
+      return;
+    }
+    this_thread::yield();
+  }
+
+  unique_lock lock(space_mutex_);
+  space_waiters_++;
+  space_cond_.wait(lock, has_space);
+  space_waiters_--;
+}
+
+void LogEntryBuffer::copy_in(int64_t position, const char *data, int32_t size)
+{
+  const int64_t offset     = position % capacity_;
+  const int64_t first_part = min(static_cast<int64_t>(size), capacity_ - offset);
+  memcpy(ring_.get() + offset, data, first_part);
+  if (first_part < size) {
+    memcpy(ring_.get(), data + first_part, size - first_part);
+  }
+}
+
+void LogEntryBuffer::copy_out(int64_t position, char *data, int32_t size) const
+{
+  const int64_t offset     = position % capacity_;
+  const int64_t first_part = min(static_cast<int64_t>(size), capacity_ - offset);
+  memcpy(data, ring_.get() + offset, first_part);
+  if (first_part < size) {
+    memcpy(data + first_part, ring_.get(), size - first_part);
+  }
+}
+
 RC LogEntryBuffer::flush(LogFileWriter &writer, int &count)
 {
   count = 0;
 
-  while (entry_number() > 0) {
-    LogEntry entry;
-    {
-      lock_guard guard(mutex_);
-      if (entries_.empty()) {
-        break;
-      }
-
-      LogEntry &front_entry = entries_.front();
-      ASSERT(front_entry.lsn() > 0 && front_entry.payload_size() > 0, "invalid log entry");
-      entry = std::move(entries_.front());
-      ASSERT(entry.payload_size() > 0 && entry.lsn() > 0, "invalid log entry");
-      entries_.pop_front();
-      bytes_ -= entry.total_size();
+  // 只有刷盘线程会修改 flushed_index_ 和 flushed_position_
+  int64_t       index          = flushed_index_.load();
+  const int64_t start_position = flushed_position_.load();
+  int64_t       end_position   = start_position;
+
+  LSN  first_lsn = 0;
+  LSN  last_lsn  = 0;
+  bool file_full = false;
+  while (published_ != nullptr && published_[index % published_slots_].load(std::memory_order_acquire) == index + 1) {
+    LogHeader header;
+    copy_out(end_position, reinterpret_cast<char *>(&header), LogHeader::SIZE);
+    if (header.lsn > writer.end_lsn()) {
+      file_full = true;
+      break;
+    }
+
+    const int64_t entry_size = LogHeader::SIZE + header.size;
+    if (count > 0 && end_position + entry_size - start_position > max_bytes_) {
+      break;
     }
-    
-    RC rc = writer.write(entry);
-    if (OB_FAIL(rc)) {
-      lock_guard guard(mutex_);
-      entries_.emplace_front(std::move(entry));
-      LogEntry &front_entry = entries_.front();
-      ASSERT(front_entry.lsn() > 0 && front_entry.payload_size() > 0, "invalid log entry");
-      return rc;
-    } else {
-      ++count;
-      flushed_lsn_ = entry.lsn();
+
+    if (count == 0) {
+      first_lsn = header.lsn;
     }
+    last_lsn = header.lsn;
+    end_position += entry_size;
+    index++;
+    count++;
+  }
+
+  if (count == 0) {
+    return file_full ? RC::LOG_FILE_FULL : RC::SUCCESS;
+  }
+
+  // 日志在环形缓冲区中通常是连续的，直接写入文件。跨过缓冲区尾部时才需要拷贝一次
+  const int64_t offset = start_position % capacity_;
+  const int64_t size   = end_position - start_position;
+  span<const char> data;
+  if (offset + size <= capacity_) {
+    data = span<const char>(ring_.get() + offset, size);
+  } else {
+    flush_buffer_.resize(size);
+    copy_out(start_position, flush_buffer_.data(), static_cast<int32_t>(size));
+    data = span<const char>(flush_buffer_.data(), size);
+  }
+
+  RC rc = writer.write_batch(data, first_lsn, last_lsn);
+  if (OB_SUCC(rc)) {
+    rc = writer.sync();
+  }
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to flush log entries. first_lsn=%ld, last_lsn=%ld, rc=%s", first_lsn, last_lsn, strrc(rc));
+    count = 0;
+    return rc;
+  }
+
+  flushed_lsn_.store(last_lsn);
+  flushed_index_.store(index);
+  flushed_position_.store(end_position);
+
+  if (space_waiters_.load() > 0) {
+    {
+      // 加锁是为了避免等待者在检查条件之后、进入等待之前错过通知
+      lock_guard guard(space_mutex_);
+    }
+    space_cond_.notify_all();
   }
-  
   return RC::SUCCESS;
 }
 
 int64_t LogEntryBuffer::bytes() const
 {
-  return bytes_.load();
+  const int64_t ref_index    = flushed_index_.load();
+  const int64_t ref_position = flushed_position_.load();
+
+  int64_t index    = 0;
+  int64_t position = 0;
+  decode(reserved_.load(), ref_index, ref_position, index, position);
+  return position - ref_position;
 }
 
 int32_t LogEntryBuffer::entry_number() const
 {
-  return entries_.size();
+  const int64_t ref_index    = flushed_index_.load();
+  const int64_t ref_position = flushed_position_.load();
+
+  int64_t index    = 0;
+  int64_t position = 0;
+  decode(reserved_.load(), ref_index, ref_position, index, position);
+  return static_cast<int32_t>(index - ref_index);
+}
+
+LSN LogEntryBuffer::current_lsn() const
+{
+  const int64_t ref_index    = flushed_index_.load();
+  const int64_t ref_position = flushed_position_.load();
+
+  int64_t index    = 0;
+  int64_t position = 0;
+  decode(reserved_.load(), ref_index, ref_position, index, position);
+  return base_lsn_ + index;
 }
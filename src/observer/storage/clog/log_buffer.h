@@ -17,8 +17,10 @@ See the Mulan PSL v2 for more details. */
 #include "common/sys/rc.h"
 #include "common/types.h"
 #include "common/lang/mutex.h"
+#include "common/lang/condition_variable.h"
 #include "common/lang/vector.h"
-#include "common/lang/deque.h"
+#include "common/lang/span.h"
+#include "common/lang/memory.h"
 #include "common/lang/atomic.h"
 #include "storage/clog/log_module.h"
 #include "storage/clog/log_entry.h"
@@ -29,8 +31,12 @@ class LogFileWriter;
  * @brief 日志数据缓冲区
  * @ingroup CLog
  * @details 缓存一部分日志在内存中而不是直接写入磁盘。
- * 这里的缓存没有考虑高性能操作，比如使用预分配内存、环形缓冲池等。
- * 在生产数据库中，通常会使用预分配内存形式的缓存来提高性能，并且可以减少内存碎片。
+ * 缓冲区是一块预分配的环形内存，日志按照文件中的格式(LogHeader + payload)直接存放在里面，
+ * 写日志时不需要申请内存，也不需要加全局锁：
+ * - 写日志的线程通过一次 fetch_add 同时申请LSN和一段字节空间；
+ * - 等待这段空间可用(刷盘线程已经把之前的日志刷走)后，把日志拷贝进去；
+ * - 在 published_ 中设置这条日志的完成标记。
+ * 刷盘线程按照LSN顺序检查完成标记，把连续完成的一段日志直接从环形缓冲区写入文件。
  */
 class LogEntryBuffer
 {
@@ -38,17 +44,27 @@ public:
   LogEntryBuffer()  = default;
   ~LogEntryBuffer() = default;
 
+  /**
+   * @brief 初始化缓冲区
+   * @details 可以调用多次，每次调用都会清空缓冲区。调用时不能有其它线程在访问缓冲区。
+   * @param lsn 当前最大的LSN，下一条日志的LSN从 lsn + 1 开始
+   * @param max_bytes 缓冲区大小
+   */
   RC init(LSN lsn, int32_t max_bytes = 0);
 
   /**
    * @brief 在缓冲区中追加一条日志
+   * @details 如果缓冲区满了，会等待刷盘线程腾出空间
    */
-  RC append(LSN &lsn, LogModule::Id module_id, vector<char> &&data);
-  RC append(LSN &lsn, LogModule module, vector<char> &&data);
+  RC append(LSN &lsn, LogModule::Id module_id, span<const char> data);
+  RC append(LSN &lsn, LogModule module, span<const char> data);
 
   /**
    * @brief 刷新缓冲区中的日志到磁盘
-   *
+   * @details 组提交(group commit)：一次取出尽可能多的已经写完的日志，
+   * 只调用一次写文件和一次刷盘。一次最多刷新 max_bytes_ 字节，并且不会超过当前日志文件
+   * 允许的最大LSN。如果缓冲区中第一条日志就不能写入当前文件，返回 LOG_FILE_FULL。
+   * 只能在一个线程中调用。
    * @param file_handle 使用它来写文件
    * @param count 刷了多少条日志
    */
@@ -64,16 +80,59 @@ public:
    */
   int32_t entry_number() const;
 
-  LSN current_lsn() const { return current_lsn_.load(); }
+  LSN current_lsn() const;
   LSN flushed_lsn() const { return flushed_lsn_.load(); }
 
 private:
-  mutex           mutex_;  /// 当前数据结构一定会在多线程中访问，所以强制使用有效的锁，而不是有条件生效的common::Mutex
-  deque<LogEntry> entries_;  /// 日志缓冲区
-  atomic<int64_t> bytes_;    /// 当前缓冲区中的日志数据大小
+  /**
+   * @brief 申请一条日志的LSN和空间
+   * @param size 日志大小，包含日志头
+   * @param[out] index 日志的序号，从0开始。日志的LSN是 base_lsn_ + index + 1
+   * @param[out] position 日志在环形缓冲区中的逻辑位置，一直递增，不会回绕
+   */
+  void reserve(int32_t size, int64_t &index, int64_t &position);
+
+  /**
+   * @brief 解析 reserved_ 中的日志序号和位置
+   * @details reserved_ 中只存放了序号和位置的低位，需要借助一个不大于它们的参考值还原出完整的数值。
+   * 刷盘的位置总是可以作为参考值，在缓冲区中的日志条数和字节数都远小于低位能表示的范围。
+   */
+  void decode(uint64_t reserved, int64_t ref_index, int64_t ref_position, int64_t &index, int64_t &position) const;
+
+  /**
+   * @brief 等待缓冲区中有足够的空间存放 [.., end_position) 的日志
+   * @details 先短暂的自旋，然后在条件变量上等待刷盘线程释放空间
+   */
+  void wait_for_space(int64_t end_position);
+
+  void copy_in(int64_t position, const char *data, int32_t size);
+  void copy_out(int64_t position, char *data, int32_t size) const;
+
+private:
+  static constexpr int      POSITION_BITS = 40;
+  static constexpr uint64_t POSITION_MASK = (uint64_t(1) << POSITION_BITS) - 1;
+  static constexpr uint64_t INDEX_MASK    = (uint64_t(1) << (64 - POSITION_BITS)) - 1;
+
+  unique_ptr<char[]>            ring_;             /// 环形缓冲区
+  int64_t                       capacity_ = 0;     /// 环形缓冲区大小
+  unique_ptr<atomic<int64_t>[]> published_;        /// 日志的完成标记，日志 index 写完后设置 published_[index % N] = index + 1
+  int64_t                       published_slots_ = 0;  /// published_ 的大小N，不小于缓冲区中能容纳的日志条数
 
-  atomic<LSN> current_lsn_{0};
-  atomic<LSN> flushed_lsn_{0};
+  /// 高位是日志序号，低位是字节位置。写日志时使用一次 fetch_add 同时申请序号和空间。
+  /// 位置低位溢出时会向序号进位，decode 时会扣除
+  atomic<uint64_t> reserved_{0};
+
+  LSN base_lsn_ = 0;  /// init 时的LSN
+
+  atomic<int64_t> flushed_index_{0};     /// 已经刷盘的日志条数
+  atomic<int64_t> flushed_position_{0};  /// 已经刷盘的日志的结束位置
+  atomic<LSN>     flushed_lsn_{0};
+
+  mutex              space_mutex_;       /// 与 space_cond_ 配合使用
+  condition_variable space_cond_;        /// 缓冲区满时，写日志的线程在这里等待
+  atomic<int32_t>    space_waiters_{0};  /// 有多少线程在等待缓冲区的空间
 
   int32_t max_bytes_ = 4 * 1024 * 1024;  /// 缓冲区最大字节数
+
+  vector<char> flush_buffer_;  /// 刷盘时日志跨过环形缓冲区尾部时使用，只有刷盘线程访问
 };
@@ -13,6 +13,7 @@ See the Mulan PSL v2 for more details. */
 //
 
 #include <fcntl.h>
+#include <unistd.h>
 
 #include "common/lang/string_view.h"
 #include "common/lang/charconv.h"
@@ -20,6 +21,7 @@ See the Mulan PSL v2 for more details. */
 #include "storage/clog/log_file.h"
 #include "storage/clog/log_entry.h"
 #include "common/io/io.h"
+#include "common/io/io_backend.h"
 
 using namespace common;
 
@@ -155,13 +157,23 @@ RC LogFileWriter::open(const char *filename, int end_lsn)
   filename_ = filename;
   end_lsn_ = end_lsn;
 
-  fd_ = ::open(filename, O_WRONLY | O_APPEND | O_CREAT | O_SYNC, 0644);
+  // 不使用O_SYNC，每条日志都同步写入的代价太高。由调用者在写入一批日志后调用 sync 刷盘
+  fd_ = ::open(filename, O_WRONLY | O_APPEND | O_CREAT, 0644);
   if (fd_ < 0) {
     LOG_WARN("open file failed. filename=%s, error=%s", filename, strerror(errno));
     return RC::FILE_OPEN;
   }
 
-  LOG_INFO("open file success. filename=%s, fd=%d", filename, fd_);
+  off_t file_size = lseek(fd_, 0, SEEK_END);
+  if (file_size < 0) {
+    LOG_WARN("failed to get file size. filename=%s, error=%s", filename, strerror(errno));
+    ::close(fd_);
+    fd_ = -1;
+    return RC::IOERR_SEEK;
+  }
+  file_size_ = file_size;
+
+  LOG_INFO("open file success. filename=%s, fd=%d, size=%ld", filename, fd_, file_size_);
   return RC::SUCCESS;
 }
 
@@ -195,22 +207,71 @@ RC LogFileWriter::write(LogEntry &entry)
 
   /// WARNING 这里需要处理日志写一半的情况
   /// 日志只写成功一部分到文件中非常难处理
-  int ret = writen(fd_, reinterpret_cast<const char *>(&entry.header()), LogHeader::SIZE);
+  struct iovec iov[2] = {
+      {const_cast<LogHeader *>(&entry.header()), static_cast<size_t>(LogHeader::SIZE)},
+      {const_cast<char *>(entry.data()), static_cast<size_t>(entry.payload_size())}};
+  common::IoRequest request;
+  request.type   = common::IoRequest::Type::WRITE;
+  request.fd     = fd_;
+  request.iov    = iov;
+  request.iovcnt = 2;
+  request.offset = file_size_;
+
+  int ret = common::IoBackend::instance().submit_and_wait(&request, 1);
   if (0 != ret) {
-    LOG_WARN("write log entry header failed. filename=%s, ret = %d, error=%s, entry=%s", 
-             filename_.c_str(), ret, strerror(errno), entry.to_string().c_str());
+    LOG_WARN("write log entry failed. filename=%s, ret = %d, error=%s, entry=%s", 
+             filename_.c_str(), ret, strerror(ret), entry.to_string().c_str());
     return RC::IOERR_WRITE;
   }
 
-  ret = writen(fd_, entry.data(), entry.payload_size());
+  file_size_ += LogHeader::SIZE + entry.payload_size();
+  last_lsn_ = entry.lsn();
+  LOG_TRACE("write log entry success. filename=%s, entry=%s", filename_.c_str(), entry.to_string().c_str());
+  return RC::SUCCESS;
+}
+
+RC LogFileWriter::write_batch(span<const char> data, LSN first_lsn, LSN last_lsn)
+{
+  if (last_lsn > end_lsn_) {
+    return RC::LOG_FILE_FULL;
+  }
+
+  if (fd_ < 0) {
+    return RC::FILE_NOT_OPENED;
+  }
+
+  if (first_lsn <= last_lsn_ || first_lsn > last_lsn) {
+    LOG_WARN("write log batch failed. invalid lsn. filename=%s, last_lsn=%d, first_lsn=%ld, batch last_lsn=%ld",
+             filename_.c_str(), last_lsn_, first_lsn, last_lsn);
+    return RC::INVALID_ARGUMENT;
+  }
+
+  /// WARNING 与单条写入一样，这里也没有处理日志写一半的情况
+  int ret = common::IoBackend::instance().write(fd_, data.data(), static_cast<int>(data.size()), file_size_);
   if (0 != ret) {
-    LOG_WARN("write log entry payload failed. filename=%s, ret = %d, error=%s, entry=%s", 
-             filename_.c_str(), ret, strerror(errno), entry.to_string().c_str());
+    LOG_WARN("write log batch failed. filename=%s, ret=%d, error=%s, first_lsn=%ld, last_lsn=%ld, size=%ld",
+             filename_.c_str(), ret, strerror(ret), first_lsn, last_lsn, data.size());
     return RC::IOERR_WRITE;
   }
 
-  last_lsn_ = entry.lsn();
-  LOG_TRACE("write log entry success. filename=%s, entry=%s", filename_.c_str(), entry.to_string().c_str());
+  file_size_ += data.size();
+  last_lsn_ = last_lsn;
+  LOG_TRACE("write log batch success. filename=%s, first_lsn=%ld, last_lsn=%ld, size=%ld",
+            filename_.c_str(), first_lsn, last_lsn, data.size());
+  return RC::SUCCESS;
+}
+
+RC LogFileWriter::sync()
+{
+  if (fd_ < 0) {
+    return RC::FILE_NOT_OPENED;
+  }
+
+  int ret = common::IoBackend::instance().sync(fd_, true /*data_only*/);
+  if (0 != ret) {
+    LOG_WARN("sync log file failed. filename=%s, error=%s", filename_.c_str(), strerror(ret));
+    return RC::IOERR_SYNC;
+  }
   return RC::SUCCESS;
 }
 
@@ -298,6 +359,7 @@ RC LogFileManager::list_files(vector<string> &files, LSN start_lsn)
 {
   files.clear();
 
+  lock_guard guard(lock_);
   // 这里的代码是AI自动生成的
   // 其实写的不好，我们只需要找到比start_lsn相等或者小的第一个日志文件就可以了
   for (auto &file : log_files_) {
@@ -311,7 +373,9 @@ RC LogFileManager::list_files(vector<string> &files, LSN start_lsn)
 
 RC LogFileManager::last_file(LogFileWriter &file_writer)
 {
+  unique_lock lock(lock_);
   if (log_files_.empty()) {
+    lock.unlock();
     return next_file(file_writer);
   }
 
@@ -326,6 +390,7 @@ RC LogFileManager::next_file(LogFileWriter &file_writer)
 {
   file_writer.close();
 
+  lock_guard guard(lock_);
   LSN lsn = 0;
   if (!log_files_.empty()) {
     lsn = log_files_.rbegin()->first + max_entry_number_per_file_;
@@ -337,3 +402,29 @@ RC LogFileManager::next_file(LogFileWriter &file_writer)
 
   return file_writer.open(file_path.c_str(), lsn + max_entry_number_per_file_ - 1);
 }
+
+RC LogFileManager::remove_files_before(LSN lsn, int &removed_count)
+{
+  removed_count = 0;
+
+  lock_guard guard(lock_);
+  while (log_files_.size() > 1) {
+    auto iter = log_files_.begin();
+    if (iter->first + max_entry_number_per_file_ - 1 >= lsn) {
+      break;
+    }
+
+    error_code ec;
+    filesystem::remove(iter->second, ec);
+    if (ec) {
+      LOG_WARN("failed to remove log file. file=%s, error=%s", iter->second.c_str(), ec.message().c_str());
+      return RC::IOERR_WRITE;
+    }
+
+    LOG_INFO("log file removed. file=%s, lsn=%ld", iter->second.c_str(), lsn);
+    log_files_.erase(iter);
+    removed_count++;
+  }
+
+  return RC::SUCCESS;
+}
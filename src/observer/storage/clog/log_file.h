@@ -17,10 +17,12 @@ See the Mulan PSL v2 for more details. */
 #include "common/sys/rc.h"
 #include "common/types.h"
 #include "common/lang/map.h"
+#include "common/lang/mutex.h"
 #include "common/lang/functional.h"
 #include "common/lang/filesystem.h"
 #include "common/lang/fstream.h"
 #include "common/lang/string.h"
+#include "common/lang/span.h"
 
 class LogEntry;
 
@@ -73,9 +75,27 @@ public:
   /// @brief 关闭当前文件
   RC close();
 
-  /// @brief 写入一条日志
+  /**
+   * @brief 写入一条日志
+   * @details 文件不是以同步方式打开的，写入后需要调用 sync 才能保证日志落盘
+   */
   RC write(LogEntry &entry);
 
+  /**
+   * @brief 一次性写入多条已经序列化好的日志
+   * @details 用于组提交(group commit)。data 中的日志是连续存放的 LogHeader + payload，
+   * 它们的LSN必须是递增的，并且都不能超过当前文件允许的最大LSN。
+   * @param data 序列化好的日志数据
+   * @param first_lsn 第一条日志的LSN
+   * @param last_lsn 最后一条日志的LSN
+   */
+  RC write_batch(span<const char> data, LSN first_lsn, LSN last_lsn);
+
+  /**
+   * @brief 把已经写入的日志刷新到磁盘
+   */
+  RC sync();
+
   /**
    * @brief 当前文件是否已经打开
    */
@@ -90,11 +110,15 @@ public:
 
   const char *filename() const { return filename_.c_str(); }
 
+  /// @brief 当前文件中允许写入的最大的LSN
+  LSN end_lsn() const { return end_lsn_; }
+
 private:
   string filename_;       /// 日志文件名
-  int    fd_       = -1;  /// 日志文件描述符
-  int    last_lsn_ = 0;   /// 写入的最后一条日志LSN
-  int    end_lsn_  = 0;   /// 当前日志文件中允许写入的最大的LSN，包括这条日志
+  int     fd_        = -1;  /// 日志文件描述符
+  int     last_lsn_  = 0;   /// 写入的最后一条日志LSN
+  int     end_lsn_   = 0;   /// 当前日志文件中允许写入的最大的LSN，包括这条日志
+  int64_t file_size_ = 0;   /// 文件当前的长度，也就是下一次写入的位置
 };
 
 /**
@@ -137,6 +161,14 @@ public:
    */
   RC next_file(LogFileWriter &file_writer);
 
+  /**
+   * @brief 删除不再需要的日志文件
+   * @details 删除所有日志都小于 lsn 的日志文件。最后一个日志文件正在写入，不会删除
+   * @param lsn 小于这个LSN的日志都不再需要了
+   * @param removed_count 返回删除了多少个文件
+   */
+  RC remove_files_before(LSN lsn, int &removed_count);
+
 private:
   /**
    * @brief 从文件名称中获取LSN
@@ -151,5 +183,6 @@ private:
   filesystem::path directory_;                  /// 日志文件存放的目录
   int              max_entry_number_per_file_;  /// 一个文件最大允许存放多少条日志
 
+  mutex                      lock_;       /// 保护 log_files_。写日志和回收日志在不同的线程中
   map<LSN, filesystem::path> log_files_;  /// 日志文件名和第一个LSN的映射
 };
@@ -96,6 +96,13 @@ public:
 
   virtual LSN current_lsn() const = 0;
 
+  /**
+   * @brief 回收检查点之前的日志
+   * @details 检查点之前的日志对应的修改都已经写回磁盘，恢复时不再需要这些日志
+   * @param check_point_lsn 检查点LSN，恢复时从这个LSN开始重做
+   */
+  virtual RC recycle(LSN check_point_lsn) { return RC::SUCCESS; }
+
   static RC create(const char *name, LogHandler *&handler);
 
 private:
@@ -103,5 +110,5 @@ private:
    * @brief 写入一条日志
    * @details 子类应该重现实现这个函数
    */
-  virtual RC _append(LSN &lsn, LogModule module, vector<char> &&data) = 0;
+  virtual RC _append(LSN &lsn, LogModule module, span<const char> data) = 0;
 };
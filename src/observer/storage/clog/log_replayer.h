@@ -35,6 +35,13 @@ public:
    */
   virtual RC replay(const LogEntry &entry) = 0;
 
+  /**
+   * @brief 等待所有已经提交的日志回放完成
+   * @details 回放器可能会把日志交给后台线程异步回放，日志遍历结束后需要调用这个函数，
+   * 返回的是异步回放过程中遇到的错误
+   */
+  virtual RC wait_replay_done() { return RC::SUCCESS; }
+
   /**
    * @brief 当所有日志回放完成时的回调函数
    */
@@ -0,0 +1,210 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "storage/common/external_sorter.h"
+#include "common/io/io.h"
+#include "common/lang/algorithm.h"
+#include "common/log/log.h"
+
+ExternalSorter::ExternalSorter(int item_size, Comparator comparator, const string &spill_file, size_t memory_limit)
+    : item_size_(item_size), comparator_(std::move(comparator)), spill_file_(spill_file), memory_limit_(memory_limit)
+{}
+
+ExternalSorter::~ExternalSorter()
+{
+  if (spill_fd_ >= 0) {
+    ::close(spill_fd_);
+    spill_fd_ = -1;
+    ::unlink(spill_file_.c_str());
+  }
+}
+
+RC ExternalSorter::add(const char *item)
+{
+  ASSERT(!finished_, "cannot add item after finished");
+
+  items_.insert(items_.end(), item, item + item_size_);
+  item_num_++;
+
+  // 排序时每条数据还需要一个指针
+  const size_t memory_used = items_.size() + items_.size() / item_size_ * sizeof(const char *);
+  if (memory_used >= memory_limit_) {
+    return spill();
+  }
+  return RC::SUCCESS;
+}
+
+void ExternalSorter::sort_in_memory()
+{
+  const size_t num = items_.size() / item_size_;
+  sorted_items_.resize(num);
+  for (size_t i = 0; i < num; i++) {
+    sorted_items_[i] = items_.data() + i * item_size_;
+  }
+
+  sort(sorted_items_.begin(), sorted_items_.end(),
+      [this](const char *left, const char *right) { return comparator_(left, right) < 0; });
+  output_pos_ = 0;
+}
+
+RC ExternalSorter::spill()
+{
+  if (spill_fd_ < 0) {
+    spill_fd_ = ::open(spill_file_.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
+    if (spill_fd_ < 0) {
+      LOG_WARN("failed to create spill file. file=%s, error=%s", spill_file_.c_str(), strerror(errno));
+      return RC::IOERR_OPEN;
+    }
+  }
+
+  sort_in_memory();
+
+  Run run;
+  run.offset   = spill_size_;
+  run.item_num = static_cast<int64_t>(sorted_items_.size());
+
+  // 攒够一批之后再写，避免每条数据一次系统调用
+  const int    batch_items = max(1, RUN_BUFFER_SIZE / item_size_);
+  vector<char> buffer(static_cast<size_t>(batch_items) * item_size_);
+  for (size_t begin = 0; begin < sorted_items_.size(); begin += batch_items) {
+    const size_t end = min(sorted_items_.size(), begin + batch_items);
+    for (size_t i = begin; i < end; i++) {
+      memcpy(buffer.data() + (i - begin) * item_size_, sorted_items_[i], item_size_);
+    }
+
+    const int size = static_cast<int>((end - begin) * item_size_);
+    int       ret  = common::pwriten(spill_fd_, buffer.data(), size, spill_size_);
+    if (ret != 0) {
+      LOG_WARN("failed to write spill file. file=%s, offset=%ld, error=%s",
+               spill_file_.c_str(), spill_size_, strerror(ret));
+      return RC::IOERR_WRITE;
+    }
+    spill_size_ += size;
+  }
+
+  LOG_DEBUG("spill a sorted run. file=%s, run=%d, items=%ld", spill_file_.c_str(), run_num(), run.item_num);
+  runs_.push_back(std::move(run));
+
+  items_.clear();
+  sorted_items_.clear();
+  return RC::SUCCESS;
+}
+
+RC ExternalSorter::finish()
+{
+  ASSERT(!finished_, "sorter has been finished");
+  finished_ = true;
+
+  if (runs_.empty()) {
+    sort_in_memory();
+    return RC::SUCCESS;
+  }
+
+  if (!items_.empty()) {
+    RC rc = spill();
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+  }
+  vector<char>().swap(items_);
+  vector<const char *>().swap(sorted_items_);
+
+  // 所有段平分内存作为读缓冲区
+  const size_t buffer_bytes = min(static_cast<size_t>(RUN_BUFFER_SIZE), memory_limit_ / runs_.size());
+  const int    buffer_items = max(1, static_cast<int>(buffer_bytes / item_size_));
+  for (int i = 0; i < run_num(); i++) {
+    Run &run = runs_[i];
+    run.buffer.resize(static_cast<size_t>(buffer_items) * item_size_);
+    RC rc = fill_run_buffer(run);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+    run_heap_.push_back(i);
+  }
+
+  make_heap(run_heap_.begin(), run_heap_.end(), [this](int left, int right) { return run_greater(left, right); });
+  LOG_INFO("begin to merge sorted runs. file=%s, runs=%d, items=%ld, spill size=%ld",
+           spill_file_.c_str(), run_num(), item_num_, spill_size_);
+  return RC::SUCCESS;
+}
+
+RC ExternalSorter::fill_run_buffer(Run &run)
+{
+  const int64_t capacity = static_cast<int64_t>(run.buffer.size() / item_size_);
+  const int     num      = static_cast<int>(min(capacity, run.item_num - run.read_num));
+
+  run.buffer_pos  = 0;
+  run.buffer_size = num;
+  if (num == 0) {
+    return RC::SUCCESS;
+  }
+
+  const int64_t offset = run.offset + run.read_num * item_size_;
+  int           ret    = common::preadn(spill_fd_, run.buffer.data(), num * item_size_, offset);
+  if (ret != 0) {
+    LOG_WARN("failed to read spill file. file=%s, offset=%ld, ret=%d", spill_file_.c_str(), offset, ret);
+    return RC::IOERR_READ;
+  }
+  run.read_num += num;
+  return RC::SUCCESS;
+}
+
+bool ExternalSorter::run_greater(int left, int right) const
+{
+  return comparator_(runs_[left].current(item_size_), runs_[right].current(item_size_)) > 0;
+}
+
+RC ExternalSorter::next(const char *&item)
+{
+  ASSERT(finished_, "sorter should be finished before fetching items");
+
+  if (runs_.empty()) {
+    if (output_pos_ >= sorted_items_.size()) {
+      return RC::RECORD_EOF;
+    }
+    item = sorted_items_[output_pos_++];
+    return RC::SUCCESS;
+  }
+
+  auto heap_compare = [this](int left, int right) { return run_greater(left, right); };
+
+  // 上次输出的数据在这个段的缓冲区中，现在才可以移动到下一条
+  if (last_run_ >= 0) {
+    Run &run = runs_[last_run_];
+    run.buffer_pos++;
+    if (run.buffer_pos >= run.buffer_size) {
+      RC rc = fill_run_buffer(run);
+      if (OB_FAIL(rc)) {
+        return rc;
+      }
+    }
+
+    if (run.buffer_pos < run.buffer_size) {
+      run_heap_.push_back(last_run_);
+      push_heap(run_heap_.begin(), run_heap_.end(), heap_compare);
+    }
+    last_run_ = -1;
+  }
+
+  if (run_heap_.empty()) {
+    return RC::RECORD_EOF;
+  }
+
+  pop_heap(run_heap_.begin(), run_heap_.end(), heap_compare);
+  last_run_ = run_heap_.back();
+  run_heap_.pop_back();
+
+  item = runs_[last_run_].current(item_size_);
+  return RC::SUCCESS;
+}
@@ -0,0 +1,114 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/sys/rc.h"
+#include "common/lang/functional.h"
+#include "common/lang/string.h"
+#include "common/lang/vector.h"
+
+/**
+ * @brief 定长数据的外部排序
+ * @details 数据先放在内存中，超过内存限制后排好序写到临时文件中，作为一个有序的段(run)。
+ * 所有数据都添加完成后，如果没有写过临时文件，直接在内存中排序；否则对所有段做多路归并。
+ * 所有的段都写在同一个临时文件中，析构时删除。
+ * @code
+ * ExternalSorter sorter(item_size, comparator, "/tmp/xxx.sort", 64 * 1024 * 1024);
+ * sorter.add(item) ...
+ * sorter.finish();
+ * while (OB_SUCC(sorter.next(item))) { ... }
+ * @endcode
+ */
+class ExternalSorter final
+{
+public:
+  using Comparator = function<int(const char *, const char *)>;
+
+  /// 归并时每个段的读缓冲区大小
+  static constexpr int RUN_BUFFER_SIZE = 256 * 1024;
+
+public:
+  /**
+   * @param item_size 每条数据的大小
+   * @param comparator 比较函数，返回值的含义与 memcmp 一样
+   * @param spill_file 临时文件的路径，内存放不下时才会创建
+   * @param memory_limit 最多使用多少内存来排序
+   */
+  ExternalSorter(int item_size, Comparator comparator, const string &spill_file, size_t memory_limit);
+  ~ExternalSorter();
+
+  /**
+   * @brief 添加一条数据
+   */
+  RC add(const char *item);
+
+  /**
+   * @brief 数据添加完成，准备按照顺序输出
+   */
+  RC finish();
+
+  /**
+   * @brief 按照顺序获取下一条数据
+   * @details 返回的数据在下次调用 next 之前有效
+   * @return RECORD_EOF 所有数据都输出完了
+   */
+  RC next(const char *&item);
+
+  /// 一共添加了多少条数据
+  int64_t item_num() const { return item_num_; }
+
+  /// 写到临时文件中的有序段个数
+  int run_num() const { return static_cast<int>(runs_.size()); }
+
+private:
+  /**
+   * @brief 临时文件中的一个有序段
+   */
+  struct Run
+  {
+    int64_t      offset    = 0;  ///< 在临时文件中的起始位置
+    int64_t      item_num  = 0;  ///< 一共有多少条数据
+    int64_t      read_num  = 0;  ///< 已经读到缓冲区中的数据条数
+    vector<char> buffer;
+    int          buffer_pos  = 0;  ///< 下一条数据在缓冲区中的位置(条数)
+    int          buffer_size = 0;  ///< 缓冲区中有效的数据条数
+
+    const char *current(int item_size) const { return buffer.data() + static_cast<size_t>(buffer_pos) * item_size; }
+  };
+
+  /// 对内存中的数据排序，排序的结果放在 sorted_items_ 中
+  void sort_in_memory();
+  /// 对内存中的数据排序，并作为一个新的段写入临时文件
+  RC spill();
+  /// 读取一个段接下来的数据到缓冲区中
+  RC fill_run_buffer(Run &run);
+  /// 归并时，小根堆的比较函数。堆顶是当前最小数据所在的段
+  bool run_greater(int left, int right) const;
+
+private:
+  const int        item_size_;
+  const Comparator comparator_;
+  const string     spill_file_;
+  const size_t     memory_limit_;
+
+  int     spill_fd_    = -1;
+  int64_t spill_size_  = 0;
+  int64_t item_num_    = 0;
+  bool    finished_    = false;
+
+  vector<char>         items_;         ///< 还在内存中的数据
+  vector<const char *> sorted_items_;  ///< 排好序的内存中数据
+  size_t               output_pos_ = 0;
+
+  vector<Run> runs_;
+  vector<int> run_heap_;   ///< 归并使用的小根堆，存放段的下标
+  int         last_run_ = -1;  ///< 上次输出的数据所在的段，下次 next 时再前进
+};
@@ -17,10 +17,15 @@ See the Mulan PSL v2 for more details. */
 #include <fcntl.h>
 #include <sys/stat.h>
 
+#include "common/conf/ini.h"
 #include "common/lang/string.h"
 #include "common/log/log.h"
 #include "common/os/path.h"
 #include "common/global_context.h"
+#include "common/lang/algorithm.h"
+#include "common/lang/chrono.h"
+#include "common/lang/limits.h"
+#include "common/thread/thread_util.h"
 #include "storage/common/meta_util.h"
 #include "storage/table/table.h"
 #include "storage/table/table_meta.h"
@@ -32,6 +37,10 @@ using namespace common;
 
 Db::~Db()
 {
+  // 检查点和回收线程会访问表和日志，需要最先停止
+  stop_vacuum_thread();
+  stop_checkpoint_thread();
+
   for (auto &iter : opened_tables_) {
     delete iter.second;
   }
@@ -140,6 +149,19 @@ RC Db::init(const char *name, const char *dbpath, const char *trx_kit_name, cons
     return rc;
   }
 
+#ifdef CONCURRENCY
+  // 回放日志时也会产生大量脏页，清理线程在恢复之前启动
+  int page_cleaner_thread_num = 1;
+  int page_cleaner_low_watermark = -1;
+  str_to_val(get_properties()->get("PAGE_CLEANER_THREAD_NUM", "1", "STORAGE"), page_cleaner_thread_num);
+  str_to_val(get_properties()->get("PAGE_CLEANER_LOW_WATERMARK", "-1", "STORAGE"), page_cleaner_low_watermark);
+  rc = buffer_pool_manager_->page_cleaner().start(page_cleaner_thread_num, page_cleaner_low_watermark);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to start page cleaner. rc=%s", strrc(rc));
+    return rc;
+  }
+#endif
+
   // 尝试恢复数据库，重做redo日志
   rc = recover();
   if (OB_FAIL(rc)) {
@@ -147,6 +169,8 @@ RC Db::init(const char *name, const char *dbpath, const char *trx_kit_name, cons
     return rc;
   }
 
+  start_checkpoint_thread();
+  start_vacuum_thread();
   return rc;
 }
 
@@ -171,7 +195,10 @@ RC Db::create_table(const char *table_name, span<const AttrInfoSqlNode> attribut
     return rc;
   }
 
-  opened_tables_[table_name] = table;
+  {
+    lock_guard<mutex> guard(vacuum_mutex_);
+    opened_tables_[table_name] = table;
+  }
   LOG_INFO("Create table success. table name=%s, table_id:%d", table_name, table_id);
   return RC::SUCCESS;
 }
@@ -281,8 +308,8 @@ RC Db::sync()
     return rc;
   }
 
-  check_point_lsn_ = current_lsn;
-  rc               = flush_meta();
+  lock_guard<mutex> guard(checkpoint_mutex_);
+  rc = advance_check_point(current_lsn);
   if (OB_FAIL(rc)) {
     LOG_ERROR("Failed to flush meta. db=%s, rc=%d:%s", name_.c_str(), rc, strrc(rc));
     return rc;
@@ -291,6 +318,198 @@ RC Db::sync()
   return rc;
 }
 
+RC Db::checkpoint()
+{
+  lock_guard<mutex> guard(checkpoint_mutex_);
+
+  // 在刷脏页之前记录当前的LSN。之后产生的脏页，recLSN一定比它大
+  LSN current_lsn = log_handler_->current_lsn();
+
+  LSN min_rec_lsn = numeric_limits<LSN>::max();
+  RC  rc          = buffer_pool_manager_->flush_dirty_pages(checkpoint_flush_pages_, min_rec_lsn);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to flush dirty pages. db=%s, rc=%s", name_.c_str(), strrc(rc));
+    return rc;
+  }
+
+  // 刷出去的页面可能还在double write buffer中，写到数据文件后，检查点才能越过这些页面的日志
+  auto dblwr_buffer = static_cast<DiskDoubleWriteBuffer *>(buffer_pool_manager_->get_dblwr_buffer());
+  rc                = dblwr_buffer->flush_page();
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to flush double write buffer. db=%s, rc=%s", name_.c_str(), strrc(rc));
+    return rc;
+  }
+
+  LSN check_point_lsn = min(current_lsn + 1, min_rec_lsn);
+
+  // 未结束的事务在恢复时需要回滚，它们的日志也要保留
+  LSN min_active_trx_lsn = trx_kit_->min_active_trx_lsn();
+  if (min_active_trx_lsn >= 0) {
+    check_point_lsn = min(check_point_lsn, min_active_trx_lsn + 1);
+  }
+
+  return advance_check_point(check_point_lsn);
+}
+
+RC Db::advance_check_point(LSN check_point_lsn)
+{
+  if (check_point_lsn <= check_point_lsn_) {
+    return RC::SUCCESS;
+  }
+
+  LSN old_check_point_lsn = check_point_lsn_;
+  check_point_lsn_        = check_point_lsn;
+
+  RC rc = flush_meta();
+  if (OB_FAIL(rc)) {
+    check_point_lsn_ = old_check_point_lsn;
+    return rc;
+  }
+
+  // 日志文件删除失败不影响数据的正确性，下次检查点时还会尝试
+  log_handler_->recycle(check_point_lsn_);
+  LOG_INFO("check point advanced. db=%s, check_point_lsn=%ld", name_.c_str(), check_point_lsn_);
+  return RC::SUCCESS;
+}
+
+void Db::start_checkpoint_thread()
+{
+  str_to_val(get_properties()->get("CHECKPOINT_INTERVAL_MS", "5000", "STORAGE"), checkpoint_interval_ms_);
+  str_to_val(get_properties()->get("CHECKPOINT_FLUSH_PAGES", "128", "STORAGE"), checkpoint_flush_pages_);
+  if (checkpoint_interval_ms_ <= 0) {
+    LOG_INFO("checkpoint thread is disabled. db=%s", name_.c_str());
+    return;
+  }
+
+#ifndef CONCURRENCY
+  // 没有开启并发编译选项时，页面和buffer pool的锁都是空实现，后台线程不能与前台同时访问页面
+  LOG_INFO("checkpoint thread is disabled because CONCURRENCY is off. db=%s", name_.c_str());
+  return;
+#endif
+
+  checkpoint_running_ = true;
+  checkpoint_thread_  = make_unique<thread>(&Db::checkpoint_thread_func, this);
+  LOG_INFO("checkpoint thread started. db=%s, interval=%dms, flush pages=%d",
+      name_.c_str(), checkpoint_interval_ms_, checkpoint_flush_pages_);
+}
+
+void Db::stop_checkpoint_thread()
+{
+  if (!checkpoint_thread_) {
+    return;
+  }
+
+  {
+    lock_guard<mutex> guard(checkpoint_thread_mutex_);
+    checkpoint_running_ = false;
+  }
+  checkpoint_cond_.notify_all();
+  checkpoint_thread_->join();
+  checkpoint_thread_.reset();
+  LOG_INFO("checkpoint thread stopped. db=%s", name_.c_str());
+}
+
+void Db::checkpoint_thread_func()
+{
+  thread_set_name("Checkpoint");
+
+  unique_lock<mutex> lock(checkpoint_thread_mutex_);
+  while (checkpoint_running_) {
+    checkpoint_cond_.wait_for(lock, chrono::milliseconds(checkpoint_interval_ms_), [this] {
+      return !checkpoint_running_;
+    });
+    if (!checkpoint_running_) {
+      break;
+    }
+
+    lock.unlock();
+    RC rc = checkpoint();
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to do checkpoint. db=%s, rc=%s", name_.c_str(), strrc(rc));
+    }
+    lock.lock();
+  }
+}
+
+RC Db::vacuum()
+{
+  lock_guard<mutex> guard(vacuum_mutex_);
+
+  int total_reclaimed_num = 0;
+  for (auto &[table_name, table] : opened_tables_) {
+    int reclaimed_num = 0;
+    RC  rc            = trx_kit_->vacuum(table, reclaimed_num);
+    if (rc == RC::UNIMPLEMENTED) {
+      continue;  // 存储引擎不支持
+    }
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to vacuum table. db=%s, table=%s, rc=%s", name_.c_str(), table_name.c_str(), strrc(rc));
+      return rc;
+    }
+    total_reclaimed_num += reclaimed_num;
+  }
+
+  if (total_reclaimed_num > 0) {
+    LOG_INFO("vacuum done. db=%s, reclaimed records=%d", name_.c_str(), total_reclaimed_num);
+  }
+  return RC::SUCCESS;
+}
+
+void Db::start_vacuum_thread()
+{
+  str_to_val(get_properties()->get("VACUUM_INTERVAL_MS", "10000", "STORAGE"), vacuum_interval_ms_);
+  if (vacuum_interval_ms_ <= 0) {
+    LOG_INFO("vacuum thread is disabled. db=%s", name_.c_str());
+    return;
+  }
+
+#ifndef CONCURRENCY
+  // 没有开启并发编译选项时，页面和buffer pool的锁都是空实现，后台线程不能与前台同时访问页面
+  LOG_INFO("vacuum thread is disabled because CONCURRENCY is off. db=%s", name_.c_str());
+  return;
+#endif
+
+  vacuum_running_ = true;
+  vacuum_thread_  = make_unique<thread>(&Db::vacuum_thread_func, this);
+  LOG_INFO("vacuum thread started. db=%s, interval=%dms", name_.c_str(), vacuum_interval_ms_);
+}
+
+void Db::stop_vacuum_thread()
+{
+  if (!vacuum_thread_) {
+    return;
+  }
+
+  {
+    lock_guard<mutex> guard(vacuum_thread_mutex_);
+    vacuum_running_ = false;
+  }
+  vacuum_cond_.notify_all();
+  vacuum_thread_->join();
+  vacuum_thread_.reset();
+  LOG_INFO("vacuum thread stopped. db=%s", name_.c_str());
+}
+
+void Db::vacuum_thread_func()
+{
+  thread_set_name("Vacuum");
+
+  unique_lock<mutex> lock(vacuum_thread_mutex_);
+  while (vacuum_running_) {
+    vacuum_cond_.wait_for(lock, chrono::milliseconds(vacuum_interval_ms_), [this] { return !vacuum_running_; });
+    if (!vacuum_running_) {
+      break;
+    }
+
+    lock.unlock();
+    RC rc = vacuum();
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to vacuum. db=%s, rc=%s", name_.c_str(), strrc(rc));
+    }
+    lock.lock();
+  }
+}
+
 RC Db::recover()
 {
   LOG_TRACE("db recover begin. check_point_lsn=%d", check_point_lsn_);
@@ -301,7 +520,12 @@ RC Db::recover()
     return RC::INTERNAL;
   }
 
-  IntegratedLogReplayer log_replayer(*buffer_pool_manager_, unique_ptr<LogReplayer>(trx_log_replayer));
+  // 页面日志的回放线程数，默认在当前线程中串行回放
+  int replay_thread_num = 0;
+  str_to_val(get_properties()->get("REPLAY_THREAD_NUM", "0", "STORAGE"), replay_thread_num);
+
+  IntegratedLogReplayer log_replayer(
+      *buffer_pool_manager_, unique_ptr<LogReplayer>(trx_log_replayer), replay_thread_num);
   RC                    rc = log_handler_->replay(log_replayer, check_point_lsn_ /*start_lsn*/);
   if (OB_FAIL(rc)) {
     LOG_WARN("failed to replay log. rc=%s", strrc(rc));
@@ -465,6 +689,10 @@ RC Db::init_dblwr_buffer()
         }
         
 
+        // 检查点线程可能正在访问这个表的buffer pool，回收线程可能正在访问这个表
+        lock_guard<mutex> vacuum_guard(vacuum_mutex_);
+        lock_guard<mutex> guard(checkpoint_mutex_);
+
         // 从内存中移除表
         opened_tables_.erase(table_name);
 
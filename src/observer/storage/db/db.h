@@ -20,6 +20,9 @@ See the Mulan PSL v2 for more details. */
 #include "common/lang/unordered_map.h"
 #include "common/lang/memory.h"
 #include "common/lang/span.h"
+#include "common/lang/mutex.h"
+#include "common/lang/condition_variable.h"
+#include "common/lang/thread.h"
 #include "sql/parser/parse_defs.h"
 #include "storage/buffer/disk_buffer_pool.h"
 #include "storage/clog/disk_log_handler.h"
@@ -96,6 +99,21 @@ public:
    */
   RC sync();
 
+  /**
+   * @brief 做一次模糊检查点(fuzzy checkpoint)
+   * @details 不需要停止事务。按照脏页第一次被修改的LSN(recLSN)从小到大刷新一部分脏页，
+   * 然后把检查点推进到所有未刷盘脏页和活跃事务的最小LSN，最后删除检查点之前的日志文件。
+   * 恢复时只需要从检查点开始重做日志，检查点推进得越及时，恢复需要的时间就越短。
+   * 后台检查点线程会周期性地调用这个函数。
+   */
+  RC checkpoint();
+
+  /**
+   * @brief 回收所有表中已经没有事务能看到的旧版本数据
+   * @details 具体哪些数据可以回收由事务管理器决定，参考 TrxKit::vacuum。后台回收线程会周期性地调用这个函数
+   */
+  RC vacuum();
+
   /// @brief 获取当前数据库的日志处理器
   LogHandler &log_handler();
 
@@ -123,6 +141,21 @@ private:
   /// @brief 初始化数据库的double buffer pool
   RC init_dblwr_buffer();
 
+  /// @brief 启动后台检查点线程。间隔时间配置为0时不启动
+  void start_checkpoint_thread();
+  /// @brief 停止后台检查点线程并等待它退出
+  void stop_checkpoint_thread();
+  void checkpoint_thread_func();
+
+  /// @brief 启动后台回收线程。间隔时间配置为0时不启动
+  void start_vacuum_thread();
+  /// @brief 停止后台回收线程并等待它退出
+  void stop_vacuum_thread();
+  void vacuum_thread_func();
+
+  /// @brief 推进检查点LSN并记录到元数据中，然后回收检查点之前的日志。需要在checkpoint_mutex_的保护下调用
+  RC advance_check_point(LSN check_point_lsn);
+
   StorageEngine get_storage_engine()
   {
     StorageEngine engine = StorageEngine::UNKNOWN_ENGINE;
@@ -152,4 +185,21 @@ private:
 
   LSN    check_point_lsn_ = 0;  ///< 当前数据库的检查点LSN。会记录到磁盘中。
   string storage_engine_;
+
+  /// 保护检查点LSN、元数据文件以及打开的buffer pool，检查点与sync、删除表互斥
+  mutex              checkpoint_mutex_;
+  mutex              checkpoint_thread_mutex_;
+  condition_variable checkpoint_cond_;                ///< 用来唤醒检查点线程，让它尽快退出
+  bool               checkpoint_running_ = false;
+  unique_ptr<thread> checkpoint_thread_;
+  int                checkpoint_interval_ms_ = 0;    ///< 检查点的间隔时间，0表示不做周期性的检查点
+  int                checkpoint_flush_pages_ = 128;  ///< 每次检查点最多刷新的脏页数，负数表示全部刷新
+
+  /// 保护打开的表，回收与创建、删除表互斥
+  mutex              vacuum_mutex_;
+  mutex              vacuum_thread_mutex_;
+  condition_variable vacuum_cond_;  ///< 用来唤醒回收线程，让它尽快退出
+  bool               vacuum_running_ = false;
+  unique_ptr<thread> vacuum_thread_;
+  int                vacuum_interval_ms_ = 0;  ///< 回收的间隔时间，0表示不做周期性的回收
 };
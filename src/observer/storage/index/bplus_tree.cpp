@@ -14,7 +14,9 @@ See the Mulan PSL v2 for more details. */
 //
 
 #include "storage/index/bplus_tree.h"
+#include "common/lang/algorithm.h"
 #include "common/lang/lower_bound.h"
+#include "common/lang/type_traits.h"
 #include "common/log/log.h"
 #include "common/global_context.h"
 #include "sql/parser/parse_defs.h"
@@ -29,11 +31,13 @@ using namespace common;
  */
 #define FIRST_INDEX_PAGE 1
 
+/**
+ * @details 内部节点的键值是压缩存储的，一个页面能放多少个元素由实际占用的空间决定，
+ * 这里给出的是元素个数的上限
+ */
 int calc_internal_page_capacity(int attr_length)
 {
-  int item_size = attr_length + sizeof(RID) + sizeof(PageNum);
-  int capacity  = ((int)BP_PAGE_DATA_SIZE - InternalIndexNode::HEADER_SIZE) / item_size;
-  return capacity;
+  return InternalIndexNodeHandler::max_item_num(attr_length + sizeof(RID));
 }
 
 int calc_leaf_page_capacity(int attr_length)
@@ -107,6 +111,9 @@ bool IndexNodeHandler::is_safe(BplusTreeOperationType op, bool is_root_node)
       return true;
     } break;
     case BplusTreeOperationType::INSERT: {
+      if (!is_leaf()) {
+        return InternalIndexNodeHandler(mtr_, header_, frame_).is_safe_to_insert();
+      }
       return size() < max_size();
     } break;
     case BplusTreeOperationType::DELETE: {
@@ -118,6 +125,9 @@ bool IndexNodeHandler::is_safe(BplusTreeOperationType op, bool is_root_node)
         // 根节点还有子节点，但是如果删除一个子节点后，只剩一个子节点，就要把自己删除，把唯一的子节点变更为根节点
         return size() > 2;
       }
+      if (!is_leaf()) {
+        return InternalIndexNodeHandler(mtr_, header_, frame_).is_safe_to_remove();
+      }
       return size() > min_size();
     } break;
     default: {
@@ -424,30 +434,70 @@ InternalIndexNodeHandler::InternalIndexNodeHandler(BplusTreeMiniTransaction &mtr
     : IndexNodeHandler(mtr, header, frame), internal_node_((InternalIndexNode *)frame->data())
 {}
 
+int InternalIndexNodeHandler::space(int key_length)
+{
+  return static_cast<int>(BP_PAGE_DATA_SIZE) - InternalIndexNode::HEADER_SIZE - 2 * key_length;
+}
+
+int InternalIndexNodeHandler::max_item_num(int key_length) { return space(key_length) / InternalIndexNode::ITEM_OVERHEAD; }
+
+int InternalIndexNodeHandler::min_item_num(int key_length)
+{
+  return space(key_length) / (InternalIndexNode::ITEM_OVERHEAD + key_length);
+}
+
+/**
+ * @brief 键值去掉前缀和最后连续的0之后，需要存储的长度
+ */
+static int suffix_length_of(const char *key, int key_length, int prefix_length)
+{
+  int length = key_length;
+  while (length > prefix_length && key[length - 1] == 0) {
+    length--;
+  }
+  return length - prefix_length;
+}
+
 string to_string(const InternalIndexNodeHandler &node, const KeyPrinter &printer)
 {
+  vector<char> key(node.key_size());
+
   stringstream ss;
   ss << to_string((const IndexNodeHandler &)node);
-  ss << ",children:["
-     << "{key:" << printer(node.__key_at(0)) << ","
-     << "value:" << *(PageNum *)node.__value_at(0) << "}";
-
-  for (int i = 1; i < node.size(); i++) {
-    ss << ",{key:" << printer(node.__key_at(i)) << ",value:" << *(PageNum *)node.__value_at(i) << "}";
+  ss << "prefix:" << node.prefix_length() << ",used:" << node.used_bytes() << ",";
+  if (node.low_fence() != nullptr) {
+    ss << "low:" << printer(node.low_fence()) << ",";
+  }
+  if (node.high_fence() != nullptr) {
+    ss << "high:" << printer(node.high_fence()) << ",";
+  }
+  ss << "children:[";
+  for (int i = 0; i < node.size(); i++) {
+    PageNum     page_num      = BP_INVALID_PAGE_NUM;
+    const char *suffix        = nullptr;
+    int         suffix_length = 0;
+    node.item_at(i, page_num, suffix, suffix_length);
+    node.decode_key(i, key.data());
+    ss << (i == 0 ? "" : ",") << "{key:" << printer(key.data()) << ",value:" << page_num << "}";
   }
   ss << "]";
   return ss.str();
 }
 
-RC InternalIndexNodeHandler::init_empty() 
+RC InternalIndexNodeHandler::init_empty()
 {
   RC rc = mtr_.logger().internal_init_empty(*this);
   if (OB_FAIL(rc)) {
     LOG_WARN("failed to log init empty internal node. rc=%s", strrc(rc));
   }
   IndexNodeHandler::init_empty(false/*leaf*/);
+  internal_node_->prefix_length = 0;
+  internal_node_->fence_flags   = 0;
+  internal_node_->reserved      = 0;
+  memset(internal_node_->array, 0, 2 * key_size());
   return RC::SUCCESS;
 }
+
 RC InternalIndexNodeHandler::create_new_root(PageNum first_page_num, const char *key, PageNum page_num)
 {
   RC rc = mtr_.logger().internal_create_new_root(*this, first_page_num, span<const char>(key, key_size()), page_num);
@@ -455,12 +505,12 @@ RC InternalIndexNodeHandler::create_new_root(PageNum first_page_num, const char
     LOG_WARN("failed to log create new root. rc=%s", strrc(rc));
   }
 
-  memset(__key_at(0), 0, key_size());
-  memcpy(__value_at(0), &first_page_num, value_size());
-  memcpy(__item_at(1), key, key_size());
-  memcpy(__value_at(1), &page_num, value_size());
-  increase_size(2);
-  return RC::SUCCESS;
+  // 根节点没有上下界
+  vector<char> items(2 * item_size(), 0);
+  memcpy(items.data() + key_size(), &first_page_num, value_size());
+  memcpy(items.data() + item_size(), key, key_size());
+  memcpy(items.data() + item_size() + key_size(), &page_num, value_size());
+  return encode(nullptr, nullptr, items.data(), 2);
 }
 
 /**
@@ -488,51 +538,119 @@ RC InternalIndexNodeHandler::insert(const char *key, PageNum page_num, const Key
 
 /**
  * @brief move half of the items to the other node ends
+ * @details 元素是变长的，元素个数没有达到上限时，按照占用的空间平分。
+ * 新节点的范围是 [分隔键值, 上界)，当前节点的范围变成 [下界, 分隔键值)，两个节点的前缀都可能变长。
  */
 RC InternalIndexNodeHandler::move_half_to(InternalIndexNodeHandler &other)
 {
-  const int size       = this->size();
-  const int move_index = size / 2;
-  const int move_num   = size - move_index;
-  RC        rc         = other.append(this->__item_at(move_index), size - move_index);
+  const int    size = this->size();
+  vector<char> items;
+  decode_items(items);
+
+  int move_index = size / 2;
+  if (size < max_size()) {
+    const int   prefix = prefix_length();
+    vector<int> item_bytes(size);
+    int         total_bytes = 0;
+    for (int i = 0; i < size; i++) {
+      item_bytes[i] = InternalIndexNode::ITEM_OVERHEAD +
+                      suffix_length_of(items.data() + i * item_size(), key_size(), prefix);
+      total_bytes += item_bytes[i];
+    }
+
+    int left_bytes = item_bytes[0];
+    move_index     = 1;
+    while (move_index < size - 1 && left_bytes * 2 < total_bytes) {
+      left_bytes += item_bytes[move_index];
+      move_index++;
+    }
+  }
+
+  const int   move_num   = size - move_index;
+  const char *move_items = items.data() + move_index * item_size();
+  const char *separator  = move_items;
+
+  RC rc = other.set_fence(separator, high_fence());
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to set fence of new node. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  rc = other.append(move_items, move_num);
   if (OB_FAIL(rc)) {
     LOG_WARN("failed to copy item to new node. rc=%d:%s", rc, strrc(rc));
     return rc;
   }
 
-  mtr_.logger().node_remove_items(*this, move_index, span<const char>(__item_at(move_index), move_num * item_size()), move_num);
-  increase_size(-(size - move_index));
-  return rc;
+  rc = mtr_.logger().node_remove_items(*this, move_index, span<const char>(move_items, move_num * item_size()), move_num);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to log shrink internal node. rc=%d:%s", rc, strrc(rc));
+    return rc;
+  }
+
+  rc = recover_remove_items(move_index, move_num);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+  return set_fence(low_fence(), separator);
 }
 
 /**
  * lookup the first item which key <= item
  * @return unlike the leafNode, the return value is not the insert position,
  * but only the index of child to find.
+ * @details 乐观读时页面可能正在被修改，这里只保证不会越界，读取的结果由调用者校验版本号之后再使用
  */
 int InternalIndexNodeHandler::lookup(const KeyComparator &comparator, const char *key, bool *found /* = nullptr */,
     int *insert_position /*= nullptr */) const
 {
-  const int size = this->size();
-  if (size == 0) {
+  const int size = min(this->size(), max_item_num(key_size()));
+  if (found) {
+    *found = false;
+  }
+  if (size <= 0) {
     if (insert_position) {
       *insert_position = 1;
     }
-    if (found) {
-      *found = false;
-    }
     return 0;
   }
 
-  common::BinaryIterator<char> iter_begin(item_size(), __key_at(1));
-  common::BinaryIterator<char> iter_end(item_size(), __key_at(size));
-  common::BinaryIterator<char> iter = lower_bound(iter_begin, iter_end, key, comparator, found);
-  int                          ret  = static_cast<int>(iter - iter_begin) + 1;
+  // 键值需要先解压才能比较，通常不长，尽量使用栈上的空间
+  char         stack_buffer[256];
+  vector<char> heap_buffer;
+  char        *buffer = stack_buffer;
+  if (key_size() > static_cast<int>(sizeof(stack_buffer))) {
+    heap_buffer.resize(key_size());
+    buffer = heap_buffer.data();
+  }
+
+  // 在 [1, size) 中找第一个不小于key的位置
+  int left  = 1;
+  int right = size;
+  while (left < right) {
+    const int mid = left + (right - left) / 2;
+    decode_key(mid, buffer);
+    const int result = comparator(buffer, key);
+    if (result < 0) {
+      left = mid + 1;
+    } else {
+      if (result == 0 && found) {
+        *found = true;
+      }
+      right = mid;
+    }
+  }
+
+  const int ret = left;
   if (insert_position) {
     *insert_position = ret;
   }
 
-  if (ret >= size || comparator(key, __key_at(ret)) < 0) {
+  if (ret >= size) {
+    return ret - 1;
+  }
+  decode_key(ret, buffer);
+  if (comparator(key, buffer) < 0) {
     return ret - 1;
   }
   return ret;
@@ -541,27 +659,43 @@ int InternalIndexNodeHandler::lookup(const KeyComparator &comparator, const char
 char *InternalIndexNodeHandler::key_at(int index)
 {
   assert(index >= 0 && index < size());
-  return __key_at(index);
+  key_buffer_.resize(key_size());
+  decode_key(index, key_buffer_.data());
+  return key_buffer_.data();
 }
 
 void InternalIndexNodeHandler::set_key_at(int index, const char *key)
 {
   assert(index >= 0 && index < size());
 
-  mtr_.logger().internal_update_key(*this, index, span<const char>(key, key_size()), span<const char>(__key_at(index), key_size()));
-  memcpy(__key_at(index), key, key_size());
+  vector<char> items;
+  decode_items(items);
+
+  char *old_key = items.data() + index * item_size();
+  mtr_.logger().internal_update_key(
+      *this, index, span<const char>(key, key_size()), span<const char>(old_key, key_size()));
+  memcpy(old_key, key, key_size());
+  RC rc = encode(low_fence(), high_fence(), items.data(), size());
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("failed to update key of internal node. index=%d, rc=%s, node=%s",
+              index, strrc(rc), to_string(*this).c_str());
+  }
 }
 
 PageNum InternalIndexNodeHandler::value_at(int index)
 {
   assert(index >= 0 && index < size());
-  return *(PageNum *)__value_at(index);
+  PageNum     page_num      = BP_INVALID_PAGE_NUM;
+  const char *suffix        = nullptr;
+  int         suffix_length = 0;
+  item_at(index, page_num, suffix, suffix_length);
+  return page_num;
 }
 
 int InternalIndexNodeHandler::value_index(PageNum page_num)
 {
   for (int i = 0; i < size(); i++) {
-    if (page_num == *(PageNum *)__value_at(i)) {
+    if (page_num == value_at(i)) {
       return i;
     }
   }
@@ -572,8 +706,11 @@ void InternalIndexNodeHandler::remove(int index)
 {
   assert(index >= 0 && index < size());
 
+  vector<char> items;
+  decode_items(items);
+
   BplusTreeLogger &logger = mtr_.logger();
-  RC rc = logger.node_remove_items(*this, index, span<const char>(__item_at(index), item_size()), 1);
+  RC rc = logger.node_remove_items(*this, index, span<const char>(items.data() + index * item_size(), item_size()), 1);
   if (OB_FAIL(rc)) {
     LOG_WARN("failed to log remove item. rc=%s. node=%s", strrc(rc), to_string(*this).c_str());
   }
@@ -581,50 +718,180 @@ void InternalIndexNodeHandler::remove(int index)
   recover_remove_items(index, 1);
 }
 
+RC InternalIndexNodeHandler::set_fence(const char *low_key, const char *high_key)
+{
+  RC rc = mtr_.logger().internal_set_fence(*this, low_key, high_key, low_fence(), high_fence());
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to log set fence. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  vector<char> items;
+  decode_items(items);
+  return encode(low_key, high_key, items.data(), size());
+}
+
+const char *InternalIndexNodeHandler::low_fence() const
+{
+  if (internal_node_->fence_flags & InternalIndexNode::HAS_LOW_FENCE) {
+    return internal_node_->array;
+  }
+  return nullptr;
+}
+
+const char *InternalIndexNodeHandler::high_fence() const
+{
+  if (internal_node_->fence_flags & InternalIndexNode::HAS_HIGH_FENCE) {
+    return internal_node_->array + key_size();
+  }
+  return nullptr;
+}
+
+bool InternalIndexNodeHandler::can_insert(const char *key) const
+{
+  if (size() >= max_size()) {
+    return false;
+  }
+
+  vector<char> items;
+  decode_items(items);
+  items.insert(items.end(), key, key + key_size());
+  items.resize(items.size() + value_size());
+  return encoded_size(low_fence(), high_fence(), items.data(), size() + 1) <= space(key_size());
+}
+
+bool InternalIndexNodeHandler::can_merge(const InternalIndexNodeHandler &right) const
+{
+  if (size() + right.size() > max_size()) {
+    return false;
+  }
+
+  vector<char> items;
+  vector<char> right_items;
+  decode_items(items);
+  right.decode_items(right_items);
+  items.insert(items.end(), right_items.begin(), right_items.end());
+  return encoded_size(low_fence(), right.high_fence(), items.data(), size() + right.size()) <= space(key_size());
+}
+
+bool InternalIndexNodeHandler::can_set_key_at(int index, const char *key) const
+{
+  vector<char> items;
+  decode_items(items);
+  memcpy(items.data() + index * item_size(), key, key_size());
+  return encoded_size(low_fence(), high_fence(), items.data(), size()) <= space(key_size());
+}
+
+bool InternalIndexNodeHandler::can_borrow(int index, const char *item, const char *low_key, const char *high_key) const
+{
+  if (size() >= max_size()) {
+    return false;
+  }
+
+  vector<char> items;
+  decode_items(items);
+  items.insert(items.begin() + index * item_size(), item, item + item_size());
+  return encoded_size(low_key, high_key, items.data(), size() + 1) <= space(key_size());
+}
+
+bool InternalIndexNodeHandler::is_underflow() const
+{
+  return size() < min_size() && used_bytes() * 2 < space(key_size());
+}
+
+bool InternalIndexNodeHandler::is_safe_to_insert() const
+{
+  const int max_item_bytes = InternalIndexNode::ITEM_OVERHEAD + key_size() - prefix_length();
+  return size() < max_size() && used_bytes() + max_item_bytes <= space(key_size());
+}
+
+bool InternalIndexNodeHandler::is_safe_to_remove() const
+{
+  const int max_item_bytes = InternalIndexNode::ITEM_OVERHEAD + key_size() - prefix_length();
+  return size() - 1 >= min_size() || (used_bytes() - max_item_bytes) * 2 >= space(key_size());
+}
+
 RC InternalIndexNodeHandler::move_to(InternalIndexNodeHandler &other)
 {
-  RC rc = other.append(__item_at(0), size());
+  vector<char> items;
+  decode_items(items);
+
+  RC rc = other.set_fence(other.low_fence(), high_fence());
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to set fence of other node. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  rc = other.append(items.data(), size());
   if (OB_FAIL(rc)) {
     LOG_WARN("failed to copy items to other node. rc=%d:%s", rc, strrc(rc));
     return rc;
   }
 
-  rc = mtr_.logger().node_remove_items(*this, 0, span<const char>(__item_at(0), size() * item_size()), size());
+  rc = mtr_.logger().node_remove_items(*this, 0, span<const char>(items.data(), items.size()), size());
   if (OB_FAIL(rc)) {
     LOG_WARN("failed to log shrink internal node. rc=%d:%s", rc, strrc(rc));
     return rc;
   }
-  recover_remove_items(0, size());
-  return RC::SUCCESS;
+  return recover_remove_items(0, size());
 }
 
+/**
+ * @details 当前节点是other右边的邻居。第一个元素移走后，第二个键值就是两个节点的分界
+ */
 RC InternalIndexNodeHandler::move_first_to_end(InternalIndexNodeHandler &other)
 {
-  RC rc = other.append(__item_at(0));
+  vector<char> items;
+  decode_items(items);
+  const char *boundary = items.data() + item_size();
+
+  RC rc = other.set_fence(other.low_fence(), boundary);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to set fence of other node. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  rc = other.append(items.data());
   if (OB_FAIL(rc)) {
     LOG_WARN("failed to append item to others.");
     return rc;
   }
 
   remove(0);
-  return rc;
+  return set_fence(boundary, high_fence());
 }
 
+/**
+ * @details 当前节点是other左边的邻居。最后一个元素的键值就是两个节点的分界
+ */
 RC InternalIndexNodeHandler::move_last_to_front(InternalIndexNodeHandler &other)
 {
-  RC rc = other.preappend(__item_at(size() - 1));
+  vector<char> items;
+  decode_items(items);
+  const char *last_item = items.data() + (size() - 1) * item_size();
+
+  RC rc = other.set_fence(last_item, other.high_fence());
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to set fence of other node. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  rc = other.preappend(last_item);
   if (OB_FAIL(rc)) {
     LOG_WARN("failed to preappend to others");
     return rc;
   }
 
-  rc = mtr_.logger().node_remove_items(*this, size() - 1, span<const char>(__item_at(size() - 1), item_size()), 1);
+  rc = mtr_.logger().node_remove_items(*this, size() - 1, span<const char>(last_item, item_size()), 1);
   if (OB_FAIL(rc)) {
     LOG_WARN("failed to log shrink internal node. rc=%d:%s", rc, strrc(rc));
     return rc;
   }
-  increase_size(-1);
-  return rc;
+  rc = recover_remove_items(size() - 1, 1);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+  return set_fence(low_fence(), last_item);
 }
 
 RC InternalIndexNodeHandler::insert_items(int index, const char *items, int num)
@@ -635,7 +902,10 @@ RC InternalIndexNodeHandler::insert_items(int index, const char *items, int num)
     return rc;
   }
 
-  recover_insert_items(index, items, num);
+  rc = recover_insert_items(index, items, num);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
 
   LatchMemo &latch_memo = mtr_.latch_memo();
   PageNum this_page_num = this->page_num();
@@ -674,12 +944,183 @@ RC InternalIndexNodeHandler::preappend(const char *item)
   return this->insert_items(0, item, 1);
 }
 
-char *InternalIndexNodeHandler::__item_at(int index) const { return internal_node_->array + (index * item_size()); }
+RC InternalIndexNodeHandler::recover_insert_items(int index, const char *items, int num)
+{
+  vector<char> all_items;
+  decode_items(all_items);
+  all_items.insert(all_items.begin() + index * item_size(), items, items + num * item_size());
+  return encode(low_fence(), high_fence(), all_items.data(), size() + num);
+}
+
+RC InternalIndexNodeHandler::recover_remove_items(int index, int num)
+{
+  vector<char> all_items;
+  decode_items(all_items);
+  all_items.erase(all_items.begin() + index * item_size(), all_items.begin() + (index + num) * item_size());
+  return encode(low_fence(), high_fence(), all_items.data(), size() - num);
+}
 
 int InternalIndexNodeHandler::value_size() const { return sizeof(PageNum); }
 
 int InternalIndexNodeHandler::item_size() const { return key_size() + this->value_size(); }
 
+char *InternalIndexNodeHandler::slot_area() const { return internal_node_->array + 2 * key_size(); }
+
+int InternalIndexNodeHandler::prefix_length() const
+{
+  return min(static_cast<int>(internal_node_->prefix_length), key_size());
+}
+
+int InternalIndexNodeHandler::used_bytes() const
+{
+  const int size = min(this->size(), max_item_num(key_size()));
+  if (size <= 0) {
+    return 0;
+  }
+
+  PageNum     page_num      = BP_INVALID_PAGE_NUM;
+  const char *suffix        = nullptr;
+  int         suffix_length = 0;
+  item_at(size - 1, page_num, suffix, suffix_length);
+  return static_cast<int>(suffix + suffix_length - slot_area());
+}
+
+void InternalIndexNodeHandler::item_at(int index, PageNum &page_num, const char *&suffix, int &suffix_length) const
+{
+  // 元素中除了后缀之外的部分：子节点页号和后缀长度
+  constexpr int item_header_size = sizeof(PageNum) + sizeof(uint16_t);
+
+  const int   space = InternalIndexNodeHandler::space(key_size());
+  const char *area  = slot_area();
+
+  uint16_t offset = 0;
+  memcpy(&offset, area + index * sizeof(uint16_t), sizeof(offset));
+  offset = static_cast<uint16_t>(min<int>(offset, space - item_header_size));
+
+  uint16_t length = 0;
+  memcpy(&page_num, area + offset, sizeof(PageNum));
+  memcpy(&length, area + offset + sizeof(PageNum), sizeof(length));
+
+  suffix        = area + offset + item_header_size;
+  suffix_length = min({static_cast<int>(length), key_size() - prefix_length(), space - offset - item_header_size});
+}
+
+void InternalIndexNodeHandler::decode_key(int index, char *key) const
+{
+  PageNum     page_num      = BP_INVALID_PAGE_NUM;
+  const char *suffix        = nullptr;
+  int         suffix_length = 0;
+  item_at(index, page_num, suffix, suffix_length);
+
+  const int prefix = prefix_length();
+  memcpy(key, internal_node_->array, prefix);
+  memcpy(key + prefix, suffix, suffix_length);
+  memset(key + prefix + suffix_length, 0, key_size() - prefix - suffix_length);
+}
+
+void InternalIndexNodeHandler::decode_items(vector<char> &items) const
+{
+  const int size = this->size();
+  items.resize(static_cast<size_t>(size) * item_size());
+  for (int i = 0; i < size; i++) {
+    PageNum     page_num      = BP_INVALID_PAGE_NUM;
+    const char *suffix        = nullptr;
+    int         suffix_length = 0;
+    item_at(i, page_num, suffix, suffix_length);
+
+    char *item = items.data() + i * item_size();
+    decode_key(i, item);
+    memcpy(item + key_size(), &page_num, sizeof(page_num));
+  }
+}
+
+/**
+ * @details 只有字符串类型并且上下界都存在时才做前缀压缩。
+ * 上下界正确时所有键值都有这个前缀，这里还会检查一遍，保证编码不会丢失数据。
+ */
+int InternalIndexNodeHandler::common_prefix_length(
+    const char *low_key, const char *high_key, const char *items, int num) const
+{
+  if (header_.attr_type != AttrType::CHARS || low_key == nullptr || high_key == nullptr) {
+    return 0;
+  }
+
+  int prefix = 0;
+  while (prefix < header_.attr_length && low_key[prefix] == high_key[prefix] && low_key[prefix] != 0) {
+    prefix++;
+  }
+
+  for (int i = 0; i < num && prefix > 0; i++) {
+    const char *key  = items + i * item_size();
+    int         same = 0;
+    while (same < prefix && key[same] == low_key[same]) {
+      same++;
+    }
+    prefix = same;
+  }
+  return prefix;
+}
+
+int InternalIndexNodeHandler::encoded_size(const char *low_key, const char *high_key, const char *items, int num) const
+{
+  const int prefix = common_prefix_length(low_key, high_key, items, num);
+  int       bytes  = 0;
+  for (int i = 0; i < num; i++) {
+    bytes += InternalIndexNode::ITEM_OVERHEAD + suffix_length_of(items + i * item_size(), key_size(), prefix);
+  }
+  return bytes;
+}
+
+/**
+ * @details 上下界可能就在当前页面中，所以先编码到临时的缓冲区，放得下再写回页面。
+ * 放不下的时候页面保持不变。
+ */
+RC InternalIndexNodeHandler::encode(const char *low_key, const char *high_key, const char *items, int num)
+{
+  constexpr int item_header_size = sizeof(PageNum) + sizeof(uint16_t);
+
+  const int key_size = this->key_size();
+  const int space    = InternalIndexNodeHandler::space(key_size);
+  const int prefix   = common_prefix_length(low_key, high_key, items, num);
+
+  vector<char> fences(2 * key_size, 0);
+  uint8_t      fence_flags = 0;
+  if (low_key != nullptr) {
+    memcpy(fences.data(), low_key, key_size);
+    fence_flags |= InternalIndexNode::HAS_LOW_FENCE;
+  }
+  if (high_key != nullptr) {
+    memcpy(fences.data() + key_size, high_key, key_size);
+    fence_flags |= InternalIndexNode::HAS_HIGH_FENCE;
+  }
+
+  vector<char> area(space);
+  int          offset = num * sizeof(uint16_t);
+  for (int i = 0; i < num; i++) {
+    const char *item   = items + i * item_size();
+    const int   length = suffix_length_of(item, key_size, prefix);
+    if (offset + item_header_size + length > space) {
+      LOG_ERROR("internal node overflow. page num=%d, item num=%d, space=%d", page_num(), num, space);
+      return RC::INTERNAL;
+    }
+
+    const uint16_t slot          = static_cast<uint16_t>(offset);
+    const uint16_t suffix_length = static_cast<uint16_t>(length);
+    memcpy(area.data() + i * sizeof(uint16_t), &slot, sizeof(slot));
+    memcpy(area.data() + offset, item + key_size, sizeof(PageNum));
+    memcpy(area.data() + offset + sizeof(PageNum), &suffix_length, sizeof(suffix_length));
+    memcpy(area.data() + offset + item_header_size, item + prefix, length);
+    offset += item_header_size + length;
+  }
+
+  internal_node_->prefix_length = static_cast<uint16_t>(prefix);
+  internal_node_->fence_flags   = fence_flags;
+  node_->key_num                = num;
+  memcpy(internal_node_->array, fences.data(), fences.size());
+  memcpy(slot_area(), area.data(), offset);
+  return RC::SUCCESS;
+}
+
 bool InternalIndexNodeHandler::validate(const KeyComparator &comparator, DiskBufferPool *bp) const
 {
   bool result = IndexNodeHandler::validate();
@@ -687,24 +1128,37 @@ bool InternalIndexNodeHandler::validate(const KeyComparator &comparator, DiskBuf
     return false;
   }
 
-  const int node_size = size();
+  const int    node_size = size();
+  vector<char> items;
+  decode_items(items);
+  auto key_of = [this, &items](int index) { return items.data() + index * item_size(); };
+
   for (int i = 2; i < node_size; i++) {
-    if (comparator(__key_at(i - 1), __key_at(i)) >= 0) {
+    if (comparator(key_of(i - 1), key_of(i)) >= 0) {
       LOG_WARN("page number = %d, invalid key order. id1=%d,id2=%d, this=%s",
           page_num(), i - 1, i, to_string(*this).c_str());
       return false;
     }
   }
 
+  if (node_size > 1 && low_fence() != nullptr && comparator(key_of(1), low_fence()) < 0) {
+    LOG_WARN("page number = %d, key is less than low fence. this=%s", page_num(), to_string(*this).c_str());
+    return false;
+  }
+  if (node_size > 0 && high_fence() != nullptr && comparator(key_of(node_size - 1), high_fence()) >= 0) {
+    LOG_WARN("page number = %d, key is not less than high fence. this=%s", page_num(), to_string(*this).c_str());
+    return false;
+  }
+
   for (int i = 0; result && i < node_size; i++) {
-    PageNum page_num = *(PageNum *)__value_at(i);
+    PageNum page_num = *(PageNum *)(key_of(i) + key_size());
     if (page_num < 0) {
       LOG_WARN("this page num=%d, got invalid child page. page num=%d", this->page_num(), page_num);
     } else {
       Frame *child_frame = nullptr;
       RC     rc = bp->get_this_page(page_num, &child_frame);
       if (OB_FAIL(rc)) {
-        LOG_WARN("failed to fetch child page while validate internal page. page num=%d, rc=%d:%s", 
+        LOG_WARN("failed to fetch child page while validate internal page. page num=%d, rc=%d:%s",
                  page_num, rc, strrc(rc));
       } else {
         IndexNodeHandler child_node(mtr_, header_, child_frame);
@@ -745,7 +1199,7 @@ bool InternalIndexNodeHandler::validate(const KeyComparator &comparator, DiskBuf
   }
 
   if (0 != index_in_parent) {
-    int cmp_result = comparator(__key_at(1), parent_node.key_at(index_in_parent));
+    int cmp_result = comparator(key_of(1), parent_node.key_at(index_in_parent));
     if (cmp_result < 0) {
       LOG_WARN("invalid internal node. the second item should be greate than or equal to parent item. "
                "this page num=%d, parent page num=%d, index in parent=%d",
@@ -756,7 +1210,7 @@ bool InternalIndexNodeHandler::validate(const KeyComparator &comparator, DiskBuf
   }
 
   if (index_in_parent < parent_node.size() - 1) {
-    int cmp_result = comparator(__key_at(size() - 1), parent_node.key_at(index_in_parent + 1));
+    int cmp_result = comparator(key_of(size() - 1), parent_node.key_at(index_in_parent + 1));
     if (cmp_result >= 0) {
       LOG_WARN("invalid internal node. last item should be less than the item at the first after item in parent."
                "this page num=%d, parent page num=%d, parent item to compare=%d",
@@ -799,6 +1253,18 @@ RC BplusTreeHandler::create(LogHandler &log_handler,
                             int attr_length, 
                             int internal_max_size /* = -1*/,
                             int leaf_max_size /* = -1 */)
+{
+  return this->create(log_handler, bpm, file_name,
+                      vector<AttrType>{attr_type}, vector<int>{attr_length}, internal_max_size, leaf_max_size);
+}
+
+RC BplusTreeHandler::create(LogHandler &log_handler,
+                            BufferPoolManager &bpm,
+                            const char *file_name,
+                            const vector<AttrType> &attr_types,
+                            const vector<int> &attr_lengths,
+                            int internal_max_size /* = -1*/,
+                            int leaf_max_size /* = -1 */)
 {
   RC rc = bpm.create_file(file_name);
   if (OB_FAIL(rc)) {
@@ -816,7 +1282,7 @@ RC BplusTreeHandler::create(LogHandler &log_handler,
   }
   LOG_INFO("Successfully open index file %s.", file_name);
 
-  rc = this->create(log_handler, *bp, attr_type, attr_length, internal_max_size, leaf_max_size);
+  rc = this->create(log_handler, *bp, attr_types, attr_lengths, internal_max_size, leaf_max_size);
   if (OB_FAIL(rc)) {
     bpm.close_file(file_name);
     return rc;
@@ -833,6 +1299,28 @@ RC BplusTreeHandler::create(LogHandler &log_handler,
             int internal_max_size /* = -1 */,
             int leaf_max_size /* = -1 */)
 {
+  return this->create(
+      log_handler, buffer_pool, vector<AttrType>{attr_type}, vector<int>{attr_length}, internal_max_size, leaf_max_size);
+}
+
+RC BplusTreeHandler::create(LogHandler &log_handler,
+            DiskBufferPool &buffer_pool,
+            const vector<AttrType> &attr_types,
+            const vector<int> &attr_lengths,
+            int internal_max_size /* = -1 */,
+            int leaf_max_size /* = -1 */)
+{
+  const int attr_num = static_cast<int>(attr_types.size());
+  if (attr_num <= 0 || attr_num > BPLUS_TREE_MAX_ATTR_NUM || attr_lengths.size() != attr_types.size()) {
+    LOG_WARN("invalid attributes of bplus tree. attr num=%d, max attr num=%d", attr_num, BPLUS_TREE_MAX_ATTR_NUM);
+    return RC::INVALID_ARGUMENT;
+  }
+
+  int attr_length = 0;
+  for (int length : attr_lengths) {
+    attr_length += length;
+  }
+
   if (internal_max_size < 0) {
     internal_max_size = calc_internal_page_capacity(attr_length);
   }
@@ -865,7 +1353,12 @@ RC BplusTreeHandler::create(LogHandler &log_handler,
   IndexFileHeader *file_header   = (IndexFileHeader *)pdata;
   file_header->attr_length       = attr_length;
   file_header->key_length        = attr_length + sizeof(RID);
-  file_header->attr_type         = attr_type;
+  file_header->attr_type         = attr_num == 1 ? attr_types[0] : AttrType::UNDEFINED;
+  file_header->attr_num          = attr_num;
+  for (int i = 0; i < attr_num; i++) {
+    file_header->attr_types[i]   = attr_types[i];
+    file_header->attr_lengths[i] = attr_lengths[i];
+  }
   file_header->internal_max_size = internal_max_size;
   file_header->leaf_max_size     = leaf_max_size;
   file_header->root_page         = BP_INVALID_PAGE_NUM;
@@ -885,8 +1378,7 @@ RC BplusTreeHandler::create(LogHandler &log_handler,
     return RC::NOMEM;
   }
 
-  key_comparator_.init(file_header->attr_type, file_header->attr_length);
-  key_printer_.init(file_header->attr_type, file_header->attr_length);
+  init_key_comparator();
 
   /*
   虽然我们针对B+树记录了WAL，但是我们记录的都是逻辑日志，并没有记录某个页面如何修改的物理日志。
@@ -957,8 +1449,7 @@ RC BplusTreeHandler::open(LogHandler &log_handler, DiskBufferPool &buffer_pool)
   // close old page_handle
   buffer_pool.unpin_page(frame);
 
-  key_comparator_.init(file_header_.attr_type, file_header_.attr_length);
-  key_printer_.init(file_header_.attr_type, file_header_.attr_length);
+  init_key_comparator();
   LOG_INFO("Successfully open index");
   return RC::SUCCESS;
 }
@@ -1198,30 +1689,262 @@ RC BplusTreeHandler::left_most_page(BplusTreeMiniTransaction &mtr, Frame *&frame
   return find_leaf_internal(mtr, BplusTreeOperationType::READ, child_page_getter, frame);
 }
 
-RC BplusTreeHandler::find_leaf_internal(BplusTreeMiniTransaction &mtr, BplusTreeOperationType op,
-    const function<PageNum(InternalIndexNodeHandler &)> &child_page_getter, Frame *&frame)
+RC BplusTreeHandler::find_leaf_before(BplusTreeMiniTransaction &mtr, const char *key, Frame *&frame, int &index)
 {
   LatchMemo &latch_memo = mtr.latch_memo();
+  const int  memo_point = latch_memo.memo_point();
+
+  vector<char> target;
+  if (key != nullptr) {
+    target.assign(key, key + file_header_.key_length);
+  }
+
+  while (true) {
+    // 查找路径上最后一次没有走最左边子节点时的分隔键值。
+    // 乐观查找重试时可能留下上一次查找记录的值，只有最后一次查找全部走最左边子节点时才会用到它，
+    // 这时找到的是最左边的叶子节点，没有比 key 小的键值，用更小的值再查找一次也找不到，不影响结果
+    vector<char> separator;
+    auto child_page_getter = [this, &target, &separator](InternalIndexNodeHandler &internal_node) {
+      // 最后一个分隔键值小于 target 的子节点
+      int child_index = internal_node.size() - 1;
+      if (!target.empty()) {
+        int insert_position = 0;
+        internal_node.lookup(key_comparator_, target.data(), nullptr, &insert_position);
+        child_index = insert_position - 1;
+      }
+      if (child_index > 0) {
+        const char *separator_key = internal_node.key_at(child_index);
+        separator.assign(separator_key, separator_key + file_header_.key_length);
+      }
+      return internal_node.value_at(child_index);
+    };
 
-  // root locked
-  if (op != BplusTreeOperationType::READ) {
-    latch_memo.xlatch(&root_lock_);
-  } else {
-    latch_memo.slatch(&root_lock_);
-  }
+    RC rc = find_leaf_internal(mtr, BplusTreeOperationType::READ, child_page_getter, frame);
+    if (rc == RC::EMPTY) {
+      frame = nullptr;
+      return RC::SUCCESS;
+    } else if (OB_FAIL(rc)) {
+      LOG_WARN("failed to find leaf. rc=%s", strrc(rc));
+      return rc;
+    }
 
-  if (is_empty()) {
-    return RC::EMPTY;
-  }
+    LeafIndexNodeHandler leaf_node(mtr, file_header_, frame);
+    index = target.empty() ? leaf_node.size() - 1 : leaf_node.lookup(key_comparator_, target.data()) - 1;
+    if (index >= 0) {
+      return RC::SUCCESS;
+    }
 
-  RC rc = crabing_protocal_fetch_page(mtr, op, file_header_.root_page, true /* is_root_node */, frame);
-  if (OB_FAIL(rc)) {
-    LOG_WARN("failed to fetch root page. page id=%d, rc=%d:%s", file_header_.root_page, rc, strrc(rc));
-    return rc;
+    latch_memo.release_from(memo_point);
+    frame = nullptr;
+    if (separator.empty()) {
+      return RC::SUCCESS;
+    }
+
+    // 找到的是分隔键值右边子树中最左边的叶子节点，比 key 小的键值都比分隔键值小
+    target.swap(separator);
   }
+}
 
-  IndexNode *node = (IndexNode *)frame->data();
-  PageNum    next_page_id;
+void BplusTreeHandler::sibling_leaves(
+    BplusTreeMiniTransaction &mtr, const char *key, bool forward, int count, vector<PageNum> &pages)
+{
+  pages.clear();
+
+  LatchMemo &latch_memo = mtr.latch_memo();
+  const int  memo_point = latch_memo.memo_point();
+
+  Frame   *current_frame = nullptr;
+  uint64_t version       = 0;
+  root_lock_.lock_shared();
+  if (is_empty()) {
+    root_lock_.unlock_shared();
+    return;
+  }
+  RC rc = latch_memo.get_page(file_header_.root_page, current_frame);
+  if (OB_SUCC(rc)) {
+    version = current_frame->version();
+  }
+  root_lock_.unlock_shared();
+  if (OB_FAIL(rc)) {
+    return;
+  }
+
+  // 与 optimistic_find_leaf 一样，读取子节点页号以后检查当前节点的版本号。根节点是叶子节点时没有兄弟节点
+  while (!Frame::is_write_latched(version) && !reinterpret_cast<IndexNode *>(current_frame->data())->is_leaf) {
+    InternalIndexNodeHandler internal_node(mtr, file_header_, current_frame);
+    const int                child_index    = internal_node.lookup(key_comparator_, key);
+    const PageNum            child_page_num = internal_node.value_at(child_index);
+    if (!current_frame->validate_version(version)) {
+      break;
+    }
+
+    Frame *child_frame = nullptr;
+    if (OB_FAIL(latch_memo.get_page(child_page_num, child_frame))) {
+      break;
+    }
+
+    const uint64_t child_version = child_frame->version();
+    const bool     child_is_leaf = reinterpret_cast<IndexNode *>(child_frame->data())->is_leaf;
+    if (Frame::is_write_latched(child_version) || !child_frame->validate_version(child_version)) {
+      break;
+    }
+
+    if (child_is_leaf) {
+      const int size = internal_node.size();
+      const int step = forward ? 1 : -1;
+      for (int i = child_index + step; i >= 0 && i < size && static_cast<int>(pages.size()) < count; i += step) {
+        pages.push_back(internal_node.value_at(i));
+      }
+      if (!current_frame->validate_version(version)) {
+        pages.clear();
+      }
+      break;
+    }
+
+    if (!current_frame->validate_version(version)) {
+      break;
+    }
+    current_frame = child_frame;
+    version       = child_version;
+  }
+
+  latch_memo.release_from(memo_point);
+}
+
+RC BplusTreeHandler::find_leaf_internal(BplusTreeMiniTransaction &mtr, BplusTreeOperationType op,
+    const function<PageNum(InternalIndexNodeHandler &)> &child_page_getter, Frame *&frame)
+{
+  // 删除操作可能会合并节点，总是使用悲观的方式
+  if (op != BplusTreeOperationType::DELETE) {
+    for (int i = 0; i < OPTIMISTIC_RETRY_TIMES; i++) {
+      RC rc = optimistic_find_leaf(mtr, op, child_page_getter, frame);
+      if (rc != RC::LOCKED_CONCURRENCY_CONFLICT) {
+        return rc;
+      }
+    }
+  }
+
+  return pessimistic_find_leaf(mtr, op, child_page_getter, frame);
+}
+
+RC BplusTreeHandler::optimistic_find_leaf(BplusTreeMiniTransaction &mtr, BplusTreeOperationType op,
+    const function<PageNum(InternalIndexNodeHandler &)> &child_page_getter, Frame *&frame)
+{
+  LatchMemo &latch_memo = mtr.latch_memo();
+  const int  memo_point = latch_memo.memo_point();
+  frame                 = nullptr;
+
+  // 根节点的页号只在持有 root_lock_ 时修改。在锁内记录根节点的版本号，之后根节点分裂或者被删除，版本号都会变化
+  Frame   *current_frame = nullptr;
+  uint64_t version       = 0;
+  root_lock_.lock_shared();
+  if (is_empty()) {
+    root_lock_.unlock_shared();
+    return RC::EMPTY;
+  }
+  const PageNum root_page = file_header_.root_page;
+  RC            rc        = latch_memo.get_page(root_page, current_frame);
+  if (OB_SUCC(rc)) {
+    version = current_frame->version();
+  }
+  root_lock_.unlock_shared();
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to fetch root page. page id=%d, rc=%d:%s", root_page, rc, strrc(rc));
+    return rc;
+  }
+
+  // 向下查找时不加锁，读取子节点页号后检查当前节点的版本号，读取子节点的版本号后再检查一次，
+  // 保证子节点的版本号是在它仍然是当前节点的子节点时读到的
+  bool is_root_node = true;
+  while (true) {
+    if (Frame::is_write_latched(version)) {
+      latch_memo.release_from(memo_point);
+      return RC::LOCKED_CONCURRENCY_CONFLICT;
+    }
+
+    const bool is_leaf = reinterpret_cast<IndexNode *>(current_frame->data())->is_leaf;
+    PageNum    child_page_num = BP_INVALID_PAGE_NUM;
+    if (!is_leaf) {
+      InternalIndexNodeHandler internal_node(mtr, file_header_, current_frame);
+      child_page_num = child_page_getter(internal_node);
+    }
+    if (!current_frame->validate_version(version)) {
+      latch_memo.release_from(memo_point);
+      return RC::LOCKED_CONCURRENCY_CONFLICT;
+    }
+    if (is_leaf) {
+      break;
+    }
+
+    Frame *child_frame = nullptr;
+    rc                 = latch_memo.get_page(child_page_num, child_frame);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("Failed to load page page_num:%d. rc=%s", child_page_num, strrc(rc));
+      latch_memo.release_from(memo_point);
+      return rc;
+    }
+
+    const uint64_t child_version = child_frame->version();
+    if (!current_frame->validate_version(version)) {
+      latch_memo.release_from(memo_point);
+      return RC::LOCKED_CONCURRENCY_CONFLICT;
+    }
+
+    current_frame = child_frame;
+    version       = child_version;
+    is_root_node  = false;
+  }
+
+  // 叶子节点加锁之后没有变化，说明它仍然是查找路径上的叶子节点。
+  // 加写锁时版本号会加一
+  if (op == BplusTreeOperationType::READ) {
+    latch_memo.slatch(current_frame);
+  } else {
+    latch_memo.xlatch(current_frame);
+    version++;
+  }
+
+  if (!current_frame->validate_version(version)) {
+    latch_memo.release_from(memo_point);
+    return RC::LOCKED_CONCURRENCY_CONFLICT;
+  }
+
+  IndexNodeHandler leaf_node(mtr, file_header_, current_frame);
+  if (!leaf_node.is_safe(op, is_root_node)) {
+    // 插入后叶子节点需要分裂，要修改父节点，只能从根节点开始加锁
+    latch_memo.release_from(memo_point);
+    return RC::LOCKED_CONCURRENCY_CONFLICT;
+  }
+
+  // 查找路径上的其它页面只是pin住，没有加锁，跟随mini transaction一起释放
+  frame = current_frame;
+  return RC::SUCCESS;
+}
+
+RC BplusTreeHandler::pessimistic_find_leaf(BplusTreeMiniTransaction &mtr, BplusTreeOperationType op,
+    const function<PageNum(InternalIndexNodeHandler &)> &child_page_getter, Frame *&frame)
+{
+  LatchMemo &latch_memo = mtr.latch_memo();
+
+  // root locked
+  if (op != BplusTreeOperationType::READ) {
+    latch_memo.xlatch(&root_lock_);
+  } else {
+    latch_memo.slatch(&root_lock_);
+  }
+
+  if (is_empty()) {
+    return RC::EMPTY;
+  }
+
+  RC rc = crabing_protocal_fetch_page(mtr, op, file_header_.root_page, true /* is_root_node */, frame);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to fetch root page. page id=%d, rc=%d:%s", file_header_.root_page, rc, strrc(rc));
+    return rc;
+  }
+
+  IndexNode *node = (IndexNode *)frame->data();
+  PageNum    next_page_id;
   for (; !node->is_leaf;) {
     InternalIndexNodeHandler internal_node(mtr, file_header_, frame);
     next_page_id = child_page_getter(internal_node);
@@ -1293,7 +2016,10 @@ RC BplusTreeHandler::insert_entry_into_leaf_node(BplusTreeMiniTransaction &mtr,
     new_index_node.insert(insert_position - leaf_node.size(), key, (const char *)rid);
   }
 
-  return insert_entry_into_parent(mtr, frame, new_frame, new_index_node.key_at(0));
+  // 父节点中使用能区分两个叶子节点的最短键值，内部节点压缩存储时更省空间
+  vector<char> separator(file_header_.key_length);
+  make_separator(leaf_node.key_at(leaf_node.size() - 1), new_index_node.key_at(0), separator.data());
+  return insert_entry_into_parent(mtr, frame, new_frame, separator.data());
 }
 
 RC BplusTreeHandler::insert_entry_into_parent(BplusTreeMiniTransaction &mtr, Frame *frame, Frame *new_frame, const char *key)
@@ -1348,7 +2074,7 @@ RC BplusTreeHandler::insert_entry_into_parent(BplusTreeMiniTransaction &mtr, Fra
     InternalIndexNodeHandler parent_node(mtr, file_header_, parent_frame);
 
     /// 当前这个父节点还没有满，直接将新节点数据插进入就行了
-    if (parent_node.size() < parent_node.max_size()) {
+    if (parent_node.can_insert(key)) {
       parent_node.insert(key, new_frame->page_num(), key_comparator_);
       new_node_handler.set_parent_page_num(parent_page_num);
 
@@ -1422,6 +2148,19 @@ RC BplusTreeHandler::split(BplusTreeMiniTransaction &mtr, Frame *frame, Frame *&
   return RC::SUCCESS;
 }
 
+void BplusTreeHandler::init_key_comparator()
+{
+  // 旧版本的索引文件没有记录每个字段的信息，只有一个字段
+  if (file_header_.attr_num <= 0) {
+    file_header_.attr_num        = 1;
+    file_header_.attr_types[0]   = file_header_.attr_type;
+    file_header_.attr_lengths[0] = file_header_.attr_length;
+  }
+
+  key_comparator_.init(file_header_.attr_num, file_header_.attr_types, file_header_.attr_lengths);
+  key_printer_.init(file_header_.attr_num, file_header_.attr_types, file_header_.attr_lengths);
+}
+
 RC BplusTreeHandler::recover_update_root_page(BplusTreeMiniTransaction &mtr, PageNum root_page_num)
 {
   update_root_page_num_locked(mtr, root_page_num);
@@ -1436,8 +2175,7 @@ RC BplusTreeHandler::recover_init_header_page(BplusTreeMiniTransaction &mtr, Fra
   header_dirty_ = false;
   frame->mark_dirty();
 
-  key_comparator_.init(file_header_.attr_type, file_header_.attr_length);
-  key_printer_.init(file_header_.attr_type, file_header_.attr_length);
+  init_key_comparator();
 
   return RC::SUCCESS;
 }
@@ -1483,6 +2221,228 @@ RC BplusTreeHandler::create_new_tree(BplusTreeMiniTransaction &mtr, const char *
   return rc;
 }
 
+RC BplusTreeHandler::bulk_load(int64_t entry_num, const function<RC(const char *&key)> &next_key, float fill_factor)
+{
+  if (!is_empty()) {
+    LOG_WARN("cannot bulk load into a non-empty tree. root page=%d", file_header_.root_page);
+    return RC::INTERNAL;
+  }
+  if (entry_num <= 0) {
+    return RC::SUCCESS;
+  }
+
+  // 节点至少要放3个元素，保证每层有多个节点时，平均分配之后每个内部节点都至少有两个子节点
+  fill_factor        = min(1.0f, max(0.1f, fill_factor));
+  auto node_capacity = [fill_factor](int max_size) {
+    return min(max_size, max(min(3, max_size), static_cast<int>(max_size * fill_factor)));
+  };
+
+  /// 正在构建的一层节点
+  struct Level
+  {
+    int64_t item_num     = 0;  ///< 这一层一共有多少个元素
+    int64_t node_num     = 0;  ///< 这一层一共有多少个节点
+    int64_t created_num  = 0;  ///< 已经创建了多少个节点
+    int     planned_size = 0;  ///< 当前节点计划放多少个元素
+    Frame  *frame        = nullptr;  ///< 当前正在填充的节点，也就是这一层最右边的节点
+  };
+
+  // 先算出每一层有多少个节点，元素平均分配到各个节点上，最右边的节点不会特别空
+  const int     key_length = file_header_.key_length;
+  vector<Level> levels;
+  int64_t       item_num = entry_num;
+  int           capacity = node_capacity(file_header_.leaf_max_size);
+  while (true) {
+    Level level;
+    level.item_num = item_num;
+    level.node_num = (item_num + capacity - 1) / capacity;
+    levels.push_back(level);
+    if (level.node_num == 1) {
+      break;
+    }
+
+    // 内部节点的键值压缩之后才能知道占用多少空间，这里按照不能压缩的情况计算
+    item_num = level.node_num;
+    capacity = node_capacity(min(file_header_.internal_max_size, InternalIndexNodeHandler::min_item_num(key_length)));
+  }
+
+  // 页面直接写到磁盘中，不记录每个页面的修改
+  BplusTreeMiniTransaction mtr(*this);
+  mtr.logger().disable_log();
+
+  vector<char> leaf_item(key_length + sizeof(RID));
+  vector<char> internal_item(key_length + sizeof(PageNum));
+  vector<char> separator(key_length);
+
+  function<RC(size_t, const char *, PageNum, PageNum &)> add_child;
+
+  // 在指定层创建一个新的节点，并把它加到上一层节点中。first_key 是新节点的第一个键值
+  auto start_node = [&](size_t level_index, const char *first_key) -> RC {
+    Level &level = levels[level_index];
+    Frame *frame = nullptr;
+    RC     rc    = disk_buffer_pool_->allocate_page(&frame);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to allocate page while bulk loading. level=%d, rc=%s", (int)level_index, strrc(rc));
+      return rc;
+    }
+
+    if (level_index == 0) {
+      LeafIndexNodeHandler leaf_node(mtr, file_header_, frame);
+      leaf_node.init_empty();
+      if (level.frame != nullptr) {
+        // 父节点中使用能区分前后两个叶子节点的最短键值
+        LeafIndexNodeHandler prev_node(mtr, file_header_, level.frame);
+        prev_node.set_next_page(frame->page_num());
+        make_separator(prev_node.key_at(prev_node.size() - 1), first_key, separator.data());
+        first_key = separator.data();
+      }
+    } else {
+      // 同一层相邻的两个节点以 first_key 为界，上下界确定之后才能做前缀压缩
+      InternalIndexNodeHandler internal_node(mtr, file_header_, frame);
+      internal_node.init_empty();
+      if (level.frame != nullptr) {
+        InternalIndexNodeHandler prev_node(mtr, file_header_, level.frame);
+        rc = prev_node.set_fence(prev_node.low_fence(), first_key);
+        if (OB_SUCC(rc)) {
+          rc = internal_node.set_fence(first_key, nullptr);
+        }
+        if (OB_FAIL(rc)) {
+          LOG_WARN("failed to set fence while bulk loading. level=%d, rc=%s", (int)level_index, strrc(rc));
+          disk_buffer_pool_->unpin_page(frame);
+          return rc;
+        }
+      }
+    }
+    frame->mark_dirty();
+
+    if (level.frame != nullptr) {
+      disk_buffer_pool_->unpin_page(level.frame);
+    }
+    level.frame        = frame;
+    level.planned_size = static_cast<int>(
+        level.item_num / level.node_num + (level.created_num < level.item_num % level.node_num ? 1 : 0));
+    level.created_num++;
+
+    if (level_index + 1 < levels.size()) {
+      PageNum parent_page_num = BP_INVALID_PAGE_NUM;
+      rc = add_child(level_index + 1, first_key, frame->page_num(), parent_page_num);
+      if (OB_FAIL(rc)) {
+        return rc;
+      }
+      IndexNodeHandler node(mtr, file_header_, frame);
+      node.set_parent_page_num(parent_page_num);
+    }
+    return RC::SUCCESS;
+  };
+
+  add_child = [&](size_t level_index, const char *key, PageNum child_page_num, PageNum &parent_page_num) -> RC {
+    Level &level = levels[level_index];
+    if (level.frame == nullptr || IndexNodeHandler(mtr, file_header_, level.frame).size() >= level.planned_size) {
+      RC rc = start_node(level_index, key);
+      if (OB_FAIL(rc)) {
+        return rc;
+      }
+    }
+
+    // 与分裂出来的内部节点一样，第一个位置也存放键值，也就是这个节点在父节点中的键值。
+    // 查找时不使用它，但是合并和重新分配节点时会用到
+    InternalIndexNodeHandler internal_node(mtr, file_header_, level.frame);
+    memcpy(internal_item.data(), key, key_length);
+    memcpy(internal_item.data() + key_length, &child_page_num, sizeof(child_page_num));
+    internal_node.recover_insert_items(internal_node.size(), internal_item.data(), 1);
+
+    parent_page_num = level.frame->page_num();
+    return RC::SUCCESS;
+  };
+
+  RC          rc         = RC::SUCCESS;
+  int64_t     loaded_num = 0;
+  const char *key        = nullptr;
+  Level      &leaf_level = levels[0];
+  while (OB_SUCC(rc = next_key(key))) {
+    if (leaf_level.frame == nullptr ||
+        IndexNodeHandler(mtr, file_header_, leaf_level.frame).size() >= leaf_level.planned_size) {
+      rc = start_node(0, key);
+      if (OB_FAIL(rc)) {
+        break;
+      }
+    }
+
+    // 叶子节点中存放的是键值和RID，键值的最后就是RID
+    memcpy(leaf_item.data(), key, key_length);
+    memcpy(leaf_item.data() + key_length, key + file_header_.attr_length, sizeof(RID));
+    LeafIndexNodeHandler leaf_node(mtr, file_header_, leaf_level.frame);
+    leaf_node.recover_insert_items(leaf_node.size(), leaf_item.data(), 1);
+    loaded_num++;
+  }
+
+  if (RC::RECORD_EOF == rc) {
+    rc = RC::SUCCESS;
+  }
+  if (OB_SUCC(rc) && loaded_num != entry_num) {
+    LOG_WARN("entry number mismatch while bulk loading. expected=%ld, loaded=%ld", entry_num, loaded_num);
+    rc = RC::INTERNAL;
+  }
+
+  const PageNum root_page_num = levels.back().frame != nullptr ? levels.back().frame->page_num() : BP_INVALID_PAGE_NUM;
+  for (Level &level : levels) {
+    if (level.frame != nullptr) {
+      disk_buffer_pool_->unpin_page(level.frame);
+      level.frame = nullptr;
+    }
+    ASSERT(OB_FAIL(rc) || level.created_num == level.node_num,
+           "node number mismatch. expected=%ld, created=%ld", level.node_num, level.created_num);
+  }
+
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to bulk load. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  // 新页面没有日志，要在记录根节点的日志之前写到磁盘上
+  rc = disk_buffer_pool_->force_all_pages();
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to force pages after bulk loading. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  {
+    BplusTreeMiniTransaction root_mtr(*this, &rc);
+    root_lock_.lock();
+    update_root_page_num_locked(root_mtr, root_page_num);
+    root_lock_.unlock();
+  }
+
+  LOG_INFO("bulk load done. entries=%ld, height=%d, leaf pages=%ld, root page=%d",
+           entry_num, static_cast<int>(levels.size()), levels[0].node_num, root_page_num);
+  return rc;
+}
+
+void BplusTreeHandler::make_separator(const char *left_key, const char *right_key, char *separator) const
+{
+  const int key_length = file_header_.key_length;
+  if (file_header_.attr_type != AttrType::CHARS) {
+    memcpy(separator, right_key, key_length);
+    return;
+  }
+
+  // 字符串按照 strncmp 的规则比较，找到第一个不同的字节，保留到这个字节为止，剩余部分(包括RID)都填0
+  const int attr_length = file_header_.attr_length;
+  int       diff        = 0;
+  while (diff < attr_length && left_key[diff] == right_key[diff] && left_key[diff] != 0) {
+    diff++;
+  }
+
+  if (diff >= attr_length || left_key[diff] == right_key[diff]) {
+    // 字符串相同，只能通过RID区分
+    memcpy(separator, right_key, key_length);
+    return;
+  }
+
+  memcpy(separator, right_key, diff + 1);
+  memset(separator + diff + 1, 0, key_length - diff - 1);
+}
+
 MemPoolItem::item_unique_ptr BplusTreeHandler::make_key(const char *user_key, const RID &rid)
 {
   MemPoolItem::item_unique_ptr key = mem_pool_item_->alloc_unique_ptr();
@@ -1612,7 +2572,7 @@ RC BplusTreeHandler::coalesce_or_redistribute(BplusTreeMiniTransaction &mtr, Fra
   LatchMemo &latch_memo = mtr.latch_memo();
 
   IndexNodeHandlerType index_node(mtr, file_header_, frame);
-  if (index_node.size() >= index_node.min_size()) {
+  if (!index_node.is_underflow()) {
     return RC::SUCCESS;
   }
 
@@ -1662,7 +2622,8 @@ RC BplusTreeHandler::coalesce_or_redistribute(BplusTreeMiniTransaction &mtr, Fra
   latch_memo.xlatch(neighbor_frame);
 
   IndexNodeHandlerType neighbor_node(mtr, file_header_, neighbor_frame);
-  if (index_node.size() + neighbor_node.size() > index_node.max_size()) {
+  const bool           can_merge = index == 0 ? index_node.can_merge(neighbor_node) : neighbor_node.can_merge(index_node);
+  if (!can_merge) {
     rc = redistribute<IndexNodeHandlerType>(mtr, neighbor_frame, frame, parent_frame, index);
   } else {
     rc = coalesce<IndexNodeHandlerType>(mtr, neighbor_frame, frame, parent_frame, index);
@@ -1735,24 +2696,60 @@ RC BplusTreeHandler::redistribute(BplusTreeMiniTransaction &mtr, Frame *neighbor
   InternalIndexNodeHandler parent_node(mtr, file_header_, parent_frame);
   IndexNodeHandlerType     neighbor_node(mtr, file_header_, neighbor_frame);
   IndexNodeHandlerType     node(mtr, file_header_, frame);
-  if (neighbor_node.size() < node.size()) {
+  // 内部节点按照占用的空间判断是否需要合并，前缀变短之后可能合并不了，邻居节点的元素可能更少
+  if (neighbor_node.size() < 2) {
+    return RC::SUCCESS;
+  }
+  if (neighbor_node.size() < node.size() && node.is_leaf()) {
     LOG_ERROR("got invalid nodes. neighbor node size %d, this node size %d", neighbor_node.size(), node.size());
   }
+
+  // 先算出借一个元素之后父节点中新的分隔键值。
+  // 内部节点是压缩存储的，换了键值之后可能放不下，这时就不再调整，节点只是比较空
+  const int    parent_index = index == 0 ? index + 1 : index;
+  vector<char> separator(file_header_.key_length);
+  if constexpr (is_same<IndexNodeHandlerType, LeafIndexNodeHandler>::value) {
+    if (index == 0) {
+      make_separator(neighbor_node.key_at(0), neighbor_node.key_at(1), separator.data());
+    } else {
+      make_separator(
+          neighbor_node.key_at(neighbor_node.size() - 2), neighbor_node.key_at(neighbor_node.size() - 1), separator.data());
+    }
+  } else {
+    const int    borrow_index = index == 0 ? 0 : neighbor_node.size() - 1;
+    const char  *low_key      = node.low_fence();
+    const char  *high_key     = node.high_fence();
+    vector<char> item(file_header_.key_length + sizeof(PageNum));
+    memcpy(item.data(), neighbor_node.key_at(borrow_index), file_header_.key_length);
+    const PageNum child_page_num = neighbor_node.value_at(borrow_index);
+    memcpy(item.data() + file_header_.key_length, &child_page_num, sizeof(child_page_num));
+    if (index == 0) {
+      memcpy(separator.data(), neighbor_node.key_at(1), file_header_.key_length);
+      high_key = separator.data();
+    } else {
+      memcpy(separator.data(), item.data(), file_header_.key_length);
+      low_key = separator.data();
+    }
+
+    if (!node.can_borrow(index == 0 ? node.size() : 0, item.data(), low_key, high_key)) {
+      LOG_TRACE("no enough space to borrow item from neighbor. page num=%d", node.page_num());
+      return RC::SUCCESS;
+    }
+  }
+
+  if (!parent_node.can_set_key_at(parent_index, separator.data())) {
+    LOG_TRACE("no enough space to update key in parent. page num=%d", parent_node.page_num());
+    return RC::SUCCESS;
+  }
+
   if (index == 0) {
     // the neighbor is at right
     neighbor_node.move_first_to_end(node);
-    // neighbor_node.validate(key_comparator_, disk_buffer_pool_, file_id_);
-    // node.validate(key_comparator_, disk_buffer_pool_, file_id_);
-    parent_node.set_key_at(index + 1, neighbor_node.key_at(0));
-    // parent_node.validate(key_comparator_, disk_buffer_pool_, file_id_);
   } else {
     // the neighbor is at left
     neighbor_node.move_last_to_front(node);
-    // neighbor_node.validate(key_comparator_, disk_buffer_pool_, file_id_);
-    // node.validate(key_comparator_, disk_buffer_pool_, file_id_);
-    parent_node.set_key_at(index, node.key_at(0));
-    // parent_node.validate(key_comparator_, disk_buffer_pool_, file_id_);
   }
+  parent_node.set_key_at(parent_index, separator.data());
 
   neighbor_frame->mark_dirty();
   frame->mark_dirty();
@@ -1826,7 +2823,7 @@ BplusTreeScanner::BplusTreeScanner(BplusTreeHandler &tree_handler)
 BplusTreeScanner::~BplusTreeScanner() { close(); }
 
 RC BplusTreeScanner::open(const char *left_user_key, int left_len, bool left_inclusive, const char *right_user_key,
-    int right_len, bool right_inclusive)
+    int right_len, bool right_inclusive, bool reverse /* = false */)
 {
   RC rc = RC::SUCCESS;
   if (inited_) {
@@ -1836,6 +2833,9 @@ RC BplusTreeScanner::open(const char *left_user_key, int left_len, bool left_inc
 
   inited_        = true;
   first_emitted_ = false;
+  reverse_       = reverse;
+  prefetch_pages_.clear();
+  prefetch_index_ = 0;
 
   LatchMemo &latch_memo = mtr_.latch_memo();
 
@@ -1850,21 +2850,9 @@ RC BplusTreeScanner::open(const char *left_user_key, int left_len, bool left_inc
     }
   }
 
-  if (nullptr == left_user_key) {
-    rc = tree_handler_.left_most_page(mtr_, current_frame_);
-    if (OB_FAIL(rc)) {
-      if (rc == RC::EMPTY) {
-        current_frame_ = nullptr;
-        return RC::SUCCESS;
-      }
-      
-      LOG_WARN("failed to find left most page. rc=%s", strrc(rc));
-      return rc;
-    }
-
-    iter_index_ = 0;
-  } else {
-
+  // 把左右边界转换成包含RID的完整键值
+  MemPoolItem::item_unique_ptr left_pkey;
+  if (left_user_key != nullptr) {
     char *fixed_left_key = const_cast<char *>(left_user_key);
     if (tree_handler_.file_header_.attr_type == AttrType::CHARS) {
       bool should_inclusive_after_fix = false;
@@ -1879,19 +2867,77 @@ RC BplusTreeScanner::open(const char *left_user_key, int left_len, bool left_inc
       }
     }
 
-    MemPoolItem::item_unique_ptr left_pkey;
     if (left_inclusive) {
       left_pkey = tree_handler_.make_key(fixed_left_key, *RID::min());
     } else {
       left_pkey = tree_handler_.make_key(fixed_left_key, *RID::max());
     }
 
-    const char *left_key = (const char *)left_pkey.get();
-
     if (fixed_left_key != left_user_key) {
       delete[] fixed_left_key;
       fixed_left_key = nullptr;
     }
+  }
+
+  // 没有指定右边界范围，那么就返回右边界最大值
+  MemPoolItem::item_unique_ptr right_pkey;
+  if (right_user_key != nullptr) {
+    char *fixed_right_key          = const_cast<char *>(right_user_key);
+    bool  should_include_after_fix = false;
+    if (tree_handler_.file_header_.attr_type == AttrType::CHARS) {
+      rc = fix_user_key(right_user_key, right_len, false /*want_greater*/, &fixed_right_key, &should_include_after_fix);
+      if (OB_FAIL(rc)) {
+        LOG_WARN("failed to fix right user key. rc=%s", strrc(rc));
+        return rc;
+      }
+
+      if (should_include_after_fix) {
+        right_inclusive = true;
+      }
+    }
+    if (right_inclusive) {
+      right_pkey = tree_handler_.make_key(fixed_right_key, *RID::max());
+    } else {
+      right_pkey = tree_handler_.make_key(fixed_right_key, *RID::min());
+    }
+
+    if (fixed_right_key != right_user_key) {
+      delete[] fixed_right_key;
+      fixed_right_key = nullptr;
+    }
+  }
+
+  if (reverse_) {
+    // 从右边界前面的最后一个键值开始，向左扫描到左边界
+    rc = tree_handler_.find_leaf_before(
+        mtr_, right_pkey ? static_cast<const char *>(right_pkey.get()) : nullptr, current_frame_, iter_index_);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to find right page. rc=%s", strrc(rc));
+      return rc;
+    }
+
+    left_key_ = std::move(left_pkey);
+    if (current_frame_ != nullptr && touch_end()) {
+      current_frame_ = nullptr;
+    }
+    return RC::SUCCESS;
+  }
+
+  if (nullptr == left_pkey) {
+    rc = tree_handler_.left_most_page(mtr_, current_frame_);
+    if (OB_FAIL(rc)) {
+      if (rc == RC::EMPTY) {
+        current_frame_ = nullptr;
+        return RC::SUCCESS;
+      }
+      
+      LOG_WARN("failed to find left most page. rc=%s", strrc(rc));
+      return rc;
+    }
+
+    iter_index_ = 0;
+  } else {
+    const char *left_key = (const char *)left_pkey.get();
 
     rc = tree_handler_.find_leaf(mtr_, BplusTreeOperationType::READ, left_key, current_frame_);
     if (rc == RC::EMPTY) {
@@ -1926,36 +2972,7 @@ RC BplusTreeScanner::open(const char *left_user_key, int left_len, bool left_inc
     iter_index_ = left_index;
   }
 
-  // 没有指定右边界范围，那么就返回右边界最大值
-  if (nullptr == right_user_key) {
-    right_key_ = nullptr;
-  } else {
-
-    char *fixed_right_key          = const_cast<char *>(right_user_key);
-    bool  should_include_after_fix = false;
-    if (tree_handler_.file_header_.attr_type == AttrType::CHARS) {
-      rc = fix_user_key(right_user_key, right_len, false /*want_greater*/, &fixed_right_key, &should_include_after_fix);
-      if (OB_FAIL(rc)) {
-        LOG_WARN("failed to fix right user key. rc=%s", strrc(rc));
-        return rc;
-      }
-
-      if (should_include_after_fix) {
-        right_inclusive = true;
-      }
-    }
-    if (right_inclusive) {
-      right_key_ = tree_handler_.make_key(fixed_right_key, *RID::max());
-    } else {
-      right_key_ = tree_handler_.make_key(fixed_right_key, *RID::min());
-    }
-
-    if (fixed_right_key != right_user_key) {
-      delete[] fixed_right_key;
-      fixed_right_key = nullptr;
-    }
-  }
-
+  right_key_ = std::move(right_pkey);
   if (touch_end()) {
     current_frame_ = nullptr;
   }
@@ -1963,37 +2980,64 @@ RC BplusTreeScanner::open(const char *left_user_key, int left_len, bool left_inc
   return RC::SUCCESS;
 }
 
-void BplusTreeScanner::fetch_item(RID &rid)
+void BplusTreeScanner::fetch_item(RID &rid, const char *&user_key)
 {
   LeafIndexNodeHandler node(mtr_, tree_handler_.file_header_, current_frame_);
   memcpy(&rid, node.value_at(iter_index_), sizeof(rid));
+  user_key = node.key_at(iter_index_);
 }
 
 bool BplusTreeScanner::touch_end()
 {
-  if (right_key_ == nullptr) {
+  const auto &end_key = reverse_ ? left_key_ : right_key_;
+  if (end_key == nullptr) {
     return false;
   }
 
   LeafIndexNodeHandler node(mtr_, tree_handler_.file_header_, current_frame_);
 
   const char *this_key       = node.key_at(iter_index_);
-  int         compare_result = tree_handler_.key_comparator_(this_key, static_cast<char *>(right_key_.get()));
-  return compare_result > 0;
+  int         compare_result = tree_handler_.key_comparator_(this_key, static_cast<char *>(end_key.get()));
+  return reverse_ ? compare_result < 0 : compare_result > 0;
 }
 
 RC BplusTreeScanner::next_entry(RID &rid)
+{
+  const char *user_key = nullptr;
+  return next_entry(rid, user_key);
+}
+
+RC BplusTreeScanner::next_entry(RID &rid, const char *&user_key)
 {
   if (nullptr == current_frame_) {
     return RC::RECORD_EOF;
   }
 
   if (!first_emitted_) {
-    fetch_item(rid);
+    fetch_item(rid, user_key);
     first_emitted_ = true;
     return RC::SUCCESS;
   }
 
+  if (reverse_) {
+    iter_index_--;
+    if (iter_index_ < 0) {
+      RC rc = move_to_prev_leaf();
+      if (OB_FAIL(rc)) {
+        return rc;
+      }
+      if (nullptr == current_frame_) {
+        return RC::RECORD_EOF;
+      }
+    }
+
+    if (touch_end()) {
+      return RC::RECORD_EOF;
+    }
+    fetch_item(rid, user_key);
+    return RC::SUCCESS;
+  }
+
   iter_index_++;
 
   LeafIndexNodeHandler node(mtr_, tree_handler_.file_header_, current_frame_);
@@ -2002,7 +3046,7 @@ RC BplusTreeScanner::next_entry(RID &rid)
       return RC::RECORD_EOF;
     }
 
-    fetch_item(rid);
+    fetch_item(rid, user_key);
     return RC::SUCCESS;
   }
 
@@ -2032,8 +3076,61 @@ RC BplusTreeScanner::next_entry(RID &rid)
   }
 
   latch_memo.release_to(memo_point);
+  prefetch_leaves();
   iter_index_ = -1;  // `next` will add 1
-  return next_entry(rid);
+  return next_entry(rid, user_key);
+}
+
+RC BplusTreeScanner::move_to_prev_leaf()
+{
+  // 先放掉当前叶子节点的锁再从根节点开始查找，加锁的顺序与插入、删除相同，不会死锁
+  LeafIndexNodeHandler node(mtr_, tree_handler_.file_header_, current_frame_);
+  const char          *first_key = node.key_at(0);
+  vector<char>         key(first_key, first_key + tree_handler_.file_header_.key_length);
+
+  mtr_.latch_memo().release();
+  current_frame_ = nullptr;
+
+  RC rc = tree_handler_.find_leaf_before(mtr_, key.data(), current_frame_, iter_index_);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to find previous leaf. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  if (current_frame_ != nullptr) {
+    prefetch_leaves();
+  }
+  return RC::SUCCESS;
+}
+
+void BplusTreeScanner::prefetch_leaves()
+{
+  const PageNum page_num = current_frame_->page_num();
+  if (prefetch_index_ < prefetch_pages_.size() && prefetch_pages_[prefetch_index_] == page_num) {
+    prefetch_index_++;
+    // 父节点中后面的叶子节点都已经预读过了，或者预读过的页面还剩一半以上，都不需要再预读
+    const size_t remain = prefetch_pages_.size() - prefetch_index_;
+    if (prefetch_pages_.size() < static_cast<size_t>(PREFETCH_LEAF_NUM) || remain > PREFETCH_LEAF_NUM / 2) {
+      return;
+    }
+  }
+
+  LeafIndexNodeHandler node(mtr_, tree_handler_.file_header_, current_frame_);
+  if (node.size() <= 0) {
+    return;
+  }
+
+  tree_handler_.sibling_leaves(mtr_, node.key_at(0), !reverse_, PREFETCH_LEAF_NUM, prefetch_pages_);
+  prefetch_index_ = 0;
+  if (prefetch_pages_.empty()) {
+    return;
+  }
+
+  RC rc = tree_handler_.disk_buffer_pool_->prefetch_pages(prefetch_pages_);
+  if (OB_FAIL(rc)) {
+    // 预读失败不影响正常的读取
+    LOG_TRACE("failed to prefetch leaves. rc=%s", strrc(rc));
+  }
 }
 
 RC BplusTreeScanner::close()
@@ -23,6 +23,7 @@ See the Mulan PSL v2 for more details. */
 #include "common/lang/memory.h"
 #include "common/lang/sstream.h"
 #include "common/lang/functional.h"
+#include "common/lang/vector.h"
 #include "common/log/log.h"
 #include "sql/parser/parse_defs.h"
 #include "storage/buffer/disk_buffer_pool.h"
@@ -49,36 +50,66 @@ enum class BplusTreeOperationType
   DELETE,
 };
 
+/**
+ * @brief 一个索引最多包含的字段个数
+ * @ingroup BPlusTree
+ */
+static constexpr int BPLUS_TREE_MAX_ATTR_NUM = 8;
+
 /**
  * @brief 属性比较(BplusTree)
  * @ingroup BPlusTree
+ * @details 多个字段的索引，键值是各个字段的值按照顺序拼接起来的，依次比较每个字段
  */
 class AttrComparator
 {
 public:
-  void init(AttrType type, int length)
+  void init(AttrType type, int length) { init(1, &type, &length); }
+
+  void init(int attr_num, const AttrType attr_types[], const int attr_lengths[])
   {
-    attr_type_   = type;
-    attr_length_ = length;
+    attr_num_    = attr_num;
+    attr_length_ = 0;
+    for (int i = 0; i < attr_num; i++) {
+      attr_types_[i]   = attr_types[i];
+      attr_lengths_[i] = attr_lengths[i];
+      attr_length_ += attr_lengths[i];
+    }
   }
 
   int attr_length() const { return attr_length_; }
 
   int operator()(const char *v1, const char *v2) const
+  {
+    int offset = 0;
+    for (int i = 0; i < attr_num_; i++) {
+      int result = compare_attr(attr_types_[i], attr_lengths_[i], v1 + offset, v2 + offset);
+      if (result != 0) {
+        return result;
+      }
+      offset += attr_lengths_[i];
+    }
+    return 0;
+  }
+
+private:
+  static int compare_attr(AttrType attr_type, int attr_length, const char *v1, const char *v2)
   {
     // TODO: optimized the comparison
     Value left;
-    left.set_type(attr_type_);
-    left.set_data(v1, attr_length_);
+    left.set_type(attr_type);
+    left.set_data(v1, attr_length);
     Value right;
-    right.set_type(attr_type_);
-    right.set_data(v2, attr_length_);
-    return DataType::type_instance(attr_type_)->compare(left, right);
+    right.set_type(attr_type);
+    right.set_data(v2, attr_length);
+    return DataType::type_instance(attr_type)->compare(left, right);
   }
 
 private:
-  AttrType attr_type_;
-  int      attr_length_;
+  int      attr_num_    = 0;
+  int      attr_length_ = 0;
+  AttrType attr_types_[BPLUS_TREE_MAX_ATTR_NUM];
+  int      attr_lengths_[BPLUS_TREE_MAX_ATTR_NUM];
 };
 
 /**
@@ -90,6 +121,10 @@ class KeyComparator
 {
 public:
   void init(AttrType type, int length) { attr_comparator_.init(type, length); }
+  void init(int attr_num, const AttrType attr_types[], const int attr_lengths[])
+  {
+    attr_comparator_.init(attr_num, attr_types, attr_lengths);
+  }
 
   const AttrComparator &attr_comparator() const { return attr_comparator_; }
 
@@ -116,23 +151,43 @@ private:
 class AttrPrinter
 {
 public:
-  void init(AttrType type, int length)
+  void init(AttrType type, int length) { init(1, &type, &length); }
+
+  void init(int attr_num, const AttrType attr_types[], const int attr_lengths[])
   {
-    attr_type_   = type;
-    attr_length_ = length;
+    attr_num_    = attr_num;
+    attr_length_ = 0;
+    for (int i = 0; i < attr_num; i++) {
+      attr_types_[i]   = attr_types[i];
+      attr_lengths_[i] = attr_lengths[i];
+      attr_length_ += attr_lengths[i];
+    }
   }
 
   int attr_length() const { return attr_length_; }
 
   string operator()(const char *v) const
   {
-    Value value(attr_type_, const_cast<char *>(v), attr_length_);
-    return value.to_string();
+    if (attr_num_ == 1) {
+      Value value(attr_types_[0], const_cast<char *>(v), attr_lengths_[0]);
+      return value.to_string();
+    }
+
+    stringstream ss;
+    ss << "(";
+    for (int i = 0, offset = 0; i < attr_num_; offset += attr_lengths_[i], i++) {
+      Value value(attr_types_[i], const_cast<char *>(v + offset), attr_lengths_[i]);
+      ss << (i == 0 ? "" : ",") << value.to_string();
+    }
+    ss << ")";
+    return ss.str();
   }
 
 private:
-  AttrType attr_type_;
-  int      attr_length_;
+  int      attr_num_    = 0;
+  int      attr_length_ = 0;
+  AttrType attr_types_[BPLUS_TREE_MAX_ATTR_NUM];
+  int      attr_lengths_[BPLUS_TREE_MAX_ATTR_NUM];
 };
 
 /**
@@ -143,6 +198,10 @@ class KeyPrinter
 {
 public:
   void init(AttrType type, int length) { attr_printer_.init(type, length); }
+  void init(int attr_num, const AttrType attr_types[], const int attr_lengths[])
+  {
+    attr_printer_.init(attr_num, attr_types, attr_lengths);
+  }
 
   const AttrPrinter &attr_printer() const { return attr_printer_; }
 
@@ -164,7 +223,9 @@ private:
  * @brief the meta information of bplus tree
  * @ingroup BPlusTree
  * @details this is the first page of bplus tree.
- * only one field can be supported, can you extend it to multi-fields?
+ * 多个字段的索引，键值是各个字段按顺序拼接起来的，attr_length 是所有字段长度的和，每个字段的类型和长度
+ * 记录在 attr_types 和 attr_lengths 中。这时 attr_type 是 UNDEFINED，与单个字段的类型相关的优化都不会生效。
+ * 旧版本的索引文件中 attr_num 是0，打开时当做单个字段处理。
  */
 struct IndexFileHeader
 {
@@ -173,12 +234,15 @@ struct IndexFileHeader
     memset(this, 0, sizeof(IndexFileHeader));
     root_page = BP_INVALID_PAGE_NUM;
   }
-  PageNum  root_page;          ///< 根节点在磁盘中的页号
-  int32_t  internal_max_size;  ///< 内部节点最大的键值对数
-  int32_t  leaf_max_size;      ///< 叶子节点最大的键值对数
-  int32_t  attr_length;        ///< 键值的长度
-  int32_t  key_length;         ///< attr length + sizeof(RID)
-  AttrType attr_type;          ///< 键值的类型
+  PageNum  root_page;                              ///< 根节点在磁盘中的页号
+  int32_t  internal_max_size;                      ///< 内部节点最大的键值对数。内部节点的键值是压缩存储的，还受页面空间的限制
+  int32_t  leaf_max_size;                          ///< 叶子节点最大的键值对数
+  int32_t  attr_length;                            ///< 键值的长度
+  int32_t  key_length;                             ///< attr length + sizeof(RID)
+  AttrType attr_type;                              ///< 键值的类型
+  int32_t  attr_num;                               ///< 索引包含的字段个数
+  AttrType attr_types[BPLUS_TREE_MAX_ATTR_NUM];    ///< 每个字段的类型
+  int32_t  attr_lengths[BPLUS_TREE_MAX_ATTR_NUM];  ///< 每个字段的长度
 
   const string to_string() const
   {
@@ -187,6 +251,7 @@ struct IndexFileHeader
     ss << "attr_length:" << attr_length << ","
        << "key_length:" << key_length << ","
        << "attr_type:" << attr_type_to_string(attr_type) << ","
+       << "attr_num:" << attr_num << ","
        << "root_page:" << root_page << ","
        << "internal_max_size:" << internal_max_size << ","
        << "leaf_max_size:" << leaf_max_size << ";";
@@ -241,19 +306,32 @@ struct LeafIndexNode : public IndexNode
  * @ingroup BPlusTree
  * @code
  * storage format:
- * | common header |
- * | key(0),page_id(0) | key(1), page_id(1) | ... | key(n), page_id(n) |
+ * | common header | prefix length | fence flags |
+ * | low fence key | high fence key | slot(0) | slot(1) | ... | slot(n) |
+ * | page_id(0), suffix length(0), suffix(0) | ... | page_id(n), suffix length(n), suffix(n) |
  * @endcode
- * the first key is ignored(key0).
- * so it will waste space, can you fix this?
+ * 内部节点的键值是压缩存储的，每个元素的长度不同，slot中记录的是元素在页面中的位置。
+ * - 前缀压缩：节点中所有的键值都在上下界 [low fence, high fence) 的范围内，对于字符串来说，它们一定有上下界的公共前缀，
+ *   这个前缀只在下界中保存一份，每个键值中去掉。前缀由上下界决定，插入新的键值时不会变短，页面不需要重新展开。
+ *   没有上界或下界的节点(最右边或最左边的节点)不做前缀压缩。
+ * - 后缀截断：键值最后连续的0不存储。叶子节点分裂时，插入父节点的是能区分左右两个节点的最短键值，
+ *   剩余部分都是0，所以内部节点的键值通常很短。
+ * 与以前一样，第一个键值(key0)就是这个节点在父节点中的键值，查找时不使用。
  */
 struct InternalIndexNode : public IndexNode
 {
-  static constexpr int HEADER_SIZE = IndexNode::HEADER_SIZE;
+  static constexpr int HEADER_SIZE = IndexNode::HEADER_SIZE + 4;
+
+  static constexpr uint8_t HAS_LOW_FENCE  = 0x01;  ///< 有下界
+  static constexpr uint8_t HAS_HIGH_FENCE = 0x02;  ///< 有上界
+
+  /// 每个元素除了后缀之外的大小：slot、子节点页号和后缀长度
+  static constexpr int ITEM_OVERHEAD = sizeof(uint16_t) + sizeof(PageNum) + sizeof(uint16_t);
+
+  uint16_t prefix_length;  ///< 所有键值共同的前缀长度，前缀就是下界的前 prefix_length 个字节
+  uint8_t  fence_flags;    ///< 是否有上下界
+  uint8_t  reserved;
 
-  /**
-   * internal node just store order -1 keys and order rids, the last rid is last right child.
-   */
   char array[0];
 };
 
@@ -308,8 +386,12 @@ public:
 
   friend string to_string(const IndexNodeHandler &handler);
 
-  RC recover_insert_items(int index, const char *items, int num);
-  RC recover_remove_items(int index, int num);
+  /**
+   * @brief 在指定位置插入元素，不记录日志
+   * @details 重做和回滚日志时使用。元素的格式是完整的键值加上值
+   */
+  virtual RC recover_insert_items(int index, const char *items, int num);
+  virtual RC recover_remove_items(int index, int num);
 
 protected:
   /**
@@ -362,6 +444,11 @@ public:
    */
   RC move_to(LeafIndexNodeHandler &other);
 
+  /// 是否需要与邻居节点合并或重新分配
+  bool is_underflow() const { return size() < min_size(); }
+  /// 把右边的节点合并到当前节点后是否还放得下
+  bool can_merge(const LeafIndexNodeHandler &right) const { return size() + right.size() <= max_size(); }
+
   bool validate(const KeyComparator &comparator, DiskBufferPool *bp) const;
 
   friend string to_string(const LeafIndexNodeHandler &handler, const KeyPrinter &printer);
@@ -390,7 +477,11 @@ public:
   RC init_empty();
   RC create_new_root(PageNum first_page_num, const char *key, PageNum page_num);
 
-  RC      insert(const char *key, PageNum page_num, const KeyComparator &comparator);
+  RC insert(const char *key, PageNum page_num, const KeyComparator &comparator);
+  /**
+   * @brief 返回指定位置的键值
+   * @details 键值是压缩存储的，会解压到当前对象的缓冲区中，在下次调用 key_at 之前有效
+   */
   char   *key_at(int index);
   PageNum value_at(int index);
 
@@ -412,6 +503,42 @@ public:
   int lookup(
       const KeyComparator &comparator, const char *key, bool *found = nullptr, int *insert_position = nullptr) const;
 
+  /**
+   * @brief 设置节点的上下界
+   * @details 节点中所有的键值都在 [low_key, high_key) 范围内，页内的公共前缀根据上下界计算。
+   * 最左边的节点没有下界，最右边的节点没有上界，对应的参数传 nullptr。
+   * 上下界变化后页面会重新编码，范围变大时前缀可能变短，调用者需要先确认页面放得下。
+   */
+  RC set_fence(const char *low_key, const char *high_key);
+  /// 下界。没有下界时返回 nullptr
+  const char *low_fence() const;
+  /// 上界。没有上界时返回 nullptr
+  const char *high_fence() const;
+
+  /// 插入一个键值后是否还放得下。放不下就需要分裂
+  bool can_insert(const char *key) const;
+  /// 把右边的节点合并到当前节点后是否还放得下
+  bool can_merge(const InternalIndexNodeHandler &right) const;
+  /// 修改指定位置的键值后是否还放得下
+  bool can_set_key_at(int index, const char *key) const;
+  /**
+   * @brief 从邻居节点借一个元素，并修改上下界之后是否还放得下
+   * @param index 新元素的位置，只能是最前面或者最后面
+   * @param item 新元素，完整的键值加上子节点页号
+   */
+  bool can_borrow(int index, const char *item, const char *low_key, const char *high_key) const;
+
+  /**
+   * @brief 是否需要与邻居节点合并或重新分配
+   * @details 元素个数和占用的空间都不到一半。指定了节点的最大元素个数时，元素个数起作用；
+   * 否则元素个数的上限很大，由占用的空间决定
+   */
+  bool is_underflow() const;
+  /// 再插入任意一个键值都不需要分裂
+  bool is_safe_to_insert() const;
+  /// 再删除任意一个键值都不会 underflow
+  bool is_safe_to_remove() const;
+
   /**
    * @brief 把当前节点的所有数据都迁移到另一个节点上
    *
@@ -426,6 +553,16 @@ public:
 
   friend string to_string(const InternalIndexNodeHandler &handler, const KeyPrinter &printer);
 
+  RC recover_insert_items(int index, const char *items, int num) override;
+  RC recover_remove_items(int index, int num) override;
+
+  /// 页面中用来存放元素的空间，不包括上下界
+  static int space(int key_length);
+  /// 指定的键值长度下，一个页面最多可以放多少个元素
+  static int max_item_num(int key_length);
+  /// 指定的键值长度下，一个页面至少可以放多少个元素，也就是所有键值都不能压缩的情况
+  static int min_item_num(int key_length);
+
 private:
   RC insert_items(int index, const char *items, int num);
   RC append(const char *items, int num);
@@ -433,13 +570,29 @@ private:
   RC preappend(const char *item);
 
 private:
-  char *__item_at(int index) const override;
-
   int value_size() const override;
   int item_size() const override;
 
+  /// 元素已经使用的空间，不包括上下界
+  int   used_bytes() const;
+  int   prefix_length() const;
+  /// slot 数组的起始位置，元素紧跟在 slot 数组后面，slot 中记录的是元素相对这里的偏移
+  char *slot_area() const;
+  /// 读取第index个元素的位置、子节点页号和后缀。乐观读的时候页面可能正在被修改，这里保证不会越界
+  void  item_at(int index, PageNum &page_num, const char *&suffix, int &suffix_length) const;
+  /// 把第index个键值解压到key中
+  void  decode_key(int index, char *key) const;
+  /// 解压所有元素，每个元素是完整的键值加上子节点页号
+  void  decode_items(vector<char> &items) const;
+  /// 计算使用指定的上下界，对这些元素编码后需要的空间
+  int   encoded_size(const char *low_key, const char *high_key, const char *items, int num) const;
+  int   common_prefix_length(const char *low_key, const char *high_key, const char *items, int num) const;
+  /// 使用指定的上下界对元素重新编码，写入页面
+  RC    encode(const char *low_key, const char *high_key, const char *items, int num);
+
 private:
-  InternalIndexNode *internal_node_ = nullptr;
+  InternalIndexNode   *internal_node_ = nullptr;
+  mutable vector<char> key_buffer_;  ///< key_at 返回的解压后的键值
 };
 
 /**
@@ -464,6 +617,17 @@ public:
   RC create(LogHandler &log_handler, DiskBufferPool &buffer_pool, AttrType attr_type, int attr_length,
       int internal_max_size = -1, int leaf_max_size = -1);
 
+  /**
+   * @brief 创建一个多个字段的B+树
+   * @details 键值是各个字段的值按照顺序拼接起来的，先按照第一个字段比较，相同时再比较下一个字段
+   * @param attr_types 每个字段的类型
+   * @param attr_lengths 每个字段的长度
+   */
+  RC create(LogHandler &log_handler, BufferPoolManager &bpm, const char *file_name, const vector<AttrType> &attr_types,
+      const vector<int> &attr_lengths, int internal_max_size = -1, int leaf_max_size = -1);
+  RC create(LogHandler &log_handler, DiskBufferPool &buffer_pool, const vector<AttrType> &attr_types,
+      const vector<int> &attr_lengths, int internal_max_size = -1, int leaf_max_size = -1);
+
   /**
    * @brief 打开一个B+树
    * @param log_handler 记录日志
@@ -493,6 +657,17 @@ public:
    */
   RC delete_entry(const char *user_key, const RID *rid);
 
+  /**
+   * @brief 使用有序的数据批量构建B+树
+   * @details 只能在空树上调用。自底向上构建，叶子节点从左到右依次填充到 fill_factor 指定的比例，
+   * 上层节点在下层节点创建时同步创建，只需要遍历一次数据。每层的节点个数提前算好，元素平均分配到各个节点上。
+   * 构建过程中的页面修改不记录日志，完成后先把所有页面写入磁盘并落盘，再记录一条更新根节点的日志。
+   * @param entry_num 键值对的个数
+   * @param next_key 按照从小到大的顺序依次返回键值(属性值+RID)，返回 RECORD_EOF 表示结束
+   * @param fill_factor 节点的填充比例
+   */
+  RC bulk_load(int64_t entry_num, const function<RC(const char *&key)> &next_key, float fill_factor);
+
   bool is_empty() const;
 
   /**
@@ -545,6 +720,11 @@ private:
   bool validate_leaf_link(BplusTreeMiniTransaction &mtr);
   bool validate_node_recursive(BplusTreeMiniTransaction &mtr, Frame *frame);
 
+  /**
+   * @brief 根据元数据页面中每个字段的类型和长度初始化键值比较器
+   */
+  void init_key_comparator();
+
 protected:
   /**
    * @brief 查找叶子节点
@@ -559,8 +739,29 @@ protected:
    */
   RC left_most_page(BplusTreeMiniTransaction &mtr, Frame *&frame);
 
+  /**
+   * @brief 查找比 key 小的最大键值，反向扫描使用
+   * @details 叶子节点之间只有向后的链接，找前一个叶子节点时从根节点重新查找。
+   * 内部节点中的键值是截断过的，可能比右边子树中最小的键值还要小，这时找到的子树中没有比 key 小的键值，
+   * 就用查找路径上最后一次没有走最左边子节点时的分隔键值再查找一次
+   * @param key 查找的键值，包含RID。nullptr 表示查找最大的键值
+   * @param[out] frame 返回找到的叶子节点，加了读锁。没有比 key 小的键值时返回 nullptr
+   * @param[out] index 键值在叶子节点中的位置
+   */
+  RC find_leaf_before(BplusTreeMiniTransaction &mtr, const char *key, Frame *&frame, int &index);
+
+  /**
+   * @brief 找到 key 所在的叶子节点的兄弟节点，扫描时用来预读
+   * @details 从父节点中取出这个叶子节点后面(forward)或者前面的最多 count 个叶子节点。
+   * 查找过程中只固定页面不加锁，通过版本号检查读到的内容，页面被修改时放弃，返回空
+   * @param key 叶子节点中的一个键值，包含RID
+   */
+  void sibling_leaves(
+      BplusTreeMiniTransaction &mtr, const char *key, bool forward, int count, vector<PageNum> &pages);
+
   /**
    * @brief 查找指定的叶子节点
+   * @details 读取和插入先尝试乐观的方式，失败几次后再使用crabing protocol
    * @param op 当前想要执行的操作。操作类型不同会在查找的过程中加不同类型的锁
    * @param child_page_getter 用于获取子节点的函数
    * @param[out] frame 返回找到的叶子节点
@@ -568,6 +769,22 @@ protected:
   RC find_leaf_internal(BplusTreeMiniTransaction &mtr, BplusTreeOperationType op,
       const function<PageNum(InternalIndexNodeHandler &)> &child_page_getter, Frame *&frame);
 
+  /**
+   * @brief 使用乐观锁查找叶子节点
+   * @details 从根节点向下查找时只pin住页面，不加锁，通过页面的版本号检查读取期间页面有没有被修改。
+   * 到达叶子节点后按照操作类型给叶子节点加锁，如果叶子节点的版本号仍然没有变化，就找到了正确的叶子节点。
+   * 插入操作只有在叶子节点不需要分裂时才能成功。
+   * @return LOCKED_CONCURRENCY_CONFLICT 查找过程中页面被修改了，或者叶子节点需要分裂，需要重试或者使用悲观的方式
+   */
+  RC optimistic_find_leaf(BplusTreeMiniTransaction &mtr, BplusTreeOperationType op,
+      const function<PageNum(InternalIndexNodeHandler &)> &child_page_getter, Frame *&frame);
+
+  /**
+   * @brief 使用crabing protocol从根节点开始加锁查找叶子节点
+   */
+  RC pessimistic_find_leaf(BplusTreeMiniTransaction &mtr, BplusTreeOperationType op,
+      const function<PageNum(InternalIndexNodeHandler &)> &child_page_getter, Frame *&frame);
+
   /**
    * @brief 使用crabing protocol 获取页面
    */
@@ -632,6 +849,13 @@ protected:
    */
   RC adjust_root(BplusTreeMiniTransaction &mtr, Frame *root_frame);
 
+  /**
+   * @brief 计算左右两个节点之间的分隔键值，放到父节点中
+   * @details 字符串类型使用能区分 left_key 和 right_key 的最短前缀，剩余部分都是0，内部节点压缩存储时只需要保存前缀。
+   * 结果满足 left_key < separator <= right_key。其它类型直接使用 right_key。
+   */
+  void make_separator(const char *left_key, const char *right_key, char *separator) const;
+
 private:
   common::MemPoolItem::item_unique_ptr make_key(const char *user_key, const RID &rid);
 
@@ -641,6 +865,9 @@ protected:
   bool            header_dirty_     = false;    /// 是否需要更新头页面
   IndexFileHeader file_header_;
 
+  /// 乐观查找叶子节点的最多尝试次数，之后使用悲观的方式
+  static constexpr int OPTIMISTIC_RETRY_TIMES = 3;
+
   // 在调整根节点时，需要加上这个锁。
   // 这个锁可以使用递归读写锁，但是这里偷懒先不改
   common::SharedMutex root_lock_;
@@ -652,6 +879,7 @@ protected:
 
 private:
   friend class BplusTreeScanner;
+  friend class BplusTreeBulkLoader;
   friend class BplusTreeTester;
 };
 
@@ -673,22 +901,28 @@ public:
    * @param right_user_key 扫描范围的右边界。如果是null，则没有右边界
    * @param right_len right_user_key 的内存大小(只有在变长字段中才会关注)
    * @param right_inclusive 右边界的值是否包含在内
+   * @param reverse 是否从右边界开始按照键值从大到小扫描
    * TODO 重构参数表示方法
    */
   RC open(const char *left_user_key, int left_len, bool left_inclusive, const char *right_user_key, int right_len,
-      bool right_inclusive);
+      bool right_inclusive, bool reverse = false);
 
   /**
    * @brief 获取下一条记录
    *
    * @param rid 当前默认所有值都是RID类型。对B+树来说并不是一个好的抽象
    * @return RC RECORD_EOF 表示遍历完成
-   * TODO 需要增加返回 key 的接口
    * @warning 不要在遍历时删除数据。删除数据会导致遍历器失效。
    * 当前默认的走索引删除的逻辑就是这样做的，所以删除逻辑有BUG。
    */
   RC next_entry(RID &rid);
 
+  /**
+   * @brief 获取下一条记录，同时返回键值
+   * @param[out] user_key 指向叶子页面中的键值(不包含RID)，下次调用 next_entry 或者关闭扫描器之后就失效了
+   */
+  RC next_entry(RID &rid, const char *&user_key);
+
   /**
    * @brief 关闭当前扫描器
    * @details 可以不调用，在析构函数时会自动执行
@@ -701,13 +935,27 @@ private:
    */
   RC fix_user_key(const char *user_key, int key_len, bool want_greater, char **fixed_key, bool *should_inclusive);
 
-  void fetch_item(RID &rid);
+  void fetch_item(RID &rid, const char *&user_key);
 
   /**
    * @brief 判断是否到了扫描的结束位置
    */
   bool touch_end();
 
+  /// 反向扫描时移动到前一个叶子节点
+  RC move_to_prev_leaf();
+
+  /**
+   * @brief 进入一个新的叶子节点时，预读扫描方向上后面的叶子节点
+   * @details 叶子节点在文件中通常不连续，按页号顺序预读没有用，从父节点中取出后面的叶子节点一起读取。
+   * 预读过的叶子节点用掉一半以后再预读下一批
+   */
+  void prefetch_leaves();
+
+public:
+  /// 每次预读的叶子节点个数
+  static constexpr int PREFETCH_LEAF_NUM = 16;
+
 private:
   bool                     inited_ = false;
   BplusTreeHandler        &tree_handler_;
@@ -717,7 +965,12 @@ private:
   /// 起始位置和终止位置都是有效的数据
   Frame *current_frame_ = nullptr;
 
-  common::MemPoolItem::item_unique_ptr right_key_;
+  bool                                 reverse_ = false;
+  common::MemPoolItem::item_unique_ptr left_key_;   ///< 反向扫描的结束位置
+  common::MemPoolItem::item_unique_ptr right_key_;  ///< 正向扫描的结束位置
   int                                  iter_index_    = -1;
   bool                                 first_emitted_ = false;
+
+  vector<PageNum> prefetch_pages_;      ///< 最近一次预读的叶子节点，按照扫描的顺序
+  size_t          prefetch_index_ = 0;  ///< 下一个应该访问到的预读页面
 };
@@ -0,0 +1,44 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/index/bplus_tree_bulk_loader.h"
+#include "common/log/log.h"
+#include "storage/index/bplus_tree.h"
+
+BplusTreeBulkLoader::BplusTreeBulkLoader(
+    BplusTreeHandler &tree_handler, const string &spill_file, size_t sort_memory, float fill_factor)
+    : tree_handler_(tree_handler),
+      fill_factor_(fill_factor),
+      sorter_(tree_handler.file_header().key_length,
+          [&tree_handler](const char *left, const char *right) { return tree_handler.key_comparator_(left, right); },
+          spill_file, sort_memory),
+      key_(tree_handler.file_header().key_length)
+{}
+
+RC BplusTreeBulkLoader::add(const char *user_key, const RID &rid)
+{
+  const int attr_length = tree_handler_.file_header().attr_length;
+  memcpy(key_.data(), user_key, attr_length);
+  memcpy(key_.data() + attr_length, &rid, sizeof(rid));
+  return sorter_.add(key_.data());
+}
+
+RC BplusTreeBulkLoader::finish()
+{
+  RC rc = sorter_.finish();
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to sort index entries. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  LOG_INFO("index entries sorted. entries=%ld, spilled runs=%d", sorter_.item_num(), sorter_.run_num());
+  return tree_handler_.bulk_load(
+      sorter_.item_num(), [this](const char *&key) { return sorter_.next(key); }, fill_factor_);
+}
@@ -0,0 +1,65 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/sys/rc.h"
+#include "common/lang/string.h"
+#include "common/lang/vector.h"
+#include "storage/common/external_sorter.h"
+#include "storage/record/record.h"
+
+class BplusTreeHandler;
+
+/**
+ * @brief 批量构建B+树
+ * @ingroup BPlusTree
+ * @details 给已经有数据的表创建索引时使用。先收集所有的键值对，使用外部排序排好序，
+ * 然后调用 BplusTreeHandler::bulk_load 自底向上构建B+树。
+ * 与逐条插入相比，不需要每次从根节点查找叶子节点，没有页面分裂，也不需要为每条数据记录日志。
+ */
+class BplusTreeBulkLoader final
+{
+public:
+  /// 默认的节点填充比例，留一些空间给之后的插入，避免马上分裂
+  static constexpr float DEFAULT_FILL_FACTOR = 0.9f;
+  /// 默认排序时使用的内存
+  static constexpr size_t DEFAULT_SORT_MEMORY = 64 * 1024 * 1024;
+
+public:
+  /**
+   * @param tree_handler 要构建的B+树，必须是空的
+   * @param spill_file 排序使用的临时文件
+   * @param sort_memory 排序时最多使用多少内存，超过后会把数据写到临时文件中
+   * @param fill_factor 节点的填充比例
+   */
+  BplusTreeBulkLoader(BplusTreeHandler &tree_handler, const string &spill_file,
+      size_t sort_memory = DEFAULT_SORT_MEMORY, float fill_factor = DEFAULT_FILL_FACTOR);
+
+  /**
+   * @brief 添加一个键值对
+   * @param user_key 属性值，长度与B+树的属性长度一致
+   */
+  RC add(const char *user_key, const RID &rid);
+
+  /**
+   * @brief 所有数据添加完成，构建B+树
+   */
+  RC finish();
+
+  /// 添加了多少个键值对
+  int64_t entry_num() const { return sorter_.item_num(); }
+
+private:
+  BplusTreeHandler &tree_handler_;
+  const float       fill_factor_;
+  ExternalSorter    sorter_;
+  vector<char>      key_;  ///< 添加时拼接键值使用
+};
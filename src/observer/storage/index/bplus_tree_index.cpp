@@ -13,13 +13,17 @@ See the Mulan PSL v2 for more details. */
 //
 
 #include "storage/index/bplus_tree_index.h"
+#include "common/conf/ini.h"
+#include "common/lang/string.h"
 #include "common/log/log.h"
+#include "storage/index/bplus_tree_bulk_loader.h"
+#include "storage/record/record_scanner.h"
 #include "storage/table/table.h"
 #include "storage/db/db.h"
 
 BplusTreeIndex::~BplusTreeIndex() noexcept { close(); }
 
-RC BplusTreeIndex::create(Table *table, const char *file_name, const IndexMeta &index_meta, const FieldMeta &field_meta)
+RC BplusTreeIndex::create(Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
 {
   if (inited_) {
     LOG_WARN("Failed to create index due to the index has been created before. file_name:%s, index:%s, field:%s",
@@ -27,10 +31,17 @@ RC BplusTreeIndex::create(Table *table, const char *file_name, const IndexMeta &
     return RC::RECORD_OPENNED;
   }
 
-  Index::init(index_meta, field_meta);
+  Index::init(index_meta, field_metas);
+
+  vector<AttrType> attr_types;
+  vector<int>      attr_lengths;
+  for (const FieldMeta &field_meta : field_metas) {
+    attr_types.push_back(field_meta.type());
+    attr_lengths.push_back(field_meta.len());
+  }
 
   BufferPoolManager &bpm = table->db()->buffer_pool_manager();
-  RC rc = index_handler_.create(table->db()->log_handler(), bpm, file_name, field_meta.type(), field_meta.len());
+  RC rc = index_handler_.create(table->db()->log_handler(), bpm, file_name, attr_types, attr_lengths);
   if (RC::SUCCESS != rc) {
     LOG_WARN("Failed to create index_handler, file_name:%s, index:%s, field:%s, rc:%s",
         file_name, index_meta.name(), index_meta.field(), strrc(rc));
@@ -44,7 +55,7 @@ RC BplusTreeIndex::create(Table *table, const char *file_name, const IndexMeta &
   return RC::SUCCESS;
 }
 
-RC BplusTreeIndex::open(Table *table, const char *file_name, const IndexMeta &index_meta, const FieldMeta &field_meta)
+RC BplusTreeIndex::open(Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
 {
   if (inited_) {
     LOG_WARN("Failed to open index due to the index has been initedd before. file_name:%s, index:%s, field:%s",
@@ -52,7 +63,7 @@ RC BplusTreeIndex::open(Table *table, const char *file_name, const IndexMeta &in
     return RC::RECORD_OPENNED;
   }
 
-  Index::init(index_meta, field_meta);
+  Index::init(index_meta, field_metas);
 
   BufferPoolManager &bpm = table->db()->buffer_pool_manager();
   RC rc = index_handler_.open(table->db()->log_handler(), bpm, file_name);
@@ -62,6 +73,13 @@ RC BplusTreeIndex::open(Table *table, const char *file_name, const IndexMeta &in
     return rc;
   }
 
+  if (index_handler_.file_header().attr_num != static_cast<int>(field_metas.size())) {
+    LOG_ERROR("field number of index file mismatch with meta. file_name:%s, index:%s, field num in file:%d, in meta:%d",
+        file_name, index_meta.name(), index_handler_.file_header().attr_num, static_cast<int>(field_metas.size()));
+    index_handler_.close();
+    return RC::INTERNAL;
+  }
+
   inited_ = true;
   table_  = table;
   LOG_INFO("Successfully open index, file_name:%s, index:%s, field:%s",
@@ -80,14 +98,73 @@ RC BplusTreeIndex::close()
   return RC::SUCCESS;
 }
 
+RC BplusTreeIndex::bulk_load(RecordScanner &scanner, const string &spill_file)
+{
+  int fill_percent   = 0;
+  int sort_memory_mb = 0;
+  common::str_to_val(common::get_properties()->get("INDEX_BUILD_FILL_FACTOR", "90", "STORAGE"), fill_percent);
+  common::str_to_val(common::get_properties()->get("INDEX_BUILD_SORT_MEMORY_MB", "64", "STORAGE"), sort_memory_mb);
+  if (fill_percent <= 0 || fill_percent > 100) {
+    fill_percent = static_cast<int>(BplusTreeBulkLoader::DEFAULT_FILL_FACTOR * 100);
+  }
+  size_t sort_memory = BplusTreeBulkLoader::DEFAULT_SORT_MEMORY;
+  if (sort_memory_mb > 0) {
+    sort_memory = static_cast<size_t>(sort_memory_mb) * 1024 * 1024;
+  }
+
+  BplusTreeBulkLoader loader(index_handler_, spill_file, sort_memory, fill_percent / 100.0f);
+
+  RC           rc = RC::SUCCESS;
+  Record       record;
+  vector<char> key_buffer;
+  while (OB_SUCC(rc = scanner.next(record))) {
+    rc = loader.add(make_key(record.data(), key_buffer), record.rid());
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to add entry to bulk loader. index=%s, rc=%s", index_meta_.name(), strrc(rc));
+      return rc;
+    }
+  }
+  if (rc != RC::RECORD_EOF) {
+    LOG_WARN("failed to scan records while bulk loading index. index=%s, rc=%s", index_meta_.name(), strrc(rc));
+    return rc;
+  }
+
+  rc = loader.finish();
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to bulk load index. index=%s, rc=%s", index_meta_.name(), strrc(rc));
+    return rc;
+  }
+
+  LOG_INFO("bulk load index done. index=%s, entries=%ld, fill factor=%d%%",
+           index_meta_.name(), loader.entry_num(), fill_percent);
+  return RC::SUCCESS;
+}
+
+const char *BplusTreeIndex::make_key(const char *record, vector<char> &key_buffer) const
+{
+  if (field_metas_.size() == 1) {
+    return record + field_metas_[0].offset();
+  }
+
+  key_buffer.resize(index_handler_.file_header().attr_length);
+  int offset = 0;
+  for (const FieldMeta &field_meta : field_metas_) {
+    memcpy(key_buffer.data() + offset, record + field_meta.offset(), field_meta.len());
+    offset += field_meta.len();
+  }
+  return key_buffer.data();
+}
+
 RC BplusTreeIndex::insert_entry(const char *record, const RID *rid)
 {
-  return index_handler_.insert_entry(record + field_meta_.offset(), rid);
+  vector<char> key_buffer;
+  return index_handler_.insert_entry(make_key(record, key_buffer), rid);
 }
 
 RC BplusTreeIndex::delete_entry(const char *record, const RID *rid)
 {
-  return index_handler_.delete_entry(record + field_meta_.offset(), rid);
+  vector<char> key_buffer;
+  return index_handler_.delete_entry(make_key(record, key_buffer), rid);
 }
 
 IndexScanner *BplusTreeIndex::create_scanner(
@@ -103,6 +180,19 @@ IndexScanner *BplusTreeIndex::create_scanner(
   return index_scanner;
 }
 
+IndexScanner *BplusTreeIndex::create_reverse_scanner(
+    const char *left_key, int left_len, bool left_inclusive, const char *right_key, int right_len, bool right_inclusive)
+{
+  BplusTreeIndexScanner *index_scanner = new BplusTreeIndexScanner(index_handler_);
+  RC rc = index_scanner->open(left_key, left_len, left_inclusive, right_key, right_len, right_inclusive, true /*reverse*/);
+  if (rc != RC::SUCCESS) {
+    LOG_WARN("failed to open reverse index scanner. rc=%d:%s", rc, strrc(rc));
+    delete index_scanner;
+    return nullptr;
+  }
+  return index_scanner;
+}
+
 RC BplusTreeIndex::sync() { return index_handler_.sync(); }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -110,14 +200,16 @@ BplusTreeIndexScanner::BplusTreeIndexScanner(BplusTreeHandler &tree_handler) : t
 
 BplusTreeIndexScanner::~BplusTreeIndexScanner() noexcept { tree_scanner_.close(); }
 
-RC BplusTreeIndexScanner::open(
-    const char *left_key, int left_len, bool left_inclusive, const char *right_key, int right_len, bool right_inclusive)
+RC BplusTreeIndexScanner::open(const char *left_key, int left_len, bool left_inclusive, const char *right_key,
+    int right_len, bool right_inclusive, bool reverse /* = false */)
 {
-  return tree_scanner_.open(left_key, left_len, left_inclusive, right_key, right_len, right_inclusive);
+  return tree_scanner_.open(left_key, left_len, left_inclusive, right_key, right_len, right_inclusive, reverse);
 }
 
 RC BplusTreeIndexScanner::next_entry(RID *rid) { return tree_scanner_.next_entry(*rid); }
 
+RC BplusTreeIndexScanner::next_entry(RID *rid, const char *&key) { return tree_scanner_.next_entry(*rid, key); }
+
 RC BplusTreeIndexScanner::destroy()
 {
   delete this;
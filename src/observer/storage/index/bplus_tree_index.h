@@ -17,6 +17,8 @@ See the Mulan PSL v2 for more details. */
 #include "storage/index/bplus_tree.h"
 #include "storage/index/index.h"
 
+class RecordScanner;
+
 /**
  * @brief B+树索引
  * @ingroup Index
@@ -27,10 +29,19 @@ public:
   BplusTreeIndex() = default;
   virtual ~BplusTreeIndex() noexcept;
 
-  RC create(Table *table, const char *file_name, const IndexMeta &index_meta, const FieldMeta &field_meta) override;
-  RC open(Table *table, const char *file_name, const IndexMeta &index_meta, const FieldMeta &field_meta) override;
+  RC create(Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas) override;
+  RC open(Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas) override;
   RC close();
 
+  /**
+   * @brief 使用表中已有的数据批量构建索引
+   * @details 只能在新创建的索引上调用。所有的键值先做外部排序，再自底向上构建B+树，比逐条插入快很多。
+   * 节点的填充比例和排序使用的内存可以在配置文件中设置
+   * @param scanner 遍历表中的数据
+   * @param spill_file 排序时使用的临时文件
+   */
+  RC bulk_load(RecordScanner &scanner, const string &spill_file);
+
   RC insert_entry(const char *record, const RID *rid) override;
   RC delete_entry(const char *record, const RID *rid) override;
 
@@ -39,9 +50,18 @@ public:
    */
   IndexScanner *create_scanner(const char *left_key, int left_len, bool left_inclusive, const char *right_key,
       int right_len, bool right_inclusive) override;
+  IndexScanner *create_reverse_scanner(const char *left_key, int left_len, bool left_inclusive, const char *right_key,
+      int right_len, bool right_inclusive) override;
 
   RC sync() override;
 
+private:
+  /**
+   * @brief 从记录中取出索引的键值
+   * @details 只有一个字段时直接返回记录中的位置，多个字段时把各个字段拼接到 key_buffer 中
+   */
+  const char *make_key(const char *record, vector<char> &key_buffer) const;
+
 private:
   bool             inited_ = false;
   Table           *table_  = nullptr;
@@ -59,10 +79,11 @@ public:
   ~BplusTreeIndexScanner() noexcept override;
 
   RC next_entry(RID *rid) override;
+  RC next_entry(RID *rid, const char *&key) override;
   RC destroy() override;
 
   RC open(const char *left_key, int left_len, bool left_inclusive, const char *right_key, int right_len,
-      bool right_inclusive);
+      bool right_inclusive, bool reverse = false);
 
 private:
   BplusTreeScanner tree_scanner_;
@@ -85,6 +85,17 @@ RC BplusTreeLogger::internal_update_key(
   return append_log_entry(make_unique<InternalUpdateKeyLogEntryHandler>(node_handler.frame(), index, key, old_key));
 }
 
+RC BplusTreeLogger::internal_set_fence(IndexNodeHandler &node_handler, const char *low_key, const char *high_key,
+    const char *old_low_key, const char *old_high_key)
+{
+  const int key_size = node_handler.key_size();
+  auto      key_span = [key_size](const char *key) {
+    return key == nullptr ? span<const char>() : span<const char>(key, key_size);
+  };
+  return append_log_entry(make_unique<InternalSetFenceLogEntryHandler>(
+      node_handler.frame(), key_span(low_key), key_span(high_key), key_span(old_low_key), key_span(old_high_key)));
+}
+
 RC BplusTreeLogger::set_parent_page(IndexNodeHandler &node_handler, PageNum page_num, PageNum old_page_num)
 {
   return append_log_entry(make_unique<SetParentPageLogEntryHandler>(node_handler.frame(), page_num, old_page_num));
@@ -121,12 +121,24 @@ public:
    * @brief 更新某个内部页面上，更新指定位置的键值
    */
   RC internal_update_key(IndexNodeHandler &node_handler, int index, span<const char> key, span<const char> old_key);
+  /**
+   * @brief 修改某个内部页面的上下界
+   * @details 没有上界或下界时传 nullptr
+   */
+  RC internal_set_fence(IndexNodeHandler &node_handler, const char *low_key, const char *high_key,
+      const char *old_low_key, const char *old_high_key);
 
   /**
    * @brief 修改某个页面的父节点编号
    */
   RC set_parent_page(IndexNodeHandler &node_handler, PageNum page_num, PageNum old_page_num);
 
+  /**
+   * @brief 不再记录页面修改的日志
+   * @details 批量构建B+树时，新页面直接写入磁盘，不需要逐个记录页面的修改
+   */
+  void disable_log() { need_log_ = false; }
+
   /**
    * @brief 提交。表示整个操作成功
    */
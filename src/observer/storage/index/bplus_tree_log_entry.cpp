@@ -34,6 +34,7 @@ string LogOperation::to_string() const
     case Type::INTERNAL_UPDATE_KEY: ss << "INTERNAL_UPDATE_KEY"; break;
     case Type::NODE_INSERT: ss << "NODE_INSERT"; break;
     case Type::NODE_REMOVE: ss << "NODE_REMOVE"; break;
+    case Type::INTERNAL_SET_FENCE: ss << "INTERNAL_SET_FENCE"; break;
     default: ss << "INVALID"; break;
   }
   return ss.str();
@@ -167,6 +168,10 @@ RC LogEntryHandler::from_buffer(
       rc = InternalUpdateKeyLogEntryHandler::deserialize(frame, buffer, handler);
     } break;
 
+    case LogOperation::Type::INTERNAL_SET_FENCE: {
+      rc = InternalSetFenceLogEntryHandler::deserialize(frame, buffer, handler);
+    } break;
+
     case LogOperation::Type::NODE_INSERT:
     case LogOperation::Type::NODE_REMOVE: {
       rc = NormalOperationLogEntryHandler::deserialize(frame, operation, buffer, handler);
@@ -328,11 +333,18 @@ RC NormalOperationLogEntryHandler::rollback(BplusTreeMiniTransaction &mtr, Bplus
   if (nullptr == frame()) {
     return RC::INTERNAL;
   }
-  IndexNodeHandler node_handler(mtr, tree_handler.file_header(), frame());
+  InternalIndexNodeHandler internal_node(mtr, tree_handler.file_header(), frame());
+  LeafIndexNodeHandler     leaf_node(mtr, tree_handler.file_header(), frame());
+  IndexNodeHandler        *real_handler = nullptr;
+  if (leaf_node.is_leaf()) {
+    real_handler = &leaf_node;
+  } else {
+    real_handler = &internal_node;
+  }
   if (operation_type().type() == LogOperation::Type::NODE_INSERT) {
-    return node_handler.recover_remove_items(index_, item_num_);
+    return real_handler->recover_remove_items(index_, item_num_);
   } else {  // should be NODE_REMOVE
-    return node_handler.recover_insert_items(index_, items_.data(), item_num_);
+    return real_handler->recover_insert_items(index_, items_.data(), item_num_);
   }
 }
 
@@ -561,6 +573,75 @@ RC InternalUpdateKeyLogEntryHandler::redo(BplusTreeMiniTransaction &mtr, BplusTr
   return RC::SUCCESS;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// InternalSetFenceLogEntryHandler
+InternalSetFenceLogEntryHandler::InternalSetFenceLogEntryHandler(Frame *frame, span<const char> low_key,
+    span<const char> high_key, span<const char> old_low_key, span<const char> old_high_key)
+    : NodeLogEntryHandler(LogOperation::Type::INTERNAL_SET_FENCE, frame),
+      low_key_(low_key.begin(), low_key.end()),
+      high_key_(high_key.begin(), high_key.end()),
+      old_low_key_(old_low_key.begin(), old_low_key.end()),
+      old_high_key_(old_high_key.begin(), old_high_key.end())
+{}
+
+RC InternalSetFenceLogEntryHandler::serialize_body(Serializer &buffer) const
+{
+  buffer.write_int32(static_cast<int32_t>(low_key_.size()));
+  buffer.write(low_key_);
+  buffer.write_int32(static_cast<int32_t>(high_key_.size()));
+  buffer.write(high_key_);
+  return RC::SUCCESS;
+}
+
+string InternalSetFenceLogEntryHandler::to_string() const
+{
+  stringstream ss;
+  ss << LogEntryHandler::to_string() << ", has_low=" << !low_key_.empty() << ", has_high=" << !high_key_.empty();
+  return ss.str();
+}
+
+RC InternalSetFenceLogEntryHandler::deserialize(Frame *frame, Deserializer &buffer, unique_ptr<LogEntryHandler> &handler)
+{
+  int     ret       = 0;
+  int32_t low_size  = -1;
+  int32_t high_size = -1;
+
+  if ((ret = buffer.read_int32(low_size)) < 0 || low_size < 0) {
+    return RC::INTERNAL;
+  }
+  vector<char> low_key(low_size);
+  if ((ret = buffer.read(low_key)) < 0) {
+    return RC::INTERNAL;
+  }
+
+  if ((ret = buffer.read_int32(high_size)) < 0 || high_size < 0) {
+    return RC::INTERNAL;
+  }
+  vector<char> high_key(high_size);
+  if ((ret = buffer.read(high_key)) < 0) {
+    return RC::INTERNAL;
+  }
+
+  handler = make_unique<InternalSetFenceLogEntryHandler>(
+      frame, low_key, high_key, span<const char>(), span<const char>());
+  return RC::SUCCESS;
+}
+
+RC InternalSetFenceLogEntryHandler::rollback(BplusTreeMiniTransaction &mtr, BplusTreeHandler &tree_handler)
+{
+  if (nullptr == frame()) {
+    return RC::INTERNAL;
+  }
+  InternalIndexNodeHandler node_handler(mtr, tree_handler.file_header(), frame());
+  return node_handler.set_fence(key_or_null(old_low_key_), key_or_null(old_high_key_));
+}
+
+RC InternalSetFenceLogEntryHandler::redo(BplusTreeMiniTransaction &mtr, BplusTreeHandler &tree_handler)
+{
+  InternalIndexNodeHandler node_handler(mtr, tree_handler.file_header(), frame());
+  return node_handler.set_fence(key_or_null(low_key_), key_or_null(high_key_));
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // UpdateRootPageLogEntryHandler
 
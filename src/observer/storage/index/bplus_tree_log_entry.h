@@ -50,6 +50,7 @@ public:
     INTERNAL_UPDATE_KEY,       /// 更新内部节点的key
     NODE_INSERT,               /// 在节点中间(也可能是末尾)插入一些元素
     NODE_REMOVE,               /// 在节点中间(也可能是末尾)删除一些元素
+    INTERNAL_SET_FENCE,        /// 修改内部节点的上下界
 
     MAX_TYPE,
   };
@@ -376,4 +377,34 @@ private:
   vector<char> old_key_;
 };
 
+/**
+ * @brief 修改内部节点上下界的日志处理类
+ * @ingroup CLog
+ * @details 上下界为空表示没有上界或下界
+ */
+class InternalSetFenceLogEntryHandler : public NodeLogEntryHandler
+{
+public:
+  InternalSetFenceLogEntryHandler(Frame *frame, span<const char> low_key, span<const char> high_key,
+      span<const char> old_low_key, span<const char> old_high_key);
+  virtual ~InternalSetFenceLogEntryHandler() = default;
+
+  RC serialize_body(common::Serializer &buffer) const override;
+  RC rollback(BplusTreeMiniTransaction &mtr, BplusTreeHandler &tree_handler) override;
+  RC redo(BplusTreeMiniTransaction &mtr, BplusTreeHandler &tree_handler) override;
+
+  string to_string() const override;
+
+  static RC deserialize(Frame *frame, common::Deserializer &buffer, unique_ptr<LogEntryHandler> &handler);
+
+private:
+  static const char *key_or_null(const vector<char> &key) { return key.empty() ? nullptr : key.data(); }
+
+private:
+  vector<char> low_key_;
+  vector<char> high_key_;
+  vector<char> old_low_key_;
+  vector<char> old_high_key_;
+};
+
 }  // namespace bplus_tree
@@ -0,0 +1,647 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/index/hash_index.h"
+#include "common/lang/algorithm.h"
+#include "common/lang/string.h"
+#include "common/log/log.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "storage/db/db.h"
+#include "storage/index/hash_index_log.h"
+#include "storage/table/table.h"
+
+/// 索引文件的第一个页面，存放 HashIndexFileHeader
+static constexpr PageNum HASH_INDEX_HEADER_PAGE = 1;
+
+/**
+ * @brief 计算键值的哈希值
+ * @details 哈希值会保存在索引文件中(决定了数据放在哪个桶)，不能使用 std::hash 这种与实现相关的函数。
+ * 这里用 FNV-1a，再用 murmur3 的 fmix64 打散，目录使用的低位也能分布均匀
+ */
+static uint64_t hash_key(const char *key, int len)
+{
+  uint64_t hash = 14695981039346656037ULL;
+  for (int i = 0; i < len; i++) {
+    hash ^= static_cast<unsigned char>(key[i]);
+    hash *= 1099511628211ULL;
+  }
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+static HashBucketPageHeader *bucket_header(Frame *frame)
+{
+  return reinterpret_cast<HashBucketPageHeader *>(frame->data());
+}
+
+static char *bucket_items(Frame *frame) { return frame->data() + sizeof(HashBucketPageHeader); }
+
+HashIndex::~HashIndex() noexcept { close(); }
+
+RC HashIndex::create(Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
+{
+  if (inited_) {
+    LOG_WARN("Failed to create index due to the index has been created before. file_name:%s, index:%s",
+        file_name, index_meta.name());
+    return RC::RECORD_OPENNED;
+  }
+
+  Index::init(index_meta, field_metas);
+
+  memset(&header_, 0, sizeof(header_));
+  header_.attr_num = static_cast<int32_t>(field_metas.size());
+  for (const FieldMeta &field_meta : field_metas) {
+    header_.key_length += field_meta.len();
+  }
+  header_.bucket_capacity = static_cast<int32_t>((BP_PAGE_DATA_SIZE - sizeof(HashBucketPageHeader)) / entry_size());
+  if (header_.bucket_capacity < 2) {
+    LOG_WARN("key is too long for hash index. index=%s, key length=%d", index_meta.name(), header_.key_length);
+    return RC::INVALID_ARGUMENT;
+  }
+
+  BufferPoolManager &bpm = table->db()->buffer_pool_manager();
+  RC rc = bpm.create_file(file_name);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("Failed to create file. file name=%s, rc=%s", file_name, strrc(rc));
+    return rc;
+  }
+
+  log_handler_ = &table->db()->log_handler();
+  rc           = bpm.open_file(*log_handler_, file_name, disk_buffer_pool_);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("Failed to open file. file name=%s, rc=%s", file_name, strrc(rc));
+    return rc;
+  }
+
+  // 初始的目录只有一项，指向一个空桶
+  HashIndexMiniTransaction mtr(*disk_buffer_pool_, *log_handler_);
+
+  Frame *header_frame = nullptr;
+  Frame *dir_frame    = nullptr;
+  Frame *bucket_frame = nullptr;
+  if (OB_FAIL(rc = mtr.allocate_page(header_frame)) || OB_FAIL(rc = mtr.allocate_page(dir_frame)) ||
+      OB_FAIL(rc = mtr.allocate_page(bucket_frame))) {
+    LOG_WARN("failed to allocate pages of hash index. rc=%s", strrc(rc));
+    return rc;
+  }
+  if (header_frame->page_num() != HASH_INDEX_HEADER_PAGE) {
+    LOG_WARN("header page num should be %d but got %d. is it a new file",
+             HASH_INDEX_HEADER_PAGE, header_frame->page_num());
+    return RC::INTERNAL;
+  }
+
+  header_.global_depth = 0;
+  header_.dir_page_num = 1;
+  header_.dir_pages[0] = dir_frame->page_num();
+  directory_.assign(1, bucket_frame->page_num());
+  if (OB_FAIL(rc = mtr.logger().bucket_init(bucket_frame, 0 /*local_depth*/)) ||
+      OB_FAIL(rc = write_directory(mtr, 0, 1)) || OB_FAIL(rc = write_header(mtr)) || OB_FAIL(rc = mtr.commit())) {
+    LOG_WARN("failed to init hash index. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  inited_ = true;
+  table_  = table;
+  LOG_INFO("Successfully create hash index. file_name:%s, index:%s, key length=%d, bucket capacity=%d",
+           file_name, index_meta.name(), header_.key_length, header_.bucket_capacity);
+  return RC::SUCCESS;
+}
+
+RC HashIndex::open(Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
+{
+  if (inited_) {
+    LOG_WARN("Failed to open index due to the index has been initedd before. file_name:%s, index:%s",
+        file_name, index_meta.name());
+    return RC::RECORD_OPENNED;
+  }
+
+  Index::init(index_meta, field_metas);
+
+  log_handler_ = &table->db()->log_handler();
+  RC rc        = table->db()->buffer_pool_manager().open_file(*log_handler_, file_name, disk_buffer_pool_);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("Failed to open file. file name=%s, rc=%s", file_name, strrc(rc));
+    return rc;
+  }
+
+  rc = load_directory();
+  if (OB_FAIL(rc)) {
+    LOG_WARN("Failed to load directory of hash index. file name=%s, rc=%s", file_name, strrc(rc));
+    return rc;
+  }
+
+  int key_length = 0;
+  for (const FieldMeta &field_meta : field_metas) {
+    key_length += field_meta.len();
+  }
+  if (header_.attr_num != static_cast<int>(field_metas.size()) || header_.key_length != key_length) {
+    LOG_ERROR("fields of hash index file mismatch with meta. file_name:%s, attr num in file:%d, key length in file:%d",
+              file_name, header_.attr_num, header_.key_length);
+    return RC::INTERNAL;
+  }
+
+  inited_ = true;
+  table_  = table;
+  LOG_INFO("Successfully open hash index. file_name:%s, index:%s, global depth=%d",
+           file_name, index_meta.name(), header_.global_depth);
+  return RC::SUCCESS;
+}
+
+RC HashIndex::close()
+{
+  if (disk_buffer_pool_ != nullptr) {
+    disk_buffer_pool_->close_file();
+    disk_buffer_pool_ = nullptr;
+  }
+  inited_ = false;
+  return RC::SUCCESS;
+}
+
+RC HashIndex::load_directory()
+{
+  Frame *frame = nullptr;
+  RC     rc    = disk_buffer_pool_->get_this_page(HASH_INDEX_HEADER_PAGE, &frame);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to get header page of hash index. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  frame->read_latch();
+  memcpy(&header_, frame->data(), sizeof(header_));
+  frame->read_unlatch();
+  disk_buffer_pool_->unpin_page(frame);
+
+  if (header_.global_depth < 0 || header_.global_depth > HASH_INDEX_MAX_GLOBAL_DEPTH ||
+      header_.dir_page_num * HASH_INDEX_DIR_ENTRIES_PER_PAGE < (1 << header_.global_depth)) {
+    LOG_ERROR("invalid header of hash index. global depth=%d, dir page num=%d", header_.global_depth, header_.dir_page_num);
+    return RC::INTERNAL;
+  }
+
+  const int size = 1 << header_.global_depth;
+  directory_.resize(size);
+  for (int i = 0; i < size; i += HASH_INDEX_DIR_ENTRIES_PER_PAGE) {
+    rc = disk_buffer_pool_->get_this_page(header_.dir_pages[i / HASH_INDEX_DIR_ENTRIES_PER_PAGE], &frame);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to get directory page of hash index. rc=%s", strrc(rc));
+      return rc;
+    }
+
+    frame->read_latch();
+    memcpy(directory_.data() + i, frame->data(), min(size - i, HASH_INDEX_DIR_ENTRIES_PER_PAGE) * sizeof(PageNum));
+    frame->read_unlatch();
+    disk_buffer_pool_->unpin_page(frame);
+  }
+  return RC::SUCCESS;
+}
+
+void HashIndex::normalize_key(char *key) const
+{
+  int offset = 0;
+  for (const FieldMeta &field_meta : field_metas_) {
+    char *value = key + offset;
+    if (field_meta.type() == AttrType::CHARS) {
+      const size_t len = strnlen(value, field_meta.len());
+      memset(value + len, 0, field_meta.len() - len);
+    } else if (field_meta.type() == AttrType::FLOATS) {
+      float float_value = 0;
+      memcpy(&float_value, value, sizeof(float_value));
+      if (float_value == 0) {
+        memset(value, 0, sizeof(float_value));
+      }
+    }
+    offset += field_meta.len();
+  }
+}
+
+void HashIndex::make_key(const char *record, char *key) const
+{
+  int offset = 0;
+  for (const FieldMeta &field_meta : field_metas_) {
+    memcpy(key + offset, record + field_meta.offset(), field_meta.len());
+    offset += field_meta.len();
+  }
+  normalize_key(key);
+}
+
+RC HashIndex::make_search_key(const char *key, int key_len, vector<char> &search_key) const
+{
+  // 只有一个字段的索引，查询条件中的字符串没有补齐到字段的长度
+  const bool single_chars = field_metas_.size() == 1 && field_metas_[0].type() == AttrType::CHARS;
+  if (key == nullptr || (key_len != header_.key_length && !single_chars)) {
+    LOG_WARN("hash index only supports lookup with full key. index=%s, key len=%d, key length=%d",
+             index_meta_.name(), key_len, header_.key_length);
+    return RC::INVALID_ARGUMENT;
+  }
+  if (key_len > header_.key_length) {
+    return RC::RECORD_EOF;
+  }
+
+  search_key.assign(header_.key_length, 0);
+  memcpy(search_key.data(), key, key_len);
+  normalize_key(search_key.data());
+  return RC::SUCCESS;
+}
+
+RC HashIndex::get_entries(const char *key, vector<RID> &rids)
+{
+  const uint64_t hash = hash_key(key, header_.key_length);
+
+  shared_lock guard(lock_);
+
+  PageNum page_num = directory_[dir_index(hash)];
+  while (page_num != BP_INVALID_PAGE_NUM) {
+    Frame *frame = nullptr;
+    RC     rc    = disk_buffer_pool_->get_this_page(page_num, &frame);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to get bucket page of hash index. page_num=%d, rc=%s", page_num, strrc(rc));
+      return rc;
+    }
+
+    frame->read_latch();
+    const HashBucketPageHeader *page_header = bucket_header(frame);
+    const char                 *items       = bucket_items(frame);
+    for (int i = 0; i < page_header->entry_num; i++) {
+      const char *item = items + i * entry_size();
+      if (0 == memcmp(item, key, header_.key_length)) {
+        rids.push_back(*reinterpret_cast<const RID *>(item + header_.key_length));
+      }
+    }
+    page_num = page_header->next_page;
+    frame->read_unlatch();
+    disk_buffer_pool_->unpin_page(frame);
+  }
+  return RC::SUCCESS;
+}
+
+RC HashIndex::insert_entry(const char *record, const RID *rid)
+{
+  vector<char> entry(entry_size());
+  make_key(record, entry.data());
+  memcpy(entry.data() + header_.key_length, rid, sizeof(RID));
+  const uint64_t hash = hash_key(entry.data(), header_.key_length);
+
+  return execute([this, &entry, hash](HashIndexMiniTransaction &mtr) {
+    return insert_entry_internal(mtr, entry.data(), hash);
+  });
+}
+
+RC HashIndex::delete_entry(const char *record, const RID *rid)
+{
+  vector<char> entry(entry_size());
+  make_key(record, entry.data());
+  memcpy(entry.data() + header_.key_length, rid, sizeof(RID));
+  const uint64_t hash = hash_key(entry.data(), header_.key_length);
+
+  return execute([this, &entry, hash](HashIndexMiniTransaction &mtr) {
+    return delete_entry_internal(mtr, entry.data(), hash);
+  });
+}
+
+RC HashIndex::execute(const function<RC(HashIndexMiniTransaction &)> &operation)
+{
+  lock_guard guard(lock_);
+
+  RC rc = RC::SUCCESS;
+  {
+    HashIndexMiniTransaction mtr(*disk_buffer_pool_, *log_handler_);
+
+    rc = operation(mtr);
+    if (OB_SUCC(rc)) {
+      rc = mtr.commit();
+    }
+    if (OB_FAIL(rc)) {
+      mtr.rollback();
+    }
+  }
+
+  // 页面已经恢复了，内存中的目录可能在中途修改过，需要重新读取。事务结束后页面才解锁
+  if (OB_FAIL(rc)) {
+    RC rc2 = load_directory();
+    if (OB_FAIL(rc2)) {
+      LOG_ERROR("failed to reload directory of hash index after rollback. index=%s, rc=%s",
+                index_meta_.name(), strrc(rc2));
+    }
+  }
+  return rc;
+}
+
+RC HashIndex::insert_entry_internal(HashIndexMiniTransaction &mtr, const char *entry, uint64_t hash)
+{
+  RC rc = RC::SUCCESS;
+  while (true) {
+    Frame *bucket_frame = nullptr;
+    rc = mtr.get_page(directory_[dir_index(hash)], bucket_frame);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+
+    // 找一个有空位的页面
+    Frame *frame = bucket_frame;
+    while (true) {
+      HashBucketPageHeader *page_header = bucket_header(frame);
+      if (page_header->entry_num < header_.bucket_capacity) {
+        return mtr.logger().bucket_insert(frame, page_header->entry_num, span<const char>(entry, entry_size()), 1);
+      }
+      if (page_header->next_page == BP_INVALID_PAGE_NUM) {
+        break;
+      }
+      rc = mtr.get_page(page_header->next_page, frame);
+      if (OB_FAIL(rc)) {
+        return rc;
+      }
+    }
+
+    // 桶的所有页面都满了，能分裂就分裂，否则增加一个溢出页面
+    bool splittable = false;
+    if (bucket_header(bucket_frame)->local_depth < HASH_INDEX_MAX_GLOBAL_DEPTH) {
+      rc = can_split(mtr, bucket_frame, hash, splittable);
+      if (OB_FAIL(rc)) {
+        return rc;
+      }
+    }
+    if (!splittable) {
+      return append_items(mtr, frame, entry, 1);
+    }
+
+    rc = split_bucket(mtr, hash);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to split bucket of hash index. index=%s, rc=%s", index_meta_.name(), strrc(rc));
+      return rc;
+    }
+  }
+  return rc;
+}
+
+RC HashIndex::delete_entry_internal(HashIndexMiniTransaction &mtr, const char *entry, uint64_t hash)
+{
+  PageNum page_num = directory_[dir_index(hash)];
+  while (page_num != BP_INVALID_PAGE_NUM) {
+    Frame *frame = nullptr;
+    RC     rc    = mtr.get_page(page_num, frame);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+
+    const HashBucketPageHeader *page_header = bucket_header(frame);
+    const char                 *items       = bucket_items(frame);
+    for (int i = 0; i < page_header->entry_num; i++) {
+      if (0 == memcmp(items + i * entry_size(), entry, entry_size())) {
+        return mtr.logger().bucket_remove(frame, i, 1 /*item_num*/, entry_size());
+      }
+    }
+    page_num = page_header->next_page;
+  }
+  return RC::RECORD_NOT_EXIST;
+}
+
+RC HashIndex::append_items(HashIndexMiniTransaction &mtr, Frame *&last_frame, const char *items, int item_num)
+{
+  RC rc = RC::SUCCESS;
+  while (item_num > 0) {
+    HashBucketPageHeader *page_header = bucket_header(last_frame);
+    const int             space       = header_.bucket_capacity - page_header->entry_num;
+    if (space <= 0) {
+      Frame *new_frame = nullptr;
+      if (OB_FAIL(rc = mtr.allocate_page(new_frame)) ||
+          OB_FAIL(rc = mtr.logger().bucket_init(new_frame, page_header->local_depth)) ||
+          OB_FAIL(rc = mtr.logger().bucket_set_link(last_frame, page_header->local_depth, new_frame->page_num()))) {
+        return rc;
+      }
+      last_frame = new_frame;
+      continue;
+    }
+
+    const int num = min(space, item_num);
+    rc = mtr.logger().bucket_insert(last_frame, page_header->entry_num, span<const char>(items, num * entry_size()), num);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+    items += num * entry_size();
+    item_num -= num;
+  }
+  return rc;
+}
+
+RC HashIndex::can_split(HashIndexMiniTransaction &mtr, Frame *bucket_frame, uint64_t hash, bool &result)
+{
+  result       = false;
+  Frame *frame = bucket_frame;
+  while (true) {
+    const HashBucketPageHeader *page_header = bucket_header(frame);
+    const char                 *items       = bucket_items(frame);
+    for (int i = 0; i < page_header->entry_num; i++) {
+      if (hash_key(items + i * entry_size(), header_.key_length) != hash) {
+        result = true;
+        return RC::SUCCESS;
+      }
+    }
+    if (page_header->next_page == BP_INVALID_PAGE_NUM) {
+      return RC::SUCCESS;
+    }
+    RC rc = mtr.get_page(page_header->next_page, frame);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+  }
+}
+
+RC HashIndex::split_bucket(HashIndexMiniTransaction &mtr, uint64_t hash)
+{
+  const int slot         = dir_index(hash);
+  Frame    *bucket_frame = nullptr;
+  RC        rc           = mtr.get_page(directory_[slot], bucket_frame);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  const int local_depth = bucket_header(bucket_frame)->local_depth;
+  if (local_depth == header_.global_depth) {
+    rc = double_directory(mtr);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to double directory of hash index. index=%s, rc=%s", index_meta_.name(), strrc(rc));
+      return rc;
+    }
+  }
+
+  Frame *new_frame = nullptr;
+  if (OB_FAIL(rc = mtr.allocate_page(new_frame)) || OB_FAIL(rc = mtr.logger().bucket_init(new_frame, local_depth + 1)) ||
+      OB_FAIL(rc = mtr.logger().bucket_set_link(bucket_frame, local_depth + 1, bucket_header(bucket_frame)->next_page))) {
+    return rc;
+  }
+
+  // 哈希值第 local_depth 位是1的数据移到新桶中
+  const uint64_t split_bit = 1ULL << local_depth;
+  vector<char>   moved_items;
+  Frame         *frame = bucket_frame;
+  while (true) {
+    const HashBucketPageHeader *page_header = bucket_header(frame);
+    const char                 *items       = bucket_items(frame);
+    const int                   entry_num   = page_header->entry_num;
+
+    vector<char> kept_items;
+    for (int i = 0; i < entry_num; i++) {
+      const char *item = items + i * entry_size();
+      vector<char> &target = (hash_key(item, header_.key_length) & split_bit) ? moved_items : kept_items;
+      target.insert(target.end(), item, item + entry_size());
+    }
+
+    const int kept_num = static_cast<int>(kept_items.size()) / entry_size();
+    if (kept_num != entry_num) {
+      if (OB_FAIL(rc = mtr.logger().bucket_remove(frame, 0, entry_num, entry_size()))) {
+        return rc;
+      }
+      if (kept_num > 0 && OB_FAIL(rc = mtr.logger().bucket_insert(frame, 0, kept_items, kept_num))) {
+        return rc;
+      }
+    }
+
+    if (page_header->next_page == BP_INVALID_PAGE_NUM) {
+      break;
+    }
+    if (OB_FAIL(rc = mtr.get_page(page_header->next_page, frame))) {
+      return rc;
+    }
+  }
+
+  if (!moved_items.empty()) {
+    rc = append_items(mtr, new_frame, moved_items.data(), static_cast<int>(moved_items.size()) / entry_size());
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+  }
+
+  // 低 local_depth+1 位与新桶相同的目录项都指向新桶，它们在目录中间隔 2^(local_depth+1) 项
+  const int new_bits = static_cast<int>((slot & (split_bit - 1)) | split_bit);
+  const int step     = static_cast<int>(split_bit << 1);
+  int       last     = new_bits;
+  for (int i = new_bits; i < static_cast<int>(directory_.size()); i += step) {
+    directory_[i] = new_frame->page_num();
+    last          = i;
+  }
+  return write_directory(mtr, new_bits, last + 1);
+}
+
+RC HashIndex::double_directory(HashIndexMiniTransaction &mtr)
+{
+  if (header_.global_depth >= HASH_INDEX_MAX_GLOBAL_DEPTH) {
+    return RC::INTERNAL;
+  }
+
+  const int old_size = 1 << header_.global_depth;
+  const int new_size = old_size << 1;
+  while (header_.dir_page_num * HASH_INDEX_DIR_ENTRIES_PER_PAGE < new_size) {
+    Frame *frame = nullptr;
+    RC     rc    = mtr.allocate_page(frame);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+    header_.dir_pages[header_.dir_page_num++] = frame->page_num();
+  }
+
+  directory_.resize(new_size);
+  copy(directory_.begin(), directory_.begin() + old_size, directory_.begin() + old_size);
+  header_.global_depth++;
+
+  RC rc = write_directory(mtr, old_size, new_size);
+  if (OB_SUCC(rc)) {
+    rc = write_header(mtr);
+  }
+  return rc;
+}
+
+RC HashIndex::write_directory(HashIndexMiniTransaction &mtr, int begin, int end)
+{
+  for (int i = begin; i < end;) {
+    const int offset = i % HASH_INDEX_DIR_ENTRIES_PER_PAGE;
+    const int num    = min(end - i, HASH_INDEX_DIR_ENTRIES_PER_PAGE - offset);
+
+    Frame *frame = nullptr;
+    RC     rc    = mtr.get_page(header_.dir_pages[i / HASH_INDEX_DIR_ENTRIES_PER_PAGE], frame);
+    if (OB_SUCC(rc)) {
+      rc = mtr.logger().dir_update(frame, offset, span<const PageNum>(directory_.data() + i, num));
+    }
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+    i += num;
+  }
+  return RC::SUCCESS;
+}
+
+RC HashIndex::write_header(HashIndexMiniTransaction &mtr)
+{
+  Frame *frame = nullptr;
+  RC     rc    = mtr.get_page(HASH_INDEX_HEADER_PAGE, frame);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+  return mtr.logger().update_header(frame, header_);
+}
+
+IndexScanner *HashIndex::create_scanner(
+    const char *left_key, int left_len, bool left_inclusive, const char *right_key, int right_len, bool right_inclusive)
+{
+  if (left_key == nullptr || right_key == nullptr || !left_inclusive || !right_inclusive || left_len != right_len ||
+      0 != memcmp(left_key, right_key, left_len)) {
+    LOG_WARN("hash index only supports equality lookup. index=%s", index_meta_.name());
+    return nullptr;
+  }
+
+  HashIndexScanner *index_scanner = new HashIndexScanner(*this);
+  RC                rc            = index_scanner->open(left_key, left_len);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to open index scanner. rc=%s", strrc(rc));
+    delete index_scanner;
+    return nullptr;
+  }
+  return index_scanner;
+}
+
+RC HashIndex::sync() { return disk_buffer_pool_->flush_all_pages(); }
+
+////////////////////////////////////////////////////////////////////////////////
+HashIndexScanner::HashIndexScanner(HashIndex &index) : index_(index) {}
+
+RC HashIndexScanner::open(const char *key, int key_len)
+{
+  RC rc = index_.make_search_key(key, key_len, key_);
+  if (rc == RC::RECORD_EOF) {
+    return RC::SUCCESS;
+  }
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+  return index_.get_entries(key_.data(), rids_);
+}
+
+RC HashIndexScanner::next_entry(RID *rid)
+{
+  if (position_ >= rids_.size()) {
+    return RC::RECORD_EOF;
+  }
+  *rid = rids_[position_++];
+  return RC::SUCCESS;
+}
+
+RC HashIndexScanner::next_entry(RID *rid, const char *&key)
+{
+  key = key_.data();
+  return next_entry(rid);
+}
+
+RC HashIndexScanner::destroy()
+{
+  delete this;
+  return RC::SUCCESS;
+}
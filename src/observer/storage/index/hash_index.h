@@ -0,0 +1,174 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/lang/functional.h"
+#include "common/lang/mutex.h"
+#include "storage/buffer/page.h"
+#include "storage/index/index.h"
+
+class DiskBufferPool;
+class Frame;
+class LogHandler;
+class HashIndexMiniTransaction;
+
+/// 目录最多有 2^HASH_INDEX_MAX_GLOBAL_DEPTH 项，超过以后桶不再分裂，只增加溢出页面
+static constexpr int HASH_INDEX_MAX_GLOBAL_DEPTH = 16;
+/// 每个目录页面存放的目录项个数
+static constexpr int HASH_INDEX_DIR_ENTRIES_PER_PAGE = 1024;
+/// 目录页面的最大个数
+static constexpr int HASH_INDEX_MAX_DIR_PAGES = (1 << HASH_INDEX_MAX_GLOBAL_DEPTH) / HASH_INDEX_DIR_ENTRIES_PER_PAGE;
+
+/**
+ * @brief 哈希索引文件的头部信息
+ * @ingroup Index
+ * @details 放在索引文件的第一个页面上
+ */
+struct HashIndexFileHeader
+{
+  int32_t attr_num;         ///< 索引的字段个数
+  int32_t key_length;       ///< 键值的长度，是所有字段长度的和
+  int32_t bucket_capacity;  ///< 每个桶页面最多存放的数据条数
+  int32_t global_depth;     ///< 目录的全局深度，目录有 2^global_depth 项
+  int32_t dir_page_num;     ///< 已经分配的目录页面个数
+  PageNum dir_pages[HASH_INDEX_MAX_DIR_PAGES];  ///< 目录页面，第i个页面存放第 i*HASH_INDEX_DIR_ENTRIES_PER_PAGE 项开始的目录项
+};
+
+/**
+ * @brief 哈希桶的页面头
+ * @ingroup Index
+ * @details 后面紧跟着 entry_num 条数据，每条数据是键值和RID，数据之间没有顺序。
+ * 桶满了以后通过 next_page 连接溢出页面，溢出页面的 local_depth 没有意义
+ */
+struct HashBucketPageHeader
+{
+  int32_t local_depth;  ///< 桶的局部深度，哈希值的低 local_depth 位相同的数据放在这个桶中
+  int32_t entry_num;    ///< 页面上的数据条数
+  PageNum next_page;    ///< 下一个溢出页面
+};
+
+/**
+ * @brief 哈希索引
+ * @ingroup Index
+ * @details 使用可扩展哈希(extendible hashing)实现，只支持等值查找。
+ * 键值的哈希值的低 global_depth 位是目录的下标，目录项是桶的第一个页面。一个桶满了以后分裂成两个，
+ * 局部深度加1，必要时目录扩大一倍。相同键值很多时分裂没有用，这时给桶增加溢出页面。删除数据时不合并桶。
+ *
+ * 查找时只需要访问一个桶页面(没有溢出页面时)，比B+树从根节点逐层查找、逐个比较键值要快。
+ * 目录在内存中有一份完整的拷贝，打开索引时从目录页面读取。
+ *
+ * 所有的页面修改都记录物理日志(参考 HashIndexLogger)，一次插入或删除中的所有修改在同一条日志中，
+ * 中途失败时回滚这些修改。查找时加读锁，插入删除时加写锁。
+ */
+class HashIndex : public Index
+{
+public:
+  HashIndex() = default;
+  virtual ~HashIndex() noexcept;
+
+  RC create(Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas) override;
+  RC open(Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas) override;
+  RC close();
+
+  RC insert_entry(const char *record, const RID *rid) override;
+  RC delete_entry(const char *record, const RID *rid) override;
+
+  /**
+   * @brief 查找键值等于 key 的数据
+   * @details 只支持等值查找，left_key 和 right_key 必须相同并且都包含边界，否则返回空指针
+   */
+  IndexScanner *create_scanner(const char *left_key, int left_len, bool left_inclusive, const char *right_key,
+      int right_len, bool right_inclusive) override;
+
+  RC sync() override;
+
+  /**
+   * @brief 把查询条件中的键值转换成索引中存放的键值
+   * @param key 键值。只有一个字符串字段时可以比字段短，其它情况下必须是完整的键值
+   * @return 字符串比字段还长时不会有匹配的数据，返回 RECORD_EOF
+   */
+  RC make_search_key(const char *key, int key_len, vector<char> &search_key) const;
+
+  /// 查找键值等于 key 的所有数据，key 是 make_search_key 返回的键值
+  RC get_entries(const char *key, vector<RID> &rids);
+
+  int global_depth() const { return header_.global_depth; }
+  int key_length() const { return header_.key_length; }
+
+private:
+  int entry_size() const { return header_.key_length + static_cast<int>(sizeof(RID)); }
+  int dir_index(uint64_t hash) const { return static_cast<int>(hash & ((1ULL << header_.global_depth) - 1)); }
+
+  /**
+   * @brief 从记录中取出键值
+   * @details 字符串在结束符后面的内容是不确定的，统一填充为0，-0.0 也转换成 0.0，这样相等的值总有相同的哈希值
+   */
+  void make_key(const char *record, char *key) const;
+  void normalize_key(char *key) const;
+
+  /// 从文件头和目录页面读取内存中的目录
+  RC load_directory();
+
+  /// 加写锁，在一个事务中执行修改，失败时回滚
+  RC execute(const function<RC(HashIndexMiniTransaction &)> &operation);
+
+  RC insert_entry_internal(HashIndexMiniTransaction &mtr, const char *entry, uint64_t hash);
+  RC delete_entry_internal(HashIndexMiniTransaction &mtr, const char *entry, uint64_t hash);
+
+  /// 把数据追加到 last_frame 开始的桶页面中，页面满了就分配新的溢出页面。last_frame 返回最后一个页面
+  RC append_items(HashIndexMiniTransaction &mtr, Frame *&last_frame, const char *items, int item_num);
+
+  /// 桶中是否有与 hash 不同的哈希值，都相同时分裂也没有用
+  RC can_split(HashIndexMiniTransaction &mtr, Frame *bucket_frame, uint64_t hash, bool &result);
+
+  /// 分裂 hash 所在的桶
+  RC split_bucket(HashIndexMiniTransaction &mtr, uint64_t hash);
+  RC double_directory(HashIndexMiniTransaction &mtr);
+
+  /// 把内存中 [begin, end) 的目录项写到目录页面上
+  RC write_directory(HashIndexMiniTransaction &mtr, int begin, int end);
+  RC write_header(HashIndexMiniTransaction &mtr);
+
+private:
+  bool            inited_           = false;
+  Table          *table_            = nullptr;
+  DiskBufferPool *disk_buffer_pool_ = nullptr;
+  LogHandler     *log_handler_      = nullptr;
+
+  HashIndexFileHeader header_;
+  vector<PageNum>     directory_;  ///< 目录，第i项是哈希值低 global_depth 位为i的桶的第一个页面
+
+  common::SharedMutex lock_;
+};
+
+/**
+ * @brief 哈希索引扫描器
+ * @ingroup Index
+ * @details 打开时就找到所有匹配的数据，不需要在扫描过程中持有锁
+ */
+class HashIndexScanner : public IndexScanner
+{
+public:
+  HashIndexScanner(HashIndex &index);
+  ~HashIndexScanner() noexcept override = default;
+
+  RC next_entry(RID *rid) override;
+  RC next_entry(RID *rid, const char *&key) override;
+  RC destroy() override;
+
+  RC open(const char *key, int key_len);
+
+private:
+  HashIndex   &index_;
+  vector<char> key_;
+  vector<RID>  rids_;
+  size_t       position_ = 0;
+};
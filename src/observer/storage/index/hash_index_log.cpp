@@ -0,0 +1,218 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/index/hash_index_log.h"
+#include "common/lang/serializer.h"
+#include "common/log/log.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "storage/buffer/frame.h"
+#include "storage/clog/log_entry.h"
+#include "storage/clog/log_handler.h"
+#include "storage/index/hash_index_log_entry.h"
+
+using namespace common;
+using namespace hash_index;
+
+///////////////////////////////////////////////////////////////////////////////
+// class HashIndexLogger
+HashIndexLogger::HashIndexLogger(LogHandler &log_handler, int32_t buffer_pool_id)
+    : log_handler_(log_handler), buffer_pool_id_(buffer_pool_id)
+{}
+
+HashIndexLogger::~HashIndexLogger() {}
+
+RC HashIndexLogger::update_header(Frame *frame, const HashIndexFileHeader &header)
+{
+  const auto *old_header = reinterpret_cast<const HashIndexFileHeader *>(frame->data());
+  return apply(make_unique<UpdateHeaderLogEntryHandler>(frame, header, *old_header));
+}
+
+RC HashIndexLogger::dir_update(Frame *frame, int index, span<const PageNum> pages)
+{
+  const auto *old_pages = reinterpret_cast<const PageNum *>(frame->data()) + index;
+  return apply(make_unique<DirUpdateLogEntryHandler>(frame, index, pages, span<const PageNum>(old_pages, pages.size())));
+}
+
+RC HashIndexLogger::bucket_init(Frame *frame, int local_depth)
+{
+  return apply(make_unique<BucketInitLogEntryHandler>(frame, local_depth));
+}
+
+RC HashIndexLogger::bucket_set_link(Frame *frame, int local_depth, PageNum next_page)
+{
+  const auto *header = reinterpret_cast<const HashBucketPageHeader *>(frame->data());
+  return apply(
+      make_unique<BucketSetLinkLogEntryHandler>(frame, local_depth, next_page, header->local_depth, header->next_page));
+}
+
+RC HashIndexLogger::bucket_insert(Frame *frame, int index, span<const char> items, int item_num)
+{
+  return apply(make_unique<BucketItemsLogEntryHandler>(frame, LogOperation::Type::BUCKET_INSERT, index, items, item_num));
+}
+
+RC HashIndexLogger::bucket_remove(Frame *frame, int index, int item_num, int item_size)
+{
+  const char *items = frame->data() + sizeof(HashBucketPageHeader) + index * item_size;
+  return apply(make_unique<BucketItemsLogEntryHandler>(
+      frame, LogOperation::Type::BUCKET_REMOVE, index, span<const char>(items, item_num * item_size), item_num));
+}
+
+RC HashIndexLogger::apply(unique_ptr<LogEntryHandler> entry)
+{
+  RC rc = entry->redo();
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to apply hash index log entry. entry=%s, rc=%s", entry->to_string().c_str(), strrc(rc));
+    return rc;
+  }
+
+  entries_.push_back(std::move(entry));
+  return RC::SUCCESS;
+}
+
+RC HashIndexLogger::commit()
+{
+  if (entries_.empty()) {
+    return RC::SUCCESS;
+  }
+
+  Serializer buffer;
+  buffer.write_int32(buffer_pool_id_);
+  for (auto &entry : entries_) {
+    RC rc = entry->serialize(buffer);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to serialize log entry. entry=%s, rc=%s", entry->to_string().c_str(), strrc(rc));
+      return rc;
+    }
+  }
+
+  LSN lsn = 0;
+  RC  rc  = log_handler_.append(lsn, LogModule::Id::HASH_INDEX, std::move(buffer.data()));
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to append log entry. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  for (auto &entry : entries_) {
+    entry->frame()->set_lsn(lsn);
+  }
+
+  entries_.clear();
+  return RC::SUCCESS;
+}
+
+RC HashIndexLogger::rollback()
+{
+  for (auto iter = entries_.rbegin(), itend = entries_.rend(); iter != itend; ++iter) {
+    RC rc = (*iter)->rollback();
+    if (OB_FAIL(rc)) {
+      LOG_ERROR("failed to rollback hash index log entry. entry=%s, rc=%s", (*iter)->to_string().c_str(), strrc(rc));
+    }
+  }
+
+  entries_.clear();
+  return RC::SUCCESS;
+}
+
+RC HashIndexLogger::redo(BufferPoolManager &bpm, const LogEntry &entry)
+{
+  ASSERT(entry.module().id() == LogModule::Id::HASH_INDEX, "invalid log entry: %s", entry.to_string().c_str());
+
+  Deserializer buffer(entry.data(), entry.payload_size());
+  int32_t      buffer_pool_id = -1;
+  if (buffer.read_int32(buffer_pool_id) != 0) {
+    LOG_ERROR("failed to read buffer pool id.");
+    return RC::IOERR_READ;
+  }
+
+  DiskBufferPool *buffer_pool = nullptr;
+  RC              rc          = bpm.get_buffer_pool(buffer_pool_id, buffer_pool);
+  if (OB_FAIL(rc) || buffer_pool == nullptr) {
+    LOG_WARN("failed to get buffer pool. rc=%s, buffer_pool_id=%d", strrc(rc), buffer_pool_id);
+    return rc;
+  }
+
+  // 页面的LSN不小于日志的LSN时，说明修改已经写到磁盘上了，不需要重做。
+  // 一条日志可能多次修改同一个页面，所以所有修改都重做完以后才设置页面的LSN
+  vector<Frame *> frames;
+  while (buffer.remain() > 0) {
+    unique_ptr<LogEntryHandler> handler;
+
+    rc = LogEntryHandler::from_buffer(*buffer_pool, buffer, handler);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to deserialize log entry. rc=%s", strrc(rc));
+      break;
+    }
+
+    Frame *frame = handler->frame();
+    frames.push_back(frame);
+    if (frame->lsn() >= entry.lsn()) {
+      continue;
+    }
+
+    rc = handler->redo();
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to redo log entry. rc=%s, lsn=%" LSN_FORMAT ", entry=%s",
+               strrc(rc), entry.lsn(), handler->to_string().c_str());
+      break;
+    }
+  }
+
+  for (Frame *frame : frames) {
+    if (OB_SUCC(rc) && frame->lsn() < entry.lsn()) {
+      frame->set_lsn(entry.lsn());
+    }
+    frame->unpin();
+  }
+  return rc;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// class HashIndexMiniTransaction
+HashIndexMiniTransaction::HashIndexMiniTransaction(DiskBufferPool &buffer_pool, LogHandler &log_handler)
+    : latch_memo_(&buffer_pool), logger_(log_handler, buffer_pool.id())
+{}
+
+RC HashIndexMiniTransaction::get_page(PageNum page_num, Frame *&frame)
+{
+  auto iter = frames_.find(page_num);
+  if (iter != frames_.end()) {
+    frame = iter->second;
+    return RC::SUCCESS;
+  }
+
+  RC rc = latch_memo_.get_page(page_num, frame);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to get page. page_num=%d, rc=%s", page_num, strrc(rc));
+    return rc;
+  }
+
+  latch_memo_.xlatch(frame);
+  frames_.emplace(page_num, frame);
+  return RC::SUCCESS;
+}
+
+RC HashIndexMiniTransaction::allocate_page(Frame *&frame)
+{
+  RC rc = latch_memo_.allocate_page(frame);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to allocate page. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  latch_memo_.xlatch(frame);
+  frames_.emplace(frame->page_num(), frame);
+  return RC::SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// class HashIndexLogReplayer
+HashIndexLogReplayer::HashIndexLogReplayer(BufferPoolManager &bpm) : buffer_pool_manager_(bpm) {}
+
+RC HashIndexLogReplayer::replay(const LogEntry &entry) { return HashIndexLogger::redo(buffer_pool_manager_, entry); }
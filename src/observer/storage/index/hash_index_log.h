@@ -0,0 +1,128 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/types.h"
+#include "common/sys/rc.h"
+#include "common/lang/memory.h"
+#include "common/lang/span.h"
+#include "common/lang/unordered_map.h"
+#include "common/lang/vector.h"
+#include "storage/clog/log_replayer.h"
+#include "storage/index/latch_memo.h"
+
+struct HashIndexFileHeader;
+class LogEntry;
+class LogHandler;
+class Frame;
+class DiskBufferPool;
+class BufferPoolManager;
+
+namespace hash_index {
+class LogEntryHandler;
+}
+
+/**
+ * @brief 哈希索引日志记录辅助类，同时可以利用此类做回滚操作
+ * @ingroup CLog
+ * @details 哈希索引的页面都通过这个类修改：每个修改先生成一个日志处理对象，在页面上执行修改后暂存在内存中，
+ * 操作完成后调用 commit 把所有的修改作为一条日志写到日志文件中，失败时调用 rollback 逆序撤销这些修改。
+ * 回滚只恢复页面的内容，操作中分配的页面不会释放。
+ */
+class HashIndexLogger final
+{
+public:
+  HashIndexLogger(LogHandler &log_handler, int32_t buffer_pool_id);
+  ~HashIndexLogger();
+
+  /// 把文件头修改为 header
+  RC update_header(Frame *frame, const HashIndexFileHeader &header);
+
+  /// 把目录页面上从 index 开始的目录项修改为 pages
+  RC dir_update(Frame *frame, int index, span<const PageNum> pages);
+
+  /// 初始化新分配的桶页面
+  RC bucket_init(Frame *frame, int local_depth);
+
+  /// 修改桶的局部深度和溢出页面
+  RC bucket_set_link(Frame *frame, int local_depth, PageNum next_page);
+
+  /// 在桶页面的 index 位置插入数据
+  RC bucket_insert(Frame *frame, int index, span<const char> items, int item_num);
+
+  /// 删除桶页面从 index 开始的 item_num 条数据
+  RC bucket_remove(Frame *frame, int index, int item_num, int item_size);
+
+  /// 把所有修改作为一条日志写到日志文件中，并设置修改过的页面的LSN
+  RC commit();
+
+  /// 逆序撤销所有的修改
+  RC rollback();
+
+  /// 重做一条日志
+  static RC redo(BufferPoolManager &bpm, const LogEntry &entry);
+
+private:
+  /// 执行修改并暂存日志
+  RC apply(unique_ptr<hash_index::LogEntryHandler> entry);
+
+private:
+  LogHandler &log_handler_;
+  int32_t     buffer_pool_id_ = -1;
+
+  vector<unique_ptr<hash_index::LogEntryHandler>> entries_;
+};
+
+/**
+ * @brief 哈希索引使用的事务辅助类
+ * @ingroup Index
+ * @details 一次插入可能会分裂桶、扩大目录，修改很多个页面，这些修改要么一起成功，要么一起回滚。
+ * 修改的页面加写锁，直到事务结束才释放，这样刷盘时不会看到修改了一半的页面。
+ */
+class HashIndexMiniTransaction final
+{
+public:
+  HashIndexMiniTransaction(DiskBufferPool &buffer_pool, LogHandler &log_handler);
+  ~HashIndexMiniTransaction() = default;
+
+  /// 获取页面并加写锁，同一个页面只加一次锁
+  RC get_page(PageNum page_num, Frame *&frame);
+
+  /// 分配新页面并加写锁
+  RC allocate_page(Frame *&frame);
+
+  HashIndexLogger &logger() { return logger_; }
+
+  RC commit() { return logger_.commit(); }
+  RC rollback() { return logger_.rollback(); }
+
+private:
+  LatchMemo                        latch_memo_;
+  HashIndexLogger                  logger_;
+  unordered_map<PageNum, Frame *>  frames_;
+};
+
+/**
+ * @brief 哈希索引日志重做器
+ * @ingroup CLog
+ */
+class HashIndexLogReplayer final : public LogReplayer
+{
+public:
+  HashIndexLogReplayer(BufferPoolManager &bpm);
+  virtual ~HashIndexLogReplayer() = default;
+
+  /// @copydoc LogReplayer::replay
+  virtual RC replay(const LogEntry &entry) override;
+
+private:
+  BufferPoolManager &buffer_pool_manager_;
+};
@@ -0,0 +1,449 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/index/hash_index_log_entry.h"
+#include "common/lang/serializer.h"
+#include "common/lang/sstream.h"
+#include "common/log/log.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "storage/buffer/frame.h"
+
+using namespace common;
+
+namespace hash_index {
+
+static HashBucketPageHeader *bucket_header(Frame *frame)
+{
+  return reinterpret_cast<HashBucketPageHeader *>(frame->data());
+}
+
+static char *bucket_items(Frame *frame) { return frame->data() + sizeof(HashBucketPageHeader); }
+
+string LogOperation::to_string() const
+{
+  stringstream ss;
+  ss << std::to_string(index()) << ":";
+  switch (type_) {
+    case Type::UPDATE_HEADER: ss << "UPDATE_HEADER"; break;
+    case Type::DIR_UPDATE: ss << "DIR_UPDATE"; break;
+    case Type::BUCKET_INIT: ss << "BUCKET_INIT"; break;
+    case Type::BUCKET_SET_LINK: ss << "BUCKET_SET_LINK"; break;
+    case Type::BUCKET_INSERT: ss << "BUCKET_INSERT"; break;
+    case Type::BUCKET_REMOVE: ss << "BUCKET_REMOVE"; break;
+    default: ss << "INVALID"; break;
+  }
+  return ss.str();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// LogEntryHandler
+LogEntryHandler::LogEntryHandler(LogOperation operation, Frame *frame) : operation_type_(operation), frame_(frame)
+{
+  if (frame_ != nullptr) {
+    set_page_num(frame->page_num());
+  }
+}
+
+PageNum LogEntryHandler::page_num() const
+{
+  if (frame_ != nullptr) {
+    return frame_->page_num();
+  }
+  return page_num_;
+}
+
+RC LogEntryHandler::serialize(Serializer &buffer) const
+{
+  RC rc = serialize_header(buffer);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+  return serialize_body(buffer);
+}
+
+RC LogEntryHandler::serialize_header(Serializer &buffer) const
+{
+  if (buffer.write_int32(operation_type().index()) < 0 || buffer.write_int32(page_num()) < 0) {
+    return RC::INTERNAL;
+  }
+  return RC::SUCCESS;
+}
+
+string LogEntryHandler::to_string() const
+{
+  stringstream ss;
+  ss << "operation=" << operation_type().to_string() << ", page_num=" << page_num();
+  return ss.str();
+}
+
+RC LogEntryHandler::from_buffer(DiskBufferPool &buffer_pool, Deserializer &buffer, unique_ptr<LogEntryHandler> &handler)
+{
+  auto frame_getter = [&buffer_pool](PageNum page_num, Frame *&frame) -> RC {
+    return buffer_pool.get_this_page(page_num, &frame);
+  };
+  return from_buffer(frame_getter, buffer, handler);
+}
+
+RC LogEntryHandler::from_buffer(
+    function<RC(PageNum, Frame *&)> frame_getter, Deserializer &buffer, unique_ptr<LogEntryHandler> &handler)
+{
+  int32_t type     = -1;
+  PageNum page_num = -1;
+  if (buffer.read_int32(type) != 0 || buffer.read_int32(page_num) != 0) {
+    return RC::INVALID_ARGUMENT;
+  }
+
+  if (type < 0 || type >= static_cast<int32_t>(LogOperation::Type::MAX_TYPE)) {
+    return RC::INVALID_ARGUMENT;
+  }
+
+  Frame *frame = nullptr;
+  RC     rc    = frame_getter(page_num, frame);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to get frame. page_num=%d, rc=%s", page_num, strrc(rc));
+    return rc;
+  }
+
+  LogOperation operation(type);
+  switch (operation.type()) {
+    case LogOperation::Type::UPDATE_HEADER: {
+      rc = UpdateHeaderLogEntryHandler::deserialize(frame, buffer, handler);
+    } break;
+    case LogOperation::Type::DIR_UPDATE: {
+      rc = DirUpdateLogEntryHandler::deserialize(frame, buffer, handler);
+    } break;
+    case LogOperation::Type::BUCKET_INIT: {
+      rc = BucketInitLogEntryHandler::deserialize(frame, buffer, handler);
+    } break;
+    case LogOperation::Type::BUCKET_SET_LINK: {
+      rc = BucketSetLinkLogEntryHandler::deserialize(frame, buffer, handler);
+    } break;
+    case LogOperation::Type::BUCKET_INSERT:
+    case LogOperation::Type::BUCKET_REMOVE: {
+      rc = BucketItemsLogEntryHandler::deserialize(frame, operation, buffer, handler);
+    } break;
+    default: {
+      LOG_ERROR("unknown log operation. operation=%s", operation.to_string().c_str());
+      rc = RC::INTERNAL;
+    } break;
+  }
+
+  if (OB_FAIL(rc) && frame != nullptr) {
+    frame->unpin();
+    return rc;
+  }
+
+  if (handler) {
+    handler->set_page_num(page_num);
+  }
+  return rc;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// UpdateHeaderLogEntryHandler
+UpdateHeaderLogEntryHandler::UpdateHeaderLogEntryHandler(
+    Frame *frame, const HashIndexFileHeader &header, const HashIndexFileHeader &old_header)
+    : LogEntryHandler(LogOperation::Type::UPDATE_HEADER, frame), header_(header), old_header_(old_header)
+{}
+
+RC UpdateHeaderLogEntryHandler::serialize_body(Serializer &buffer) const
+{
+  if (buffer.write(reinterpret_cast<const char *>(&header_), sizeof(header_)) < 0 ||
+      buffer.write(reinterpret_cast<const char *>(&old_header_), sizeof(old_header_)) < 0) {
+    return RC::INTERNAL;
+  }
+  return RC::SUCCESS;
+}
+
+RC UpdateHeaderLogEntryHandler::deserialize(Frame *frame, Deserializer &buffer, unique_ptr<LogEntryHandler> &handler)
+{
+  HashIndexFileHeader header;
+  HashIndexFileHeader old_header;
+  if (buffer.read(reinterpret_cast<char *>(&header), sizeof(header)) < 0 ||
+      buffer.read(reinterpret_cast<char *>(&old_header), sizeof(old_header)) < 0) {
+    return RC::INTERNAL;
+  }
+  handler = make_unique<UpdateHeaderLogEntryHandler>(frame, header, old_header);
+  return RC::SUCCESS;
+}
+
+RC UpdateHeaderLogEntryHandler::rollback()
+{
+  memcpy(frame()->data(), &old_header_, sizeof(old_header_));
+  frame()->mark_dirty();
+  return RC::SUCCESS;
+}
+
+RC UpdateHeaderLogEntryHandler::redo()
+{
+  memcpy(frame()->data(), &header_, sizeof(header_));
+  frame()->mark_dirty();
+  return RC::SUCCESS;
+}
+
+string UpdateHeaderLogEntryHandler::to_string() const
+{
+  stringstream ss;
+  ss << LogEntryHandler::to_string() << ", global_depth=" << header_.global_depth
+     << ", dir_page_num=" << header_.dir_page_num;
+  return ss.str();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// DirUpdateLogEntryHandler
+DirUpdateLogEntryHandler::DirUpdateLogEntryHandler(
+    Frame *frame, int index, span<const PageNum> pages, span<const PageNum> old_pages)
+    : LogEntryHandler(LogOperation::Type::DIR_UPDATE, frame),
+      index_(index),
+      pages_(pages.begin(), pages.end()),
+      old_pages_(old_pages.begin(), old_pages.end())
+{}
+
+RC DirUpdateLogEntryHandler::serialize_body(Serializer &buffer) const
+{
+  const int bytes = static_cast<int>(pages_.size() * sizeof(PageNum));
+  if (buffer.write_int32(index_) < 0 || buffer.write_int32(static_cast<int32_t>(pages_.size())) < 0 ||
+      buffer.write(reinterpret_cast<const char *>(pages_.data()), bytes) < 0 ||
+      buffer.write(reinterpret_cast<const char *>(old_pages_.data()), bytes) < 0) {
+    return RC::INTERNAL;
+  }
+  return RC::SUCCESS;
+}
+
+RC DirUpdateLogEntryHandler::deserialize(Frame *frame, Deserializer &buffer, unique_ptr<LogEntryHandler> &handler)
+{
+  int32_t index = -1;
+  int32_t num   = -1;
+  if (buffer.read_int32(index) < 0 || buffer.read_int32(num) < 0 || index < 0 || num < 0 ||
+      index + num > HASH_INDEX_DIR_ENTRIES_PER_PAGE) {
+    return RC::INTERNAL;
+  }
+
+  vector<PageNum> pages(num);
+  vector<PageNum> old_pages(num);
+  const int       bytes = static_cast<int>(num * sizeof(PageNum));
+  if (buffer.read(reinterpret_cast<char *>(pages.data()), bytes) < 0 ||
+      buffer.read(reinterpret_cast<char *>(old_pages.data()), bytes) < 0) {
+    return RC::INTERNAL;
+  }
+  handler = make_unique<DirUpdateLogEntryHandler>(frame, index, pages, old_pages);
+  return RC::SUCCESS;
+}
+
+RC DirUpdateLogEntryHandler::rollback()
+{
+  memcpy(frame()->data() + index_ * sizeof(PageNum), old_pages_.data(), old_pages_.size() * sizeof(PageNum));
+  frame()->mark_dirty();
+  return RC::SUCCESS;
+}
+
+RC DirUpdateLogEntryHandler::redo()
+{
+  memcpy(frame()->data() + index_ * sizeof(PageNum), pages_.data(), pages_.size() * sizeof(PageNum));
+  frame()->mark_dirty();
+  return RC::SUCCESS;
+}
+
+string DirUpdateLogEntryHandler::to_string() const
+{
+  stringstream ss;
+  ss << LogEntryHandler::to_string() << ", index=" << index_ << ", num=" << pages_.size();
+  return ss.str();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// BucketInitLogEntryHandler
+BucketInitLogEntryHandler::BucketInitLogEntryHandler(Frame *frame, int local_depth)
+    : LogEntryHandler(LogOperation::Type::BUCKET_INIT, frame), local_depth_(local_depth)
+{}
+
+RC BucketInitLogEntryHandler::serialize_body(Serializer &buffer) const
+{
+  return buffer.write_int32(local_depth_) < 0 ? RC::INTERNAL : RC::SUCCESS;
+}
+
+RC BucketInitLogEntryHandler::deserialize(Frame *frame, Deserializer &buffer, unique_ptr<LogEntryHandler> &handler)
+{
+  int32_t local_depth = -1;
+  if (buffer.read_int32(local_depth) < 0) {
+    return RC::INTERNAL;
+  }
+  handler = make_unique<BucketInitLogEntryHandler>(frame, local_depth);
+  return RC::SUCCESS;
+}
+
+RC BucketInitLogEntryHandler::redo()
+{
+  HashBucketPageHeader *header = bucket_header(frame());
+  header->local_depth          = local_depth_;
+  header->entry_num            = 0;
+  header->next_page            = BP_INVALID_PAGE_NUM;
+  frame()->mark_dirty();
+  return RC::SUCCESS;
+}
+
+string BucketInitLogEntryHandler::to_string() const
+{
+  stringstream ss;
+  ss << LogEntryHandler::to_string() << ", local_depth=" << local_depth_;
+  return ss.str();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// BucketSetLinkLogEntryHandler
+BucketSetLinkLogEntryHandler::BucketSetLinkLogEntryHandler(
+    Frame *frame, int local_depth, PageNum next_page, int old_local_depth, PageNum old_next_page)
+    : LogEntryHandler(LogOperation::Type::BUCKET_SET_LINK, frame),
+      local_depth_(local_depth),
+      next_page_(next_page),
+      old_local_depth_(old_local_depth),
+      old_next_page_(old_next_page)
+{}
+
+RC BucketSetLinkLogEntryHandler::serialize_body(Serializer &buffer) const
+{
+  if (buffer.write_int32(local_depth_) < 0 || buffer.write_int32(next_page_) < 0 ||
+      buffer.write_int32(old_local_depth_) < 0 || buffer.write_int32(old_next_page_) < 0) {
+    return RC::INTERNAL;
+  }
+  return RC::SUCCESS;
+}
+
+RC BucketSetLinkLogEntryHandler::deserialize(Frame *frame, Deserializer &buffer, unique_ptr<LogEntryHandler> &handler)
+{
+  int32_t local_depth     = -1;
+  PageNum next_page       = BP_INVALID_PAGE_NUM;
+  int32_t old_local_depth = -1;
+  PageNum old_next_page   = BP_INVALID_PAGE_NUM;
+  if (buffer.read_int32(local_depth) < 0 || buffer.read_int32(next_page) < 0 ||
+      buffer.read_int32(old_local_depth) < 0 || buffer.read_int32(old_next_page) < 0) {
+    return RC::INTERNAL;
+  }
+  handler = make_unique<BucketSetLinkLogEntryHandler>(frame, local_depth, next_page, old_local_depth, old_next_page);
+  return RC::SUCCESS;
+}
+
+RC BucketSetLinkLogEntryHandler::rollback()
+{
+  HashBucketPageHeader *header = bucket_header(frame());
+  header->local_depth          = old_local_depth_;
+  header->next_page            = old_next_page_;
+  frame()->mark_dirty();
+  return RC::SUCCESS;
+}
+
+RC BucketSetLinkLogEntryHandler::redo()
+{
+  HashBucketPageHeader *header = bucket_header(frame());
+  header->local_depth          = local_depth_;
+  header->next_page            = next_page_;
+  frame()->mark_dirty();
+  return RC::SUCCESS;
+}
+
+string BucketSetLinkLogEntryHandler::to_string() const
+{
+  stringstream ss;
+  ss << LogEntryHandler::to_string() << ", local_depth=" << local_depth_ << ", next_page=" << next_page_;
+  return ss.str();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// BucketItemsLogEntryHandler
+BucketItemsLogEntryHandler::BucketItemsLogEntryHandler(
+    Frame *frame, LogOperation operation, int index, span<const char> items, int item_num)
+    : LogEntryHandler(operation, frame), index_(index), item_num_(item_num), items_(items.begin(), items.end())
+{}
+
+RC BucketItemsLogEntryHandler::serialize_body(Serializer &buffer) const
+{
+  if (buffer.write_int32(index_) < 0 || buffer.write_int32(item_num_) < 0 ||
+      buffer.write_int32(static_cast<int32_t>(items_.size())) < 0 || buffer.write(items_) < 0) {
+    return RC::INTERNAL;
+  }
+  return RC::SUCCESS;
+}
+
+RC BucketItemsLogEntryHandler::deserialize(
+    Frame *frame, LogOperation operation, Deserializer &buffer, unique_ptr<LogEntryHandler> &handler)
+{
+  int32_t index      = -1;
+  int32_t item_num   = -1;
+  int32_t item_bytes = -1;
+  if (buffer.read_int32(index) < 0 || buffer.read_int32(item_num) < 0 || buffer.read_int32(item_bytes) < 0 ||
+      index < 0 || item_num <= 0 || item_bytes <= 0 || item_bytes % item_num != 0) {
+    return RC::INTERNAL;
+  }
+
+  vector<char> items(item_bytes);
+  if (buffer.read(items) < 0) {
+    return RC::INTERNAL;
+  }
+
+  handler = make_unique<BucketItemsLogEntryHandler>(frame, operation, index, items, item_num);
+  return RC::SUCCESS;
+}
+
+RC BucketItemsLogEntryHandler::insert_items()
+{
+  HashBucketPageHeader *header    = bucket_header(frame());
+  const int             item_size = static_cast<int>(items_.size()) / item_num_;
+  if (index_ > header->entry_num ||
+      sizeof(HashBucketPageHeader) + (header->entry_num + item_num_) * item_size > BP_PAGE_DATA_SIZE) {
+    LOG_WARN("invalid bucket insert. %s, entry_num=%d", to_string().c_str(), header->entry_num);
+    return RC::INTERNAL;
+  }
+
+  char *items = bucket_items(frame());
+  memmove(items + (index_ + item_num_) * item_size,
+      items + index_ * item_size,
+      (header->entry_num - index_) * item_size);
+  memcpy(items + index_ * item_size, items_.data(), items_.size());
+  header->entry_num += item_num_;
+  frame()->mark_dirty();
+  return RC::SUCCESS;
+}
+
+RC BucketItemsLogEntryHandler::remove_items()
+{
+  HashBucketPageHeader *header    = bucket_header(frame());
+  const int             item_size = static_cast<int>(items_.size()) / item_num_;
+  if (index_ + item_num_ > header->entry_num) {
+    LOG_WARN("invalid bucket remove. %s, entry_num=%d", to_string().c_str(), header->entry_num);
+    return RC::INTERNAL;
+  }
+
+  char *items = bucket_items(frame());
+  memmove(items + index_ * item_size,
+      items + (index_ + item_num_) * item_size,
+      (header->entry_num - index_ - item_num_) * item_size);
+  header->entry_num -= item_num_;
+  frame()->mark_dirty();
+  return RC::SUCCESS;
+}
+
+RC BucketItemsLogEntryHandler::rollback()
+{
+  return operation_type().type() == LogOperation::Type::BUCKET_INSERT ? remove_items() : insert_items();
+}
+
+RC BucketItemsLogEntryHandler::redo()
+{
+  return operation_type().type() == LogOperation::Type::BUCKET_INSERT ? insert_items() : remove_items();
+}
+
+string BucketItemsLogEntryHandler::to_string() const
+{
+  stringstream ss;
+  ss << LogEntryHandler::to_string() << ", index=" << index_ << ", item_num=" << item_num_;
+  return ss.str();
+}
+
+}  // namespace hash_index
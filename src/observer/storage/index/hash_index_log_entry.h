@@ -0,0 +1,239 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/types.h"
+#include "common/sys/rc.h"
+#include "common/lang/functional.h"
+#include "common/lang/memory.h"
+#include "common/lang/span.h"
+#include "common/lang/string.h"
+#include "common/lang/vector.h"
+#include "storage/index/hash_index.h"
+
+class Frame;
+class DiskBufferPool;
+
+namespace common {
+class Serializer;
+class Deserializer;
+}  // namespace common
+
+namespace hash_index {
+
+/**
+ * @brief 哈希索引日志操作类型
+ * @ingroup CLog
+ */
+class LogOperation
+{
+public:
+  enum class Type
+  {
+    UPDATE_HEADER,    /// 修改索引文件头
+    DIR_UPDATE,       /// 修改目录页面上连续的几个目录项
+    BUCKET_INIT,      /// 初始化桶页面
+    BUCKET_SET_LINK,  /// 修改桶的局部深度和溢出页面
+    BUCKET_INSERT,    /// 在桶页面中插入一些数据
+    BUCKET_REMOVE,    /// 在桶页面中删除一些数据
+
+    MAX_TYPE,
+  };
+
+public:
+  LogOperation(Type type) : type_(type) {}
+  explicit LogOperation(int type) : type_(static_cast<Type>(type)) {}
+
+  Type type() const { return type_; }
+  int  index() const { return static_cast<int>(type_); }
+
+  string to_string() const;
+
+private:
+  Type type_;
+};
+
+/**
+ * @brief 哈希索引日志处理辅助类
+ * @ingroup CLog
+ * @details 与B+树的逻辑日志不同，哈希索引的日志是物理日志，记录了页面上哪些字节修改前后的内容，
+ * 重做和回滚都不需要打开索引，只需要页面本身。每种操作类型的日志都有一个具体的实现类。
+ */
+class LogEntryHandler
+{
+public:
+  LogEntryHandler(LogOperation operation, Frame *frame = nullptr);
+  virtual ~LogEntryHandler() = default;
+
+  Frame       *frame() { return frame_; }
+  const Frame *frame() const { return frame_; }
+
+  PageNum page_num() const;
+  void    set_page_num(PageNum page_num) { page_num_ = page_num; }
+
+  /// @brief 日志操作类型
+  LogOperation operation_type() const { return operation_type_; }
+
+  /// @brief 序列化日志
+  RC serialize(common::Serializer &buffer) const;
+  /// @brief 序列化日志头
+  RC serialize_header(common::Serializer &buffer) const;
+
+  /// @brief 序列化日志内容。所有子类应该实现这个函数
+  virtual RC serialize_body(common::Serializer &buffer) const = 0;
+
+  /// @brief 把页面恢复到修改之前的样子
+  virtual RC rollback() = 0;
+
+  /// @brief 在页面上执行修改。正常执行和重启恢复都使用这个函数修改页面
+  virtual RC redo() = 0;
+
+  virtual string to_string() const;
+
+  /**
+   * @brief 从buffer中反序列化出一个LogEntryHandler
+   * @param frame_getter 获取日志对应的页面
+   */
+  static RC from_buffer(
+      function<RC(PageNum, Frame *&)> frame_getter, common::Deserializer &buffer, unique_ptr<LogEntryHandler> &handler);
+  static RC from_buffer(DiskBufferPool &buffer_pool, common::Deserializer &buffer, unique_ptr<LogEntryHandler> &handler);
+
+protected:
+  LogOperation operation_type_;
+  Frame       *frame_    = nullptr;
+  PageNum      page_num_ = BP_INVALID_PAGE_NUM;
+};
+
+/**
+ * @brief 修改索引文件头
+ * @ingroup CLog
+ */
+class UpdateHeaderLogEntryHandler : public LogEntryHandler
+{
+public:
+  UpdateHeaderLogEntryHandler(Frame *frame, const HashIndexFileHeader &header, const HashIndexFileHeader &old_header);
+  virtual ~UpdateHeaderLogEntryHandler() = default;
+
+  RC serialize_body(common::Serializer &buffer) const override;
+  RC rollback() override;
+  RC redo() override;
+
+  string to_string() const override;
+
+  static RC deserialize(Frame *frame, common::Deserializer &buffer, unique_ptr<LogEntryHandler> &handler);
+
+private:
+  HashIndexFileHeader header_;
+  HashIndexFileHeader old_header_;
+};
+
+/**
+ * @brief 修改目录页面上从 index 开始的几个目录项
+ * @ingroup CLog
+ */
+class DirUpdateLogEntryHandler : public LogEntryHandler
+{
+public:
+  DirUpdateLogEntryHandler(Frame *frame, int index, span<const PageNum> pages, span<const PageNum> old_pages);
+  virtual ~DirUpdateLogEntryHandler() = default;
+
+  RC serialize_body(common::Serializer &buffer) const override;
+  RC rollback() override;
+  RC redo() override;
+
+  string to_string() const override;
+
+  static RC deserialize(Frame *frame, common::Deserializer &buffer, unique_ptr<LogEntryHandler> &handler);
+
+private:
+  int             index_ = 0;
+  vector<PageNum> pages_;
+  vector<PageNum> old_pages_;
+};
+
+/**
+ * @brief 初始化一个新分配的桶页面。新页面上没有有效的数据，回滚时什么都不做
+ * @ingroup CLog
+ */
+class BucketInitLogEntryHandler : public LogEntryHandler
+{
+public:
+  BucketInitLogEntryHandler(Frame *frame, int local_depth);
+  virtual ~BucketInitLogEntryHandler() = default;
+
+  RC serialize_body(common::Serializer &buffer) const override;
+  RC rollback() override { return RC::SUCCESS; }
+  RC redo() override;
+
+  string to_string() const override;
+
+  static RC deserialize(Frame *frame, common::Deserializer &buffer, unique_ptr<LogEntryHandler> &handler);
+
+private:
+  int local_depth_ = 0;
+};
+
+/**
+ * @brief 修改桶的局部深度和溢出页面
+ * @ingroup CLog
+ */
+class BucketSetLinkLogEntryHandler : public LogEntryHandler
+{
+public:
+  BucketSetLinkLogEntryHandler(Frame *frame, int local_depth, PageNum next_page, int old_local_depth, PageNum old_next_page);
+  virtual ~BucketSetLinkLogEntryHandler() = default;
+
+  RC serialize_body(common::Serializer &buffer) const override;
+  RC rollback() override;
+  RC redo() override;
+
+  string to_string() const override;
+
+  static RC deserialize(Frame *frame, common::Deserializer &buffer, unique_ptr<LogEntryHandler> &handler);
+
+private:
+  int     local_depth_     = 0;
+  PageNum next_page_       = BP_INVALID_PAGE_NUM;
+  int     old_local_depth_ = 0;
+  PageNum old_next_page_   = BP_INVALID_PAGE_NUM;
+};
+
+/**
+ * @brief 在桶页面的 index 位置插入或删除 item_num 条数据
+ * @ingroup CLog
+ * @details 插入和删除互为回滚操作，日志中记录了数据的内容
+ */
+class BucketItemsLogEntryHandler : public LogEntryHandler
+{
+public:
+  BucketItemsLogEntryHandler(Frame *frame, LogOperation operation, int index, span<const char> items, int item_num);
+  virtual ~BucketItemsLogEntryHandler() = default;
+
+  RC serialize_body(common::Serializer &buffer) const override;
+  RC rollback() override;
+  RC redo() override;
+
+  string to_string() const override;
+
+  static RC deserialize(
+      Frame *frame, LogOperation operation, common::Deserializer &buffer, unique_ptr<LogEntryHandler> &handler);
+
+private:
+  RC insert_items();
+  RC remove_items();
+
+private:
+  int          index_    = 0;
+  int          item_num_ = 0;
+  vector<char> items_;
+};
+
+}  // namespace hash_index
@@ -0,0 +1,594 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/index/hnsw_index.h"
+#include "common/lang/algorithm.h"
+#include "common/lang/cmath.h"
+#include "common/lang/functional.h"
+#include "common/lang/queue.h"
+#include "common/lang/serializer.h"
+#include "common/lang/string.h"
+#include "common/log/log.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "storage/db/db.h"
+#include "storage/table/table.h"
+
+/// 索引文件的第一个页面，存放 HnswFileHeader
+static constexpr PageNum HNSW_HEADER_PAGE = 1;
+/// 第一个存放图数据的页面
+static constexpr PageNum HNSW_FIRST_DATA_PAGE = 2;
+
+HnswIndex::~HnswIndex() noexcept { close(); }
+
+RC HnswIndex::init_params(const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
+{
+  if (field_metas.size() != 1 || field_metas[0].type() != AttrType::VECTORS) {
+    LOG_WARN("hnsw index should be created on one vector field. index=%s", index_meta.name());
+    return RC::INVALID_ARGUMENT;
+  }
+
+  const FieldMeta &field_meta = field_metas[0];
+  if (field_meta.len() <= 0 || field_meta.len() % sizeof(float) != 0) {
+    LOG_WARN("invalid length of vector field. index=%s, field=%s, len=%d", index_meta.name(), field_meta.name(), field_meta.len());
+    return RC::INVALID_ARGUMENT;
+  }
+
+  const char *distance = index_meta.param("distance", "l2_distance");
+  if (vector_distance_type_from_name(distance) == VectorDistanceType::UNKNOWN) {
+    LOG_WARN("unknown distance of hnsw index. index=%s, distance=%s", index_meta.name(), distance);
+    return RC::INVALID_ARGUMENT;
+  }
+
+  if (!common::str_to_val(index_meta.param("m", "16"), m_) ||
+      !common::str_to_val(index_meta.param("ef_construction", "64"), ef_construction_) ||
+      !common::str_to_val(index_meta.param("ef_search", "40"), ef_search_) ||
+      m_ < 2 || ef_construction_ < m_ || ef_search_ <= 0) {
+    LOG_WARN("invalid params of hnsw index. index=%s, m=%s, ef_construction=%s, ef_search=%s",
+             index_meta.name(), index_meta.param("m", "16"), index_meta.param("ef_construction", "64"),
+             index_meta.param("ef_search", "40"));
+    return RC::INVALID_ARGUMENT;
+  }
+
+  level_factor_ = 1.0 / log(static_cast<double>(m_));
+  return RC::SUCCESS;
+}
+
+RC HnswIndex::create(Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
+{
+  if (inited_) {
+    LOG_WARN("Failed to create index due to the index has been created before. file_name:%s, index:%s",
+        file_name, index_meta.name());
+    return RC::RECORD_OPENNED;
+  }
+
+  RC rc = init_params(index_meta, field_metas);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+  Index::init(index_meta, field_metas);
+
+  memset(&header_, 0, sizeof(header_));
+  header_.dimension     = field_metas[0].len() / static_cast<int>(sizeof(float));
+  header_.distance_type = static_cast<int32_t>(vector_distance_type_from_name(index_meta.param("distance", "l2_distance")));
+
+  BufferPoolManager &bpm = table->db()->buffer_pool_manager();
+  rc = bpm.create_file(file_name);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("Failed to create file. file name=%s, rc=%s", file_name, strrc(rc));
+    return rc;
+  }
+
+  rc = bpm.open_file(table->db()->log_handler(), file_name, disk_buffer_pool_);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("Failed to open file. file name=%s, rc=%s", file_name, strrc(rc));
+    return rc;
+  }
+
+  Frame *header_frame = nullptr;
+  rc = disk_buffer_pool_->allocate_page(&header_frame);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to allocate header page of hnsw index. rc=%s", strrc(rc));
+    return rc;
+  }
+  const PageNum header_page = header_frame->page_num();
+  disk_buffer_pool_->unpin_page(header_frame);
+  if (header_page != HNSW_HEADER_PAGE) {
+    LOG_WARN("header page num should be %d but got %d. is it a new file", HNSW_HEADER_PAGE, header_page);
+    return RC::INTERNAL;
+  }
+
+  rc = save();
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  inited_ = true;
+  table_  = table;
+  LOG_INFO("Successfully create hnsw index. file_name:%s, index:%s, dimension=%d, m=%d, ef_construction=%d, ef_search=%d",
+           file_name, index_meta.name(), header_.dimension, m_, ef_construction_, ef_search_);
+  return RC::SUCCESS;
+}
+
+RC HnswIndex::open(Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
+{
+  if (inited_) {
+    LOG_WARN("Failed to open index due to the index has been initedd before. file_name:%s, index:%s",
+        file_name, index_meta.name());
+    return RC::RECORD_OPENNED;
+  }
+
+  RC rc = init_params(index_meta, field_metas);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+  Index::init(index_meta, field_metas);
+
+  rc = table->db()->buffer_pool_manager().open_file(table->db()->log_handler(), file_name, disk_buffer_pool_);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("Failed to open file. file name=%s, rc=%s", file_name, strrc(rc));
+    return rc;
+  }
+
+  rc = load();
+  if (OB_FAIL(rc)) {
+    LOG_WARN("Failed to load hnsw graph. file name=%s, rc=%s", file_name, strrc(rc));
+    return rc;
+  }
+
+  if (header_.dimension * static_cast<int>(sizeof(float)) != field_metas[0].len()) {
+    LOG_ERROR("dimension of hnsw index mismatch with field. file_name:%s, dimension in file:%d, field len:%d",
+              file_name, header_.dimension, field_metas[0].len());
+    return RC::INTERNAL;
+  }
+
+  inited_ = true;
+  table_  = table;
+  LOG_INFO("Successfully open hnsw index. file_name:%s, index:%s, nodes=%ld, max level=%d",
+           file_name, index_meta.name(), nodes_.size(), max_level_);
+  return RC::SUCCESS;
+}
+
+RC HnswIndex::close()
+{
+  if (disk_buffer_pool_ != nullptr) {
+    if (dirty_) {
+      RC rc = save();
+      if (OB_FAIL(rc)) {
+        LOG_WARN("failed to save hnsw graph while closing. index=%s, rc=%s", index_meta_.name(), strrc(rc));
+      }
+    }
+    disk_buffer_pool_->close_file();
+    disk_buffer_pool_ = nullptr;
+  }
+  inited_ = false;
+  return RC::SUCCESS;
+}
+
+int HnswIndex::random_level()
+{
+  uniform_real_distribution<double> distribution(0.0, 1.0);
+  const double                      value = 1.0 - distribution(random_);  // (0, 1]
+  return static_cast<int>(-log(value) * level_factor_);
+}
+
+vector<int> HnswIndex::neighbors_of(int id, int level) const
+{
+  const Node &node = *nodes_[id];
+  lock_guard  guard(node.lock);
+  if (level > node.level) {
+    return vector<int>();
+  }
+  return node.neighbors[level];
+}
+
+int HnswIndex::greedy_search(const float *query, int entry, int from_level, int to_level) const
+{
+  int   current       = entry;
+  float current_distance = distance(query, nodes_[current]->vec.data());
+  for (int level = from_level; level > to_level; level--) {
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (int neighbor : neighbors_of(current, level)) {
+        const float neighbor_distance = distance(query, nodes_[neighbor]->vec.data());
+        if (neighbor_distance < current_distance) {
+          current          = neighbor;
+          current_distance = neighbor_distance;
+          changed          = true;
+        }
+      }
+    }
+  }
+  return current;
+}
+
+vector<HnswIndex::Candidate> HnswIndex::search_layer(const float *query, int entry, int ef, int level) const
+{
+  vector<bool> visited(nodes_.size(), false);
+
+  // candidates 是小顶堆，每次扩展最近的节点；results 是大顶堆，保存当前最近的 ef 个节点
+  priority_queue<Candidate, vector<Candidate>, greater<Candidate>> candidates;
+  priority_queue<Candidate>                                        results;
+
+  const float entry_distance = distance(query, nodes_[entry]->vec.data());
+  candidates.emplace(entry_distance, entry);
+  results.emplace(entry_distance, entry);
+  visited[entry] = true;
+
+  while (!candidates.empty()) {
+    const Candidate current = candidates.top();
+    if (current.first > results.top().first && static_cast<int>(results.size()) >= ef) {
+      break;
+    }
+    candidates.pop();
+
+    for (int neighbor : neighbors_of(current.second, level)) {
+      if (visited[neighbor]) {
+        continue;
+      }
+      visited[neighbor] = true;
+
+      const float neighbor_distance = distance(query, nodes_[neighbor]->vec.data());
+      if (static_cast<int>(results.size()) < ef || neighbor_distance < results.top().first) {
+        candidates.emplace(neighbor_distance, neighbor);
+        results.emplace(neighbor_distance, neighbor);
+        if (static_cast<int>(results.size()) > ef) {
+          results.pop();
+        }
+      }
+    }
+  }
+
+  vector<Candidate> sorted_results(results.size());
+  for (int i = static_cast<int>(results.size()) - 1; i >= 0; i--) {
+    sorted_results[i] = results.top();
+    results.pop();
+  }
+  return sorted_results;
+}
+
+vector<int> HnswIndex::select_neighbors(const vector<Candidate> &candidates, int max_num) const
+{
+  vector<int> selected;
+  for (const Candidate &candidate : candidates) {
+    if (static_cast<int>(selected.size()) >= max_num) {
+      break;
+    }
+
+    const float *vec  = nodes_[candidate.second]->vec.data();
+    bool         good = true;
+    for (int id : selected) {
+      if (distance(vec, nodes_[id]->vec.data()) < candidate.first) {
+        good = false;
+        break;
+      }
+    }
+    if (good) {
+      selected.push_back(candidate.second);
+    }
+  }
+  return selected;
+}
+
+void HnswIndex::connect(int id, int level, const vector<Candidate> &candidates)
+{
+  Node             &node     = *nodes_[id];
+  const vector<int> selected = select_neighbors(candidates, m_);
+  {
+    lock_guard guard(node.lock);
+    node.neighbors[level] = selected;
+  }
+
+  const int max_num = max_neighbors(level);
+  for (int neighbor_id : selected) {
+    Node      &neighbor  = *nodes_[neighbor_id];
+    lock_guard guard(neighbor.lock);
+
+    vector<int> &neighbors = neighbor.neighbors[level];
+    if (static_cast<int>(neighbors.size()) < max_num) {
+      neighbors.push_back(id);
+      continue;
+    }
+
+    // 邻居满了，从原来的邻居和新节点中重新选择
+    vector<Candidate> neighbor_candidates;
+    neighbor_candidates.emplace_back(distance(neighbor.vec.data(), node.vec.data()), id);
+    for (int other : neighbors) {
+      neighbor_candidates.emplace_back(distance(neighbor.vec.data(), nodes_[other]->vec.data()), other);
+    }
+    sort(neighbor_candidates.begin(), neighbor_candidates.end());
+    neighbors = select_neighbors(neighbor_candidates, max_num);
+  }
+}
+
+RC HnswIndex::insert_entry(const char *record, const RID *rid)
+{
+  const float *vec = reinterpret_cast<const float *>(record + field_metas_[0].offset());
+
+  auto node = make_unique<Node>();
+  node->rid = *rid;
+  node->vec.assign(vec, vec + header_.dimension);
+
+  // 先把节点放到图中，这时还没有其它节点指向它
+  int id        = 0;
+  int level     = 0;
+  int entry     = -1;
+  int max_level = -1;
+  {
+    lock_guard graph_guard(graph_lock_);
+    lock_guard entry_guard(entry_lock_);
+
+    level       = random_level();
+    node->level = level;
+    node->neighbors.resize(level + 1);
+
+    id = static_cast<int>(nodes_.size());
+    nodes_.push_back(std::move(node));
+    rid_nodes_[*rid] = id;
+    dirty_           = true;
+
+    entry     = entry_point_;
+    max_level = max_level_;
+    if (entry < 0) {
+      entry_point_ = id;
+      max_level_   = level;
+      return RC::SUCCESS;
+    }
+  }
+
+  // 从上往下逐层查找邻居并连接起来，其它插入可以并发执行
+  {
+    shared_lock graph_guard(graph_lock_);
+
+    const float *node_vec = nodes_[id]->vec.data();
+    int          current  = greedy_search(node_vec, entry, max_level, level);
+    for (int l = min(level, max_level); l >= 0; l--) {
+      vector<Candidate> candidates = search_layer(node_vec, current, ef_construction_, l);
+      connect(id, l, candidates);
+      current = candidates.front().second;
+    }
+  }
+
+  if (level > max_level) {
+    lock_guard entry_guard(entry_lock_);
+    if (level > max_level_) {
+      entry_point_ = id;
+      max_level_   = level;
+    }
+  }
+  return RC::SUCCESS;
+}
+
+RC HnswIndex::delete_entry(const char *record, const RID *rid)
+{
+  lock_guard guard(graph_lock_);
+
+  auto iter = rid_nodes_.find(*rid);
+  if (iter == rid_nodes_.end()) {
+    LOG_WARN("no such entry in hnsw index. index=%s, rid=%s", index_meta_.name(), rid->to_string().c_str());
+    return RC::RECORD_NOT_EXIST;
+  }
+
+  // 节点还留在图中用来导航
+  nodes_[iter->second]->deleted = true;
+  rid_nodes_.erase(iter);
+  dirty_ = true;
+  return RC::SUCCESS;
+}
+
+vector<RID> HnswIndex::ann_search(const vector<float> &base_vector, size_t limit)
+{
+  vector<RID> result;
+  if (!inited_ || limit == 0 || static_cast<int>(base_vector.size()) != header_.dimension) {
+    LOG_WARN("invalid arguments of ann search. index=%s, dimension=%d, query dimension=%d, limit=%ld",
+             index_meta_.name(), header_.dimension, static_cast<int>(base_vector.size()), limit);
+    return result;
+  }
+
+  shared_lock graph_guard(graph_lock_);
+
+  int entry     = -1;
+  int max_level = -1;
+  {
+    lock_guard entry_guard(entry_lock_);
+    entry     = entry_point_;
+    max_level = max_level_;
+  }
+  if (entry < 0) {
+    return result;
+  }
+
+  const float *query   = base_vector.data();
+  const int    current = greedy_search(query, entry, max_level, 0);
+  const int    ef      = max(ef_search_, static_cast<int>(limit));
+  for (const Candidate &candidate : search_layer(query, current, ef, 0)) {
+    if (result.size() >= limit) {
+      break;
+    }
+    const Node &node = *nodes_[candidate.second];
+    if (!node.deleted) {
+      result.push_back(node.rid);
+    }
+  }
+  return result;
+}
+
+IndexScanner *HnswIndex::create_scanner(
+    const char *left_key, int left_len, bool left_inclusive, const char *right_key, int right_len, bool right_inclusive)
+{
+  LOG_WARN("hnsw index does not support range scan. index=%s", index_meta_.name());
+  return nullptr;
+}
+
+RC HnswIndex::save()
+{
+  common::Serializer serializer;
+  serializer.write_int32(entry_point_);
+  serializer.write_int32(max_level_);
+  serializer.write_int32(static_cast<int32_t>(nodes_.size()));
+  for (const unique_ptr<Node> &node : nodes_) {
+    serializer.write_int32(node->rid.page_num);
+    serializer.write_int32(node->rid.slot_num);
+    serializer.write_int32(node->level);
+    serializer.write_int32(node->deleted ? 1 : 0);
+    serializer.write(reinterpret_cast<const char *>(node->vec.data()), static_cast<int>(sizeof(float) * node->vec.size()));
+    for (const vector<int> &neighbors : node->neighbors) {
+      serializer.write_int32(static_cast<int32_t>(neighbors.size()));
+      serializer.write(reinterpret_cast<const char *>(neighbors.data()), static_cast<int>(sizeof(int) * neighbors.size()));
+    }
+  }
+
+  // 数据页面是连续分配的，不够的时候再分配新的页面
+  const char   *data      = serializer.data().data();
+  const int64_t data_size = serializer.size();
+  const int     page_num  = static_cast<int>((data_size + BP_PAGE_DATA_SIZE - 1) / BP_PAGE_DATA_SIZE);
+  RC            rc        = RC::SUCCESS;
+  for (int i = 0; i < page_num; i++) {
+    Frame *frame = nullptr;
+    if (i < header_.data_page_num) {
+      rc = disk_buffer_pool_->get_this_page(HNSW_FIRST_DATA_PAGE + i, &frame);
+    } else {
+      rc = disk_buffer_pool_->allocate_page(&frame);
+      if (OB_SUCC(rc) && frame->page_num() != HNSW_FIRST_DATA_PAGE + i) {
+        LOG_WARN("data page of hnsw index should be continuous. expect=%d, got=%d", HNSW_FIRST_DATA_PAGE + i, frame->page_num());
+        disk_buffer_pool_->unpin_page(frame);
+        rc = RC::INTERNAL;
+      }
+    }
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to get data page of hnsw index. index=%s, page=%d, rc=%s",
+               index_meta_.name(), HNSW_FIRST_DATA_PAGE + i, strrc(rc));
+      return rc;
+    }
+
+    const int64_t offset = static_cast<int64_t>(i) * BP_PAGE_DATA_SIZE;
+    frame->write_latch();
+    memcpy(frame->data(), data + offset, min<int64_t>(BP_PAGE_DATA_SIZE, data_size - offset));
+    frame->mark_dirty();
+    frame->write_unlatch();
+    disk_buffer_pool_->unpin_page(frame);
+  }
+
+  Frame *header_frame = nullptr;
+  rc                  = disk_buffer_pool_->get_this_page(HNSW_HEADER_PAGE, &header_frame);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to get header page of hnsw index. index=%s, rc=%s", index_meta_.name(), strrc(rc));
+    return rc;
+  }
+
+  header_.data_page_num = max(header_.data_page_num, page_num);
+  header_.data_size     = data_size;
+  header_frame->write_latch();
+  memcpy(header_frame->data(), &header_, sizeof(header_));
+  header_frame->mark_dirty();
+  header_frame->write_unlatch();
+  disk_buffer_pool_->unpin_page(header_frame);
+
+  dirty_ = false;
+  return RC::SUCCESS;
+}
+
+RC HnswIndex::load()
+{
+  Frame *frame = nullptr;
+  RC     rc    = disk_buffer_pool_->get_this_page(HNSW_HEADER_PAGE, &frame);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to get header page of hnsw index. rc=%s", strrc(rc));
+    return rc;
+  }
+  frame->read_latch();
+  memcpy(&header_, frame->data(), sizeof(header_));
+  frame->read_unlatch();
+  disk_buffer_pool_->unpin_page(frame);
+
+  vector<char> data(header_.data_size);
+  for (int64_t offset = 0; offset < header_.data_size; offset += BP_PAGE_DATA_SIZE) {
+    const PageNum page_num = HNSW_FIRST_DATA_PAGE + static_cast<PageNum>(offset / BP_PAGE_DATA_SIZE);
+    rc                     = disk_buffer_pool_->get_this_page(page_num, &frame);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to get data page of hnsw index. page=%d, rc=%s", page_num, strrc(rc));
+      return rc;
+    }
+    frame->read_latch();
+    memcpy(data.data() + offset, frame->data(), min<int64_t>(BP_PAGE_DATA_SIZE, header_.data_size - offset));
+    frame->read_unlatch();
+    disk_buffer_pool_->unpin_page(frame);
+  }
+
+  common::Deserializer deserializer(data.data(), static_cast<int>(data.size()));
+  int32_t              node_num = 0;
+  if (deserializer.read_int32(entry_point_) != 0 || deserializer.read_int32(max_level_) != 0 ||
+      deserializer.read_int32(node_num) != 0) {
+    LOG_WARN("hnsw graph data is broken. data size=%ld", header_.data_size);
+    return RC::INTERNAL;
+  }
+
+  nodes_.clear();
+  rid_nodes_.clear();
+  nodes_.reserve(node_num);
+  for (int32_t i = 0; i < node_num; i++) {
+    auto    node    = make_unique<Node>();
+    int32_t deleted = 0;
+    int     ret     = deserializer.read_int32(node->rid.page_num);
+    ret |= deserializer.read_int32(node->rid.slot_num);
+    ret |= deserializer.read_int32(node->level);
+    ret |= deserializer.read_int32(deleted);
+    if (ret != 0 || node->level < 0) {
+      LOG_WARN("hnsw graph data is broken. node=%d", i);
+      return RC::INTERNAL;
+    }
+
+    node->deleted = deleted != 0;
+    node->vec.resize(header_.dimension);
+    ret = deserializer.read(reinterpret_cast<char *>(node->vec.data()), static_cast<int>(sizeof(float) * header_.dimension));
+
+    node->neighbors.resize(node->level + 1);
+    for (vector<int> &neighbors : node->neighbors) {
+      int32_t neighbor_num = 0;
+      ret |= deserializer.read_int32(neighbor_num);
+      if (ret != 0 || neighbor_num < 0 || neighbor_num > deserializer.remain()) {
+        LOG_WARN("hnsw graph data is broken. node=%d", i);
+        return RC::INTERNAL;
+      }
+      neighbors.resize(neighbor_num);
+      ret |= deserializer.read(reinterpret_cast<char *>(neighbors.data()), static_cast<int>(sizeof(int) * neighbor_num));
+    }
+    if (ret != 0) {
+      LOG_WARN("hnsw graph data is broken. node=%d", i);
+      return RC::INTERNAL;
+    }
+
+    if (!node->deleted) {
+      rid_nodes_[node->rid] = i;
+    }
+    nodes_.push_back(std::move(node));
+  }
+
+  dirty_ = false;
+  return RC::SUCCESS;
+}
+
+RC HnswIndex::sync()
+{
+  if (disk_buffer_pool_ == nullptr) {
+    return RC::SUCCESS;
+  }
+
+  {
+    lock_guard guard(graph_lock_);
+    if (dirty_) {
+      RC rc = save();
+      if (OB_FAIL(rc)) {
+        return rc;
+      }
+    }
+  }
+  return disk_buffer_pool_->flush_all_pages();
+}
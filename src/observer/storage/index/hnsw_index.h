@@ -0,0 +1,149 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/lang/memory.h"
+#include "common/lang/mutex.h"
+#include "common/lang/random.h"
+#include "common/lang/unordered_map.h"
+#include "storage/buffer/page.h"
+#include "storage/index/ivfflat_index.h"
+#include "storage/record/record.h"
+
+/**
+ * @brief hnsw 索引文件的头部信息
+ * @ingroup Index
+ * @details 放在索引文件的第一个页面上。图的数据序列化后，从第二个页面开始连续存放
+ */
+struct HnswFileHeader
+{
+  int32_t dimension;        ///< 向量的维度
+  int32_t distance_type;    ///< VectorDistanceType
+  int32_t data_page_num;    ///< 已经分配的存放图数据的页面个数
+  int32_t reserved;
+  int64_t data_size;        ///< 图数据序列化后的字节数
+};
+
+/**
+ * @brief hnsw 向量索引
+ * @ingroup Index
+ * @details HNSW(Hierarchical Navigable Small World)是一个分层的近邻图。每个向量随机分配一个层数，
+ * 层数越高的节点越少。查询时从最高层的入口节点开始，在每一层贪心地走向离查询向量更近的节点，
+ * 到第0层时使用大小为 ef_search 的候选集做一次宽度优先的搜索。ef_search 越大召回率越高，速度越慢。
+ *
+ * 整个图放在内存中，每个节点有自己的锁保护它的邻居列表，多个插入可以并发执行。
+ * 删除只是把节点标记为已删除，节点还留在图中用来导航，查询结果中会跳过它。
+ * 索引修改不记录日志，sync 和 close 时把整个图序列化后写到 buffer pool 文件中，打开索引时再读出来。
+ * 异常退出后需要重建索引。
+ *
+ * 索引参数：distance(l2_distance、cosine_distance、inner_product)，m(每层的最大邻居数，第0层是2m)，
+ * ef_construction(插入时的候选集大小)，ef_search(查询时的候选集大小)。
+ */
+class HnswIndex : public Index
+{
+public:
+  HnswIndex() = default;
+  virtual ~HnswIndex() noexcept;
+
+  bool is_vector_index() override { return true; }
+
+  RC create(Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas) override;
+  RC open(Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas) override;
+  RC close();
+
+  /**
+   * @brief 查找离 base_vector 最近的 limit 条数据
+   * @return 按照距离从小到大排列的RID
+   */
+  vector<RID> ann_search(const vector<float> &base_vector, size_t limit);
+
+  RC insert_entry(const char *record, const RID *rid) override;
+  RC delete_entry(const char *record, const RID *rid) override;
+
+  /// 向量索引不支持范围扫描
+  IndexScanner *create_scanner(const char *left_key, int left_len, bool left_inclusive, const char *right_key,
+      int right_len, bool right_inclusive) override;
+
+  RC sync() override;
+
+  int                m() const { return m_; }
+  int                ef_construction() const { return ef_construction_; }
+  int                ef_search() const { return ef_search_; }
+  void               set_ef_search(int ef_search) { ef_search_ = ef_search; }
+  int                dimension() const { return header_.dimension; }
+  VectorDistanceType distance_type() const { return static_cast<VectorDistanceType>(header_.distance_type); }
+
+private:
+  struct Node
+  {
+    RID                 rid;
+    int                 level   = 0;
+    bool                deleted = false;
+    vector<float>       vec;
+    vector<vector<int>> neighbors;  ///< 每一层的邻居
+    mutable common::Mutex lock;     ///< 保护 neighbors
+  };
+
+  /// 距离和节点编号
+  using Candidate = pair<float, int>;
+
+private:
+  /// 从索引参数中解析 distance、m、ef_construction、ef_search
+  RC init_params(const IndexMeta &index_meta, const vector<FieldMeta> &field_metas);
+
+  float distance(const float *left, const float *right) const
+  {
+    return vector_distance(distance_type(), left, right, header_.dimension);
+  }
+
+  /// 某一层的最大邻居数
+  int max_neighbors(int level) const { return level == 0 ? 2 * m_ : m_; }
+
+  int random_level();
+
+  vector<int> neighbors_of(int id, int level) const;
+
+  /// 从 entry 开始，在 from_level 到 to_level(不包含)之间贪心地查找最近的节点
+  int greedy_search(const float *query, int entry, int from_level, int to_level) const;
+
+  /// 在某一层上查找最近的 ef 个节点，结果按照距离从小到大排列
+  vector<Candidate> search_layer(const float *query, int entry, int ef, int level) const;
+
+  /// 启发式地选择邻居：如果候选节点离某个已选的邻居比离基准节点更近，就不选它，这样邻居可以分布在不同的方向上
+  vector<int> select_neighbors(const vector<Candidate> &candidates, int max_num) const;
+
+  /// 把新节点和它在某一层的邻居互相连接起来
+  void connect(int id, int level, const vector<Candidate> &candidates);
+
+  RC save();
+  RC load();
+
+private:
+  bool            inited_           = false;
+  Table          *table_            = nullptr;
+  DiskBufferPool *disk_buffer_pool_ = nullptr;
+  int             m_                = 16;
+  int             ef_construction_  = 64;
+  int             ef_search_        = 40;
+  double          level_factor_     = 0;
+  bool            dirty_            = false;
+
+  HnswFileHeader header_;
+
+  vector<unique_ptr<Node>>         nodes_;
+  unordered_map<RID, int, RIDHash> rid_nodes_;    ///< RID 到没有删除的节点
+  common::SharedMutex              graph_lock_;   ///< 增加节点时加写锁，查询和修改邻居时加读锁
+
+  int           entry_point_ = -1;
+  int           max_level_   = -1;
+  mt19937       random_{0};
+  common::Mutex entry_lock_;  ///< 保护 entry_point_、max_level_ 和 random_
+};
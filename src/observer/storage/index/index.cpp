@@ -14,9 +14,9 @@ See the Mulan PSL v2 for more details. */
 
 #include "storage/index/index.h"
 
-RC Index::init(const IndexMeta &index_meta, const FieldMeta &field_meta)
+RC Index::init(const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
 {
-  index_meta_ = index_meta;
-  field_meta_ = field_meta;
+  index_meta_  = index_meta;
+  field_metas_ = field_metas;
   return RC::SUCCESS;
 }
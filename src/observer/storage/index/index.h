@@ -15,7 +15,8 @@ See the Mulan PSL v2 for more details. */
 #pragma once
 
 #include <stddef.h>
-#include <vector>
+
+#include "common/lang/vector.h"
 
 #include "common/sys/rc.h"
 #include "storage/field/field_meta.h"
@@ -40,11 +41,12 @@ public:
   Index()          = default;
   virtual ~Index() = default;
 
-  virtual RC create(Table *table, const char *file_name, const IndexMeta &index_meta, const FieldMeta &field_meta)
+  virtual RC create(
+      Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
   {
     return RC::UNSUPPORTED;
   }
-  virtual RC open(Table *table, const char *file_name, const IndexMeta &index_meta, const FieldMeta &field_meta)
+  virtual RC open(Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
   {
     return RC::UNSUPPORTED;
   }
@@ -53,6 +55,9 @@ public:
 
   const IndexMeta &index_meta() const { return index_meta_; }
 
+  /// 索引包含的字段，按照在键值中的顺序排列
+  const vector<FieldMeta> &field_metas() const { return field_metas_; }
+
   /**
    * @brief 插入一条数据
    *
@@ -82,6 +87,16 @@ public:
   virtual IndexScanner *create_scanner(const char *left_key, int left_len, bool left_inclusive, const char *right_key,
       int right_len, bool right_inclusive) = 0;
 
+  /**
+   * @brief 创建一个按照键值从大到小扫描的扫描器
+   * @details 参数与 create_scanner 相同，从右边界开始扫描。不支持反向扫描的索引返回空指针
+   */
+  virtual IndexScanner *create_reverse_scanner(const char *left_key, int left_len, bool left_inclusive,
+      const char *right_key, int right_len, bool right_inclusive)
+  {
+    return nullptr;
+  }
+
   /**
    * @brief 同步索引数据到磁盘
    *
@@ -89,11 +104,11 @@ public:
   virtual RC sync() = 0;
 
 protected:
-  RC init(const IndexMeta &index_meta, const FieldMeta &field_meta);
+  RC init(const IndexMeta &index_meta, const vector<FieldMeta> &field_metas);
 
 protected:
-  IndexMeta index_meta_;  ///< 索引的元数据
-  FieldMeta field_meta_;  ///< 当前实现仅考虑一个字段的索引
+  IndexMeta         index_meta_;   ///< 索引的元数据
+  vector<FieldMeta> field_metas_;  ///< 索引包含的字段，键值是这些字段的值按顺序拼接起来的
 };
 
 /**
@@ -112,4 +127,11 @@ public:
    */
   virtual RC next_entry(RID *rid) = 0;
   virtual RC destroy()            = 0;
+
+  /**
+   * @brief 遍历元素数据，同时返回索引的键值
+   * @details 索引覆盖了查询用到的所有字段时，可以直接从键值中取出字段的值，不需要再读取记录。
+   * 返回的键值在下次调用 next_entry 之前有效
+   */
+  virtual RC next_entry(RID *rid, const char *&key) { return RC::UNSUPPORTED; }
 };
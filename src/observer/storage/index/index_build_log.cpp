@@ -0,0 +1,62 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/index/index_build_log.h"
+#include "common/log/log.h"
+#include "storage/index/index.h"
+
+void IndexBuildLog::append(OpType type, const char *record, int record_size, const RID &rid)
+{
+  Entry entry{type, rid, vector<char>(record, record + record_size)};
+
+  lock_guard guard(lock_);
+  entries_.push_back(std::move(entry));
+}
+
+RC IndexBuildLog::apply()
+{
+  deque<Entry> entries;
+  {
+    lock_guard guard(lock_);
+    entries.swap(entries_);
+  }
+
+  for (const Entry &entry : entries) {
+    RC rc = apply(entry);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to apply index build log. index=%s, rid=%s, rc=%s",
+               index_.index_meta().name(), entry.rid.to_string().c_str(), strrc(rc));
+      return rc;
+    }
+  }
+
+  LOG_TRACE("applied index build log. index=%s, entry num=%d", index_.index_meta().name(), static_cast<int>(entries.size()));
+  return RC::SUCCESS;
+}
+
+RC IndexBuildLog::apply(const Entry &entry)
+{
+  // 无论是插入还是删除，都先删除索引中可能已经存在的数据
+  RC rc = index_.delete_entry(entry.record.data(), &entry.rid);
+  if (OB_FAIL(rc) && rc != RC::RECORD_NOT_EXIST && rc != RC::RECORD_INVALID_KEY) {
+    return rc;
+  }
+
+  if (entry.type == OpType::DELETE) {
+    return RC::SUCCESS;
+  }
+  return index_.insert_entry(entry.record.data(), &entry.rid);
+}
+
+size_t IndexBuildLog::size() const
+{
+  lock_guard guard(lock_);
+  return entries_.size();
+}
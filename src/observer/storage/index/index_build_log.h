@@ -0,0 +1,72 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/lang/deque.h"
+#include "common/lang/mutex.h"
+#include "common/lang/vector.h"
+#include "common/sys/rc.h"
+#include "storage/record/record.h"
+
+class Index;
+
+/**
+ * @brief 在线创建索引时记录的数据修改
+ * @ingroup Index
+ * @details 创建索引时扫描表中已有的数据构建索引，扫描过程中不阻塞插入和删除，这期间的修改都追加到这里，
+ * 扫描完成后再应用到新索引上。
+ * 扫描和修改是同时进行的，扫描可能已经看到了某条修改，也可能没有看到，所以应用修改时要保证重复执行没有影响：
+ * 插入一条数据前先删除索引中同样的数据，删除不存在的数据时忽略错误。
+ * 修改按照追加的顺序应用，同一个RID先删除再插入(RID被复用)时结果也是正确的。
+ */
+class IndexBuildLog
+{
+public:
+  enum class OpType
+  {
+    INSERT,
+    DELETE
+  };
+
+public:
+  IndexBuildLog(Index &index) : index_(index) {}
+  ~IndexBuildLog() = default;
+
+  Index &index() const { return index_; }
+
+  /// 追加一条修改，可以在多个线程中同时调用
+  void append(OpType type, const char *record, int record_size, const RID &rid);
+
+  /**
+   * @brief 把当前所有的修改应用到索引上
+   * @details 应用过程中不持有锁，其它线程可以继续追加修改，这些修改留给下一次调用
+   */
+  RC apply();
+
+  /// 还没有应用的修改条数
+  size_t size() const;
+
+private:
+  struct Entry
+  {
+    OpType       type;
+    RID          rid;
+    vector<char> record;
+  };
+
+  RC apply(const Entry &entry);
+
+private:
+  Index &index_;
+
+  mutable common::Mutex lock_;
+  deque<Entry>          entries_;
+};
@@ -21,51 +21,185 @@ See the Mulan PSL v2 for more details. */
 
 const static Json::StaticString FIELD_NAME("name");
 const static Json::StaticString FIELD_FIELD_NAME("field_name");
+const static Json::StaticString FIELD_FIELD_NAMES("field_names");
+const static Json::StaticString FIELD_TYPE("type");
+const static Json::StaticString FIELD_PARAMS("params");
 
-RC IndexMeta::init(const char *name, const FieldMeta &field)
+static const char *INDEX_TYPE_NAMES[] = {"unknown", "bplus_tree", "ivfflat", "hnsw", "hash"};
+
+const char *index_type_name(IndexType type)
+{
+  const int index = static_cast<int>(type);
+  if (index < 0 || index >= static_cast<int>(sizeof(INDEX_TYPE_NAMES) / sizeof(INDEX_TYPE_NAMES[0]))) {
+    return INDEX_TYPE_NAMES[0];
+  }
+  return INDEX_TYPE_NAMES[index];
+}
+
+IndexType index_type_from_name(const char *name)
+{
+  for (size_t i = 1; i < sizeof(INDEX_TYPE_NAMES) / sizeof(INDEX_TYPE_NAMES[0]); i++) {
+    if (0 == strcasecmp(name, INDEX_TYPE_NAMES[i])) {
+      return static_cast<IndexType>(i);
+    }
+  }
+  return IndexType::UNKNOWN;
+}
+
+RC IndexMeta::init(const char *name, const FieldMeta &field) { return init(name, vector<const FieldMeta *>{&field}); }
+
+RC IndexMeta::init(const char *name, const vector<const FieldMeta *> &fields)
+{
+  return init(name, fields, IndexType::BPLUS_TREE, map<string, string>());
+}
+
+RC IndexMeta::init(
+    const char *name, const vector<const FieldMeta *> &fields, IndexType type, const map<string, string> &params)
 {
+  if (type == IndexType::UNKNOWN) {
+    LOG_ERROR("Failed to init index, unknown index type. name=%s", name);
+    return RC::INVALID_ARGUMENT;
+  }
+
   if (common::is_blank(name)) {
     LOG_ERROR("Failed to init index, name is empty.");
     return RC::INVALID_ARGUMENT;
   }
 
-  name_  = name;
-  field_ = field.name();
+  if (fields.empty()) {
+    LOG_ERROR("Failed to init index, no field. name=%s", name);
+    return RC::INVALID_ARGUMENT;
+  }
+
+  name_ = name;
+  fields_.clear();
+  for (const FieldMeta *field : fields) {
+    if (contains_field(field->name())) {
+      LOG_ERROR("Failed to init index, duplicate field. name=%s, field=%s", name, field->name());
+      return RC::INVALID_ARGUMENT;
+    }
+    fields_.push_back(field->name());
+  }
+  type_   = type;
+  params_ = params;
   return RC::SUCCESS;
 }
 
 void IndexMeta::to_json(Json::Value &json_value) const
 {
   json_value[FIELD_NAME]       = name_;
-  json_value[FIELD_FIELD_NAME] = field_;
+  json_value[FIELD_FIELD_NAME] = fields_[0];  // 兼容只有一个字段的旧版本
+
+  Json::Value fields_value;
+  for (const string &field : fields_) {
+    fields_value.append(field);
+  }
+  json_value[FIELD_FIELD_NAMES] = std::move(fields_value);
+
+  json_value[FIELD_TYPE] = index_type_name(type_);
+  if (!params_.empty()) {
+    Json::Value params_value;
+    for (const auto &[key, value] : params_) {
+      params_value[key] = value;
+    }
+    json_value[FIELD_PARAMS] = std::move(params_value);
+  }
 }
 
 RC IndexMeta::from_json(const TableMeta &table, const Json::Value &json_value, IndexMeta &index)
 {
-  const Json::Value &name_value  = json_value[FIELD_NAME];
-  const Json::Value &field_value = json_value[FIELD_FIELD_NAME];
+  const Json::Value &name_value = json_value[FIELD_NAME];
   if (!name_value.isString()) {
     LOG_ERROR("Index name is not a string. json value=%s", name_value.toStyledString().c_str());
     return RC::INTERNAL;
   }
 
-  if (!field_value.isString()) {
-    LOG_ERROR("Field name of index [%s] is not a string. json value=%s",
-        name_value.asCString(), field_value.toStyledString().c_str());
+  // 旧版本的元数据只有 field_name
+  Json::Value field_names;
+  if (json_value.isMember(FIELD_FIELD_NAMES)) {
+    field_names = json_value[FIELD_FIELD_NAMES];
+  } else {
+    field_names.append(json_value[FIELD_FIELD_NAME]);
+  }
+
+  if (!field_names.isArray() || field_names.empty()) {
+    LOG_ERROR("Field names of index [%s] is not an array. json value=%s",
+        name_value.asCString(), field_names.toStyledString().c_str());
     return RC::INTERNAL;
   }
 
-  const FieldMeta *field = table.field(field_value.asCString());
-  if (nullptr == field) {
-    LOG_ERROR("Deserialize index [%s]: no such field: %s", name_value.asCString(), field_value.asCString());
-    return RC::SCHEMA_FIELD_MISSING;
+  vector<const FieldMeta *> fields;
+  for (const Json::Value &field_value : field_names) {
+    if (!field_value.isString()) {
+      LOG_ERROR("Field name of index [%s] is not a string. json value=%s",
+          name_value.asCString(), field_value.toStyledString().c_str());
+      return RC::INTERNAL;
+    }
+
+    const FieldMeta *field = table.field(field_value.asCString());
+    if (nullptr == field) {
+      LOG_ERROR("Deserialize index [%s]: no such field: %s", name_value.asCString(), field_value.asCString());
+      return RC::SCHEMA_FIELD_MISSING;
+    }
+    fields.push_back(field);
   }
 
-  return index.init(name_value.asCString(), *field);
+  // 旧版本的元数据没有索引类型，都是B+树
+  IndexType type = IndexType::BPLUS_TREE;
+  if (json_value.isMember(FIELD_TYPE)) {
+    const Json::Value &type_value = json_value[FIELD_TYPE];
+    type = type_value.isString() ? index_type_from_name(type_value.asCString()) : IndexType::UNKNOWN;
+    if (type == IndexType::UNKNOWN) {
+      LOG_ERROR("Unknown type of index [%s]. json value=%s", name_value.asCString(), type_value.toStyledString().c_str());
+      return RC::INTERNAL;
+    }
+  }
+
+  map<string, string> params;
+  const Json::Value  &params_value = json_value[FIELD_PARAMS];
+  if (params_value.isObject()) {
+    for (const string &key : params_value.getMemberNames()) {
+      if (!params_value[key].isString()) {
+        LOG_ERROR("Param of index [%s] is not a string. param=%s", name_value.asCString(), key.c_str());
+        return RC::INTERNAL;
+      }
+      params[key] = params_value[key].asString();
+    }
+  }
+
+  return index.init(name_value.asCString(), fields, type, params);
 }
 
 const char *IndexMeta::name() const { return name_.c_str(); }
 
-const char *IndexMeta::field() const { return field_.c_str(); }
+const char *IndexMeta::param(const char *name, const char *default_value) const
+{
+  auto iter = params_.find(name);
+  return iter == params_.end() ? default_value : iter->second.c_str();
+}
 
-void IndexMeta::desc(ostream &os) const { os << "index name=" << name_ << ", field=" << field_; }
\ No newline at end of file
+const char *IndexMeta::field() const { return fields_.empty() ? "" : fields_[0].c_str(); }
+
+bool IndexMeta::contains_field(const char *field) const
+{
+  for (const string &name : fields_) {
+    if (name == field) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void IndexMeta::desc(ostream &os) const
+{
+  os << "index name=" << name_ << ", field=";
+  for (size_t i = 0; i < fields_.size(); i++) {
+    os << (i == 0 ? "" : ",") << fields_[i];
+  }
+  if (type_ != IndexType::BPLUS_TREE) {
+    os << ", type=" << index_type_name(type_);
+  }
+  for (const auto &[key, value] : params_) {
+    os << ", " << key << "=" << value;
+  }
+}
@@ -15,7 +15,9 @@ See the Mulan PSL v2 for more details. */
 #pragma once
 
 #include "common/sys/rc.h"
+#include "common/lang/map.h"
 #include "common/lang/string.h"
+#include "common/lang/vector.h"
 
 class TableMeta;
 class FieldMeta;
@@ -24,11 +26,30 @@ namespace Json {
 class Value;
 }  // namespace Json
 
+/**
+ * @brief 索引的类型
+ * @ingroup Index
+ */
+enum class IndexType
+{
+  UNKNOWN,
+  BPLUS_TREE,  ///< B+树，默认的索引类型
+  IVFFLAT,     ///< 向量索引，参考 IvfflatIndex
+  HNSW,        ///< 向量索引，参考 HnswIndex
+  HASH,        ///< 哈希索引，只支持等值查找，参考 HashIndex
+};
+
+const char *index_type_name(IndexType type);
+
+/// 根据名字(不区分大小写)获取索引类型，不认识的名字返回 UNKNOWN
+IndexType index_type_from_name(const char *name);
+
 /**
  * @brief 描述一个索引
  * @ingroup Index
  * @details 一个索引包含了表的哪些字段，索引的名称等。
- * 如果以后实现了多种类型的索引，还需要记录索引的类型，对应类型的一些元数据等
+ * 一个索引可以包含多个字段，字段的顺序就是它们在键值中的顺序。
+ * 不同类型的索引还可以有自己的参数，比如向量索引的距离类型、聚类中心个数等，由具体的索引解释
  */
 class IndexMeta
 {
@@ -36,11 +57,28 @@ public:
   IndexMeta() = default;
 
   RC init(const char *name, const FieldMeta &field);
+  RC init(const char *name, const vector<const FieldMeta *> &fields);
+  RC init(const char *name, const vector<const FieldMeta *> &fields, IndexType type, const map<string, string> &params);
 
 public:
   const char *name() const;
+
+  IndexType type() const { return type_; }
+
+  const map<string, string> &params() const { return params_; }
+
+  /// 获取索引的参数，没有设置时返回 default_value
+  const char *param(const char *name, const char *default_value) const;
+
+  /// 第一个字段的名字
   const char *field() const;
 
+  const vector<string> &fields() const { return fields_; }
+  int                   field_num() const { return static_cast<int>(fields_.size()); }
+
+  /// 索引是否包含指定的字段
+  bool contains_field(const char *field) const;
+
   void desc(ostream &os) const;
 
 public:
@@ -48,6 +86,8 @@ public:
   static RC from_json(const TableMeta &table, const Json::Value &json_value, IndexMeta &index);
 
 protected:
-  string name_;   // index's name
-  string field_;  // field's name
+  string              name_;                         // index's name
+  vector<string>      fields_;                       // fields' name
+  IndexType           type_ = IndexType::BPLUS_TREE;
+  map<string, string> params_;
 };
@@ -0,0 +1,735 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/index/ivfflat_index.h"
+#include "common/lang/algorithm.h"
+#include "common/lang/limits.h"
+#include "common/lang/queue.h"
+#include "common/lang/random.h"
+#include "common/lang/string.h"
+#include "common/log/log.h"
+#include "common/math/vector_distance.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "storage/db/db.h"
+#include "storage/record/record_scanner.h"
+#include "storage/table/table.h"
+
+/// 索引文件的第一个页面，存放 IvfflatFileHeader
+static constexpr PageNum IVFFLAT_HEADER_PAGE = 1;
+
+/// 最多可以有多少个倒排列表，列表的页面信息都要放在第一个页面上
+static constexpr int IVFFLAT_MAX_LISTS =
+    static_cast<int>((BP_PAGE_DATA_SIZE - sizeof(IvfflatFileHeader)) / sizeof(IvfflatListInfo));
+
+/**
+ * @brief 存放聚类中心的页面头
+ * @details 后面紧跟着 centroid_num 个聚类中心，每个中心是 dimension 个 float
+ */
+struct IvfflatCentroidPageHeader
+{
+  PageNum next_page;
+  int32_t centroid_num;
+};
+
+/**
+ * @brief 倒排列表的页面头
+ * @details 后面紧跟着 entry_num 条数据，每条数据是 RID 和 dimension 个 float。删除数据时用列表中最后一条数据填补空位
+ */
+struct IvfflatListPageHeader
+{
+  PageNum next_page;
+  int32_t entry_num;
+};
+
+VectorDistanceType vector_distance_type_from_name(const char *name)
+{
+  if (0 == strcasecmp(name, "l2_distance")) {
+    return VectorDistanceType::L2_DISTANCE;
+  } else if (0 == strcasecmp(name, "cosine_distance")) {
+    return VectorDistanceType::COSINE_DISTANCE;
+  } else if (0 == strcasecmp(name, "inner_product")) {
+    return VectorDistanceType::INNER_PRODUCT;
+  }
+  return VectorDistanceType::UNKNOWN;
+}
+
+float vector_distance(VectorDistanceType type, const float *left, const float *right, int dim)
+{
+  switch (type) {
+    case VectorDistanceType::L2_DISTANCE: return common::l2_distance(left, right, dim);
+    case VectorDistanceType::COSINE_DISTANCE: return common::cosine_distance(left, right, dim);
+    case VectorDistanceType::INNER_PRODUCT: return common::inner_product(left, right, dim);
+    default: return numeric_limits<float>::max();
+  }
+}
+
+IvfflatIndex::~IvfflatIndex() noexcept { close(); }
+
+RC IvfflatIndex::init_params(const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
+{
+  if (field_metas.size() != 1 || field_metas[0].type() != AttrType::VECTORS) {
+    LOG_WARN("ivfflat index should be created on one vector field. index=%s", index_meta.name());
+    return RC::INVALID_ARGUMENT;
+  }
+
+  const FieldMeta &field_meta = field_metas[0];
+  if (field_meta.len() <= 0 || field_meta.len() % sizeof(float) != 0) {
+    LOG_WARN("invalid length of vector field. index=%s, field=%s, len=%d", index_meta.name(), field_meta.name(), field_meta.len());
+    return RC::INVALID_ARGUMENT;
+  }
+
+  const char *distance = index_meta.param("distance", "l2_distance");
+  if (vector_distance_type_from_name(distance) == VectorDistanceType::UNKNOWN) {
+    LOG_WARN("unknown distance of ivfflat index. index=%s, distance=%s", index_meta.name(), distance);
+    return RC::INVALID_ARGUMENT;
+  }
+
+  if (!common::str_to_val(index_meta.param("lists", "1"), lists_) ||
+      !common::str_to_val(index_meta.param("probes", "1"), probes_) ||
+      lists_ <= 0 || lists_ > IVFFLAT_MAX_LISTS || probes_ <= 0 || probes_ > lists_) {
+    LOG_WARN("invalid lists or probes of ivfflat index. index=%s, lists=%s, probes=%s, max lists=%d",
+             index_meta.name(), index_meta.param("lists", "1"), index_meta.param("probes", "1"), IVFFLAT_MAX_LISTS);
+    return RC::INVALID_ARGUMENT;
+  }
+  return RC::SUCCESS;
+}
+
+RC IvfflatIndex::create(Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
+{
+  if (inited_) {
+    LOG_WARN("Failed to create index due to the index has been created before. file_name:%s, index:%s",
+        file_name, index_meta.name());
+    return RC::RECORD_OPENNED;
+  }
+
+  RC rc = init_params(index_meta, field_metas);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+  Index::init(index_meta, field_metas);
+
+  header_.dimension     = field_metas[0].len() / static_cast<int>(sizeof(float));
+  header_.distance_type = static_cast<int32_t>(vector_distance_type_from_name(index_meta.param("distance", "l2_distance")));
+  header_.list_num      = 1;
+  header_.centroid_num  = 0;
+  header_.centroid_page = BP_INVALID_PAGE_NUM;
+  if (entry_capacity() <= 0) {
+    LOG_WARN("vector is too large for ivfflat index. index=%s, dimension=%d", index_meta.name(), header_.dimension);
+    return RC::INVALID_ARGUMENT;
+  }
+
+  BufferPoolManager &bpm = table->db()->buffer_pool_manager();
+  rc = bpm.create_file(file_name);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("Failed to create file. file name=%s, rc=%s", file_name, strrc(rc));
+    return rc;
+  }
+
+  rc = bpm.open_file(table->db()->log_handler(), file_name, disk_buffer_pool_);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("Failed to open file. file name=%s, rc=%s", file_name, strrc(rc));
+    return rc;
+  }
+
+  Frame *header_frame = nullptr;
+  rc = disk_buffer_pool_->allocate_page(&header_frame);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to allocate header page of ivfflat index. rc=%s", strrc(rc));
+    return rc;
+  }
+  const PageNum header_page = header_frame->page_num();
+  disk_buffer_pool_->unpin_page(header_frame);
+  if (header_page != IVFFLAT_HEADER_PAGE) {
+    LOG_WARN("header page num should be %d but got %d. is it a new file", IVFFLAT_HEADER_PAGE, header_page);
+    return RC::INTERNAL;
+  }
+
+  // 没有训练的索引只有一个倒排列表
+  list_infos_.clear();
+  rc = append_entry(-1 /*list*/, nullptr, RID());
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  inited_ = true;
+  table_  = table;
+  LOG_INFO("Successfully create ivfflat index. file_name:%s, index:%s, dimension=%d, lists=%d, probes=%d",
+           file_name, index_meta.name(), header_.dimension, lists_, probes_);
+  return RC::SUCCESS;
+}
+
+RC IvfflatIndex::open(Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
+{
+  if (inited_) {
+    LOG_WARN("Failed to open index due to the index has been initedd before. file_name:%s, index:%s",
+        file_name, index_meta.name());
+    return RC::RECORD_OPENNED;
+  }
+
+  RC rc = init_params(index_meta, field_metas);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+  Index::init(index_meta, field_metas);
+
+  rc = table->db()->buffer_pool_manager().open_file(table->db()->log_handler(), file_name, disk_buffer_pool_);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("Failed to open file. file name=%s, rc=%s", file_name, strrc(rc));
+    return rc;
+  }
+
+  Frame *frame = nullptr;
+  rc           = disk_buffer_pool_->get_this_page(IVFFLAT_HEADER_PAGE, &frame);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("Failed to get header page of ivfflat index. file name=%s, rc=%s", file_name, strrc(rc));
+    return rc;
+  }
+
+  frame->read_latch();
+  memcpy(&header_, frame->data(), sizeof(header_));
+  const auto *list_infos = reinterpret_cast<const IvfflatListInfo *>(frame->data() + sizeof(IvfflatFileHeader));
+  list_infos_.assign(list_infos, list_infos + header_.list_num);
+  frame->read_unlatch();
+  disk_buffer_pool_->unpin_page(frame);
+
+  if (header_.dimension * static_cast<int>(sizeof(float)) != field_metas[0].len()) {
+    LOG_ERROR("dimension of ivfflat index mismatch with field. file_name:%s, dimension in file:%d, field len:%d",
+              file_name, header_.dimension, field_metas[0].len());
+    return RC::INTERNAL;
+  }
+
+  rc = load_centroids();
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  inited_ = true;
+  table_  = table;
+  LOG_INFO("Successfully open ivfflat index. file_name:%s, index:%s, lists=%d, centroids=%d",
+           file_name, index_meta.name(), header_.list_num, header_.centroid_num);
+  return RC::SUCCESS;
+}
+
+RC IvfflatIndex::close()
+{
+  if (disk_buffer_pool_ != nullptr) {
+    disk_buffer_pool_->close_file();
+    disk_buffer_pool_ = nullptr;
+  }
+  inited_ = false;
+  return RC::SUCCESS;
+}
+
+int IvfflatIndex::entry_capacity() const
+{
+  return static_cast<int>((BP_PAGE_DATA_SIZE - sizeof(IvfflatListPageHeader)) / entry_size());
+}
+
+const float *IvfflatIndex::vector_of(const char *record) const
+{
+  return reinterpret_cast<const float *>(record + field_metas_[0].offset());
+}
+
+int IvfflatIndex::list_of(const float *vec) const
+{
+  int   list          = 0;
+  float best_distance = numeric_limits<float>::max();
+  for (int i = 0; i < header_.centroid_num; i++) {
+    const float distance = common::l2_distance_square(vec, centroids_.data() + i * header_.dimension, header_.dimension);
+    if (distance < best_distance) {
+      best_distance = distance;
+      list          = i;
+    }
+  }
+  return list;
+}
+
+RC IvfflatIndex::write_header()
+{
+  Frame *frame = nullptr;
+  RC     rc    = disk_buffer_pool_->get_this_page(IVFFLAT_HEADER_PAGE, &frame);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to get header page of ivfflat index. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  frame->write_latch();
+  header_.list_num = static_cast<int32_t>(list_infos_.size());
+  memcpy(frame->data(), &header_, sizeof(header_));
+  memcpy(frame->data() + sizeof(header_), list_infos_.data(), list_infos_.size() * sizeof(IvfflatListInfo));
+  frame->mark_dirty();
+  frame->write_unlatch();
+  disk_buffer_pool_->unpin_page(frame);
+  return RC::SUCCESS;
+}
+
+RC IvfflatIndex::append_entry(int list, const float *vec, const RID &rid)
+{
+  Frame *last_frame = nullptr;
+  RC     rc         = RC::SUCCESS;
+  if (list >= 0) {
+    rc = disk_buffer_pool_->get_this_page(list_infos_[list].last_page, &last_frame);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to get page of ivfflat list. list=%d, page=%d, rc=%s", list, list_infos_[list].last_page, strrc(rc));
+      return rc;
+    }
+    last_frame->write_latch();
+  }
+
+  // 最后一个页面放满了或者是一个新的列表，需要分配新的页面
+  auto  *last_header = last_frame == nullptr ? nullptr : reinterpret_cast<IvfflatListPageHeader *>(last_frame->data());
+  Frame *frame       = last_frame;
+  if (last_header == nullptr || last_header->entry_num >= entry_capacity()) {
+    rc = disk_buffer_pool_->allocate_page(&frame);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to allocate page for ivfflat list. list=%d, rc=%s", list, strrc(rc));
+      if (last_frame != nullptr) {
+        last_frame->write_unlatch();
+        disk_buffer_pool_->unpin_page(last_frame);
+      }
+      return rc;
+    }
+
+    frame->write_latch();
+    auto *page_header      = reinterpret_cast<IvfflatListPageHeader *>(frame->data());
+    page_header->next_page = BP_INVALID_PAGE_NUM;
+    page_header->entry_num = 0;
+    frame->mark_dirty();
+
+    if (last_frame != nullptr) {
+      last_header->next_page = frame->page_num();
+      last_frame->mark_dirty();
+      last_frame->write_unlatch();
+      disk_buffer_pool_->unpin_page(last_frame);
+      list_infos_[list].last_page = frame->page_num();
+    } else {
+      list_infos_.push_back(IvfflatListInfo{frame->page_num(), frame->page_num()});
+    }
+
+    rc = write_header();
+    if (OB_FAIL(rc)) {
+      frame->write_unlatch();
+      disk_buffer_pool_->unpin_page(frame);
+      return rc;
+    }
+  }
+
+  if (vec != nullptr) {
+    auto *page_header = reinterpret_cast<IvfflatListPageHeader *>(frame->data());
+    char *entry       = frame->data() + sizeof(IvfflatListPageHeader) + page_header->entry_num * entry_size();
+    memcpy(entry, &rid, sizeof(rid));
+    memcpy(entry + sizeof(rid), vec, sizeof(float) * header_.dimension);
+    page_header->entry_num++;
+    frame->mark_dirty();
+  }
+
+  frame->write_unlatch();
+  disk_buffer_pool_->unpin_page(frame);
+  return RC::SUCCESS;
+}
+
+RC IvfflatIndex::write_centroids(const vector<float> &centroids, int centroid_num)
+{
+  const int dimension    = header_.dimension;
+  const int page_capacity =
+      static_cast<int>((BP_PAGE_DATA_SIZE - sizeof(IvfflatCentroidPageHeader)) / (sizeof(float) * dimension));
+
+  Frame *prev_frame = nullptr;
+  RC     rc         = RC::SUCCESS;
+  for (int written = 0; written < centroid_num && OB_SUCC(rc);) {
+    Frame *frame = nullptr;
+    rc           = disk_buffer_pool_->allocate_page(&frame);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to allocate page for centroids. rc=%s", strrc(rc));
+      break;
+    }
+
+    const int num     = min(page_capacity, centroid_num - written);
+    auto     *header  = reinterpret_cast<IvfflatCentroidPageHeader *>(frame->data());
+    header->next_page    = BP_INVALID_PAGE_NUM;
+    header->centroid_num = num;
+    memcpy(frame->data() + sizeof(IvfflatCentroidPageHeader),
+        centroids.data() + static_cast<size_t>(written) * dimension,
+        sizeof(float) * num * dimension);
+    frame->mark_dirty();
+    written += num;
+
+    if (prev_frame == nullptr) {
+      header_.centroid_page = frame->page_num();
+    } else {
+      reinterpret_cast<IvfflatCentroidPageHeader *>(prev_frame->data())->next_page = frame->page_num();
+      prev_frame->mark_dirty();
+      disk_buffer_pool_->unpin_page(prev_frame);
+    }
+    prev_frame = frame;
+  }
+
+  if (prev_frame != nullptr) {
+    disk_buffer_pool_->unpin_page(prev_frame);
+  }
+  return rc;
+}
+
+RC IvfflatIndex::load_centroids()
+{
+  centroids_.clear();
+  centroids_.reserve(static_cast<size_t>(header_.centroid_num) * header_.dimension);
+
+  PageNum page_num = header_.centroid_page;
+  while (page_num != BP_INVALID_PAGE_NUM && static_cast<int>(centroids_.size()) < header_.centroid_num * header_.dimension) {
+    Frame *frame = nullptr;
+    RC     rc    = disk_buffer_pool_->get_this_page(page_num, &frame);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to get page of centroids. page=%d, rc=%s", page_num, strrc(rc));
+      return rc;
+    }
+
+    auto        *header = reinterpret_cast<const IvfflatCentroidPageHeader *>(frame->data());
+    const float *values = reinterpret_cast<const float *>(frame->data() + sizeof(IvfflatCentroidPageHeader));
+    centroids_.insert(centroids_.end(), values, values + header->centroid_num * header_.dimension);
+    page_num = header->next_page;
+    disk_buffer_pool_->unpin_page(frame);
+  }
+
+  if (static_cast<int>(centroids_.size()) != header_.centroid_num * header_.dimension) {
+    LOG_ERROR("centroids of ivfflat index are broken. expect=%d, got=%d",
+              header_.centroid_num, static_cast<int>(centroids_.size()) / header_.dimension);
+    return RC::INTERNAL;
+  }
+  return RC::SUCCESS;
+}
+
+RC IvfflatIndex::train(RecordScanner &scanner)
+{
+  if (header_.centroid_num != 0) {
+    LOG_WARN("ivfflat index has been trained. index=%s", index_meta_.name());
+    return RC::INTERNAL;
+  }
+
+  const int dimension  = header_.dimension;
+  const int max_sample = lists_ * TRAIN_SAMPLES_PER_LIST;
+
+  // 数据很多时使用蓄水池抽样
+  mt19937       random(0);
+  vector<float> samples;
+  int64_t       record_num = 0;
+  Record        record;
+  RC            rc = RC::SUCCESS;
+  while (OB_SUCC(rc = scanner.next(record))) {
+    const float *vec = vector_of(record.data());
+    if (record_num < max_sample) {
+      samples.insert(samples.end(), vec, vec + dimension);
+    } else {
+      const int64_t pos = static_cast<int64_t>(random() % (record_num + 1));
+      if (pos < max_sample) {
+        memcpy(samples.data() + pos * dimension, vec, sizeof(float) * dimension);
+      }
+    }
+    record_num++;
+  }
+  if (rc != RC::RECORD_EOF) {
+    LOG_WARN("failed to scan records to train ivfflat index. index=%s, rc=%s", index_meta_.name(), strrc(rc));
+    return rc;
+  }
+
+  const int sample_num   = static_cast<int>(samples.size() / dimension);
+  const int centroid_num = min(lists_, sample_num);
+  if (centroid_num == 0) {
+    LOG_INFO("no data to train ivfflat index. index=%s", index_meta_.name());
+    return RC::SUCCESS;
+  }
+
+  // 随机选择一些数据作为初始的聚类中心
+  vector<int> sample_ids(sample_num);
+  for (int i = 0; i < sample_num; i++) {
+    sample_ids[i] = i;
+  }
+  shuffle(sample_ids.begin(), sample_ids.end(), random);
+
+  vector<float> centroids(static_cast<size_t>(centroid_num) * dimension);
+  for (int i = 0; i < centroid_num; i++) {
+    memcpy(centroids.data() + i * dimension, samples.data() + sample_ids[i] * dimension, sizeof(float) * dimension);
+  }
+
+  vector<int>    assignment(sample_num, -1);
+  vector<double> sums(static_cast<size_t>(centroid_num) * dimension);
+  vector<int>    counts(centroid_num);
+  for (int iteration = 0; iteration < KMEANS_ITERATIONS; iteration++) {
+    bool changed = false;
+    for (int i = 0; i < sample_num; i++) {
+      const float *vec           = samples.data() + i * dimension;
+      int          best          = 0;
+      float        best_distance = numeric_limits<float>::max();
+      for (int c = 0; c < centroid_num; c++) {
+        const float distance = common::l2_distance_square(vec, centroids.data() + c * dimension, dimension);
+        if (distance < best_distance) {
+          best_distance = distance;
+          best          = c;
+        }
+      }
+      changed       = changed || assignment[i] != best;
+      assignment[i] = best;
+    }
+
+    if (!changed) {
+      break;
+    }
+
+    fill(sums.begin(), sums.end(), 0.0);
+    fill(counts.begin(), counts.end(), 0);
+    for (int i = 0; i < sample_num; i++) {
+      const float *vec = samples.data() + i * dimension;
+      double      *sum = sums.data() + assignment[i] * dimension;
+      for (int d = 0; d < dimension; d++) {
+        sum[d] += vec[d];
+      }
+      counts[assignment[i]]++;
+    }
+
+    for (int c = 0; c < centroid_num; c++) {
+      float *centroid = centroids.data() + c * dimension;
+      if (counts[c] == 0) {
+        // 空的类随机选一条数据作为新的中心
+        memcpy(centroid, samples.data() + (random() % sample_num) * dimension, sizeof(float) * dimension);
+        continue;
+      }
+      for (int d = 0; d < dimension; d++) {
+        centroid[d] = static_cast<float>(sums[c * dimension + d] / counts[c]);
+      }
+    }
+  }
+
+  rc = write_centroids(centroids, centroid_num);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  // 创建索引时的列表是空的，可以直接作为第一个列表
+  for (int i = 1; i < centroid_num && OB_SUCC(rc); i++) {
+    rc = append_entry(-1 /*list*/, nullptr, RID());
+  }
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  centroids_.swap(centroids);
+  header_.centroid_num = centroid_num;
+  rc                   = write_header();
+  LOG_INFO("trained ivfflat index. index=%s, records=%ld, samples=%d, centroids=%d",
+           index_meta_.name(), record_num, sample_num, centroid_num);
+  return rc;
+}
+
+RC IvfflatIndex::insert_entry(const char *record, const RID *rid)
+{
+  lock_guard guard(lock_);
+
+  const float *vec = vector_of(record);
+  return append_entry(list_of(vec), vec, *rid);
+}
+
+RC IvfflatIndex::delete_entry(const char *record, const RID *rid)
+{
+  lock_guard guard(lock_);
+
+  const int        list = list_of(vector_of(record));
+  IvfflatListInfo &info = list_infos_[list];
+
+  // 在列表中找到这条数据
+  Frame  *frame    = nullptr;
+  int     slot     = -1;
+  PageNum page_num = info.first_page;
+  RC      rc       = RC::SUCCESS;
+  while (page_num != BP_INVALID_PAGE_NUM) {
+    rc = disk_buffer_pool_->get_this_page(page_num, &frame);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to get page of ivfflat list. page=%d, rc=%s", page_num, strrc(rc));
+      return rc;
+    }
+
+    frame->write_latch();
+    auto *page_header = reinterpret_cast<IvfflatListPageHeader *>(frame->data());
+    for (int i = 0; i < page_header->entry_num; i++) {
+      const char *entry = frame->data() + sizeof(IvfflatListPageHeader) + i * entry_size();
+      if (*reinterpret_cast<const RID *>(entry) == *rid) {
+        slot = i;
+        break;
+      }
+    }
+    if (slot >= 0) {
+      break;
+    }
+
+    page_num = page_header->next_page;
+    frame->write_unlatch();
+    disk_buffer_pool_->unpin_page(frame);
+  }
+
+  if (slot < 0) {
+    LOG_WARN("no such entry in ivfflat index. index=%s, rid=%s", index_meta_.name(), rid->to_string().c_str());
+    return RC::RECORD_NOT_EXIST;
+  }
+
+  // 用列表中的最后一条数据填补删除的位置
+  Frame *last_frame = frame;
+  if (page_num != info.last_page) {
+    rc = disk_buffer_pool_->get_this_page(info.last_page, &last_frame);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to get page of ivfflat list. page=%d, rc=%s", info.last_page, strrc(rc));
+      frame->write_unlatch();
+      disk_buffer_pool_->unpin_page(frame);
+      return rc;
+    }
+    last_frame->write_latch();
+  }
+
+  auto     *last_header = reinterpret_cast<IvfflatListPageHeader *>(last_frame->data());
+  const int last_slot   = last_header->entry_num - 1;
+  if (last_frame != frame || last_slot != slot) {
+    memcpy(frame->data() + sizeof(IvfflatListPageHeader) + slot * entry_size(),
+        last_frame->data() + sizeof(IvfflatListPageHeader) + last_slot * entry_size(),
+        entry_size());
+  }
+  last_header->entry_num--;
+  frame->mark_dirty();
+  last_frame->mark_dirty();
+
+  const PageNum empty_page = (last_header->entry_num == 0 && info.last_page != info.first_page) ? info.last_page
+                                                                                                : BP_INVALID_PAGE_NUM;
+  if (last_frame != frame) {
+    last_frame->write_unlatch();
+    disk_buffer_pool_->unpin_page(last_frame);
+  }
+  frame->write_unlatch();
+  disk_buffer_pool_->unpin_page(frame);
+
+  if (empty_page == BP_INVALID_PAGE_NUM) {
+    return RC::SUCCESS;
+  }
+
+  // 最后一个页面空了，从列表中摘下来
+  page_num = info.first_page;
+  while (OB_SUCC(rc)) {
+    rc = disk_buffer_pool_->get_this_page(page_num, &frame);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to get page of ivfflat list. page=%d, rc=%s", page_num, strrc(rc));
+      return rc;
+    }
+
+    frame->write_latch();
+    auto         *page_header = reinterpret_cast<IvfflatListPageHeader *>(frame->data());
+    const PageNum next_page   = page_header->next_page;
+    if (next_page == empty_page) {
+      page_header->next_page = BP_INVALID_PAGE_NUM;
+      frame->mark_dirty();
+      info.last_page = page_num;
+    }
+    frame->write_unlatch();
+    disk_buffer_pool_->unpin_page(frame);
+
+    if (next_page == empty_page) {
+      break;
+    }
+    page_num = next_page;
+  }
+
+  rc = write_header();
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+  return disk_buffer_pool_->dispose_page(empty_page);
+}
+
+vector<RID> IvfflatIndex::ann_search(const vector<float> &base_vector, size_t limit)
+{
+  vector<RID> result;
+  if (!inited_ || limit == 0 || static_cast<int>(base_vector.size()) != header_.dimension) {
+    LOG_WARN("invalid arguments of ann search. index=%s, dimension=%d, query dimension=%d, limit=%ld",
+             index_meta_.name(), header_.dimension, static_cast<int>(base_vector.size()), limit);
+    return result;
+  }
+
+  shared_lock guard(lock_);
+
+  const int          dimension = header_.dimension;
+  const float       *query     = base_vector.data();
+  VectorDistanceType type      = distance_type();
+
+  // 找到离查询向量最近的 probes 个聚类中心
+  vector<int> lists;
+  if (header_.centroid_num == 0) {
+    lists.push_back(0);
+  } else {
+    vector<pair<float, int>> centroid_distances;
+    for (int i = 0; i < header_.centroid_num; i++) {
+      centroid_distances.emplace_back(
+          common::l2_distance_square(query, centroids_.data() + i * dimension, dimension), i);
+    }
+    const int probe_num = min(probes_, header_.centroid_num);
+    partial_sort(centroid_distances.begin(), centroid_distances.begin() + probe_num, centroid_distances.end());
+    for (int i = 0; i < probe_num; i++) {
+      lists.push_back(centroid_distances[i].second);
+    }
+  }
+
+  // 大顶堆中保存当前最近的 limit 条数据
+  auto compare = [](const pair<float, RID> &left, const pair<float, RID> &right) { return left.first < right.first; };
+  priority_queue<pair<float, RID>, vector<pair<float, RID>>, decltype(compare)> heap(compare);
+  for (int list : lists) {
+    PageNum page_num = list_infos_[list].first_page;
+    while (page_num != BP_INVALID_PAGE_NUM) {
+      Frame *frame = nullptr;
+      RC     rc    = disk_buffer_pool_->get_this_page(page_num, &frame);
+      if (OB_FAIL(rc)) {
+        LOG_WARN("failed to get page of ivfflat list. page=%d, rc=%s", page_num, strrc(rc));
+        return result;
+      }
+
+      frame->read_latch();
+      auto *page_header = reinterpret_cast<const IvfflatListPageHeader *>(frame->data());
+      for (int i = 0; i < page_header->entry_num; i++) {
+        const char  *entry    = frame->data() + sizeof(IvfflatListPageHeader) + i * entry_size();
+        const float *vec      = reinterpret_cast<const float *>(entry + sizeof(RID));
+        const float  distance = vector_distance(type, vec, query, dimension);
+        if (heap.size() < limit) {
+          heap.emplace(distance, *reinterpret_cast<const RID *>(entry));
+        } else if (distance < heap.top().first) {
+          heap.pop();
+          heap.emplace(distance, *reinterpret_cast<const RID *>(entry));
+        }
+      }
+      page_num = page_header->next_page;
+      frame->read_unlatch();
+      disk_buffer_pool_->unpin_page(frame);
+    }
+  }
+
+  result.resize(heap.size());
+  for (int i = static_cast<int>(heap.size()) - 1; i >= 0; i--) {
+    result[i] = heap.top().second;
+    heap.pop();
+  }
+  return result;
+}
+
+IndexScanner *IvfflatIndex::create_scanner(
+    const char *left_key, int left_len, bool left_inclusive, const char *right_key, int right_len, bool right_inclusive)
+{
+  LOG_WARN("ivfflat index does not support range scan. index=%s", index_meta_.name());
+  return nullptr;
+}
+
+RC IvfflatIndex::sync()
+{
+  if (disk_buffer_pool_ == nullptr) {
+    return RC::SUCCESS;
+  }
+  return disk_buffer_pool_->flush_all_pages();
+}
@@ -10,40 +10,149 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
+#include "common/lang/mutex.h"
+#include "storage/buffer/page.h"
 #include "storage/index/index.h"
 
+class DiskBufferPool;
+class Frame;
+class RecordScanner;
+
+/**
+ * @brief 向量距离的类型
+ * @ingroup Index
+ */
+enum class VectorDistanceType
+{
+  UNKNOWN,
+  L2_DISTANCE,      ///< 欧氏距离
+  COSINE_DISTANCE,  ///< 余弦距离
+  INNER_PRODUCT,    ///< 内积
+};
+
+/// 根据名字获取距离类型，比如 l2_distance，不认识的名字返回 UNKNOWN
+VectorDistanceType vector_distance_type_from_name(const char *name);
+
+/// 按照指定的距离类型计算两个向量的距离
+float vector_distance(VectorDistanceType type, const float *left, const float *right, int dim);
+
+/**
+ * @brief ivfflat 索引文件的头部信息
+ * @ingroup Index
+ * @details 放在索引文件的第一个页面上，后面紧跟着每个倒排列表的页面信息
+ */
+struct IvfflatFileHeader
+{
+  int32_t dimension;      ///< 向量的维度
+  int32_t distance_type;  ///< VectorDistanceType
+  int32_t list_num;       ///< 倒排列表的个数
+  int32_t centroid_num;   ///< 聚类中心的个数。0表示没有训练过，这时只有一个倒排列表
+  PageNum centroid_page;  ///< 第一个存放聚类中心的页面
+};
+
+/**
+ * @brief 一个倒排列表的页面信息
+ * @ingroup Index
+ */
+struct IvfflatListInfo
+{
+  PageNum first_page;  ///< 列表的第一个页面，页面通过 next_page 连接起来
+  PageNum last_page;   ///< 列表的最后一个页面，新的数据追加到这个页面上
+};
+
 /**
  * @brief ivfflat 向量索引
  * @ingroup Index
+ * @details IVF(Inverted File)索引先用 k-means 把表中的向量聚成 lists 个类，每个类一个倒排列表，
+ * 列表中存放属于这个类的向量和它的RID。查询时先找到离查询向量最近的 probes 个聚类中心，
+ * 只在这几个列表中计算距离，probes 越大召回率越高，速度越慢。Flat 表示列表中存放原始的向量，不做压缩。
+ *
+ * 索引数据放在单独的 buffer pool 文件中：第一个页面是 IvfflatFileHeader 和各个列表的页面信息，
+ * 聚类中心和倒排列表都放在链接起来的页面上。聚类中心在打开索引时全部读到内存中。
+ * 创建索引时使用表中已有的数据训练聚类中心(参考 train)，表是空的时候没有聚类中心，所有的数据都放在一个列表中。
+ * 聚类和选择列表时使用欧氏距离，列表中的排序使用索引参数指定的距离。
+ *
+ * 索引参数：distance(l2_distance、cosine_distance、inner_product)，lists(列表个数)，probes(查询的列表个数)。
+ * 索引的修改不记录日志，异常退出后需要重建索引。
  */
 class IvfflatIndex : public Index
 {
 public:
-  IvfflatIndex(){};
-  virtual ~IvfflatIndex() noexcept {};
+  /// 每个列表最多使用多少条数据训练聚类中心
+  static constexpr int TRAIN_SAMPLES_PER_LIST = 256;
+  /// k-means 的迭代次数
+  static constexpr int KMEANS_ITERATIONS = 16;
+
+public:
+  IvfflatIndex() = default;
+  virtual ~IvfflatIndex() noexcept;
 
-  RC create(Table *table, const char *file_name, const IndexMeta &index_meta, const FieldMeta &field_meta)
-  {
-    return RC::UNIMPLEMENTED;
-  };
-  RC open(Table *table, const char *file_name, const IndexMeta &index_meta, const FieldMeta &field_meta)
-  {
+  bool is_vector_index() override { return true; }
 
-    return RC::UNIMPLEMENTED;
-  };
+  RC create(Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas) override;
+  RC open(Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas) override;
+  RC close();
 
-  vector<RID> ann_search(const vector<float> &base_vector, size_t limit) { return vector<RID>(); }
+  /**
+   * @brief 使用表中已有的数据训练聚类中心
+   * @details 只能在新创建的空索引上调用。训练完成后，表中已有的数据需要再逐条插入索引
+   */
+  RC train(RecordScanner &scanner);
 
-  RC close() { return RC::UNIMPLEMENTED; }
+  /**
+   * @brief 查找离 base_vector 最近的 limit 条数据
+   * @return 按照距离从小到大排列的RID
+   */
+  vector<RID> ann_search(const vector<float> &base_vector, size_t limit);
 
-  RC insert_entry(const char *record, const RID *rid) override { return RC::UNIMPLEMENTED; };
-  RC delete_entry(const char *record, const RID *rid) override { return RC::UNIMPLEMENTED; };
+  RC insert_entry(const char *record, const RID *rid) override;
+  RC delete_entry(const char *record, const RID *rid) override;
 
-  RC sync() override { return RC::UNIMPLEMENTED; };
+  /// 向量索引不支持范围扫描
+  IndexScanner *create_scanner(const char *left_key, int left_len, bool left_inclusive, const char *right_key,
+      int right_len, bool right_inclusive) override;
+
+  RC sync() override;
+
+  int                lists() const { return lists_; }
+  int                probes() const { return probes_; }
+  void               set_probes(int probes) { probes_ = probes; }
+  int                dimension() const { return header_.dimension; }
+  VectorDistanceType distance_type() const { return static_cast<VectorDistanceType>(header_.distance_type); }
+  int                centroid_num() const { return header_.centroid_num; }
 
 private:
-  bool   inited_ = false;
-  Table *table_  = nullptr;
-  int    lists_  = 1;
-  int    probes_ = 1;
+  /// 从索引参数中解析 distance、lists、probes
+  RC init_params(const IndexMeta &index_meta, const vector<FieldMeta> &field_metas);
+
+  /// 记录中向量字段的位置
+  const float *vector_of(const char *record) const;
+
+  /// 向量属于哪个倒排列表
+  int list_of(const float *vec) const;
+
+  /// 每个页面可以存放多少条数据
+  int entry_capacity() const;
+  int entry_size() const { return static_cast<int>(sizeof(RID) + sizeof(float) * header_.dimension); }
+
+  /// 把内存中的头部信息写到第一个页面上
+  RC write_header();
+
+  RC write_centroids(const vector<float> &centroids, int centroid_num);
+  RC load_centroids();
+
+  RC append_entry(int list, const float *vec, const RID &rid);
+
+private:
+  bool            inited_           = false;
+  Table          *table_            = nullptr;
+  DiskBufferPool *disk_buffer_pool_ = nullptr;
+  int             lists_            = 1;
+  int             probes_           = 1;
+
+  IvfflatFileHeader       header_;
+  vector<IvfflatListInfo> list_infos_;
+  vector<float>           centroids_;  ///< 所有的聚类中心，每 dimension 个 float 是一个中心
+
+  common::SharedMutex lock_;  ///< 插入删除修改倒排列表的结构，查询可以并发
 };
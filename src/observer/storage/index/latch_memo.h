@@ -76,8 +76,12 @@ public:
 
   void release();
 
+  /// @brief 释放 point 之前的锁和页面，不包括 point
   void release_to(int point);
 
+  /// @brief 释放 point 以及之后的锁和页面，与 release_to 相反
+  void release_from(int point);
+
   int memo_point() const { return static_cast<int>(items_.size()); }
 
 private:
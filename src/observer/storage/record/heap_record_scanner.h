@@ -12,6 +12,7 @@ See the Mulan PSL v2 for more details. */
 
 #include "storage/record/record_scanner.h"
 #include "storage/buffer/disk_buffer_pool.h"
+#include "storage/buffer/read_ahead.h"
 #include "storage/trx/trx.h"
 
 /**
@@ -50,6 +51,8 @@ public:
    */
   RC next(Record &record) override;
 
+  void hint_sequential_scan() override { read_ahead_.set_sequential_hint(true); }
+
 private:
   /**
    * @brief 获取该文件中的下一条记录
@@ -71,6 +74,7 @@ private:
   ReadWriteMode   rw_mode_ = ReadWriteMode::READ_WRITE;  ///< 遍历出来的数据，是否可能对它做修改
 
   BufferPoolIterator bp_iterator_;                    ///< 遍历buffer pool的所有页面
+  ReadAhead          read_ahead_;                     ///< 顺序访问页面时预读后面的页面
   ConditionFilter   *condition_filter_    = nullptr;  ///< 过滤record
   RecordPageHandler *record_page_handler_ = nullptr;  ///< 处理文件某页面的记录
   RecordPageIterator record_page_iterator_;           ///< 遍历某个页面上的所有record
@@ -700,6 +700,96 @@ RC RecordFileHandler::visit_record(const RID &rid, function<bool(Record &)> upda
   return rc;
 }
 
+RC RecordFileHandler::visit_records(
+    const RID *rids, int rid_num, ReadWriteMode mode, const function<RC(Record &)> &visitor)
+{
+  unique_ptr<RecordPageHandler> page_handler(RecordPageHandler::create(storage_format_));
+
+  RC rc = RC::SUCCESS;
+  for (int i = 0; i < rid_num && OB_SUCC(rc); i++) {
+    const RID &rid = rids[i];
+    if (i == 0 || rids[i - 1].page_num != rid.page_num) {
+      page_handler->cleanup();
+      rc = page_handler->init(*disk_buffer_pool_, *log_handler_, rid.page_num, mode);
+      if (OB_FAIL(rc)) {
+        LOG_ERROR("Failed to init record page handler.page number=%d", rid.page_num);
+        return rc;
+      }
+    }
+
+    Record inplace_record;
+    rc = page_handler->get_record(rid, inplace_record);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to get record from record page handle. rid=%s, rc=%s", rid.to_string().c_str(), strrc(rc));
+      break;
+    }
+
+    rc = visitor(inplace_record);
+  }
+
+  page_handler->cleanup();
+  return rc;
+}
+
+RC RecordFileHandler::find_records(
+    PageNum page_num, const function<bool(const Record &)> &filter, vector<Record> &records)
+{
+  unique_ptr<RecordPageHandler> page_handler(RecordPageHandler::create(storage_format_));
+
+  RC rc = page_handler->init(*disk_buffer_pool_, *log_handler_, page_num, ReadWriteMode::READ_ONLY);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to init record page handler. page num=%d, rc=%s", page_num, strrc(rc));
+    return rc;
+  }
+
+  RecordPageIterator iterator;
+  iterator.init(page_handler.get());
+  Record record;
+  while (iterator.has_next()) {
+    rc = iterator.next(record);
+    if (OB_FAIL(rc)) {
+      break;
+    }
+
+    if (filter(record)) {
+      Record &copied = records.emplace_back();
+      copied.copy_data(record.data(), record.len());
+      copied.set_rid(record.rid());
+    }
+  }
+
+  page_handler->cleanup();
+  return rc == RC::RECORD_EOF ? RC::SUCCESS : rc;
+}
+
+RC RecordFileHandler::delete_records(PageNum page_num, span<const RID> rids)
+{
+  unique_ptr<RecordPageHandler> page_handler(RecordPageHandler::create(storage_format_));
+
+  RC rc = page_handler->init(*disk_buffer_pool_, *log_handler_, page_num, ReadWriteMode::READ_WRITE);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to init record page handler. page num=%d, rc=%s", page_num, strrc(rc));
+    return rc;
+  }
+
+  for (const RID &rid : rids) {
+    ASSERT(rid.page_num == page_num, "rid is not on the page. page num=%d, rid=%s", page_num, rid.to_string().c_str());
+    rc = page_handler->delete_record(&rid);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to delete record. rid=%s, rc=%s", rid.to_string().c_str(), strrc(rc));
+      break;
+    }
+  }
+
+  // 与 delete_record 一样，先释放页面锁再加 lock_
+  page_handler->cleanup();
+
+  lock_.lock();
+  free_pages_.insert(page_num);
+  lock_.unlock();
+  return rc;
+}
+
 ChunkFileScanner::~ChunkFileScanner() { close_scan(); }
 
 RC ChunkFileScanner::close_scan()
@@ -732,6 +822,7 @@ RC ChunkFileScanner::open_scan_chunk(
     LOG_WARN("failed to init bp iterator. rc=%d:%s", rc, strrc(rc));
     return rc;
   }
+  read_ahead_.init(buffer_pool);
   if (table == nullptr || table->table_meta().storage_format() == StorageFormat::ROW_FORMAT) {
     record_page_handler_ = new RowRecordPageHandler();
   } else {
@@ -747,6 +838,7 @@ RC ChunkFileScanner::next_chunk(Chunk &chunk)
 
   while (bp_iterator_.has_next()) {
     PageNum page_num = bp_iterator_.next();
+    read_ahead_.on_access(page_num);
     record_page_handler_->cleanup();
     rc = record_page_handler_->init(*disk_buffer_pool_, *log_handler_, page_num, rw_mode_);
     if (OB_FAIL(rc)) {
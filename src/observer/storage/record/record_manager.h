@@ -15,8 +15,11 @@ See the Mulan PSL v2 for more details. */
 #pragma once
 
 #include "common/lang/bitmap.h"
+#include "common/lang/span.h"
 #include "common/lang/sstream.h"
+#include "common/lang/unordered_set.h"
 #include "storage/buffer/disk_buffer_pool.h"
+#include "storage/buffer/read_ahead.h"
 #include "storage/common/chunk.h"
 #include "storage/record/record.h"
 #include "storage/record/record_log.h"
@@ -401,6 +404,28 @@ public:
 
   RC visit_record(const RID &rid, function<bool(Record &)> updater);
 
+  /**
+   * @brief 批量访问记录
+   * @details 连续的RID在同一个页面上时，页面只固定一次。调用者把RID按照页面排好序，每个页面就只会访问一次。
+   * 传给visitor的记录直接指向页面中的数据，只在visitor执行期间有效
+   * @param rids    要访问的记录
+   * @param rid_num 记录的个数
+   * @param visitor 返回值不是SUCCESS时停止访问，并返回这个值
+   */
+  RC visit_records(const RID *rids, int rid_num, ReadWriteMode mode, const function<RC(Record &)> &visitor);
+
+  /**
+   * @brief 复制出页面上 filter 返回 true 的记录
+   * @details 只在遍历页面期间持有页面读锁，返回的记录是复制出来的
+   */
+  RC find_records(PageNum page_num, const function<bool(const Record &)> &filter, vector<Record> &records);
+
+  /**
+   * @brief 删除同一个页面上的多条记录
+   * @details 只加一次页面写锁，删除完以后页面放回 free_pages_
+   */
+  RC delete_records(PageNum page_num, span<const RID> rids);
+
 private:
   /**
    * @brief 初始化当前没有填满记录的页面，初始化free_pages_成员
@@ -440,6 +465,11 @@ public:
    */
   RC next_chunk(Chunk &chunk);
 
+  /**
+   * @brief 告诉扫描器会顺序访问所有的页面，可以提前把后面的页面读到内存中
+   */
+  void hint_sequential_scan() { read_ahead_.set_sequential_hint(true); }
+
 private:
   Table *table_ = nullptr;  ///< 当前遍历的是哪张表。
 
@@ -448,5 +478,6 @@ private:
   ReadWriteMode   rw_mode_ = ReadWriteMode::READ_WRITE;  ///< 遍历出来的数据，是否可能对它做修改
 
   BufferPoolIterator bp_iterator_;                    ///< 遍历buffer pool的所有页面
+  ReadAhead          read_ahead_;                     ///< 顺序访问页面时预读后面的页面
   RecordPageHandler *record_page_handler_ = nullptr;  ///< 处理文件某页面的记录
 };
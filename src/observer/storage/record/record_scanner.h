@@ -39,4 +39,10 @@ public:
    * @param record 返回的下一条记录
    */
   virtual RC next(Record &record) = 0;
+
+  /**
+   * @brief 告诉扫描器会顺序访问所有的记录
+   * @details 扫描器可以据此提前把后面的页面读到内存中
+   */
+  virtual void hint_sequential_scan() {}
 };
\ No newline at end of file
@@ -10,8 +10,12 @@ See the Mulan PSL v2 for more details. */
 
 #include "storage/table/heap_table_engine.h"
 #include "storage/record/heap_record_scanner.h"
+#include "common/lang/algorithm.h"
 #include "common/log/log.h"
 #include "storage/index/bplus_tree_index.h"
+#include "storage/index/hash_index.h"
+#include "storage/index/hnsw_index.h"
+#include "storage/index/ivfflat_index.h"
 #include "storage/common/meta_util.h"
 #include "storage/db/db.h"
 
@@ -38,6 +42,8 @@ HeapTableEngine::~HeapTableEngine()
 }
 RC HeapTableEngine::insert_record(Record &record)
 {
+  auto guard = shared_index_guard();
+
   RC rc = RC::SUCCESS;
   rc    = record_handler_->insert_record(record.data(), table_meta_->record_size(), &record.rid());
   if (rc != RC::SUCCESS) {
@@ -45,6 +51,8 @@ RC HeapTableEngine::insert_record(Record &record)
     return rc;
   }
 
+  append_build_logs(IndexBuildLog::OpType::INSERT, record.data(), record.rid());
+
   rc = insert_entry_of_indexes(record.data(), record.rid());
   if (rc != RC::SUCCESS) {  // 可能出现了键值重复
     RC rc2 = delete_entry_of_indexes(record.data(), record.rid(), false /*error_on_not_exists*/);
@@ -57,6 +65,9 @@ RC HeapTableEngine::insert_record(Record &record)
       LOG_PANIC("Failed to rollback record data when insert index entries failed. table name=%s, rc=%d:%s",
                 table_meta_->name(), rc2, strrc(rc2));
     }
+
+    // 正在创建的索引可能已经扫描到了这条数据
+    append_build_logs(IndexBuildLog::OpType::DELETE, record.data(), record.rid());
   }
   return rc;
 }
@@ -66,6 +77,12 @@ RC HeapTableEngine::visit_record(const RID &rid, function<bool(Record &)> visito
   return record_handler_->visit_record(rid, visitor);
 }
 
+RC HeapTableEngine::visit_records(
+    const RID *rids, int rid_num, ReadWriteMode mode, const function<RC(Record &)> &visitor)
+{
+  return record_handler_->visit_records(rids, rid_num, mode, visitor);
+}
+
 RC HeapTableEngine::get_record(const RID &rid, Record &record)
 {
   RC rc = record_handler_->get_record(rid, record);
@@ -79,6 +96,8 @@ RC HeapTableEngine::get_record(const RID &rid, Record &record)
 
 RC HeapTableEngine::delete_record(const Record &record)
 {
+  auto guard = shared_index_guard();
+
   RC rc = RC::SUCCESS;
   for (Index *index : indexes_) {
     rc = index->delete_entry(record.data(), &record.rid());
@@ -87,6 +106,9 @@ RC HeapTableEngine::delete_record(const Record &record)
            table_meta_->name(), index->index_meta().name(), record.rid().to_string().c_str(), strrc(rc));
   }
   rc = record_handler_->delete_record(&record.rid());
+  if (OB_SUCC(rc)) {
+    append_build_logs(IndexBuildLog::OpType::DELETE, record.data(), record.rid());
+  }
   return rc;
 }
 
@@ -109,67 +131,154 @@ RC HeapTableEngine::get_chunk_scanner(ChunkFileScanner &scanner, Trx *trx, ReadW
   return rc;
 }
 
-RC HeapTableEngine::create_index(Trx *trx, const FieldMeta *field_meta, const char *index_name)
+Index *HeapTableEngine::new_index(IndexType type)
 {
-  if (common::is_blank(index_name) || nullptr == field_meta) {
-    LOG_INFO("Invalid input arguments, table name is %s, index_name is blank or attribute_name is blank", table_meta_->name());
-    return RC::INVALID_ARGUMENT;
+  switch (type) {
+    case IndexType::BPLUS_TREE: return new BplusTreeIndex();
+    case IndexType::IVFFLAT: return new IvfflatIndex();
+    case IndexType::HNSW: return new HnswIndex();
+    case IndexType::HASH: return new HashIndex();
+    default: return nullptr;
   }
+}
 
-  IndexMeta new_index_meta;
-
-  RC rc = new_index_meta.init(index_name, *field_meta);
+RC HeapTableEngine::load_index(Index *index, const string &index_file)
+{
+  // 索引中包含表中所有的数据，包括其它事务还没有提交的数据，所以扫描时不按照事务的可见性过滤
+  RecordScanner *scanner = nullptr;
+  RC             rc      = get_record_scanner(scanner, nullptr /*trx*/, ReadWriteMode::READ_ONLY);
   if (rc != RC::SUCCESS) {
-    LOG_INFO("Failed to init IndexMeta in table:%s, index_name:%s, field_name:%s", 
-             table_meta_->name(), index_name, field_meta->name());
+    LOG_WARN("failed to create scanner while creating index. table=%s, index=%s, rc=%s", 
+             table_meta_->name(), index->index_meta().name(), strrc(rc));
     return rc;
   }
 
+  // B+树把当前的所有数据排好序后批量构建索引
+  if (index->index_meta().type() == IndexType::BPLUS_TREE) {
+    rc = static_cast<BplusTreeIndex *>(index)->bulk_load(*scanner, index_file + ".sort");
+    scanner->close_scan();
+    delete scanner;
+    return rc;
+  }
+
+  // ivfflat 索引先用已有的数据训练聚类中心，其它类型的索引都逐条插入
+  if (index->index_meta().type() == IndexType::IVFFLAT) {
+    rc = static_cast<IvfflatIndex *>(index)->train(*scanner);
+    scanner->close_scan();
+    delete scanner;
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+
+    rc = get_record_scanner(scanner, nullptr /*trx*/, ReadWriteMode::READ_ONLY);
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+  }
+
+  Record record;
+  while (OB_SUCC(rc = scanner->next(record))) {
+    rc = index->insert_entry(record.data(), &record.rid());
+    if (rc != RC::SUCCESS) {
+      break;
+    }
+  }
+  scanner->close_scan();
+  delete scanner;
+  return rc == RC::RECORD_EOF ? RC::SUCCESS : rc;
+}
+
+RC HeapTableEngine::create_index(Trx *trx, const vector<const FieldMeta *> &field_metas, const IndexMeta &index_meta)
+{
+  const char *index_name = index_meta.name();
+  if (common::is_blank(index_name) || field_metas.empty()) {
+    LOG_INFO("Invalid input arguments, table name is %s, index_name is blank or attribute_name is blank", table_meta_->name());
+    return RC::INVALID_ARGUMENT;
+  }
+
+  vector<FieldMeta> index_fields;
+  for (const FieldMeta *field_meta : field_metas) {
+    if (nullptr == field_meta) {
+      LOG_INFO("Invalid input arguments, table name is %s, field meta is null", table_meta_->name());
+      return RC::INVALID_ARGUMENT;
+    }
+    index_fields.push_back(*field_meta);
+  }
+
   // 创建索引相关数据
-  BplusTreeIndex *index      = new BplusTreeIndex();
-  string          index_file = table_index_file(db_->path().c_str(), table_meta_->name(), index_name);
+  Index *index = new_index(index_meta.type());
+  if (nullptr == index) {
+    LOG_WARN("unsupported index type. table=%s, index=%s, type=%s",
+             table_meta_->name(), index_name, index_type_name(index_meta.type()));
+    return RC::UNSUPPORTED;
+  }
+  string index_file = table_index_file(db_->path().c_str(), table_meta_->name(), index_name);
 
-  rc = index->create(table_, index_file.c_str(), new_index_meta, *field_meta);
+  RC rc = index->create(table_, index_file.c_str(), index_meta, index_fields);
   if (rc != RC::SUCCESS) {
     delete index;
-    LOG_ERROR("Failed to create bplus tree index. file name=%s, rc=%d:%s", index_file.c_str(), rc, strrc(rc));
+    LOG_ERROR("Failed to create index. file name=%s, rc=%d:%s", index_file.c_str(), rc, strrc(rc));
     return rc;
   }
 
-  // 遍历当前的所有数据，插入这个索引
-  RecordScanner *scanner = nullptr;
-  rc = get_record_scanner(scanner, trx, ReadWriteMode::READ_ONLY);
-  if (rc != RC::SUCCESS) {
-    LOG_WARN("failed to create scanner while creating index. table=%s, index=%s, rc=%s", 
-             table_meta_->name(), index_name, strrc(rc));
+  // 扫描已有数据的过程中不阻塞插入和删除，这期间的修改记录在 build_log 中
+  IndexBuildLog build_log(*index);
+  {
+    auto guard = exclusive_index_guard();
+    build_logs_.push_back(&build_log);
+  }
+
+  rc = load_index(index, index_file);
+  if (OB_SUCC(rc)) {
+    LOG_INFO("inserted all records into new index. table=%s, index=%s", table_meta_->name(), index_name);
+    rc = finish_index_build(build_log, index_meta);
+  }
+
+  if (OB_FAIL(rc)) {
+    {
+      auto guard = exclusive_index_guard();
+      remove_build_log(&build_log);
+    }
+    delete index;
+    LOG_WARN("failed to build index. table=%s, index=%s, rc=%s", table_meta_->name(), index_name, strrc(rc));
     return rc;
   }
 
-  Record record;
-  while (OB_SUCC(rc = scanner->next(record))) {
-    rc = index->insert_entry(record.data(), &record.rid());
-    if (rc != RC::SUCCESS) {
-      LOG_WARN("failed to insert record into index while creating index. table=%s, index=%s, rc=%s",
-               table_meta_->name(), index_name, strrc(rc));
+  LOG_INFO("Successfully added a new index (%s) on the table (%s)", index_name, table_meta_->name());
+  return rc;
+}
+
+RC HeapTableEngine::finish_index_build(IndexBuildLog &build_log, const IndexMeta &index_meta)
+{
+  const char *index_name = index_meta.name();
+
+  // 不加锁应用修改，直到剩余的修改比较少。修改的速度比应用的速度快时，剩余的修改不会减少，就不再追赶了
+  const size_t switch_threshold = 1024;
+  size_t       remain_num       = build_log.size();
+  while (remain_num > switch_threshold) {
+    RC rc = build_log.apply();
+    if (OB_FAIL(rc)) {
       return rc;
     }
+
+    const size_t last_remain_num = remain_num;
+    remain_num                   = build_log.size();
+    if (remain_num >= last_remain_num) {
+      break;
+    }
   }
-  if (RC::RECORD_EOF == rc) {
-    rc = RC::SUCCESS;
-  } else {
-    LOG_WARN("failed to insert record into index while creating index. table=%s, index=%s, rc=%s",
-             table_meta_->name(), index_name, strrc(rc));
+
+  // 加写锁以后不会再有新的修改，应用完剩下的修改后，索引和元数据一起生效
+  auto guard = exclusive_index_guard();
+
+  RC rc = build_log.apply();
+  if (OB_FAIL(rc)) {
     return rc;
   }
-  scanner->close_scan();
-  delete scanner;
-  LOG_INFO("inserted all records into new index. table=%s, index=%s", table_meta_->name(), index_name);
-
-  indexes_.push_back(index);
 
   /// 接下来将这个索引放到表的元数据中
   TableMeta new_table_meta(*table_meta_);
-  rc = new_table_meta.add_index(new_index_meta);
+  rc = new_table_meta.add_index(index_meta);
   if (rc != RC::SUCCESS) {
     LOG_ERROR("Failed to add index (%s) on table (%s). error=%d:%s", index_name, table_meta_->name(), rc, strrc(rc));
     return rc;
@@ -202,12 +311,39 @@ RC HeapTableEngine::create_index(Trx *trx, const FieldMeta *field_meta, const ch
     return RC::IOERR_WRITE;
   }
 
+  indexes_.push_back(&build_log.index());
   table_meta_->swap(new_table_meta);
-
-  LOG_INFO("Successfully added a new index (%s) on the table (%s)", index_name, table_meta_->name());
+  remove_build_log(&build_log);
   return rc;
 }
 
+shared_lock<common::SharedMutex> HeapTableEngine::shared_index_guard() const
+{
+  lock_guard gate_guard(index_gate_);
+  return shared_lock<common::SharedMutex>(index_lock_);
+}
+
+unique_lock<common::SharedMutex> HeapTableEngine::exclusive_index_guard() const
+{
+  lock_guard gate_guard(index_gate_);
+  return unique_lock<common::SharedMutex>(index_lock_);
+}
+
+void HeapTableEngine::remove_build_log(IndexBuildLog *build_log)
+{
+  auto iter = find(build_logs_.begin(), build_logs_.end(), build_log);
+  if (iter != build_logs_.end()) {
+    build_logs_.erase(iter);
+  }
+}
+
+void HeapTableEngine::append_build_logs(IndexBuildLog::OpType type, const char *record, const RID &rid)
+{
+  for (IndexBuildLog *build_log : build_logs_) {
+    build_log->append(type, record, table_meta_->record_size(), rid);
+  }
+}
+
 RC HeapTableEngine::insert_entry_of_indexes(const char *record, const RID &rid)
 {
   RC rc = RC::SUCCESS;
@@ -236,6 +372,8 @@ RC HeapTableEngine::delete_entry_of_indexes(const char *record, const RID &rid,
 
 RC HeapTableEngine::sync()
 {
+  auto guard = shared_index_guard();
+
   RC rc = RC::SUCCESS;
   for (Index *index : indexes_) {
     rc = index->sync();
@@ -254,8 +392,67 @@ RC HeapTableEngine::sync()
   return rc;
 }
 
+RC HeapTableEngine::vacuum(const function<bool(const Record &)> &is_garbage, int &reclaimed_num)
+{
+  reclaimed_num = 0;
+
+  BufferPoolIterator bp_iterator;
+  RC                 rc = bp_iterator.init(*data_buffer_pool_, 1);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to init buffer pool iterator. table=%s, rc=%s", table_meta_->name(), strrc(rc));
+    return rc;
+  }
+
+  vector<Record> garbage;
+  vector<RID>    rids;
+  while (bp_iterator.has_next()) {
+    const PageNum page_num = bp_iterator.next();
+
+    // 先加页面读锁找出垃圾记录，删除索引项时不持有页面锁，避免与索引扫描之后访问记录的顺序相反
+    garbage.clear();
+    rc = record_handler_->find_records(page_num, is_garbage, garbage);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to find garbage records. table=%s, page num=%d, rc=%s", table_meta_->name(), page_num, strrc(rc));
+      return rc;
+    }
+    if (garbage.empty()) {
+      continue;
+    }
+
+    // 垃圾记录不会再被其它事务修改，所以在这期间不会发生变化
+    auto guard = shared_index_guard();
+
+    rids.clear();
+    for (const Record &record : garbage) {
+      for (Index *index : indexes_) {
+        RC rc2 = index->delete_entry(record.data(), &record.rid());
+        if (OB_FAIL(rc2)) {
+          LOG_WARN("failed to delete garbage entry from index. table=%s, index=%s, rid=%s, rc=%s",
+                   table_meta_->name(), index->index_meta().name(), record.rid().to_string().c_str(), strrc(rc2));
+        }
+      }
+      rids.push_back(record.rid());
+    }
+
+    rc = record_handler_->delete_records(page_num, rids);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to delete garbage records. table=%s, page num=%d, rc=%s", table_meta_->name(), page_num, strrc(rc));
+      return rc;
+    }
+
+    for (const Record &record : garbage) {
+      append_build_logs(IndexBuildLog::OpType::DELETE, record.data(), record.rid());
+    }
+    reclaimed_num += static_cast<int>(garbage.size());
+  }
+
+  LOG_TRACE("vacuum table done. table=%s, reclaimed=%d", table_meta_->name(), reclaimed_num);
+  return RC::SUCCESS;
+}
+
 Index *HeapTableEngine::find_index(const char *index_name) const
 {
+  auto guard = shared_index_guard();
   for (Index *index : indexes_) {
     if (0 == strcmp(index->index_meta().name(), index_name)) {
       return index;
@@ -302,20 +499,29 @@ RC HeapTableEngine::open()
   init();
   const int index_num = table_meta_->index_num();
   for (int i = 0; i < index_num; i++) {
-    const IndexMeta *index_meta = table_meta_->index(i);
-    const FieldMeta *field_meta = table_meta_->field(index_meta->field());
-    if (field_meta == nullptr) {
-      LOG_ERROR("Found invalid index meta info which has a non-exists field. table=%s, index=%s, field=%s",
-                table_meta_->name(), index_meta->name(), index_meta->field());
-      // skip cleanup
-      //  do all cleanup action in destructive Table function
-      return RC::INTERNAL;
+    const IndexMeta  *index_meta = table_meta_->index(i);
+    vector<FieldMeta> index_fields;
+    for (const string &field_name : index_meta->fields()) {
+      const FieldMeta *field_meta = table_meta_->field(field_name.c_str());
+      if (field_meta == nullptr) {
+        LOG_ERROR("Found invalid index meta info which has a non-exists field. table=%s, index=%s, field=%s",
+                  table_meta_->name(), index_meta->name(), field_name.c_str());
+        // skip cleanup
+        //  do all cleanup action in destructive Table function
+        return RC::INTERNAL;
+      }
+      index_fields.push_back(*field_meta);
     }
 
-    BplusTreeIndex *index      = new BplusTreeIndex();
-    string          index_file = table_index_file(db_->path().c_str(), table_meta_->name(), index_meta->name());
+    Index *index = new_index(index_meta->type());
+    if (nullptr == index) {
+      LOG_ERROR("Found unsupported index type. table=%s, index=%s, type=%s",
+                table_meta_->name(), index_meta->name(), index_type_name(index_meta->type()));
+      return RC::UNSUPPORTED;
+    }
+    string index_file = table_index_file(db_->path().c_str(), table_meta_->name(), index_meta->name());
 
-    rc = index->open(table_, index_file.c_str(), *index_meta, *field_meta);
+    rc = index->open(table_, index_file.c_str(), *index_meta, index_fields);
     if (rc != RC::SUCCESS) {
       delete index;
       LOG_ERROR("Failed to open index. table=%s, index=%s, file=%s, rc=%s",
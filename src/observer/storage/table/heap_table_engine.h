@@ -10,8 +10,10 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
+#include "common/lang/mutex.h"
 #include "storage/table/table_engine.h"
 #include "storage/index/index.h"
+#include "storage/index/index_build_log.h"
 #include "storage/record/record_manager.h"
 #include "storage/db/db.h"
 
@@ -36,11 +38,13 @@ public:
   }
   RC get_record(const RID &rid, Record &record) override;
 
-  RC create_index(Trx *trx, const FieldMeta *field_meta, const char *index_name) override;
+  RC create_index(Trx *trx, const vector<const FieldMeta *> &field_metas, const IndexMeta &index_meta) override;
   RC get_record_scanner(RecordScanner *&scanner, Trx *trx, ReadWriteMode mode) override;
   RC get_chunk_scanner(ChunkFileScanner &scanner, Trx *trx, ReadWriteMode mode) override;
   RC visit_record(const RID &rid, function<bool(Record &)> visitor) override;
+  RC visit_records(const RID *rids, int rid_num, ReadWriteMode mode, const function<RC(Record &)> &visitor) override;
   RC sync() override;
+  RC vacuum(const function<bool(const Record &)> &is_garbage, int &reclaimed_num) override;
 
   Index *find_index(const char *index_name) const override;
   Index *find_index_by_field(const char *field_name) const override;
@@ -49,6 +53,33 @@ public:
   RC init() override;
 
 private:
+  /// 根据索引类型创建索引对象，不支持的类型返回 nullptr
+  static Index *new_index(IndexType type);
+
+  /// 把表中已有的数据加载到新创建的索引中
+  RC load_index(Index *index, const string &index_file);
+
+  /**
+   * @brief 应用创建索引过程中发生的修改，然后让索引生效
+   * @details 先在不加锁的情况下应用修改，剩余的修改不多时加表的写锁，应用完剩下的修改，
+   * 把索引加入 indexes_ 并修改元数据，这样其它线程看到的要么是正在创建的索引，要么是已经生效的索引
+   */
+  RC finish_index_build(IndexBuildLog &build_log, const IndexMeta &index_meta);
+
+  /// 从 build_logs_ 中删除 build_log，调用者要持有 index_lock_ 的写锁
+  void remove_build_log(IndexBuildLog *build_log);
+
+  /// 把插入或删除的数据追加到所有正在创建的索引的日志中，调用者要持有 index_lock_ 的读锁
+  void append_build_logs(IndexBuildLog::OpType type, const char *record, const RID &rid);
+
+  /**
+   * @brief 加 index_lock_ 的读锁或写锁
+   * @details 加锁前先经过 index_gate_。std::shared_mutex 优先读锁，插入删除不断加读锁时，
+   * 创建索引的线程可能一直加不上写锁。等待写锁时持有 index_gate_，新的读锁就会等在外面
+   */
+  shared_lock<common::SharedMutex> shared_index_guard() const;
+  unique_lock<common::SharedMutex> exclusive_index_guard() const;
+
   RC insert_entry_of_indexes(const char *record, const RID &rid);
   RC delete_entry_of_indexes(const char *record, const RID &rid, bool error_on_not_exists);
 
@@ -58,4 +89,9 @@ private:
   vector<Index *>    indexes_;
   Db                *db_;
   Table             *table_;
+
+  /// 插入删除数据时加读锁，开始和结束创建索引时短暂地加写锁，保证每次修改要么记录到创建索引的日志中，要么修改了生效的索引
+  mutable common::Mutex       index_gate_;
+  mutable common::SharedMutex index_lock_;
+  vector<IndexBuildLog *>     build_logs_;  ///< 正在创建的索引记录修改的日志
 };
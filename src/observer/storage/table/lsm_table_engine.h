@@ -38,12 +38,23 @@ public:
   }
   RC get_record(const RID &rid, Record &record) override { return RC::UNIMPLEMENTED; }
 
-  RC create_index(Trx *trx, const FieldMeta *field_meta, const char *index_name) override { return RC::UNIMPLEMENTED; }
+  RC create_index(Trx *trx, const vector<const FieldMeta *> &field_metas, const IndexMeta &index_meta) override
+  {
+    return RC::UNIMPLEMENTED;
+  }
   RC get_record_scanner(RecordScanner *&scanner, Trx *trx, ReadWriteMode mode) override;
   RC get_chunk_scanner(ChunkFileScanner &scanner, Trx *trx, ReadWriteMode mode) override { return RC::UNIMPLEMENTED; }
   RC visit_record(const RID &rid, function<bool(Record &)> visitor) override { return RC::UNIMPLEMENTED; }
+  RC visit_records(const RID *rids, int rid_num, ReadWriteMode mode, const function<RC(Record &)> &visitor) override
+  {
+    return RC::UNIMPLEMENTED;
+  }
   // TODO:
   RC     sync() override { return RC::SUCCESS; }
+  RC     vacuum(const function<bool(const Record &)> &is_garbage, int &reclaimed_num) override
+  {
+    return RC::UNIMPLEMENTED;
+  }
   Index *find_index(const char *index_name) const override { return nullptr; }
   Index *find_index_by_field(const char *field_name) const override { return nullptr; }
   RC     open() override;
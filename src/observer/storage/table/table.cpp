@@ -199,6 +199,11 @@ RC Table::update_record_with_trx(const Record &old_record, const Record &new_rec
   return engine_->update_record_with_trx(old_record, new_record, trx);
 }
 
+RC Table::visit_records(const RID *rids, int rid_num, ReadWriteMode mode, const function<RC(Record &)> &visitor)
+{
+  return engine_->visit_records(rids, rid_num, mode, visitor);
+}
+
 RC Table::get_record(const RID &rid, Record &record)
 {
   return engine_->get_record(rid, record);
@@ -272,9 +277,9 @@ RC Table::get_chunk_scanner(ChunkFileScanner &scanner, Trx *trx, ReadWriteMode m
   return engine_->get_chunk_scanner(scanner, trx, mode);
 }
 
-RC Table::create_index(Trx *trx, const FieldMeta *field_meta, const char *index_name)
+RC Table::create_index(Trx *trx, const vector<const FieldMeta *> &field_metas, const IndexMeta &index_meta)
 {
-  return engine_->create_index(trx, field_meta, index_name);
+  return engine_->create_index(trx, field_metas, index_meta);
 }
 
 RC Table::delete_record(const Record &record)
@@ -295,3 +300,8 @@ RC Table::sync()
 {
   return engine_->sync();
 }
+
+RC Table::vacuum(const function<bool(const Record &)> &is_garbage, int &reclaimed_num)
+{
+  return engine_->vacuum(is_garbage, reclaimed_num);
+}
@@ -90,7 +90,12 @@ public:
   RC get_record(const RID &rid, Record &record);
 
   // TODO refactor
-  RC create_index(Trx *trx, const FieldMeta *field_meta, const char *index_name);
+  /**
+   * @brief 在指定的字段上创建索引
+   * @param field_metas 索引包含的字段，键值按照这个顺序拼接
+   * @param index_meta  索引的名字、类型和参数
+   */
+  RC create_index(Trx *trx, const vector<const FieldMeta *> &field_metas, const IndexMeta &index_meta);
 
   RC get_record_scanner(RecordScanner *&scanner, Trx *trx, ReadWriteMode mode);
 
@@ -105,6 +110,12 @@ public:
    */
   RC visit_record(const RID &rid, function<bool(Record &)> visitor);
 
+  /**
+   * @brief 批量访问记录，连续的RID在同一个页面上时只固定一次页面
+   * @details 按照页面排好序的RID，每个页面只会访问一次。传给visitor的记录只在visitor执行期间有效
+   */
+  RC visit_records(const RID *rids, int rid_num, ReadWriteMode mode, const function<RC(Record &)> &visitor);
+
 public:
   int32_t     table_id() const { return table_meta_.table_id(); }
   const char *name() const;
@@ -115,6 +126,13 @@ public:
 
   RC sync();
 
+  /**
+   * @brief 回收表中的垃圾记录，比如已经没有事务能看到的旧版本
+   * @param is_garbage    判断一条记录是否可以回收
+   * @param reclaimed_num 返回回收的记录条数
+   */
+  RC vacuum(const function<bool(const Record &)> &is_garbage, int &reclaimed_num);
+
 private:
   RC set_value_to_record(char *record_data, const Value &value, const FieldMeta *field);
 
@@ -44,11 +44,19 @@ public:
   virtual RC update_record_with_trx(const Record &old_record, const Record &new_record, Trx *trx) = 0;
   virtual RC get_record(const RID &rid, Record &record)                                           = 0;
 
-  virtual RC     create_index(Trx *trx, const FieldMeta *field_meta, const char *index_name) = 0;
+  virtual RC     create_index(Trx *trx, const vector<const FieldMeta *> &field_metas, const IndexMeta &index_meta) = 0;
   virtual RC     get_record_scanner(RecordScanner *&scanner, Trx *trx, ReadWriteMode mode)   = 0;
   virtual RC     get_chunk_scanner(ChunkFileScanner &scanner, Trx *trx, ReadWriteMode mode)  = 0;
   virtual RC     visit_record(const RID &rid, function<bool(Record &)> visitor)              = 0;
+  virtual RC     visit_records(const RID *rids, int rid_num, ReadWriteMode mode, const function<RC(Record &)> &visitor) = 0;
   virtual RC     sync()                                                                      = 0;
+
+  /**
+   * @brief 回收表中的垃圾记录
+   * @details 逐个页面找出 is_garbage 返回 true 的记录，删除它们的索引项和记录
+   * @param reclaimed_num 返回回收的记录条数
+   */
+  virtual RC vacuum(const function<bool(const Record &)> &is_garbage, int &reclaimed_num) = 0;
   virtual Index *find_index(const char *index_name) const                                    = 0;
   virtual Index *find_index_by_field(const char *field_name) const                           = 0;
   virtual RC     open()                                                                      = 0;
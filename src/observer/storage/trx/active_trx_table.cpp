@@ -0,0 +1,164 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/trx/active_trx_table.h"
+#include "common/lang/sstream.h"
+#include "common/lang/thread.h"
+#include "common/log/log.h"
+
+string ReadView::to_string() const
+{
+  stringstream ss;
+  ss << "low=" << low_ << ", high=" << high_ << ", active=[";
+  for (size_t i = 0; i < active_ids_.size(); i++) {
+    if (i > 0) {
+      ss << ",";
+    }
+    ss << active_ids_[i];
+  }
+  ss << "]";
+  return ss.str();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int ActiveTrxTable::acquire_slot()
+{
+  bool warned = false;
+  while (true) {
+    for (int i = 0; i < MAX_ACTIVE_TRX_NUM; i++) {
+      int32_t expected = FREE_ID;
+      if (slots_[i].trx_id.load() == FREE_ID && slots_[i].trx_id.compare_exchange_strong(expected, RESERVED_ID)) {
+        int used_num = used_slot_num_.load();
+        while (used_num < i + 1 && !used_slot_num_.compare_exchange_weak(used_num, i + 1)) {
+        }
+        return i;
+      }
+    }
+
+    if (!warned) {
+      LOG_WARN("too many active transactions, waiting for a free slot. max active trx num=%d", MAX_ACTIVE_TRX_NUM);
+      warned = true;
+    }
+    this_thread::yield();
+  }
+}
+
+int32_t ActiveTrxTable::wait_value(const atomic<int32_t> &value)
+{
+  int32_t result = value.load();
+  while (result == RESERVED_ID) {
+    this_thread::yield();
+    result = value.load();
+  }
+  return result;
+}
+
+int32_t ActiveTrxTable::begin(Trx *trx, LSN begin_lsn, int &slot, ReadView &read_view)
+{
+  slot       = acquire_slot();
+  Slot &self = slots_[slot];
+  self.trx.store(trx);
+  self.begin_lsn.store(begin_lsn);
+  self.view_low.store(RESERVED_ID);
+
+  const int32_t trx_id = next_trx_id();
+  self.trx_id.store(trx_id);
+
+  // 先确定高水位再扫描槽位。扫描过一个槽位以后才开始提交的事务，分配到的提交事务号一定不小于高水位
+  read_view.high_ = current_trx_id_.load() + 1;
+  read_view.active_ids_.clear();
+  const int used_num = used_slot_num_.load();
+  for (int i = 0; i < used_num; i++) {
+    const int32_t commit_id = wait_value(slots_[i].commit_id);
+    if (commit_id != FREE_ID && commit_id < read_view.high_) {
+      read_view.active_ids_.push_back(commit_id);
+    }
+  }
+
+  sort(read_view.active_ids_.begin(), read_view.active_ids_.end());
+  read_view.low_ = read_view.active_ids_.empty() ? read_view.high_ : read_view.active_ids_.front();
+  self.view_low.store(read_view.low_);
+  return trx_id;
+}
+
+int32_t ActiveTrxTable::begin_commit(int slot)
+{
+  Slot &self = slots_[slot];
+  self.commit_id.store(RESERVED_ID);
+  const int32_t commit_id = next_trx_id();
+  self.commit_id.store(commit_id);
+  return commit_id;
+}
+
+void ActiveTrxTable::end(int slot)
+{
+  Slot &self = slots_[slot];
+  self.trx.store(nullptr);
+  self.begin_lsn.store(-1);
+  self.view_low.store(FREE_ID);
+  self.commit_id.store(FREE_ID);
+  self.trx_id.store(FREE_ID);
+}
+
+void ActiveTrxTable::update_trx_id(int32_t trx_id)
+{
+  int32_t current = current_trx_id_.load();
+  while (current < trx_id && !current_trx_id_.compare_exchange_weak(current, trx_id)) {
+  }
+}
+
+int32_t ActiveTrxTable::low_watermark() const
+{
+  int32_t watermark = current_trx_id_.load() + 1;
+
+  // 扫描两遍。第一遍扫描过程中提交完成的事务，可能被已经扫描过的槽位上新开始的事务放进读视图，
+  // 这样的读视图在第二遍扫描时一定能看到
+  for (int round = 0; round < 2; round++) {
+    const int used_num = used_slot_num_.load();
+    for (int i = 0; i < used_num; i++) {
+      const int32_t view_low = wait_value(slots_[i].view_low);
+      if (view_low != FREE_ID) {
+        watermark = min(watermark, view_low);
+      }
+
+      const int32_t commit_id = wait_value(slots_[i].commit_id);
+      if (commit_id != FREE_ID) {
+        watermark = min(watermark, commit_id);
+      }
+    }
+  }
+  return watermark;
+}
+
+LSN ActiveTrxTable::min_begin_lsn() const
+{
+  LSN       min_lsn  = -1;
+  const int used_num = used_slot_num_.load();
+  for (int i = 0; i < used_num; i++) {
+    LSN begin_lsn = slots_[i].begin_lsn.load();
+    if (begin_lsn >= 0 && (min_lsn < 0 || begin_lsn < min_lsn)) {
+      min_lsn = begin_lsn;
+    }
+  }
+  return min_lsn;
+}
+
+void ActiveTrxTable::all_trxes(vector<Trx *> &trxes) const
+{
+  trxes.clear();
+  const int used_num = used_slot_num_.load();
+  for (int i = 0; i < used_num; i++) {
+    Trx *trx = slots_[i].trx.load();
+    if (trx != nullptr) {
+      trxes.push_back(trx);
+    }
+  }
+}
@@ -0,0 +1,134 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/lang/algorithm.h"
+#include "common/lang/atomic.h"
+#include "common/lang/string.h"
+#include "common/lang/vector.h"
+#include "common/types.h"
+
+class Trx;
+
+/**
+ * @brief 事务开始时创建的读视图
+ * @ingroup Transaction
+ * @details 记录中只会写入提交事务号，所以读视图只关心提交事务号。
+ * 创建读视图时记录高水位和正在提交的事务的提交事务号，它们中最小的是低水位。
+ * 小于低水位的提交事务号都已经提交完成，不小于高水位的是以后才分配的，中间的需要在正在提交的事务号中查找。
+ * 提交事务号在修改完所有记录之前一直处于正在提交的状态，所以一个事务的修改要么全部可见，要么全部不可见。
+ */
+class ReadView
+{
+public:
+  ReadView()  = default;
+  ~ReadView() = default;
+
+  /// 提交事务号为 xid 的修改在这个读视图中是否已经提交
+  bool is_committed(int32_t xid) const
+  {
+    if (xid < low_) {
+      return true;
+    }
+    if (xid >= high_) {
+      return false;
+    }
+    return !binary_search(active_ids_.begin(), active_ids_.end(), xid);
+  }
+
+  int32_t low() const { return low_; }
+  int32_t high() const { return high_; }
+
+  string to_string() const;
+
+private:
+  friend class ActiveTrxTable;
+
+  int32_t         low_  = 0;    ///< 最小的正在提交的事务号，没有时等于高水位
+  int32_t         high_ = 0;    ///< 创建读视图时下一个要分配的事务号
+  vector<int32_t> active_ids_;  ///< 正在提交的事务号，有序
+};
+
+/**
+ * @brief 活跃事务表
+ * @ingroup Transaction
+ * @details 每个活跃事务占用一个槽位，槽位中记录事务号、提交事务号、读视图的低水位和开始时的LSN。
+ * 所有操作都不加锁：占用槽位使用CAS。分配提交事务号和创建读视图之前先把对应的字段标记为 RESERVED_ID，
+ * 其它线程创建读视图或计算低水位时遇到这样的字段需要等待它填上数值，这样不会漏掉已经分配但还没有填到槽位中的事务号。
+ */
+class ActiveTrxTable
+{
+public:
+  static constexpr int MAX_ACTIVE_TRX_NUM = 1024;
+
+public:
+  ActiveTrxTable()  = default;
+  ~ActiveTrxTable() = default;
+
+  /**
+   * @brief 开始一个事务
+   * @details 占用一个空闲的槽位，分配事务号，并创建读视图。没有空闲的槽位时等待其它事务结束
+   * @param trx       开始的事务
+   * @param begin_lsn 事务开始时的LSN
+   * @param slot      返回占用的槽位
+   * @param read_view 返回创建的读视图
+   * @return int32_t  分配的事务号
+   */
+  int32_t begin(Trx *trx, LSN begin_lsn, int &slot, ReadView &read_view);
+
+  /**
+   * @brief 开始提交事务，分配提交事务号
+   * @details 调用 end 之前其它事务都认为这个提交事务号还没有提交
+   */
+  int32_t begin_commit(int slot);
+
+  /// 事务提交或回滚以后释放槽位
+  void end(int slot);
+
+  int32_t next_trx_id() { return ++current_trx_id_; }
+  int32_t current_trx_id() const { return current_trx_id_.load(); }
+  /// 日志回放时使用，保证以后分配的事务号比日志中的大
+  void update_trx_id(int32_t trx_id);
+
+  /**
+   * @brief 所有活跃事务和以后开始的事务都认为已经提交的事务号的上界
+   * @details 即正在提交的事务号、读视图的低水位和下一个事务号中的最小值。结束事务号比它小的记录不会再被任何事务看到
+   */
+  int32_t low_watermark() const;
+
+  /// 活跃事务开始时LSN的最小值，没有活跃事务时返回-1
+  LSN min_begin_lsn() const;
+
+  void all_trxes(vector<Trx *> &trxes) const;
+
+private:
+  static constexpr int32_t FREE_ID     = 0;
+  static constexpr int32_t RESERVED_ID = -1;
+
+  struct alignas(64) Slot
+  {
+    atomic<int32_t> trx_id{FREE_ID};  ///< FREE_ID 表示槽位空闲
+    atomic<int32_t> commit_id{FREE_ID};
+    atomic<int32_t> view_low{FREE_ID};
+    atomic<LSN>     begin_lsn{-1};
+    atomic<Trx *>   trx{nullptr};
+  };
+
+  int acquire_slot();
+
+  /// 读取槽位中的事务号，等待正在分配的事务号
+  static int32_t wait_value(const atomic<int32_t> &value);
+
+private:
+  atomic<int32_t> current_trx_id_{0};
+  atomic<int>     used_slot_num_{0};  ///< 用过的最大槽位号加1，扫描时不需要访问后面的槽位
+  Slot            slots_[MAX_ACTIVE_TRX_NUM];
+};
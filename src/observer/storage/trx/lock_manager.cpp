@@ -0,0 +1,261 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/trx/lock_manager.h"
+#include "common/lang/algorithm.h"
+#include "common/lang/chrono.h"
+#include "common/log/log.h"
+#include "common/thread/thread_util.h"
+
+namespace {
+
+using WaitForGraph = unordered_map<int32_t, vector<int32_t>>;
+
+/**
+ * @brief 在等待图中找一个环
+ * @param path  当前的搜索路径
+ * @param state 0 未访问，1 在搜索路径上，2 已经访问完成
+ * @param cycle 返回找到的环
+ */
+bool find_cycle(const WaitForGraph &graph, int32_t trx_id, vector<int32_t> &path, unordered_map<int32_t, int> &state,
+    vector<int32_t> &cycle)
+{
+  state[trx_id] = 1;
+  path.push_back(trx_id);
+
+  auto iter = graph.find(trx_id);
+  if (iter != graph.end()) {
+    for (int32_t next : iter->second) {
+      int &next_state = state[next];
+      if (next_state == 1) {
+        auto begin = std::find(path.begin(), path.end(), next);
+        cycle.assign(begin, path.end());
+        return true;
+      }
+      if (next_state == 0 && find_cycle(graph, next, path, state, cycle)) {
+        return true;
+      }
+    }
+  }
+
+  path.pop_back();
+  state[trx_id] = 2;
+  return false;
+}
+
+}  // namespace
+
+LockManager::~LockManager()
+{
+  if (!deadlock_thread_) {
+    return;
+  }
+
+  {
+    lock_guard<mutex> guard(deadlock_thread_mutex_);
+    deadlock_running_ = false;
+  }
+  deadlock_cond_.notify_all();
+  deadlock_thread_->join();
+  deadlock_thread_.reset();
+}
+
+RC LockManager::init(int wait_timeout_ms, int deadlock_detect_interval_ms)
+{
+  wait_timeout_ms_             = max(wait_timeout_ms, 0);
+  deadlock_detect_interval_ms_ = max(deadlock_detect_interval_ms, 0);
+
+#ifdef CONCURRENCY
+  if (deadlock_detect_interval_ms_ > 0) {
+    deadlock_running_ = true;
+    deadlock_thread_  = make_unique<thread>(&LockManager::deadlock_thread_func, this);
+  }
+#endif
+
+  LOG_INFO("lock manager initialized. wait timeout=%dms, deadlock detect interval=%dms",
+           wait_timeout_ms_, deadlock_detect_interval_ms_);
+  return RC::SUCCESS;
+}
+
+bool LockManager::can_grant(const LockQueue &queue, list<LockRequest>::const_iterator request)
+{
+  for (auto iter = queue.requests.begin(); iter != request; ++iter) {
+    if (iter->trx_id == request->trx_id) {
+      continue;
+    }
+    if (iter->mode == LockMode::EXCLUSIVE || request->mode == LockMode::EXCLUSIVE) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void LockManager::grant_waiters(LockQueue &queue)
+{
+  bool granted = false;
+  for (auto iter = queue.requests.begin(); iter != queue.requests.end(); ++iter) {
+    if (!iter->granted && !iter->aborted && can_grant(queue, iter)) {
+      iter->granted = true;
+      granted       = true;
+    }
+  }
+
+  if (granted) {
+    queue.cond.notify_all();
+  }
+}
+
+RC LockManager::lock(int32_t trx_id, const LockKey &key, LockMode mode)
+{
+  Partition         &part = partition(key);
+  unique_lock<mutex> guard(part.lock);
+  LockQueue         &queue = part.queues[key];
+
+  for (const LockRequest &request : queue.requests) {
+    if (request.trx_id == trx_id && request.granted &&
+        (request.mode == LockMode::EXCLUSIVE || mode == LockMode::SHARED)) {
+      return RC::SUCCESS;
+    }
+  }
+
+  auto request = queue.requests.insert(queue.requests.end(), LockRequest{trx_id, mode, false, false});
+  if (can_grant(queue, request)) {
+    request->granted = true;
+    return RC::SUCCESS;
+  }
+
+  RC rc = RC::LOCKED_CONCURRENCY_CONFLICT;
+#ifdef CONCURRENCY
+  LOG_TRACE("waiting for row lock. trx id=%d, table id=%d, rid=%s",
+            trx_id, key.table_id, key.rid.to_string().c_str());
+  queue.cond.wait_for(guard, chrono::milliseconds(wait_timeout_ms_), [&request] {
+    return request->granted || request->aborted;
+  });
+  if (request->granted) {
+    return RC::SUCCESS;
+  }
+  rc = request->aborted ? RC::LOCKED_DEADLOCK : RC::LOCKED_TIMEOUT;
+#endif
+
+  // 排在后面的请求可能因为这个请求而在等待
+  queue.requests.erase(request);
+  grant_waiters(queue);
+  if (queue.requests.empty()) {
+    part.queues.erase(key);
+  }
+
+  LOG_TRACE("failed to lock row. trx id=%d, table id=%d, rid=%s, rc=%s",
+            trx_id, key.table_id, key.rid.to_string().c_str(), strrc(rc));
+  return rc;
+}
+
+void LockManager::unlock(int32_t trx_id, span<const LockKey> keys)
+{
+  for (const LockKey &key : keys) {
+    Partition        &part = partition(key);
+    lock_guard<mutex> guard(part.lock);
+
+    auto iter = part.queues.find(key);
+    if (iter == part.queues.end()) {
+      continue;
+    }
+
+    LockQueue &queue = iter->second;
+    queue.requests.remove_if([trx_id](const LockRequest &request) { return request.trx_id == trx_id; });
+    if (queue.requests.empty()) {
+      part.queues.erase(iter);
+    } else {
+      grant_waiters(queue);
+    }
+  }
+}
+
+int LockManager::detect_deadlock()
+{
+  // 每个事务同时最多等待一个锁，等待者指向排在它前面并且不兼容的请求
+  WaitForGraph                     graph;
+  unordered_map<int32_t, LockKey> waiting_keys;
+  for (Partition &part : partitions_) {
+    lock_guard<mutex> guard(part.lock);
+    for (const auto &[key, queue] : part.queues) {
+      for (auto waiter = queue.requests.begin(); waiter != queue.requests.end(); ++waiter) {
+        if (waiter->granted || waiter->aborted) {
+          continue;
+        }
+
+        waiting_keys[waiter->trx_id] = key;
+        vector<int32_t> &edges       = graph[waiter->trx_id];
+        for (auto iter = queue.requests.begin(); iter != waiter; ++iter) {
+          if (iter->trx_id != waiter->trx_id &&
+              (iter->mode == LockMode::EXCLUSIVE || waiter->mode == LockMode::EXCLUSIVE)) {
+            edges.push_back(iter->trx_id);
+          }
+        }
+      }
+    }
+  }
+
+  int resolved_num = 0;
+  while (true) {
+    vector<int32_t>              path;
+    vector<int32_t>              cycle;
+    unordered_map<int32_t, int> state;
+    for (const auto &[trx_id, edges] : graph) {
+      if (state[trx_id] == 0 && find_cycle(graph, trx_id, path, state, cycle)) {
+        break;
+      }
+    }
+    if (cycle.empty()) {
+      break;
+    }
+
+    // 最年轻的事务做的修改通常最少，让它放弃等待
+    const int32_t  victim = *std::max_element(cycle.begin(), cycle.end());
+    const LockKey &key    = waiting_keys[victim];
+    graph.erase(victim);
+
+    Partition        &part = partition(key);
+    lock_guard<mutex> guard(part.lock);
+    auto              iter = part.queues.find(key);
+    if (iter == part.queues.end()) {
+      continue;
+    }
+    for (LockRequest &request : iter->second.requests) {
+      if (request.trx_id == victim && !request.granted && !request.aborted) {
+        request.aborted = true;
+        iter->second.cond.notify_all();
+        resolved_num++;
+        LOG_INFO("deadlock detected, abort the youngest trx. victim trx id=%d, table id=%d, rid=%s, cycle size=%d",
+                 victim, key.table_id, key.rid.to_string().c_str(), static_cast<int>(cycle.size()));
+        break;
+      }
+    }
+  }
+  return resolved_num;
+}
+
+void LockManager::deadlock_thread_func()
+{
+  common::thread_set_name("DeadlockDetect");
+
+  unique_lock<mutex> lock(deadlock_thread_mutex_);
+  while (deadlock_running_) {
+    deadlock_cond_.wait_for(lock, chrono::milliseconds(deadlock_detect_interval_ms_), [this] {
+      return !deadlock_running_;
+    });
+    if (!deadlock_running_) {
+      break;
+    }
+
+    lock.unlock();
+    detect_deadlock();
+    lock.lock();
+  }
+}
@@ -0,0 +1,132 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/lang/condition_variable.h"
+#include "common/lang/list.h"
+#include "common/lang/memory.h"
+#include "common/lang/mutex.h"
+#include "common/lang/span.h"
+#include "common/lang/thread.h"
+#include "common/lang/unordered_map.h"
+#include "common/lang/vector.h"
+#include "common/sys/rc.h"
+#include "storage/record/record.h"
+
+/**
+ * @brief 行锁的模式
+ * @ingroup Transaction
+ */
+enum class LockMode
+{
+  SHARED,
+  EXCLUSIVE,
+};
+
+/**
+ * @brief 加锁的对象，即某张表中的一行
+ * @ingroup Transaction
+ */
+struct LockKey
+{
+  int32_t table_id = -1;
+  RID     rid;
+
+  bool operator==(const LockKey &other) const { return table_id == other.table_id && rid == other.rid; }
+};
+
+struct LockKeyHash
+{
+  size_t operator()(const LockKey &key) const noexcept { return hash<int32_t>()(key.table_id) ^ RIDHash()(key.rid); }
+};
+
+/**
+ * @brief 行锁管理器
+ * @ingroup Transaction
+ * @details 按照 LockKey 的哈希值分成多个分区，每个分区一个互斥锁，保存每行的加锁队列。
+ * 队列中按照申请的顺序排列，与已经持有的锁和排在前面的等待者都兼容时才能加锁成功，否则等待，直到超时。
+ * 等待的事务与它等待的事务构成等待图，后台线程定期检查等待图中的环，选择环中最年轻(事务号最大)的事务放弃等待，解除死锁。
+ * 只有在 CONCURRENCY 编译模式下才会等待，否则有冲突时直接返回 LOCKED_CONCURRENCY_CONFLICT。
+ */
+class LockManager
+{
+public:
+  LockManager() = default;
+  ~LockManager();
+
+  /**
+   * @brief 初始化，启动死锁检测线程
+   * @param wait_timeout_ms             等锁的超时时间
+   * @param deadlock_detect_interval_ms 死锁检测的间隔，0表示不检测，只依靠超时
+   */
+  RC init(int wait_timeout_ms, int deadlock_detect_interval_ms);
+
+  /**
+   * @brief 加锁，已经持有同样或者更强的锁时直接返回成功
+   * @return RC - SUCCESS 加锁成功
+   *            - LOCKED_CONCURRENCY_CONFLICT 有冲突并且不能等待
+   *            - LOCKED_TIMEOUT 等待超时
+   *            - LOCKED_DEADLOCK 被选为死锁的牺牲者
+   */
+  RC lock(int32_t trx_id, const LockKey &key, LockMode mode);
+
+  /// 释放事务在这些行上持有的所有锁
+  void unlock(int32_t trx_id, span<const LockKey> keys);
+
+  /**
+   * @brief 检测一次死锁
+   * @return int 解除的死锁个数
+   */
+  int detect_deadlock();
+
+private:
+  struct LockRequest
+  {
+    int32_t  trx_id  = -1;
+    LockMode mode    = LockMode::SHARED;
+    bool     granted = false;
+    bool     aborted = false;  ///< 被选为死锁的牺牲者
+  };
+
+  struct LockQueue
+  {
+    list<LockRequest>  requests;
+    condition_variable cond;
+  };
+
+  struct Partition
+  {
+    mutex                                          lock;
+    unordered_map<LockKey, LockQueue, LockKeyHash> queues;
+  };
+
+  static constexpr int PARTITION_NUM = 16;
+
+  Partition &partition(const LockKey &key) { return partitions_[LockKeyHash()(key) % PARTITION_NUM]; }
+
+  /// request 能否与队列中排在它前面的请求同时持有锁
+  static bool can_grant(const LockQueue &queue, list<LockRequest>::const_iterator request);
+  /// 有请求离开队列以后，唤醒可以加锁的等待者
+  static void grant_waiters(LockQueue &queue);
+
+  void deadlock_thread_func();
+
+private:
+  int wait_timeout_ms_             = 0;
+  int deadlock_detect_interval_ms_ = 0;
+
+  Partition partitions_[PARTITION_NUM];
+
+  mutex              deadlock_thread_mutex_;
+  condition_variable deadlock_cond_;
+  bool               deadlock_running_ = false;
+  unique_ptr<thread> deadlock_thread_;
+};
@@ -13,21 +13,13 @@ See the Mulan PSL v2 for more details. */
 //
 
 #include "storage/trx/mvcc_trx.h"
+#include "common/conf/ini.h"
+#include "common/lang/string.h"
 #include "storage/db/db.h"
 #include "storage/field/field.h"
 #include "storage/trx/mvcc_trx_log.h"
 #include "common/lang/algorithm.h"
 
-MvccTrxKit::~MvccTrxKit()
-{
-  vector<Trx *> tmp_trxes;
-  tmp_trxes.swap(trxes_);
-
-  for (Trx *trx : tmp_trxes) {
-    delete trx;
-  }
-}
-
 RC MvccTrxKit::init()
 {
   // 事务使用一些特殊的字段，放到每行记录中，表示行记录的可见性。
@@ -36,60 +28,69 @@ RC MvccTrxKit::init()
       FieldMeta("__trx_xid_begin", AttrType::INTS, 0 /*attr_offset*/, 4 /*attr_len*/, false /*visible*/, -1/*field_id*/),
       FieldMeta("__trx_xid_end", AttrType::INTS, 0 /*attr_offset*/, 4 /*attr_len*/, false /*visible*/, -2/*field_id*/)};
 
+  int lock_wait_timeout_ms        = 3000;
+  int deadlock_detect_interval_ms = 100;
+  common::str_to_val(common::get_properties()->get("LOCK_WAIT_TIMEOUT_MS", "3000", "STORAGE"), lock_wait_timeout_ms);
+  common::str_to_val(common::get_properties()->get("DEADLOCK_DETECT_INTERVAL_MS", "100", "STORAGE"),
+                     deadlock_detect_interval_ms);
+  RC rc = lock_manager_.init(lock_wait_timeout_ms, deadlock_detect_interval_ms);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to init lock manager. rc=%s", strrc(rc));
+    return rc;
+  }
+
   LOG_INFO("init mvcc trx kit done.");
   return RC::SUCCESS;
 }
 
 const vector<FieldMeta> *MvccTrxKit::trx_fields() const { return &fields_; }
 
-int32_t MvccTrxKit::next_trx_id() { return ++current_trx_id_; }
-
 int32_t MvccTrxKit::max_trx_id() const { return numeric_limits<int32_t>::max(); }
 
-Trx *MvccTrxKit::create_trx(LogHandler &log_handler)
-{
-  Trx *trx = new MvccTrx(*this, log_handler);
-  if (trx != nullptr) {
-    lock_.lock();
-    trxes_.push_back(trx);
-    lock_.unlock();
-  }
-  return trx;
-}
+Trx *MvccTrxKit::create_trx(LogHandler &log_handler) { return new MvccTrx(*this, log_handler); }
 
 Trx *MvccTrxKit::create_trx(LogHandler &log_handler, int32_t trx_id)
 {
-  Trx *trx = new MvccTrx(*this, log_handler, trx_id);
-  if (trx != nullptr) {
-    lock_.lock();
-    trxes_.push_back(trx);
-    if (current_trx_id_ < trx_id) {
-      current_trx_id_ = trx_id;
-    }
-    lock_.unlock();
-  }
-  return trx;
+  active_trx_table_.update_trx_id(trx_id);
+  return new MvccTrx(*this, log_handler, trx_id);
 }
 
-void MvccTrxKit::destroy_trx(Trx *trx)
+void MvccTrxKit::destroy_trx(Trx *trx) { delete trx; }
+
+/// 只返回已经开始的事务
+void MvccTrxKit::all_trxes(vector<Trx *> &trxes) { active_trx_table_.all_trxes(trxes); }
+
+LSN MvccTrxKit::min_active_trx_lsn() { return active_trx_table_.min_begin_lsn(); }
+
+RC MvccTrxKit::vacuum(Table *table, int &reclaimed_num)
 {
-  lock_.lock();
-  for (auto iter = trxes_.begin(), itend = trxes_.end(); iter != itend; ++iter) {
-    if (*iter == trx) {
-      trxes_.erase(iter);
-      break;
-    }
+  reclaimed_num = 0;
+
+  span<const FieldMeta> trx_fields = table->table_meta().trx_fields();
+  if (trx_fields.size() < 2) {
+    return RC::SUCCESS;
   }
-  lock_.unlock();
 
-  delete trx;
-}
+  Field begin_xid_field(table, &trx_fields[0]);
+  Field end_xid_field(table, &trx_fields[1]);
 
-void MvccTrxKit::all_trxes(vector<Trx *> &trxes)
-{
-  lock_.lock();
-  trxes = trxes_;
-  lock_.unlock();
+  // 只回收已经提交的删除。正在插入或删除的记录事务号是负数
+  const int32_t low_watermark = active_trx_table_.low_watermark();
+  auto          is_garbage    = [&begin_xid_field, &end_xid_field, low_watermark](const Record &record) {
+    const int32_t begin_xid = begin_xid_field.get_int(record);
+    const int32_t end_xid   = end_xid_field.get_int(record);
+    return begin_xid > 0 && end_xid > 0 && end_xid < low_watermark;
+  };
+
+  RC rc = table->vacuum(is_garbage, reclaimed_num);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to vacuum table. table=%s, rc=%s", table->name(), strrc(rc));
+    return rc;
+  }
+
+  LOG_TRACE("vacuum table done. table=%s, low watermark=%d, reclaimed=%d",
+            table->name(), low_watermark, reclaimed_num);
+  return RC::SUCCESS;
 }
 
 LogReplayer *MvccTrxKit::create_log_replayer(Db &db, LogHandler &log_handler)
@@ -109,7 +110,11 @@ MvccTrx::MvccTrx(MvccTrxKit &kit, LogHandler &log_handler, int32_t trx_id)
   recovering_ = true;
 }
 
-MvccTrx::~MvccTrx() {}
+MvccTrx::~MvccTrx()
+{
+  // 没有提交或回滚就销毁的事务，也不能一直占用活跃事务表的槽位和行锁
+  end_trx();
+}
 
 RC MvccTrx::insert_record(Table *table, Record &record)
 {
@@ -140,18 +145,33 @@ RC MvccTrx::delete_record(Table *table, Record &record)
   Field end_field;
   trx_fields(table, begin_field, end_field);
 
-  RC delete_result = RC::SUCCESS;
+  // 其它事务正在删除这条记录时，等它结束
+  RC rc = lock_record(table, record.rid(), LockMode::EXCLUSIVE);
+  if (OB_FAIL(rc)) {
+    LOG_TRACE("failed to lock record. rid=%s, rc=%s", record.rid().to_string().c_str(), strrc(rc));
+    return rc;
+  }
+
+  RC   delete_result     = RC::SUCCESS;
+  bool deleted_by_others = false;
 
-  RC rc = table->visit_record(record.rid(), [this, table, &delete_result, &end_field](Record &inplace_record) -> bool {
-    RC rc = this->visit_record(table, inplace_record, ReadWriteMode::READ_WRITE);
-    if (OB_FAIL(rc)) {
-      delete_result = rc;
-      return false;
-    }
+  rc = table->visit_record(record.rid(),
+      [this, table, &delete_result, &deleted_by_others, &end_field](Record &inplace_record) -> bool {
+        RC rc = this->visit_record(table, inplace_record, ReadWriteMode::READ_WRITE);
+        if (OB_FAIL(rc)) {
+          delete_result = rc;
+          return false;
+        }
 
-    end_field.set_int(inplace_record, -trx_id_);
-    return true;
-  });
+        // 持有行锁以后，其它事务对这条记录的删除都已经结束了。如果已经提交，就不需要再删除
+        if (end_field.get_int(inplace_record) != trx_kit_.max_trx_id()) {
+          deleted_by_others = true;
+          return false;
+        }
+
+        end_field.set_int(inplace_record, -trx_id_);
+        return true;
+      });
 
   if (OB_FAIL(rc)) {
     LOG_WARN("failed to visit record. rc=%s", strrc(rc));
@@ -163,6 +183,11 @@ RC MvccTrx::delete_record(Table *table, Record &record)
     return delete_result;
   }
 
+  if (deleted_by_others) {
+    LOG_TRACE("record has been deleted by another trx. rid=%s", record.rid().to_string().c_str());
+    return RC::SUCCESS;
+  }
+
   rc = log_handler_.delete_record(trx_id_, table, record.rid());
   ASSERT(rc == RC::SUCCESS, "failed to append delete record log. trx id=%d, table id=%d, rid=%s, record len=%d, rc=%s",
       trx_id_, table->table_id(), record.rid().to_string().c_str(), record.len(), strrc(rc));
@@ -183,11 +208,12 @@ RC MvccTrx::visit_record(Table *table, Record &record, ReadWriteMode mode)
 
   RC rc = RC::SUCCESS;
   if (begin_xid > 0 && end_xid > 0) {
-    if (trx_id_ >= begin_xid && trx_id_ <= end_xid) {
-      rc = RC::SUCCESS;
-    } else {
+    // 在当前事务开始以后才提交的删除，当前事务还能看到。修改时先加行锁，再按照记录最新的状态处理
+    if (!read_view_.is_committed(begin_xid) || read_view_.is_committed(end_xid)) {
       LOG_TRACE("record invisible. trx id=%d, begin xid=%d, end xid=%d", trx_id_, begin_xid, end_xid);
       rc = RC::RECORD_INVISIBLE;
+    } else {
+      rc = RC::SUCCESS;
     }
   } else if (begin_xid < 0) {
     // begin xid 小于0说明是刚插入而且没有提交的数据
@@ -200,7 +226,10 @@ RC MvccTrx::visit_record(Table *table, Record &record, ReadWriteMode mode)
     }
   } else if (end_xid < 0) {
     // end xid 小于0 说明是正在删除但是还没有提交的数据
-    if (mode == ReadWriteMode::READ_ONLY) {
+    if (!read_view_.is_committed(begin_xid)) {
+      LOG_TRACE("record invisible. trx id=%d, begin xid=%d, end xid=%d", trx_id_, begin_xid, end_xid);
+      rc = RC::RECORD_INVISIBLE;
+    } else if (mode == ReadWriteMode::READ_ONLY) {
       // 如果 -end_xid 就是当前事务的事务号，说明是当前事务删除的
       if (-end_xid != trx_id_) {
         rc = RC::SUCCESS;
@@ -210,13 +239,11 @@ RC MvccTrx::visit_record(Table *table, Record &record, ReadWriteMode mode)
         rc = RC::RECORD_INVISIBLE;
       }
     } else {
-      // 如果当前想要修改此条数据，并且不是当前事务删除的，简单的报错
-      // 这是事务并发处理的一种方式，非常简单粗暴。其它的并发处理方法，可以等待，或者让客户端重试
-      // 或者等事务结束后，再检测修改的数据是否有冲突
+      // 如果当前想要修改此条数据，并且不是当前事务删除的，在修改时等待行锁，等删除的事务结束以后再处理
       if (-end_xid != trx_id_) {
-        LOG_TRACE("concurrency conflit. someone is deleting this record right now. trx id=%d, begin xid=%d, end xid=%d",
+        LOG_TRACE("someone is deleting this record right now. trx id=%d, begin xid=%d, end xid=%d",
                   trx_id_, begin_xid, end_xid);
-        rc = RC::LOCKED_CONCURRENCY_CONFLICT;
+        rc = RC::SUCCESS;
       } else {
         LOG_TRACE("record invisible. self has deleted this record. trx id=%d, begin xid=%d, end xid=%d",
                   trx_id_, begin_xid, end_xid);
@@ -246,12 +273,36 @@ void MvccTrx::trx_fields(Table *table, Field &begin_xid_field, Field &end_xid_fi
   end_xid_field.set_field(&trx_fields[1]);
 }
 
+RC MvccTrx::lock_record(Table *table, const RID &rid, LockMode mode)
+{
+  LockKey key{table->table_id(), rid};
+  RC      rc = trx_kit_.lock_manager().lock(trx_id_, key, mode);
+  if (OB_SUCC(rc)) {
+    locks_.push_back(key);
+  }
+  return rc;
+}
+
+/// 事务结束以后释放活跃事务表中的槽位，其它事务新建的读视图会认为它已经提交。然后释放行锁，唤醒等待的事务
+void MvccTrx::end_trx()
+{
+  if (slot_ >= 0) {
+    trx_kit_.active_trx_table().end(slot_);
+    slot_ = -1;
+  }
+
+  if (!locks_.empty()) {
+    trx_kit_.lock_manager().unlock(trx_id_, locks_);
+    locks_.clear();
+  }
+}
+
 RC MvccTrx::start_if_need()
 {
   if (!started_) {
     ASSERT(operations_.empty(), "try to start a new trx while operations is not empty");
-    trx_id_ = trx_kit_.next_trx_id();
-    LOG_DEBUG("current thread change to new trx with %d", trx_id_);
+    trx_id_ = trx_kit_.active_trx_table().begin(this, log_handler_.current_lsn(), slot_, read_view_);
+    LOG_DEBUG("current thread change to new trx with %d, read view: %s", trx_id_, read_view_.to_string().c_str());
     started_ = true;
   }
   return RC::SUCCESS;
@@ -259,13 +310,13 @@ RC MvccTrx::start_if_need()
 
 RC MvccTrx::commit()
 {
-  int32_t commit_id = trx_kit_.next_trx_id();
+  // 提交事务号在修改完所有记录之前一直在活跃事务表中，其它事务的读视图认为它还没有提交
+  int32_t commit_id = slot_ >= 0 ? trx_kit_.active_trx_table().begin_commit(slot_) : trx_kit_.next_trx_id();
   return commit_with_trx_id(commit_id);
 }
 
 RC MvccTrx::commit_with_trx_id(int32_t commit_xid)
 {
-  // TODO 原子性提交BUG：这里存在一个很大的问题，不能让其他事务一次性看到当前事务更新到的数据或同时看不到
   RC rc    = RC::SUCCESS;
   started_ = false;
 
@@ -324,6 +375,7 @@ RC MvccTrx::commit_with_trx_id(int32_t commit_xid)
   if (!recovering_) {
     rc = log_handler_.commit(trx_id_, commit_xid);
   }
+  end_trx();
 
   operations_.clear();
 
@@ -405,6 +457,7 @@ RC MvccTrx::rollback()
   if (!recovering_) {
     rc = log_handler_.rollback(trx_id_);
   }
+  end_trx();
   LOG_TRACE("append trx rollback log. trx id=%d, rc=%s", trx_id_, strrc(rc));
   return rc;
 }
@@ -450,9 +503,10 @@ RC MvccTrx::redo(Db *db, const LogEntry &log_entry)
     } break;
 
     case MvccTrxLogOperation::Type::COMMIT: {
-      // auto *trx_log_record = reinterpret_cast<const MvccTrxCommitLogEntry *>(log_entry.data());
-      // commit_with_trx_id(trx_log_record->commit_trx_id);
       // 遇到了提交日志，说明前面的记录都已经提交成功了
+      // 记录中可能已经写入了提交事务号，以后分配的事务号都要比它大
+      auto *trx_log_record = reinterpret_cast<const MvccTrxCommitLogEntry *>(log_entry.data());
+      trx_kit_.active_trx_table().update_trx_id(trx_log_record->commit_trx_id);
     } break;
 
     case MvccTrxLogOperation::Type::ROLLBACK: {
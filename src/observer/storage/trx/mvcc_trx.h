@@ -15,6 +15,8 @@ See the Mulan PSL v2 for more details. */
 #pragma once
 
 #include "common/lang/vector.h"
+#include "storage/trx/active_trx_table.h"
+#include "storage/trx/lock_manager.h"
 #include "storage/trx/trx.h"
 #include "storage/trx/mvcc_trx_log.h"
 
@@ -25,8 +27,8 @@ class MvccTrxLogHandler;
 class MvccTrxKit : public TrxKit
 {
 public:
-  MvccTrxKit() = default;
-  virtual ~MvccTrxKit();
+  MvccTrxKit()          = default;
+  virtual ~MvccTrxKit() = default;
 
   RC                       init() override;
   const vector<FieldMeta> *trx_fields() const override;
@@ -39,25 +41,37 @@ public:
 
   LogReplayer *create_log_replayer(Db &db, LogHandler &log_handler) override;
 
-public:
-  int32_t next_trx_id();
+  //! @copydoc TrxKit::min_active_trx_lsn
+  LSN min_active_trx_lsn() override;
+
+  /**
+   * @brief 回收结束事务号小于活跃事务表低水位的记录
+   * @details 已提交的删除把记录的结束事务号设置为提交事务号。结束事务号小于低水位时，
+   * 所有活跃事务和以后开始的事务都认为删除已经提交，这样的记录就可以回收了
+   */
+  RC vacuum(Table *table, int &reclaimed_num) override;
 
 public:
+  int32_t next_trx_id() { return active_trx_table_.next_trx_id(); }
   int32_t max_trx_id() const;
 
+  ActiveTrxTable &active_trx_table() { return active_trx_table_; }
+  LockManager    &lock_manager() { return lock_manager_; }
+
 private:
   vector<FieldMeta> fields_;  // 存储事务数据需要用到的字段元数据，所有表结构都需要带的
 
-  atomic<int32_t> current_trx_id_{0};
-
-  common::Mutex lock_;
-  vector<Trx *> trxes_;
+  ActiveTrxTable active_trx_table_;
+  LockManager    lock_manager_;
 };
 
 /**
  * @brief 多版本并发事务
  * @ingroup Transaction
- * TODO 没有垃圾回收
+ * @details 事务开始时创建读视图，记录的开始和结束事务号在读视图中是否提交决定了记录是否可见。
+ * 提交时分配的提交事务号在所有记录都修改完之前一直处于进行中的状态，其它事务不会只看到一部分修改。
+ * 修改记录前先加行锁，其它事务正在修改时等待它结束，然后按照记录最新的状态修改，行锁在事务结束时释放。
+ * 删除的记录只是设置了结束事务号，由 MvccTrxKit::vacuum 回收
  */
 class MvccTrx : public Trx
 {
@@ -95,9 +109,13 @@ public:
 
   int32_t id() const override { return trx_id_; }
 
+  const ReadView &read_view() const { return read_view_; }
+
 private:
   RC   commit_with_trx_id(int32_t commit_id);
   void trx_fields(Table *table, Field &begin_xid_field, Field &end_xid_field) const;
+  RC   lock_record(Table *table, const RID &rid, LockMode mode);
+  void end_trx();
 
 private:
   static const int32_t MAX_TRX_ID = numeric_limits<int32_t>::max();
@@ -111,5 +129,8 @@ private:
   int32_t           trx_id_     = -1;
   bool              started_    = false;
   bool              recovering_ = false;
+  int               slot_       = -1;  ///< 在活跃事务表中占用的槽位
+  ReadView          read_view_;
+  vector<LockKey>   locks_;  ///< 持有的行锁
   OperationSet      operations_;
 };
@@ -134,6 +134,9 @@ public:
    */
   RC rollback(int32_t trx_id);
 
+  /// @brief 当前日志的最大LSN
+  LSN current_lsn() const;
+
 private:
   LogHandler &log_handler_;
 };
@@ -34,6 +34,7 @@ class LogHandler;
 class LogEntry;
 class Trx;
 class LogReplayer;
+class Table;
 
 /**
  * @brief 描述一个操作，比如插入、删除行等
@@ -129,6 +130,22 @@ public:
 
   virtual LogReplayer *create_log_replayer(Db &db, LogHandler &log_handler) = 0;
 
+  /**
+   * @brief 所有活跃事务开始时LSN的最小值
+   * @details 检查点不能越过活跃事务的日志，否则恢复时无法回滚这些事务。没有活跃事务时返回-1
+   */
+  virtual LSN min_active_trx_lsn() { return -1; }
+
+  /**
+   * @brief 回收表中已经没有事务能看到的旧版本数据
+   * @param reclaimed_num 返回回收的记录条数
+   */
+  virtual RC vacuum(Table *table, int &reclaimed_num)
+  {
+    reclaimed_num = 0;
+    return RC::SUCCESS;
+  }
+
 public:
   static TrxKit *create(const char *name, Db *db);
 };
@@ -0,0 +1,116 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "common/io/io_backend.h"
+#include "common/lang/filesystem.h"
+#include "common/lang/string.h"
+#include "common/lang/vector.h"
+
+using namespace common;
+
+/*
+1. 一次提交多个不连续的写请求，每个请求包含多个数据块
+2. 一次提交多个读请求，检查读到的数据
+3. 读取超过文件尾的数据，返回-1
+*/
+void test_read_write(IoBackend &backend)
+{
+  const string filename = string("io_backend_") + backend.name() + ".data";
+  filesystem::remove(filename);
+
+  int fd = ::open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+  ASSERT_GE(fd, 0);
+
+  const int      block_size  = 4096;
+  const int      block_count = 200;  // 超过 io_uring 的队列深度，需要分多次提交
+  vector<string> blocks(block_count);
+  for (int i = 0; i < block_count; i++) {
+    blocks[i] = string(block_size, static_cast<char>('a' + i % 26));
+  }
+
+  // 每个请求写两块数据，请求之间空出一块
+  const int         request_count = block_count / 2;
+  vector<iovec>     iovs(block_count);
+  vector<IoRequest> requests(request_count);
+  for (int i = 0; i < request_count; i++) {
+    iovs[2 * i]     = iovec{blocks[2 * i].data(), block_size};
+    iovs[2 * i + 1] = iovec{blocks[2 * i + 1].data(), block_size};
+
+    requests[i].type   = IoRequest::Type::WRITE;
+    requests[i].fd     = fd;
+    requests[i].iov    = &iovs[2 * i];
+    requests[i].iovcnt = 2;
+    requests[i].offset = static_cast<int64_t>(3 * i) * block_size;
+  }
+  ASSERT_EQ(0, backend.submit_and_wait(requests.data(), request_count));
+  for (const IoRequest &request : requests) {
+    ASSERT_EQ(0, request.result);
+  }
+  ASSERT_EQ(0, backend.sync(fd, true));
+
+  vector<string> read_blocks(block_count, string(block_size, 0));
+  for (int i = 0; i < request_count; i++) {
+    iovs[2 * i]     = iovec{read_blocks[2 * i].data(), block_size};
+    iovs[2 * i + 1] = iovec{read_blocks[2 * i + 1].data(), block_size};
+
+    requests[i].type   = IoRequest::Type::READ;
+    requests[i].iov    = &iovs[2 * i];
+    requests[i].iovcnt = 2;
+    requests[i].offset = static_cast<int64_t>(3 * i) * block_size;
+  }
+  ASSERT_EQ(0, backend.submit_and_wait(requests.data(), request_count));
+  for (int i = 0; i < block_count; i++) {
+    ASSERT_EQ(blocks[i], read_blocks[i]);
+  }
+
+  // 中间空出来的块读到的都是0
+  string hole(block_size, 1);
+  ASSERT_EQ(0, backend.read(fd, hole.data(), block_size, 2 * block_size));
+  ASSERT_EQ(string(block_size, 0), hole);
+
+  // 文件最后一块之后没有数据
+  const int64_t file_size = static_cast<int64_t>(3 * (request_count - 1) + 2) * block_size;
+  string        tail(block_size, 0);
+  ASSERT_EQ(0, backend.read(fd, tail.data(), block_size, file_size - block_size));
+  ASSERT_EQ(blocks[block_count - 1], tail);
+  ASSERT_EQ(-1, backend.read(fd, tail.data(), block_size, file_size - block_size / 2));
+  ASSERT_EQ(-1, backend.read(fd, tail.data(), block_size, file_size));
+
+  ::close(fd);
+  filesystem::remove(filename);
+}
+
+TEST(IoBackend, sync)
+{
+  unique_ptr<IoBackend> backend = IoBackend::create("sync");
+  ASSERT_NE(nullptr, backend);
+  test_read_write(*backend);
+}
+
+TEST(IoBackend, io_uring)
+{
+  unique_ptr<IoBackend> backend = IoBackend::create("io_uring");
+  if (!backend) {
+    GTEST_SKIP() << "io_uring is not supported";
+  }
+  test_read_write(*backend);
+}
+
+TEST(IoBackend, init)
+{
+  ASSERT_STREQ("sync", IoBackend::instance().name());
+  ASSERT_NE(0, IoBackend::init("unknown"));
+  ASSERT_STREQ("sync", IoBackend::instance().name());
+  ASSERT_EQ(nullptr, IoBackend::create("unknown"));
+}
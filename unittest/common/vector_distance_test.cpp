@@ -0,0 +1,61 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <math.h>
+
+#include "common/lang/random.h"
+#include "common/lang/vector.h"
+#include "common/math/vector_distance.h"
+#include "gtest/gtest.h"
+
+using namespace common;
+
+TEST(vector_distance, simple)
+{
+  float left[]  = {1, 0, 0};
+  float right[] = {0, 2, 0};
+  ASSERT_FLOAT_EQ(5.0f, l2_distance_square(left, right, 3));
+  ASSERT_FLOAT_EQ(sqrtf(5.0f), l2_distance(left, right, 3));
+  ASSERT_FLOAT_EQ(0.0f, inner_product(left, right, 3));
+  ASSERT_FLOAT_EQ(1.0f, cosine_distance(left, right, 3));
+  ASSERT_NEAR(0.0f, cosine_distance(left, left, 3), 1e-6);
+
+  float zero[] = {0, 0, 0};
+  ASSERT_FLOAT_EQ(1.0f, cosine_distance(left, zero, 3));
+}
+
+// 各种维度，包括不是8的倍数的维度，都要和标量的计算结果一致
+TEST(vector_distance, compare_with_scalar)
+{
+  mt19937                         random(1);
+  uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+  for (int dim = 1; dim <= 67; dim++) {
+    vector<float> left(dim);
+    vector<float> right(dim);
+    for (int i = 0; i < dim; i++) {
+      left[i]  = distribution(random);
+      right[i] = distribution(random);
+    }
+
+    double l2 = 0, dot = 0, left_norm = 0, right_norm = 0;
+    for (int i = 0; i < dim; i++) {
+      l2 += (left[i] - right[i]) * (left[i] - right[i]);
+      dot += left[i] * right[i];
+      left_norm += left[i] * left[i];
+      right_norm += right[i] * right[i];
+    }
+
+    ASSERT_NEAR(l2, l2_distance_square(left.data(), right.data(), dim), 1e-4) << "dim=" << dim;
+    ASSERT_NEAR(sqrt(l2), l2_distance(left.data(), right.data(), dim), 1e-4) << "dim=" << dim;
+    ASSERT_NEAR(dot, inner_product(left.data(), right.data(), dim), 1e-4) << "dim=" << dim;
+    ASSERT_NEAR(1 - dot / sqrt(left_norm * right_norm), cosine_distance(left.data(), right.data(), dim), 1e-4)
+        << "dim=" << dim;
+  }
+}
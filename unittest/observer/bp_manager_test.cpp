@@ -125,6 +125,60 @@ TEST(test_frame_manager, test_frame_manager_simple_lru)
   frame_manager.cleanup();
 }
 
+TEST(test_frame_manager, test_frame_manager_scan_resistant)
+{
+  // 一个分片，方便确定淘汰的顺序
+  BPFrameManager frame_manager("Test");
+  ASSERT_EQ(RC::SUCCESS, frame_manager.init(1, 1 /*shard_num*/));
+
+  const int buffer_pool_id = 0;
+  const int hot_page_num   = 8;
+  for (PageNum page_num = 0; page_num < hot_page_num; page_num++) {
+    Frame *frame = frame_manager.alloc(buffer_pool_id, page_num);
+    ASSERT_NE(frame, nullptr);
+    frame->unpin();
+
+    // 再次访问，成为热点页面
+    ASSERT_EQ(frame, frame_manager.get(buffer_pool_id, page_num));
+    frame->unpin();
+  }
+
+  // 模拟一次全表扫描，每个页面只访问一次，直到内存用完
+  PageNum page_num = hot_page_num;
+  while (true) {
+    Frame *frame = frame_manager.alloc(buffer_pool_id, page_num);
+    if (frame == nullptr) {
+      break;
+    }
+    frame->unpin();
+    page_num++;
+  }
+
+  // 扫描继续进行，需要不断地淘汰页面，同时热点页面还在被访问。被淘汰的应该都是扫描的页面
+  auto purger = [](Frame *) { return RC::SUCCESS; };
+  for (int i = 0; i < 1000; i++, page_num++) {
+    ASSERT_EQ(1, frame_manager.purge_frames(1, purger));
+    Frame *frame = frame_manager.alloc(buffer_pool_id, page_num);
+    ASSERT_NE(frame, nullptr);
+    frame->unpin();
+
+    Frame *hot_frame = frame_manager.get(buffer_pool_id, i % hot_page_num);
+    ASSERT_NE(hot_frame, nullptr);
+    hot_frame->unpin();
+  }
+
+  for (PageNum hot_page = 0; hot_page < hot_page_num; hot_page++) {
+    Frame *frame = frame_manager.get(buffer_pool_id, hot_page);
+    ASSERT_NE(frame, nullptr);
+    frame->unpin();
+  }
+
+  for (Frame *frame : frame_manager.find_list(buffer_pool_id)) {
+    ASSERT_EQ(RC::SUCCESS, frame_manager.free(buffer_pool_id, frame->page_num(), frame));
+  }
+  ASSERT_EQ(RC::SUCCESS, frame_manager.cleanup());
+}
+
 int main(int argc, char **argv)
 {
 
@@ -0,0 +1,154 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "common/lang/algorithm.h"
+#include "common/lang/filesystem.h"
+#include "common/lang/memory.h"
+#include "common/lang/random.h"
+#include "common/lang/vector.h"
+#include "common/log/log.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "storage/buffer/double_write_buffer.h"
+#include "storage/clog/vacuous_log_handler.h"
+#include "storage/common/external_sorter.h"
+#include "storage/index/bplus_tree.h"
+#include "storage/index/bplus_tree_bulk_loader.h"
+#include "gtest/gtest.h"
+
+using namespace common;
+
+TEST(ExternalSorter, spill_and_merge)
+{
+  filesystem::path test_directory("external_sorter");
+  filesystem::remove_all(test_directory);
+  filesystem::create_directory(test_directory);
+  filesystem::path spill_file = test_directory / "test.sort";
+
+  auto comparator = [](const char *left, const char *right) {
+    return *(const int *)left - *(const int *)right;
+  };
+
+  const int   num = 10000;
+  vector<int> values(num);
+  mt19937     random(0);
+  for (int &value : values) {
+    value = static_cast<int>(random() % 1000);
+  }
+
+  {
+    // 内存足够时不写临时文件
+    ExternalSorter sorter(sizeof(int), comparator, spill_file.string(), 1024 * 1024);
+    for (int value : values) {
+      ASSERT_EQ(RC::SUCCESS, sorter.add((const char *)&value));
+    }
+    ASSERT_EQ(RC::SUCCESS, sorter.finish());
+    ASSERT_EQ(0, sorter.run_num());
+    ASSERT_FALSE(filesystem::exists(spill_file));
+  }
+
+  vector<int> expected = values;
+  sort(expected.begin(), expected.end());
+
+  ExternalSorter sorter(sizeof(int), comparator, spill_file.string(), 4096);
+  for (int value : values) {
+    ASSERT_EQ(RC::SUCCESS, sorter.add((const char *)&value));
+  }
+  ASSERT_EQ(RC::SUCCESS, sorter.finish());
+  ASSERT_GT(sorter.run_num(), 1);
+  ASSERT_EQ(num, sorter.item_num());
+
+  const char *item = nullptr;
+  for (int i = 0; i < num; i++) {
+    ASSERT_EQ(RC::SUCCESS, sorter.next(item));
+    ASSERT_EQ(expected[i], *(const int *)item);
+  }
+  ASSERT_EQ(RC::RECORD_EOF, sorter.next(item));
+}
+
+TEST(BplusTreeBulkLoader, build_and_modify)
+{
+  filesystem::path test_directory("bplus_tree_bulk_loader");
+  filesystem::path index_file = test_directory / "test.btree";
+  filesystem::remove_all(test_directory);
+  filesystem::create_directory(test_directory);
+
+  VacuousLogHandler log_handler;
+  BufferPoolManager bpm;
+  ASSERT_EQ(RC::SUCCESS, bpm.init(make_unique<VacuousDoubleWriteBuffer>()));
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(index_file.c_str()));
+
+  DiskBufferPool *buffer_pool = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, index_file.c_str(), buffer_pool));
+
+  const int        order = 8;
+  BplusTreeHandler handler;
+  ASSERT_EQ(RC::SUCCESS, handler.create(log_handler, *buffer_pool, AttrType::INTS, sizeof(int), order, order));
+
+  // 每个键值重复3次，乱序加入。validate_tree 会pin住所有页面，树不能超过缓冲池的大小
+  const int              key_num = 1000;
+  vector<pair<int, RID>> entries;
+  for (int i = 0; i < key_num * 3; i++) {
+    entries.emplace_back(i / 3, RID(i / 100 + 1, i % 100));
+  }
+  shuffle(entries.begin(), entries.end(), mt19937(0));
+
+  {
+    BplusTreeBulkLoader loader(handler, (test_directory / "test.sort").string(), 4096, 0.75f);
+    for (auto &[key, rid] : entries) {
+      ASSERT_EQ(RC::SUCCESS, loader.add((const char *)&key, rid));
+    }
+    ASSERT_EQ(RC::SUCCESS, loader.finish());
+  }
+  ASSERT_FALSE(handler.is_empty());
+  ASSERT_TRUE(handler.validate_tree());
+
+  for (int key = 0; key < key_num; key += 7) {
+    list<RID> rids;
+    ASSERT_EQ(RC::SUCCESS, handler.get_entry((const char *)&key, sizeof(key), rids));
+    ASSERT_EQ(3, static_cast<int>(rids.size()));
+  }
+
+  // 批量构建的树仍然可以正常插入和删除
+  for (int i = 0; i < key_num; i++) {
+    const int key = key_num + i;
+    const RID rid(1000, i);
+    ASSERT_EQ(RC::SUCCESS, handler.insert_entry((const char *)&key, &rid));
+  }
+  ASSERT_TRUE(handler.validate_tree());
+
+  for (auto &[key, rid] : entries) {
+    if (key % 2 == 0) {
+      ASSERT_EQ(RC::SUCCESS, handler.delete_entry((const char *)&key, &rid));
+    }
+  }
+  ASSERT_TRUE(handler.validate_tree());
+
+  int       count = 0;
+  RID       rid;
+  BplusTreeScanner scanner(handler);
+  ASSERT_EQ(RC::SUCCESS, scanner.open(nullptr, 0, false, nullptr, 0, false));
+  while (RC::SUCCESS == scanner.next_entry(rid)) {
+    count++;
+  }
+  scanner.close();
+  ASSERT_EQ(key_num / 2 * 3 + key_num, count);
+
+  // 非空的树不能再批量构建
+  BplusTreeBulkLoader loader(handler, (test_directory / "test2.sort").string());
+  ASSERT_EQ(RC::SUCCESS, loader.add((const char *)&count, rid));
+  ASSERT_NE(RC::SUCCESS, loader.finish());
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  LoggerFactory::init_default("bplus_tree_bulk_loader_test.log", LOG_LEVEL_INFO);
+  return RUN_ALL_TESTS();
+}
@@ -17,8 +17,11 @@ See the Mulan PSL v2 for more details. */
 #include <filesystem>
 
 #include "common/log/log.h"
+#include "common/lang/algorithm.h"
 #include "common/lang/memory.h"
 #include "common/lang/filesystem.h"
+#include "common/lang/random.h"
+#include "common/lang/vector.h"
 #include "sql/parser/parse_defs.h"
 #include "storage/buffer/disk_buffer_pool.h"
 #include "storage/index/bplus_tree.h"
@@ -568,6 +571,341 @@ TEST(test_bplus_tree, test_chars)
   ASSERT_EQ(2, count);
 }
 
+TEST(test_bplus_tree, test_compressed_internal_node)
+{
+  filesystem::path test_directory("bplus_tree");
+  filesystem::remove_all(test_directory);
+  filesystem::create_directories(test_directory);
+
+  filesystem::path buffer_pool_file = test_directory / "test_compressed_internal_node.bp";
+
+  const int attr_length = 64;
+
+  VacuousLogHandler log_handler;
+  BufferPoolManager bpm;
+  ASSERT_EQ(RC::SUCCESS, bpm.init(make_unique<VacuousDoubleWriteBuffer>()));
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(buffer_pool_file.c_str()));
+
+  DiskBufferPool *buffer_pool = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, buffer_pool_file.c_str(), buffer_pool));
+  ASSERT_NE(nullptr, buffer_pool);
+
+  BplusTreeHandler tree_handler;
+  ASSERT_EQ(RC::SUCCESS, tree_handler.create(log_handler, *buffer_pool, AttrType::CHARS, attr_length));
+  const IndexFileHeader &index_file_header = tree_handler.file_header();
+  const int              key_length        = index_file_header.key_length;
+  BplusTreeMiniTransaction mtr(tree_handler);
+
+  KeyComparator key_comparator;
+  key_comparator.init(AttrType::CHARS, attr_length);
+
+  Frame frame;
+  InternalIndexNodeHandler internal_node(mtr, index_file_header, &frame);
+  internal_node.init_empty();
+
+  auto make_key = [key_length](int i) {
+    vector<char> key(key_length, 0);
+    snprintf(key.data(), key.size(), "warehouse/district/customer/%08d", i);
+    return key;
+  };
+
+  // 所有的键值都有公共的前缀，并且后面的0都不需要存储
+  vector<char> low_key  = make_key(0);
+  vector<char> high_key = make_key(100000000 - 1);
+  ASSERT_EQ(RC::SUCCESS, internal_node.create_new_root(0, make_key(1).data(), 1));
+  ASSERT_EQ(RC::SUCCESS, internal_node.set_fence(low_key.data(), high_key.data()));
+  internal_node.set_key_at(0, low_key.data());
+
+  int num = 2;
+  for (; internal_node.can_insert(make_key(num).data()); num++) {
+    ASSERT_EQ(RC::SUCCESS, internal_node.insert(make_key(num).data(), num, key_comparator));
+  }
+  ASSERT_EQ(num, internal_node.size());
+  ASSERT_GT(num, 2 * InternalIndexNodeHandler::min_item_num(key_length));
+
+  for (int i = 1; i < num; i++) {
+    ASSERT_EQ(0, memcmp(make_key(i).data(), internal_node.key_at(i), key_length));
+    ASSERT_EQ(i, internal_node.value_at(i));
+
+    bool found = false;
+    ASSERT_EQ(i, internal_node.lookup(key_comparator, make_key(i).data(), &found));
+    ASSERT_TRUE(found);
+  }
+
+  // 范围变大之后前缀变短，页面放不下这么多元素了
+  vector<char> other_key(key_length, 0);
+  snprintf(other_key.data(), other_key.size(), "x");
+  ASSERT_FALSE(internal_node.can_set_key_at(num - 1, other_key.data()));
+  ASSERT_TRUE(internal_node.can_set_key_at(num - 1, make_key(num).data()));
+}
+
+TEST(test_bplus_tree, test_chars_with_common_prefix)
+{
+  LoggerFactory::init_default("test_chars.log");
+
+  VacuousLogHandler log_handler;
+
+  filesystem::path test_directory("bplus_tree");
+  filesystem::path buffer_pool_file = test_directory / "chars_prefix.btree";
+  filesystem::remove_all(test_directory);
+  filesystem::create_directory(test_directory);
+
+  BufferPoolManager bpm;
+  ASSERT_EQ(RC::SUCCESS, bpm.init(make_unique<VacuousDoubleWriteBuffer>()));
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(buffer_pool_file.c_str()));
+
+  DiskBufferPool *buffer_pool = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, buffer_pool_file.c_str(), buffer_pool));
+  ASSERT_NE(nullptr, buffer_pool);
+
+  // 叶子节点很小，内部节点使用默认大小，保证有多层内部节点
+  const int        attr_length = 48;
+  BplusTreeHandler handler;
+  ASSERT_EQ(RC::SUCCESS, handler.create(log_handler, *buffer_pool, AttrType::CHARS, attr_length, -1, 4));
+
+  const int num = 6000;
+  vector<int> values(num);
+  for (int i = 0; i < num; i++) {
+    values[i] = i;
+  }
+  shuffle(values.begin(), values.end(), mt19937(0));
+
+  char key[attr_length];
+  auto make_key = [&key](int i) {
+    memset(key, 0, sizeof(key));
+    snprintf(key, sizeof(key), "/usr/local/share/miniob/%c/%06d", 'a' + i % 3, i);
+    return key;
+  };
+
+  for (int i : values) {
+    const RID rid(i / 100, i % 100);
+    ASSERT_EQ(RC::SUCCESS, handler.insert_entry(make_key(i), &rid));
+  }
+  ASSERT_TRUE(handler.validate_tree());
+
+  for (int i = 0; i < num; i += 7) {
+    list<RID> rids;
+    ASSERT_EQ(RC::SUCCESS, handler.get_entry(make_key(i), strlen(key), rids));
+    ASSERT_EQ(1, static_cast<int>(rids.size()));
+    ASSERT_EQ(RID(i / 100, i % 100), rids.front());
+  }
+
+  for (int i : values) {
+    if (i % 4 != 0) {
+      const RID rid(i / 100, i % 100);
+      ASSERT_EQ(RC::SUCCESS, handler.delete_entry(make_key(i), &rid));
+    }
+  }
+  ASSERT_TRUE(handler.validate_tree());
+
+  int count = 0;
+  RID rid;
+  BplusTreeScanner scanner(handler);
+  ASSERT_EQ(RC::SUCCESS, scanner.open(nullptr, 0, false, nullptr, 0, false));
+  while (RC::SUCCESS == scanner.next_entry(rid)) {
+    count++;
+  }
+  scanner.close();
+  ASSERT_EQ(num / 4, count);
+}
+
+TEST(test_bplus_tree, test_reverse_scanner)
+{
+  LoggerFactory::init_default("test_reverse.log");
+
+  VacuousLogHandler log_handler;
+
+  filesystem::path test_directory("bplus_tree");
+  filesystem::path buffer_pool_file = test_directory / "reverse.btree";
+  filesystem::remove_all(test_directory);
+  filesystem::create_directory(test_directory);
+
+  BufferPoolManager bpm;
+  ASSERT_EQ(RC::SUCCESS, bpm.init(make_unique<VacuousDoubleWriteBuffer>()));
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(buffer_pool_file.c_str()));
+
+  DiskBufferPool *buffer_pool = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, buffer_pool_file.c_str(), buffer_pool));
+  ASSERT_NE(nullptr, buffer_pool);
+
+  // 有公共前缀的字符串，内部节点的键值会被截断，反向扫描找前一个叶子节点时需要处理这种情况
+  const int        attr_length = 32;
+  BplusTreeHandler handler;
+  ASSERT_EQ(RC::SUCCESS, handler.create(log_handler, *buffer_pool, AttrType::CHARS, attr_length, -1, 4));
+
+  char key[attr_length];
+  auto make_key = [&key](int i) {
+    memset(key, 0, sizeof(key));
+    snprintf(key, sizeof(key), "/data/miniob/%06d", i);
+    return key;
+  };
+
+  // 每个键值有两条数据，删除一部分以后叶子节点不是满的
+  const int   num = 3000;
+  vector<int> values;
+  for (int i = 0; i < num; i++) {
+    values.push_back(i);
+    values.push_back(i);
+  }
+  shuffle(values.begin(), values.end(), mt19937(0));
+  vector<int> slots(num, 0);
+  for (int i : values) {
+    const RID rid(i, slots[i]++);
+    ASSERT_EQ(RC::SUCCESS, handler.insert_entry(make_key(i), &rid));
+  }
+  for (int i = 0; i < num; i += 3) {
+    const RID rid(i, 0);
+    ASSERT_EQ(RC::SUCCESS, handler.delete_entry(make_key(i), &rid));
+  }
+  ASSERT_TRUE(handler.validate_tree());
+
+  auto scan = [&handler](const char *left, bool left_inclusive, const char *right, bool right_inclusive,
+                  bool reverse) {
+    vector<RID>      rids;
+    BplusTreeScanner scanner(handler);
+    EXPECT_EQ(RC::SUCCESS,
+        scanner.open(left, left ? strlen(left) : 0, left_inclusive, right, right ? strlen(right) : 0, right_inclusive,
+            reverse));
+    RID rid;
+    while (RC::SUCCESS == scanner.next_entry(rid)) {
+      rids.push_back(rid);
+    }
+    scanner.close();
+    return rids;
+  };
+
+  auto check = [&scan](const char *left, bool left_inclusive, const char *right, bool right_inclusive) {
+    vector<RID> forward = scan(left, left_inclusive, right, right_inclusive, false);
+    vector<RID> reverse = scan(left, left_inclusive, right, right_inclusive, true);
+    std::reverse(reverse.begin(), reverse.end());
+    EXPECT_EQ(forward, reverse);
+    return static_cast<int>(forward.size());
+  };
+
+  // 键值是3的倍数的数据删除了一条
+  ASSERT_EQ(5000, check(nullptr, false, nullptr, false));
+
+  string left_key(make_key(1000));
+  string right_key(make_key(2000));
+  ASSERT_EQ(1669, check(left_key.c_str(), true, right_key.c_str(), true));
+  ASSERT_EQ(1665, check(left_key.c_str(), false, right_key.c_str(), false));
+  ASSERT_EQ(1666, check(nullptr, false, left_key.c_str(), false));
+  ASSERT_EQ(1665, check(right_key.c_str(), false, nullptr, false));
+  ASSERT_EQ(1, check(make_key(999), true, make_key(999), true));
+  ASSERT_EQ(0, check("/data/miniob/999999", true, nullptr, false));
+  ASSERT_EQ(0, check(nullptr, false, "/data", true));
+
+  // 反向扫描的第一条数据是范围内的最大值
+  vector<RID> rids = scan(nullptr, false, left_key.c_str(), true, true);
+  ASSERT_FALSE(rids.empty());
+  ASSERT_EQ(1000, rids[0].page_num);
+}
+
+TEST(test_bplus_tree, test_composite_key)
+{
+  LoggerFactory::init_default("test_composite.log");
+
+  VacuousLogHandler log_handler;
+
+  filesystem::path test_directory("bplus_tree");
+  filesystem::path buffer_pool_file = test_directory / "composite.btree";
+  filesystem::remove_all(test_directory);
+  filesystem::create_directory(test_directory);
+
+  BufferPoolManager bpm;
+  ASSERT_EQ(RC::SUCCESS, bpm.init(make_unique<VacuousDoubleWriteBuffer>()));
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(buffer_pool_file.c_str()));
+
+  DiskBufferPool *buffer_pool = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, buffer_pool_file.c_str(), buffer_pool));
+  ASSERT_NE(nullptr, buffer_pool);
+
+  // 键值是 (int, char(8))，先按照整数排序，再按照字符串排序
+  const int        chars_length = 8;
+  const int        attr_length  = sizeof(int) + chars_length;
+  BplusTreeHandler handler;
+  ASSERT_EQ(RC::SUCCESS,
+      handler.create(log_handler, *buffer_pool, {AttrType::INTS, AttrType::CHARS}, {static_cast<int>(sizeof(int)), chars_length}, 8, 8));
+  ASSERT_EQ(2, handler.file_header().attr_num);
+  ASSERT_EQ(attr_length, handler.file_header().attr_length);
+
+  const int group_num = 50;
+  const int group_size = 20;
+  vector<int> values(group_num * group_size);
+  for (int i = 0; i < static_cast<int>(values.size()); i++) {
+    values[i] = i;
+  }
+  shuffle(values.begin(), values.end(), mt19937(0));
+
+  // 字符串部分与整数部分的顺序相反，只比较字符串或者只比较整数都会得到错误的顺序
+  char key[attr_length];
+  auto make_key = [&key](int i) {
+    const int group = i % group_num;
+    memset(key, 0, sizeof(key));
+    memcpy(key, &group, sizeof(group));
+    snprintf(key + sizeof(int), chars_length, "k%05d", (group_size * group_num - i) % 100000);
+    return key;
+  };
+
+  for (int i : values) {
+    const RID rid(i / 100 + 1, i % 100);
+    ASSERT_EQ(RC::SUCCESS, handler.insert_entry(make_key(i), &rid));
+  }
+  ASSERT_TRUE(handler.validate_tree());
+
+  for (int i = 0; i < static_cast<int>(values.size()); i += 7) {
+    list<RID> rids;
+    ASSERT_EQ(RC::SUCCESS, handler.get_entry(make_key(i), attr_length, rids));
+    ASSERT_EQ(1, static_cast<int>(rids.size()));
+    ASSERT_EQ(RID(i / 100 + 1, i % 100), rids.front());
+  }
+
+  // 只指定第一个字段，后面的字段使用最小值和最大值
+  const int group = 7;
+  char      left_key[attr_length];
+  char      right_key[attr_length];
+  memcpy(left_key, &group, sizeof(group));
+  memset(left_key + sizeof(int), 0, chars_length);
+  memcpy(right_key, &group, sizeof(group));
+  memset(right_key + sizeof(int), 0xff, chars_length);
+
+  {
+    BplusTreeScanner scanner(handler);
+    ASSERT_EQ(RC::SUCCESS, scanner.open(left_key, attr_length, true, right_key, attr_length, true));
+    int         count    = 0;
+    string      last_str;
+    RID         rid;
+    const char *user_key = nullptr;
+    while (RC::SUCCESS == scanner.next_entry(rid, user_key)) {
+      ASSERT_EQ(group, *reinterpret_cast<const int *>(user_key));
+      string str(user_key + sizeof(int), strnlen(user_key + sizeof(int), chars_length));
+      ASSERT_LT(last_str, str);
+      last_str = str;
+      count++;
+    }
+    scanner.close();
+    ASSERT_EQ(group_size, count);
+  }
+
+  for (int i : values) {
+    if (i % 3 != 0) {
+      const RID rid(i / 100 + 1, i % 100);
+      ASSERT_EQ(RC::SUCCESS, handler.delete_entry(make_key(i), &rid));
+    }
+  }
+  ASSERT_TRUE(handler.validate_tree());
+
+  // 从元数据页面中读出每个字段的信息
+  BplusTreeHandler reopened_handler;
+  ASSERT_EQ(RC::SUCCESS, reopened_handler.open(log_handler, *buffer_pool));
+  ASSERT_EQ(2, reopened_handler.file_header().attr_num);
+  for (int i = 0; i < static_cast<int>(values.size()); i += 3) {
+    list<RID> rids;
+    ASSERT_EQ(RC::SUCCESS, reopened_handler.get_entry(make_key(i), attr_length, rids));
+    ASSERT_EQ(1, static_cast<int>(rids.size()));
+  }
+}
+
 TEST(test_bplus_tree, test_scanner)
 {
   LoggerFactory::init_default("test.log");
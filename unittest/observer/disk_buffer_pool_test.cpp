@@ -19,6 +19,7 @@ See the Mulan PSL v2 for more details. */
 #include "storage/buffer/disk_buffer_pool.h"
 #include "storage/clog/vacuous_log_handler.h"
 #include "storage/buffer/double_write_buffer.h"
+#include "storage/buffer/read_ahead.h"
 
 using namespace std;
 using namespace common;
@@ -132,6 +133,236 @@ TEST(BufferPool, create)
   ASSERT_EQ(buffer_pool->id(), buffer_pool2->id());
 }
 
+TEST(BufferPoolManager, flush_dirty_pages)
+{
+  /*
+  检查点按照recLSN从小到大刷新脏页，没有刷新的脏页中最小的recLSN就是检查点能推进到的位置
+  */
+  filesystem::path test_directory("buffer_pool");
+  filesystem::path bp_file = test_directory / "flush_dirty_pages.bp";
+  filesystem::remove_all(test_directory);
+  filesystem::create_directory(test_directory);
+
+  BufferPoolManager bpm;
+  ASSERT_EQ(RC::SUCCESS, bpm.init(make_unique<VacuousDoubleWriteBuffer>()));
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(bp_file.c_str()));
+
+  VacuousLogHandler log_handler;
+  DiskBufferPool   *buffer_pool = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, bp_file.c_str(), buffer_pool));
+
+  const int page_num = 10;
+  for (int i = 0; i < page_num; i++) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->allocate_page(&frame));
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->unpin_page(frame));
+  }
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->flush_all_pages());
+
+  // 页面编号越大，第一次修改的LSN越小。每个页面修改两次，recLSN是第一次修改的LSN
+  const LSN base_lsn = 1000;
+  for (PageNum page = 1; page <= page_num; page++) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->get_this_page(page, &frame));
+    frame->set_lsn(base_lsn - page);
+    frame->set_lsn(base_lsn + page);
+    frame->mark_dirty();
+    ASSERT_EQ(base_lsn - page, frame->rec_lsn());
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->unpin_page(frame));
+  }
+
+  const int flush_count = 3;
+  LSN       min_rec_lsn = numeric_limits<LSN>::max();
+  ASSERT_EQ(RC::SUCCESS, bpm.flush_dirty_pages(flush_count, min_rec_lsn));
+  ASSERT_EQ(base_lsn - (page_num - flush_count), min_rec_lsn);
+
+  vector<pair<PageNum, LSN>> dirty_pages;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->collect_dirty_pages(dirty_pages));
+  ASSERT_EQ(page_num - flush_count, static_cast<int>(dirty_pages.size()));
+  for (auto &[page, rec_lsn] : dirty_pages) {
+    ASSERT_LE(page, page_num - flush_count);
+    ASSERT_EQ(base_lsn - page, rec_lsn);
+  }
+
+  // 全部刷新后没有脏页，不会限制检查点
+  min_rec_lsn = numeric_limits<LSN>::max();
+  ASSERT_EQ(RC::SUCCESS, bpm.flush_dirty_pages(-1, min_rec_lsn));
+  ASSERT_EQ(numeric_limits<LSN>::max(), min_rec_lsn);
+  dirty_pages.clear();
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->collect_dirty_pages(dirty_pages));
+  ASSERT_TRUE(dirty_pages.empty());
+
+  ASSERT_EQ(RC::SUCCESS, bpm.close_file(bp_file.c_str()));
+}
+
+TEST(BufferPoolManager, page_cleaner)
+{
+  /*
+  1. 用很小的内存创建buffer pool manager，分配页面直到空闲页帧低于水位线，页面都是脏页
+  2. 清理一轮，脏页写回磁盘后淘汰，空闲页帧回到水位线之上
+  3. 重新打开文件检查页面内容
+  */
+  filesystem::path test_directory("buffer_pool");
+  filesystem::path bp_file    = test_directory / "page_cleaner.bp";
+  filesystem::path dblwr_file = test_directory / "page_cleaner.dblwr";
+  filesystem::remove_all(test_directory);
+  filesystem::create_directory(test_directory);
+
+  const int         memory_size = DEFAULT_ITEM_NUM_PER_POOL * BP_PAGE_SIZE;
+  BufferPoolManager bpm(memory_size);
+  auto              dblwr_buffer = make_unique<DiskDoubleWriteBuffer>(bpm);
+  ASSERT_EQ(RC::SUCCESS, dblwr_buffer->open_file(dblwr_file.c_str()));
+  ASSERT_EQ(RC::SUCCESS, bpm.init(std::move(dblwr_buffer)));
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(bp_file.c_str()));
+
+  VacuousLogHandler log_handler;
+  DiskBufferPool   *buffer_pool = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, bp_file.c_str(), buffer_pool));
+
+  BPFrameManager &frame_manager = bpm.get_frame_manager();
+  const int       total_frames  = static_cast<int>(frame_manager.total_frame_num());
+  const int       low_watermark = total_frames / 4;
+  const int       page_num      = total_frames - low_watermark / 2;
+  for (int i = 1; i < page_num; i++) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->allocate_page(&frame));
+    ASSERT_EQ(i, frame->page_num());
+    snprintf(frame->data(), BP_PAGE_DATA_SIZE, "page %d", i);
+    frame->mark_dirty();
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->unpin_page(frame));
+  }
+  ASSERT_LT(static_cast<int>(frame_manager.free_frame_num()), low_watermark);
+
+  PageCleaner &page_cleaner = bpm.page_cleaner();
+  page_cleaner.clean(low_watermark);
+  ASSERT_GE(static_cast<int>(frame_manager.free_frame_num()), low_watermark);
+  ASSERT_GT(page_cleaner.stat().flushed_pages.load(), 0);
+  ASSERT_GE(page_cleaner.stat().freed_frames.load(), page_cleaner.stat().flushed_pages.load());
+  ASSERT_EQ(0, page_cleaner.stat().foreground_stalls.load());
+
+  ASSERT_EQ(RC::SUCCESS, bpm.close_file(bp_file.c_str()));
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, bp_file.c_str(), buffer_pool));
+  for (int i = 1; i < page_num; i++) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->get_this_page(i, &frame));
+    ASSERT_EQ(string("page ") + std::to_string(i), string(frame->data()));
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->unpin_page(frame));
+  }
+  ASSERT_EQ(RC::SUCCESS, bpm.close_file(bp_file.c_str()));
+}
+
+TEST(BufferPoolManager, read_ahead)
+{
+  /*
+  1. 创建文件并写入一些页面，重新打开文件，这时页面都不在内存中
+  2. 从第一个页面开始预读，预读的页面都在内存中，并且内容正确
+  3. 顺序访问页面，连续几次向后访问之后开始预读
+  */
+  filesystem::path test_directory("buffer_pool");
+  filesystem::path bp_file = test_directory / "read_ahead.bp";
+  filesystem::remove_all(test_directory);
+  filesystem::create_directory(test_directory);
+
+  BufferPoolManager bpm;
+  ASSERT_EQ(RC::SUCCESS, bpm.init(make_unique<VacuousDoubleWriteBuffer>()));
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(bp_file.c_str()));
+
+  VacuousLogHandler log_handler;
+  DiskBufferPool   *buffer_pool = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, bp_file.c_str(), buffer_pool));
+
+  const int page_num = 3 * ReadAhead::DEFAULT_WINDOW;
+  for (int i = 1; i < page_num; i++) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->allocate_page(&frame));
+    snprintf(frame->data(), BP_PAGE_DATA_SIZE, "page %d", i);
+    frame->mark_dirty();
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->unpin_page(frame));
+  }
+  ASSERT_EQ(RC::SUCCESS, bpm.close_file(bp_file.c_str()));
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, bp_file.c_str(), buffer_pool));
+
+  BPFrameManager &frame_manager = bpm.get_frame_manager();
+  const int       bp_id         = buffer_pool->id();
+  ASSERT_FALSE(frame_manager.contains(bp_id, 1));
+
+  PageNum end_page = -1;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->read_ahead(1, 10, end_page));
+  ASSERT_EQ(11, end_page);
+  for (int i = 1; i < end_page; i++) {
+    ASSERT_TRUE(frame_manager.contains(bp_id, i));
+  }
+  ASSERT_FALSE(frame_manager.contains(bp_id, end_page));
+
+  Frame *frame = nullptr;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->get_this_page(5, &frame));
+  ASSERT_EQ(string("page 5"), string(frame->data()));
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->unpin_page(frame));
+
+  ReadAhead read_ahead;
+  read_ahead.init(*buffer_pool);
+  for (int i = 1; i < page_num; i++) {
+    read_ahead.on_access(i);
+    if (i <= ReadAhead::SEQUENTIAL_THRESHOLD) {
+      ASSERT_EQ(0, read_ahead.read_ahead_count());
+    }
+    ASSERT_TRUE(frame_manager.contains(bp_id, i)) << "page " << i;
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->get_this_page(i, &frame));
+    ASSERT_EQ(string("page ") + std::to_string(i), string(frame->data()));
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->unpin_page(frame));
+  }
+  ASSERT_GT(read_ahead.read_ahead_count(), 1);
+
+  ASSERT_EQ(RC::SUCCESS, bpm.close_file(bp_file.c_str()));
+}
+
+TEST(BufferPoolManager, prefetch_pages)
+{
+  // 预读不连续的页面，没有分配的页面被忽略
+  filesystem::path test_directory("buffer_pool");
+  filesystem::path bp_file = test_directory / "prefetch.bp";
+  filesystem::remove_all(test_directory);
+  filesystem::create_directory(test_directory);
+
+  BufferPoolManager bpm;
+  ASSERT_EQ(RC::SUCCESS, bpm.init(make_unique<VacuousDoubleWriteBuffer>()));
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(bp_file.c_str()));
+
+  VacuousLogHandler log_handler;
+  DiskBufferPool   *buffer_pool = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, bp_file.c_str(), buffer_pool));
+
+  for (int i = 1; i < 40; i++) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->allocate_page(&frame));
+    snprintf(frame->data(), BP_PAGE_DATA_SIZE, "page %d", i);
+    frame->mark_dirty();
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->unpin_page(frame));
+  }
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->dispose_page(20));
+  ASSERT_EQ(RC::SUCCESS, bpm.close_file(bp_file.c_str()));
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, bp_file.c_str(), buffer_pool));
+
+  BPFrameManager &frame_manager = bpm.get_frame_manager();
+  const int       bp_id         = buffer_pool->id();
+
+  const vector<PageNum> pages = {30, 7, 31, 20, 1000};
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->prefetch_pages(pages));
+  ASSERT_TRUE(frame_manager.contains(bp_id, 7));
+  ASSERT_TRUE(frame_manager.contains(bp_id, 30));
+  ASSERT_TRUE(frame_manager.contains(bp_id, 31));
+  ASSERT_FALSE(frame_manager.contains(bp_id, 8));
+  ASSERT_FALSE(frame_manager.contains(bp_id, 20));
+  ASSERT_FALSE(frame_manager.contains(bp_id, 1000));
+
+  Frame *frame = nullptr;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->get_this_page(31, &frame));
+  ASSERT_EQ(string("page 31"), string(frame->data()));
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->unpin_page(frame));
+
+  ASSERT_EQ(RC::SUCCESS, bpm.close_file(bp_file.c_str()));
+}
+
 int main(int argc, char **argv)
 {
   testing::InitGoogleTest(&argc, argv);
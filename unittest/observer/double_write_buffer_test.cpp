@@ -12,7 +12,9 @@ See the Mulan PSL v2 for more details. */
 // Created by wangyunlai on 2024/04/19
 //
 
+#include <fcntl.h>
 #include <filesystem>
+#include <unistd.h>
 
 #include "gtest/gtest.h"
 
@@ -21,6 +23,8 @@ See the Mulan PSL v2 for more details. */
 #include "storage/clog/vacuous_log_handler.h"
 #include "storage/clog/disk_log_handler.h"
 #include "storage/clog/integrated_log_replayer.h"
+#include "common/io/io.h"
+#include "common/math/crc.h"
 
 using namespace std;
 using namespace common;
@@ -201,6 +205,99 @@ TEST(DoubleWriteBuffer, single_file_exception)
   bpm  = nullptr;
 }
 
+TEST(DoubleWriteBuffer, torn_pages)
+{
+  /*
+  模拟一批页面写入共享文件并落盘后，写数据文件时宕机，数据文件中的页面只写了一半
+  1. 不使用double write buffer写入第一个版本的页面
+  2. 修改页面，通过double write buffer刷盘
+  3. 恢复共享文件的文件头，相当于这一批页面还没有写完，再把数据文件中的页面改坏
+  4. 重启后恢复，数据文件中的页面是第二个版本
+  */
+  filesystem::path directory("double_write_buffer_test_torn_pages_dir");
+  filesystem::remove_all(directory);
+  filesystem::create_directories(directory);
+
+  filesystem::path buffer_pool_filename         = directory / "buffer_pool.bp";
+  filesystem::path double_write_buffer_filename = directory / "double_write_buffer.dwb";
+
+  const int         page_num = 20;
+  VacuousLogHandler log_handler;
+  DiskBufferPool   *buffer_pool = nullptr;
+
+  auto bpm = make_unique<BufferPoolManager>();
+  ASSERT_EQ(RC::SUCCESS, bpm->init(make_unique<VacuousDoubleWriteBuffer>()));
+  ASSERT_EQ(RC::SUCCESS, bpm->create_file(buffer_pool_filename.c_str()));
+  ASSERT_EQ(RC::SUCCESS, bpm->open_file(log_handler, buffer_pool_filename.c_str(), buffer_pool));
+  for (int i = 1; i <= page_num; i++) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->allocate_page(&frame));
+    snprintf(frame->data(), BP_PAGE_DATA_SIZE, "page %d version 1", i);
+    frame->mark_dirty();
+    frame->unpin();
+  }
+  bpm = nullptr;
+
+  bpm                      = make_unique<BufferPoolManager>();
+  auto double_write_buffer = make_unique<DiskDoubleWriteBuffer>(*bpm, page_num + 1);
+  ASSERT_EQ(RC::SUCCESS, double_write_buffer->open_file(double_write_buffer_filename.c_str()));
+  ASSERT_EQ(RC::SUCCESS, bpm->init(std::move(double_write_buffer)));
+  ASSERT_EQ(RC::SUCCESS, bpm->open_file(log_handler, buffer_pool_filename.c_str(), buffer_pool));
+  for (int i = 1; i <= page_num; i++) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->get_this_page(i, &frame));
+    snprintf(frame->data(), BP_PAGE_DATA_SIZE, "page %d version 2", i);
+    frame->mark_dirty();
+    frame->unpin();
+  }
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->flush_all_pages());
+  ASSERT_EQ(RC::SUCCESS, bpm->get_dblwr_buffer()->flush_page());
+  bpm = nullptr;
+
+  // 共享文件中只写过一批页面，恢复文件头中的页面数
+  const int64_t dblwr_file_size = filesystem::file_size(double_write_buffer_filename);
+  ASSERT_EQ(0, (dblwr_file_size - DoubleWriteBufferHeader::SIZE) % DoubleWritePage::SIZE);
+  const int32_t batch_page_cnt = (dblwr_file_size - DoubleWriteBufferHeader::SIZE) / DoubleWritePage::SIZE;
+  ASSERT_GE(batch_page_cnt, page_num);
+
+  int fd = ::open(double_write_buffer_filename.c_str(), O_RDWR);
+  ASSERT_GE(fd, 0);
+  DoubleWriteBufferHeader header;
+  ASSERT_EQ(0, preadn(fd, &header, sizeof(header), 0));
+  ASSERT_EQ(0, header.page_cnt);
+  header.page_cnt = batch_page_cnt;
+  ASSERT_EQ(0, pwriten(fd, &header, sizeof(header), 0));
+  ::close(fd);
+
+  // 数据文件中页面的后一半没有写入
+  fd = ::open(buffer_pool_filename.c_str(), O_RDWR);
+  ASSERT_GE(fd, 0);
+  const string garbage(BP_PAGE_SIZE / 2, 'x');
+  for (int i = 1; i <= page_num; i++) {
+    ASSERT_EQ(0, pwriten(fd, garbage.data(), garbage.size(), static_cast<int64_t>(i) * BP_PAGE_SIZE + BP_PAGE_SIZE / 2));
+
+    Page page;
+    ASSERT_EQ(0, preadn(fd, &page, sizeof(page), static_cast<int64_t>(i) * BP_PAGE_SIZE));
+    ASSERT_NE(page.check_sum, crc32(page.data, BP_PAGE_DATA_SIZE));
+  }
+
+  bpm                 = make_unique<BufferPoolManager>();
+  double_write_buffer = make_unique<DiskDoubleWriteBuffer>(*bpm);
+  ASSERT_EQ(RC::SUCCESS, double_write_buffer->open_file(double_write_buffer_filename.c_str()));
+  ASSERT_EQ(RC::SUCCESS, bpm->init(std::move(double_write_buffer)));
+  ASSERT_EQ(RC::SUCCESS, bpm->open_file(log_handler, buffer_pool_filename.c_str(), buffer_pool));
+  ASSERT_EQ(RC::SUCCESS, static_cast<DiskDoubleWriteBuffer *>(bpm->get_dblwr_buffer())->recover());
+
+  for (int i = 1; i <= page_num; i++) {
+    Page page;
+    ASSERT_EQ(0, preadn(fd, &page, sizeof(page), static_cast<int64_t>(i) * BP_PAGE_SIZE));
+    ASSERT_EQ(page.check_sum, crc32(page.data, BP_PAGE_DATA_SIZE));
+    ASSERT_EQ(string("page ") + std::to_string(i) + " version 2", string(page.data));
+  }
+  ::close(fd);
+  bpm = nullptr;
+}
+
 int main(int argc, char **argv)
 {
   testing::InitGoogleTest(&argc, argv);
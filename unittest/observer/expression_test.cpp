@@ -334,6 +334,31 @@ TEST(AggregateExpr, aggregate_expr_test)
   ASSERT_EQ(RC::INVALID_ARGUMENT, AggregateExpr::type_from_string("invalid type", aggr_type));
 }
 
+TEST(AggregateExpr, min_max_test)
+{
+  AggregateExpr max_expr(AggregateExpr::Type::MAX, make_unique<ValueExpr>(Value(1)));
+  AggregateExpr min_expr(AggregateExpr::Type::MIN, make_unique<ValueExpr>(Value(1)));
+  auto          max_aggregator = max_expr.create_aggregator();
+  auto          min_aggregator = min_expr.create_aggregator();
+  for (int i : {5, -3, 42, 7, -3, 0}) {
+    ASSERT_EQ(RC::SUCCESS, max_aggregator->accumulate(Value(i)));
+    ASSERT_EQ(RC::SUCCESS, min_aggregator->accumulate(Value(i)));
+  }
+
+  Value result;
+  ASSERT_EQ(RC::SUCCESS, max_aggregator->evaluate(result));
+  ASSERT_EQ(42, result.get_int());
+  ASSERT_EQ(RC::SUCCESS, min_aggregator->evaluate(result));
+  ASSERT_EQ(-3, result.get_int());
+
+  auto string_aggregator = max_expr.create_aggregator();
+  for (const char *s : {"apple", "pear", "banana"}) {
+    ASSERT_EQ(RC::SUCCESS, string_aggregator->accumulate(Value(s)));
+  }
+  ASSERT_EQ(RC::SUCCESS, string_aggregator->evaluate(result));
+  ASSERT_EQ("pear", result.to_string());
+}
+
 int main(int argc, char **argv)
 {
 
@@ -0,0 +1,241 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <filesystem>
+
+#include "common/lang/algorithm.h"
+#include "common/log/log.h"
+#include "sql/parser/parse_defs.h"
+#include "storage/clog/log_handler.h"
+#include "storage/db/db.h"
+#include "storage/index/hash_index.h"
+#include "storage/table/table.h"
+#include "storage/trx/vacuous_trx.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace common;
+
+class HashIndexTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    filesystem::remove_all(test_path_);
+    filesystem::create_directories(db_path_);
+    open_db(db_path_);
+
+    AttrInfoSqlNode attrs[] = {{AttrType::INTS, "id", 4}, {AttrType::CHARS, "name", 16}};
+    ASSERT_EQ(RC::SUCCESS, db_->create_table("t", attrs, {}));
+    table_ = db_->find_table("t");
+    ASSERT_NE(nullptr, table_);
+  }
+
+  void TearDown() override
+  {
+    db_.reset();
+    filesystem::remove_all(test_path_);
+  }
+
+  void open_db(const filesystem::path &path)
+  {
+    table_ = nullptr;
+    db_    = make_unique<Db>();
+    ASSERT_EQ(RC::SUCCESS, db_->init(path.filename().c_str(), path.c_str(), "vacuous", "disk"));
+    table_ = db_->find_table("t");
+  }
+
+  void create_index(const char *name, const vector<const char *> &field_names)
+  {
+    vector<const FieldMeta *> fields;
+    for (const char *field_name : field_names) {
+      fields.push_back(table_->table_meta().field(field_name));
+    }
+
+    IndexMeta  index_meta;
+    VacuousTrx trx;
+    ASSERT_EQ(RC::SUCCESS, index_meta.init(name, fields, IndexType::HASH, {}));
+    ASSERT_EQ(RC::SUCCESS, table_->create_index(&trx, fields, index_meta));
+  }
+
+  HashIndex *index(const char *name) { return static_cast<HashIndex *>(table_->find_index(name)); }
+
+  /// 插入一条记录。name 结束符后面的内容故意填上垃圾数据，索引应该忽略它们
+  RID insert_record(int id, const char *name)
+  {
+    Record record;
+    EXPECT_EQ(RC::SUCCESS, record.new_record(table_->table_meta().record_size()));
+    const FieldMeta *id_field   = table_->table_meta().field("id");
+    const FieldMeta *name_field = table_->table_meta().field("name");
+    memcpy(record.data() + id_field->offset(), &id, sizeof(id));
+    memset(record.data() + name_field->offset(), 'x', name_field->len());
+    memcpy(record.data() + name_field->offset(), name, strlen(name) + 1);
+    EXPECT_EQ(RC::SUCCESS, table_->insert_record(record));
+    return record.rid();
+  }
+
+  vector<RID> lookup(HashIndex *hash_index, const char *key, int key_len)
+  {
+    vector<RID>   rids;
+    IndexScanner *scanner = hash_index->create_scanner(key, key_len, true, key, key_len, true);
+    EXPECT_NE(nullptr, scanner);
+    if (scanner == nullptr) {
+      return rids;
+    }
+
+    RID rid;
+    while (OB_SUCC(scanner->next_entry(&rid))) {
+      rids.push_back(rid);
+    }
+    scanner->destroy();
+    return rids;
+  }
+
+  vector<RID> lookup(HashIndex *hash_index, int id)
+  {
+    return lookup(hash_index, reinterpret_cast<const char *>(&id), sizeof(id));
+  }
+
+protected:
+  filesystem::path test_path_ = "hash_index_test_dir";
+  filesystem::path db_path_   = test_path_ / "db";
+  unique_ptr<Db>   db_;
+  Table           *table_ = nullptr;
+};
+
+TEST_F(HashIndexTest, insert_delete_reopen)
+{
+  // 先插入一部分数据再建索引，建好以后继续插入，每个键值有两条数据
+  const int key_num = 5000;
+  vector<vector<RID>> expected(key_num);
+  for (int i = 0; i < key_num; i++) {
+    expected[i].push_back(insert_record(i, "a"));
+  }
+  create_index("id_hash", {"id"});
+  for (int i = 0; i < key_num; i++) {
+    expected[i].push_back(insert_record(i, "b"));
+  }
+
+  HashIndex *hash_index = index("id_hash");
+  ASSERT_NE(nullptr, hash_index);
+  ASSERT_GT(hash_index->global_depth(), 0);
+
+  auto check = [&](HashIndex *hash_index) {
+    for (int i = 0; i < key_num; i++) {
+      vector<RID> rids = lookup(hash_index, i);
+      ASSERT_TRUE(is_permutation(rids.begin(), rids.end(), expected[i].begin(), expected[i].end())) << "key=" << i;
+    }
+    ASSERT_TRUE(lookup(hash_index, key_num).empty());
+  };
+  check(hash_index);
+
+  // 删除偶数键值的第一条数据
+  for (int i = 0; i < key_num; i += 2) {
+    Record record;
+    ASSERT_EQ(RC::SUCCESS, table_->get_record(expected[i][0], record));
+    ASSERT_EQ(RC::SUCCESS, table_->delete_record(record));
+    expected[i].erase(expected[i].begin());
+  }
+  check(hash_index);
+
+  ASSERT_EQ(RC::SUCCESS, db_->sync());
+  open_db(db_path_);
+  hash_index = index("id_hash");
+  ASSERT_NE(nullptr, hash_index);
+  check(hash_index);
+}
+
+TEST_F(HashIndexTest, duplicate_and_string_keys)
+{
+  create_index("name_hash", {"name"});
+  create_index("id_name_hash", {"id", "name"});
+
+  // 相同键值的数据很多时，分裂不起作用，使用溢出页面
+  const int   dup_num = 2000;
+  vector<RID> dup_rids;
+  for (int i = 0; i < dup_num; i++) {
+    dup_rids.push_back(insert_record(i, "same"));
+  }
+  RID other_rid = insert_record(dup_num, "other");
+
+  HashIndex *name_index = index("name_hash");
+  ASSERT_NE(nullptr, name_index);
+  ASSERT_EQ(0, name_index->global_depth());
+
+  // 单个字符串字段的查询条件没有补齐到字段的长度
+  vector<RID> rids = lookup(name_index, "same", 4);
+  ASSERT_TRUE(is_permutation(rids.begin(), rids.end(), dup_rids.begin(), dup_rids.end()));
+  rids = lookup(name_index, "other", 5);
+  ASSERT_EQ(1, static_cast<int>(rids.size()));
+  ASSERT_EQ(other_rid, rids[0]);
+  ASSERT_TRUE(lookup(name_index, "sam", 3).empty());
+  ASSERT_TRUE(lookup(name_index, "a string longer than field", 26).empty());
+
+  // 多个字段的索引使用完整的键值
+  HashIndex *id_name_index = index("id_name_hash");
+  ASSERT_NE(nullptr, id_name_index);
+  char key[20] = {0};
+  int  id      = 7;
+  memcpy(key, &id, sizeof(id));
+  strcpy(key + sizeof(id), "same");
+  rids = lookup(id_name_index, key, sizeof(key));
+  ASSERT_EQ(1, static_cast<int>(rids.size()));
+  ASSERT_EQ(dup_rids[7], rids[0]);
+
+  // 不支持范围查找
+  ASSERT_EQ(nullptr, name_index->create_scanner("a", 1, true, "b", 1, true));
+}
+
+TEST_F(HashIndexTest, recover)
+{
+  create_index("id_hash", {"id"});
+  const int   key_num = 3000;
+  vector<RID> rids;
+  for (int i = 0; i < key_num; i++) {
+    rids.push_back(insert_record(i, "a"));
+  }
+  ASSERT_EQ(RC::SUCCESS, db_->sync());
+
+  // 删除偶数键值。索引页面还没有写到磁盘，只有日志写到了磁盘。复制所有文件模拟宕机，在新目录中恢复
+  for (int i = 0; i < key_num; i += 2) {
+    Record record;
+    ASSERT_EQ(RC::SUCCESS, table_->get_record(rids[i], record));
+    ASSERT_EQ(RC::SUCCESS, table_->delete_record(record));
+  }
+
+  LogHandler &log_handler = db_->log_handler();
+  ASSERT_EQ(RC::SUCCESS, log_handler.wait_lsn(log_handler.current_lsn()));
+
+  filesystem::path db_path2 = test_path_ / "db2";
+  filesystem::copy(db_path_, db_path2, filesystem::copy_options::recursive);
+  db_.reset();
+
+  open_db(db_path2);
+  HashIndex *hash_index = index("id_hash");
+  ASSERT_NE(nullptr, hash_index);
+  ASSERT_GT(hash_index->global_depth(), 0);
+  for (int i = 0; i < key_num; i++) {
+    vector<RID> result = lookup(hash_index, i);
+    if (i % 2 == 0) {
+      ASSERT_TRUE(result.empty()) << "key=" << i;
+    } else {
+      ASSERT_EQ(1, static_cast<int>(result.size())) << "key=" << i;
+      ASSERT_EQ(rids[i], result[0]);
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  filesystem::path log_filename = filesystem::path(argv[0]).filename();
+  LoggerFactory::init_default(log_filename.string() + ".log", LOG_LEVEL_INFO);
+  return RUN_ALL_TESTS();
+}
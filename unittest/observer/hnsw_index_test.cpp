@@ -0,0 +1,233 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <filesystem>
+
+#include "common/lang/algorithm.h"
+#include "common/lang/random.h"
+#include "common/lang/thread.h"
+#include "common/math/vector_distance.h"
+#include "sql/parser/parse_defs.h"
+#include "storage/db/db.h"
+#include "storage/index/hnsw_index.h"
+#include "storage/table/table.h"
+#include "storage/trx/vacuous_trx.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace common;
+
+static constexpr int DIMENSION = 16;
+
+class HnswIndexTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    filesystem::remove_all(db_path_);
+    filesystem::create_directories(db_path_);
+    open_db();
+
+    AttrInfoSqlNode attrs[] = {{AttrType::INTS, "id", 4}, {AttrType::VECTORS, "v", DIMENSION * sizeof(float)}};
+    ASSERT_EQ(RC::SUCCESS, db_->create_table("t", attrs, {}));
+    table_ = db_->find_table("t");
+    ASSERT_NE(nullptr, table_);
+  }
+
+  void TearDown() override
+  {
+    db_.reset();
+    filesystem::remove_all(db_path_);
+  }
+
+  void open_db()
+  {
+    db_ = make_unique<Db>();
+    ASSERT_EQ(RC::SUCCESS, db_->init("hnsw", db_path_, "vacuous", "vacuous"));
+  }
+
+  void insert_records(int num)
+  {
+    uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+    const FieldMeta *v_field = table_->table_meta().field("v");
+    for (int i = 0; i < num; i++) {
+      Record record;
+      ASSERT_EQ(RC::SUCCESS, record.new_record(table_->table_meta().record_size()));
+      auto *vec = reinterpret_cast<float *>(record.data() + v_field->offset());
+      for (int d = 0; d < DIMENSION; d++) {
+        vec[d] = distribution(random_);
+      }
+      ASSERT_EQ(RC::SUCCESS, table_->insert_record(record));
+      vectors_.emplace_back(record.rid(), vector<float>(vec, vec + DIMENSION));
+    }
+  }
+
+  RC create_index(const map<string, string> &params)
+  {
+    const FieldMeta *v_field = table_->table_meta().field("v");
+    IndexMeta        index_meta;
+    RC               rc = index_meta.init("v_index", {v_field}, IndexType::HNSW, params);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+    VacuousTrx trx;
+    return table_->create_index(&trx, {v_field}, index_meta);
+  }
+
+  HnswIndex *index() { return static_cast<HnswIndex *>(table_->find_index("v_index")); }
+
+  vector<RID> brute_force(const vector<float> &query, size_t limit)
+  {
+    vector<pair<float, RID>> distances;
+    for (auto &[rid, vec] : vectors_) {
+      distances.emplace_back(l2_distance(vec.data(), query.data(), DIMENSION), rid);
+    }
+    sort(distances.begin(), distances.end(), [](const pair<float, RID> &left, const pair<float, RID> &right) {
+      return left.first < right.first;
+    });
+
+    vector<RID> result;
+    for (size_t i = 0; i < limit && i < distances.size(); i++) {
+      result.push_back(distances[i].second);
+    }
+    return result;
+  }
+
+  /// 随机查询 query_num 次，返回 top 10 的平均召回率
+  double recall(int query_num)
+  {
+    mt19937                          random(4);
+    uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+    int hit = 0;
+    for (int i = 0; i < query_num; i++) {
+      vector<float> query(DIMENSION);
+      for (float &value : query) {
+        value = distribution(random);
+      }
+
+      vector<RID> expected = brute_force(query, 10);
+      for (const RID &rid : index()->ann_search(query, 10)) {
+        hit += find(expected.begin(), expected.end(), rid) != expected.end() ? 1 : 0;
+      }
+    }
+    return static_cast<double>(hit) / (query_num * 10);
+  }
+
+protected:
+  const char                      *db_path_ = "hnsw_index_test_db";
+  unique_ptr<Db>                   db_;
+  Table                           *table_ = nullptr;
+  vector<pair<RID, vector<float>>> vectors_;
+  mt19937                          random_{3};
+};
+
+TEST_F(HnswIndexTest, invalid_params)
+{
+  ASSERT_EQ(RC::INVALID_ARGUMENT, create_index({{"distance", "hamming"}}));
+  ASSERT_EQ(RC::INVALID_ARGUMENT, create_index({{"m", "1"}}));
+  ASSERT_EQ(RC::INVALID_ARGUMENT, create_index({{"m", "16"}, {"ef_construction", "8"}}));
+  ASSERT_EQ(RC::INVALID_ARGUMENT, create_index({{"ef_search", "0"}}));
+}
+
+TEST_F(HnswIndexTest, search)
+{
+  // 一部分数据在创建索引之前插入，一部分在之后插入
+  insert_records(1000);
+  ASSERT_EQ(RC::SUCCESS, create_index({{"m", "8"}, {"ef_construction", "64"}, {"ef_search", "16"}}));
+  insert_records(2000);
+
+  index()->set_ef_search(16);
+  const double low_recall = recall(50);
+  index()->set_ef_search(200);
+  const double high_recall = recall(50);
+  ASSERT_GE(high_recall, 0.95);
+  ASSERT_GE(high_recall, low_recall);
+
+  // 精确查找自己
+  for (int i = 0; i < 50; i++) {
+    vector<RID> result = index()->ann_search(vectors_[i * 37].second, 1);
+    ASSERT_EQ(1, result.size());
+    ASSERT_EQ(vectors_[i * 37].first, result[0]);
+  }
+}
+
+TEST_F(HnswIndexTest, delete_reopen)
+{
+  ASSERT_EQ(RC::SUCCESS, create_index({{"ef_search", "100"}}));
+  insert_records(2000);
+
+  // 删除一半的数据，删除的数据不会出现在结果中
+  for (size_t i = 0; i < vectors_.size(); i += 2) {
+    Record record;
+    ASSERT_EQ(RC::SUCCESS, table_->get_record(vectors_[i].first, record));
+    ASSERT_EQ(RC::SUCCESS, table_->delete_record(record));
+  }
+  vector<pair<RID, vector<float>>> remain;
+  for (size_t i = 1; i < vectors_.size(); i += 2) {
+    remain.push_back(vectors_[i]);
+  }
+  vectors_.swap(remain);
+
+  const double before = recall(50);
+  ASSERT_GE(before, 0.9);
+
+  vector<float> query = vectors_[5].second;
+  vector<RID>   expected = index()->ann_search(query, 20);
+
+  // 重新打开后图的结构不变，结果完全一样
+  ASSERT_EQ(RC::SUCCESS, db_->sync());
+  db_.reset();
+  open_db();
+  table_ = db_->find_table("t");
+  ASSERT_NE(nullptr, table_);
+  ASSERT_NE(nullptr, index());
+  index()->set_ef_search(100);
+  ASSERT_EQ(expected, index()->ann_search(query, 20));
+  ASSERT_EQ(before, recall(50));
+}
+
+#ifdef CONCURRENCY
+TEST_F(HnswIndexTest, concurrent_insert)
+{
+  ASSERT_EQ(RC::SUCCESS, create_index({{"ef_search", "100"}}));
+
+  const int thread_num     = 4;
+  const int num_per_thread = 1000;
+  const int record_size    = table_->table_meta().record_size();
+  const int offset         = table_->table_meta().field("v")->offset();
+
+  mt19937                          random(5);
+  uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+  vector<vector<char>>             records(thread_num * num_per_thread, vector<char>(record_size));
+  for (int i = 0; i < thread_num * num_per_thread; i++) {
+    auto *vec = reinterpret_cast<float *>(records[i].data() + offset);
+    for (int d = 0; d < DIMENSION; d++) {
+      vec[d] = distribution(random);
+    }
+    vectors_.emplace_back(RID(i / 100 + 1, i % 100), vector<float>(vec, vec + DIMENSION));
+  }
+
+  vector<thread> threads;
+  for (int t = 0; t < thread_num; t++) {
+    threads.emplace_back([&, t]() {
+      for (int i = t * num_per_thread; i < (t + 1) * num_per_thread; i++) {
+        ASSERT_EQ(RC::SUCCESS, index()->insert_entry(records[i].data(), &vectors_[i].first));
+      }
+    });
+  }
+  for (thread &t : threads) {
+    t.join();
+  }
+
+  ASSERT_GE(recall(50), 0.9);
+}
+#endif
@@ -0,0 +1,200 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <filesystem>
+
+#include "common/lang/algorithm.h"
+#include "common/lang/random.h"
+#include "common/math/vector_distance.h"
+#include "sql/parser/parse_defs.h"
+#include "storage/db/db.h"
+#include "storage/index/ivfflat_index.h"
+#include "storage/table/table.h"
+#include "storage/trx/vacuous_trx.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace common;
+
+static constexpr int DIMENSION = 12;
+
+class IvfflatIndexTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    filesystem::remove_all(db_path_);
+    filesystem::create_directories(db_path_);
+    open_db();
+
+    AttrInfoSqlNode attrs[] = {{AttrType::INTS, "id", 4}, {AttrType::VECTORS, "v", DIMENSION * sizeof(float)}};
+    ASSERT_EQ(RC::SUCCESS, db_->create_table("t", attrs, {}));
+    table_ = db_->find_table("t");
+    ASSERT_NE(nullptr, table_);
+  }
+
+  void TearDown() override
+  {
+    db_.reset();
+    filesystem::remove_all(db_path_);
+  }
+
+  void open_db()
+  {
+    db_ = make_unique<Db>();
+    ASSERT_EQ(RC::SUCCESS, db_->init("ivfflat", db_path_, "vacuous", "vacuous"));
+  }
+
+  /// 数据分布在几个簇中，簇的中心离得比较远
+  void insert_records(int num)
+  {
+    mt19937                          random(2);
+    uniform_real_distribution<float> center_distribution(-10.0f, 10.0f);
+    normal_distribution<float>       noise(0.0f, 0.5f);
+
+    vector<float> centers(8 * DIMENSION);
+    for (float &value : centers) {
+      value = center_distribution(random);
+    }
+
+    const FieldMeta *id_field = table_->table_meta().field("id");
+    const FieldMeta *v_field  = table_->table_meta().field("v");
+    for (int i = 0; i < num; i++) {
+      Record record;
+      ASSERT_EQ(RC::SUCCESS, record.new_record(table_->table_meta().record_size()));
+      memcpy(record.data() + id_field->offset(), &i, sizeof(i));
+
+      auto        *vec    = reinterpret_cast<float *>(record.data() + v_field->offset());
+      const float *center = centers.data() + (i % 8) * DIMENSION;
+      for (int d = 0; d < DIMENSION; d++) {
+        vec[d] = center[d] + noise(random);
+      }
+      ASSERT_EQ(RC::SUCCESS, table_->insert_record(record));
+      vectors_.emplace_back(record.rid(), vector<float>(vec, vec + DIMENSION));
+    }
+  }
+
+  RC create_index(const map<string, string> &params)
+  {
+    const FieldMeta *v_field = table_->table_meta().field("v");
+    IndexMeta        index_meta;
+    RC               rc = index_meta.init("v_index", {v_field}, IndexType::IVFFLAT, params);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+    VacuousTrx trx;
+    return table_->create_index(&trx, {v_field}, index_meta);
+  }
+
+  /// 暴力计算最近的 limit 条数据
+  vector<RID> brute_force(const vector<float> &query, size_t limit)
+  {
+    vector<pair<float, RID>> distances;
+    for (auto &[rid, vec] : vectors_) {
+      distances.emplace_back(l2_distance(vec.data(), query.data(), DIMENSION), rid);
+    }
+    sort(distances.begin(), distances.end(), [](const pair<float, RID> &left, const pair<float, RID> &right) {
+      return left.first < right.first;
+    });
+
+    vector<RID> result;
+    for (size_t i = 0; i < limit && i < distances.size(); i++) {
+      result.push_back(distances[i].second);
+    }
+    return result;
+  }
+
+  static int overlap(const vector<RID> &left, const vector<RID> &right)
+  {
+    int count = 0;
+    for (const RID &rid : left) {
+      count += find(right.begin(), right.end(), rid) != right.end() ? 1 : 0;
+    }
+    return count;
+  }
+
+protected:
+  const char                       *db_path_ = "ivfflat_index_test_db";
+  unique_ptr<Db>                    db_;
+  Table                            *table_ = nullptr;
+  vector<pair<RID, vector<float>>> vectors_;
+};
+
+TEST_F(IvfflatIndexTest, invalid_params)
+{
+  ASSERT_EQ(RC::INVALID_ARGUMENT, create_index({{"distance", "hamming"}}));
+  ASSERT_EQ(RC::INVALID_ARGUMENT, create_index({{"lists", "4"}, {"probes", "5"}}));
+  ASSERT_EQ(RC::INVALID_ARGUMENT, create_index({{"lists", "abc"}}));
+}
+
+TEST_F(IvfflatIndexTest, search)
+{
+  insert_records(2000);
+  ASSERT_EQ(RC::SUCCESS, create_index({{"lists", "8"}, {"probes", "8"}}));
+
+  auto *index = static_cast<IvfflatIndex *>(table_->find_index("v_index"));
+  ASSERT_NE(nullptr, index);
+  ASSERT_EQ(8, index->centroid_num());
+
+  // 查询所有的列表时结果和暴力计算一样
+  for (int i = 0; i < 20; i++) {
+    const vector<float> &query = vectors_[i * 97].second;
+    ASSERT_EQ(brute_force(query, 10), index->ann_search(query, 10));
+  }
+
+  // 只查询一个列表时，簇分得很开，召回率也很高
+  index->set_probes(1);
+  int hit = 0;
+  for (int i = 0; i < 20; i++) {
+    const vector<float> &query = vectors_[i * 97].second;
+    hit += overlap(brute_force(query, 10), index->ann_search(query, 10));
+  }
+  ASSERT_GE(hit, 180);
+}
+
+TEST_F(IvfflatIndexTest, insert_delete_reopen)
+{
+  // 空表上创建索引，数据都放在一个列表中
+  ASSERT_EQ(RC::SUCCESS, create_index({{"lists", "4"}, {"distance", "l2_distance"}}));
+  insert_records(1500);
+
+  auto *index = static_cast<IvfflatIndex *>(table_->find_index("v_index"));
+  ASSERT_NE(nullptr, index);
+  ASSERT_EQ(0, index->centroid_num());
+
+  const vector<float> query = vectors_[7].second;
+  ASSERT_EQ(brute_force(query, 20), index->ann_search(query, 20));
+
+  // 删除一半的数据，会释放一些页面
+  for (size_t i = 0; i < vectors_.size(); i += 2) {
+    Record record;
+    ASSERT_EQ(RC::SUCCESS, table_->get_record(vectors_[i].first, record));
+    ASSERT_EQ(RC::SUCCESS, table_->delete_record(record));
+  }
+  vector<pair<RID, vector<float>>> remain;
+  for (size_t i = 1; i < vectors_.size(); i += 2) {
+    remain.push_back(vectors_[i]);
+  }
+  vectors_.swap(remain);
+
+  vector<RID> expected = brute_force(query, 20);
+  ASSERT_EQ(expected, index->ann_search(query, 20));
+  ASSERT_EQ(vectors_.size(), index->ann_search(query, 100000).size());
+
+  // 重新打开后索引的数据还在
+  ASSERT_EQ(RC::SUCCESS, db_->sync());
+  db_.reset();
+  open_db();
+  table_ = db_->find_table("t");
+  ASSERT_NE(nullptr, table_);
+  index = static_cast<IvfflatIndex *>(table_->find_index("v_index"));
+  ASSERT_NE(nullptr, index);
+  ASSERT_EQ(expected, index->ann_search(query, 20));
+}
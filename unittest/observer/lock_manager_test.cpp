@@ -0,0 +1,147 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <filesystem>
+
+#include "common/lang/atomic.h"
+#include "common/lang/chrono.h"
+#include "common/lang/thread.h"
+#include "common/log/log.h"
+#include "sql/parser/parse_defs.h"
+#include "storage/db/db.h"
+#include "storage/table/table.h"
+#include "storage/trx/lock_manager.h"
+#include "storage/trx/trx.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace common;
+
+#ifdef CONCURRENCY
+static const RC CONFLICT_RC = RC::LOCKED_TIMEOUT;
+#else
+static const RC CONFLICT_RC = RC::LOCKED_CONCURRENCY_CONFLICT;
+#endif
+
+TEST(LockManager, shared_exclusive)
+{
+  LockManager lock_manager;
+  ASSERT_EQ(RC::SUCCESS, lock_manager.init(10 /*wait_timeout_ms*/, 0 /*deadlock_detect_interval_ms*/));
+
+  const LockKey key1{1, RID(1, 0)};
+  const LockKey key2{1, RID(1, 1)};
+  ASSERT_EQ(RC::SUCCESS, lock_manager.lock(1, key1, LockMode::SHARED));
+  ASSERT_EQ(RC::SUCCESS, lock_manager.lock(2, key1, LockMode::SHARED));
+  ASSERT_EQ(CONFLICT_RC, lock_manager.lock(3, key1, LockMode::EXCLUSIVE));
+  ASSERT_EQ(RC::SUCCESS, lock_manager.lock(3, key2, LockMode::EXCLUSIVE));
+  ASSERT_EQ(RC::SUCCESS, lock_manager.lock(3, key2, LockMode::SHARED));
+  ASSERT_EQ(CONFLICT_RC, lock_manager.lock(1, key2, LockMode::SHARED));
+
+  // 只有自己持有共享锁时可以升级
+  ASSERT_EQ(CONFLICT_RC, lock_manager.lock(1, key1, LockMode::EXCLUSIVE));
+  lock_manager.unlock(2, vector<LockKey>{key1});
+  ASSERT_EQ(RC::SUCCESS, lock_manager.lock(1, key1, LockMode::EXCLUSIVE));
+  ASSERT_EQ(CONFLICT_RC, lock_manager.lock(2, key1, LockMode::SHARED));
+
+  lock_manager.unlock(1, vector<LockKey>{key1, key1});
+  lock_manager.unlock(3, vector<LockKey>{key2});
+  ASSERT_EQ(RC::SUCCESS, lock_manager.lock(2, key1, LockMode::EXCLUSIVE));
+  ASSERT_EQ(RC::SUCCESS, lock_manager.lock(1, key2, LockMode::EXCLUSIVE));
+  ASSERT_EQ(0, lock_manager.detect_deadlock());
+}
+
+#ifdef CONCURRENCY
+TEST(LockManager, wait_and_deadlock)
+{
+  LockManager lock_manager;
+  ASSERT_EQ(RC::SUCCESS, lock_manager.init(10000 /*wait_timeout_ms*/, 0 /*deadlock_detect_interval_ms*/));
+
+  const LockKey key1{1, RID(1, 0)};
+  const LockKey key2{1, RID(1, 1)};
+  ASSERT_EQ(RC::SUCCESS, lock_manager.lock(1, key1, LockMode::EXCLUSIVE));
+  ASSERT_EQ(RC::SUCCESS, lock_manager.lock(2, key2, LockMode::EXCLUSIVE));
+
+  // 事务1等待事务2，事务2再等待事务1，形成死锁。事务2比较年轻，被选为牺牲者
+  atomic<RC> rc1(RC::INTERNAL);
+  atomic<RC> rc2(RC::INTERNAL);
+  thread     waiter1([&]() { rc1 = lock_manager.lock(1, key2, LockMode::EXCLUSIVE); });
+  this_thread::sleep_for(chrono::milliseconds(50));
+  ASSERT_EQ(0, lock_manager.detect_deadlock());
+
+  thread waiter2([&]() {
+    rc2 = lock_manager.lock(2, key1, LockMode::SHARED);
+    lock_manager.unlock(2, vector<LockKey>{key2});
+  });
+
+  int resolved_num = 0;
+  for (int i = 0; i < 100 && resolved_num == 0; i++) {
+    this_thread::sleep_for(chrono::milliseconds(10));
+    resolved_num = lock_manager.detect_deadlock();
+  }
+  ASSERT_EQ(1, resolved_num);
+
+  waiter2.join();
+  waiter1.join();
+  ASSERT_EQ(RC::LOCKED_DEADLOCK, rc2.load());
+  ASSERT_EQ(RC::SUCCESS, rc1.load());
+}
+
+TEST(LockManager, delete_waits_for_lock)
+{
+  filesystem::path test_path("lock_manager_test_dir");
+  filesystem::remove_all(test_path);
+  filesystem::create_directories(test_path);
+
+  auto db = make_unique<Db>();
+  ASSERT_EQ(RC::SUCCESS, db->init("db", test_path.c_str(), "mvcc", "disk"));
+  AttrInfoSqlNode attrs[] = {{AttrType::INTS, "id", 4}};
+  ASSERT_EQ(RC::SUCCESS, db->create_table("t", attrs, {}));
+  Table *table = db->find_table("t");
+  ASSERT_NE(nullptr, table);
+
+  TrxKit &trx_kit = db->trx_kit();
+  Trx    *trx1    = trx_kit.create_trx(db->log_handler());
+  Trx    *trx2    = trx_kit.create_trx(db->log_handler());
+
+  Value  value(1);
+  Record record;
+  ASSERT_EQ(RC::SUCCESS, table->make_record(1, &value, record));
+  ASSERT_EQ(RC::SUCCESS, trx1->start_if_need());
+  ASSERT_EQ(RC::SUCCESS, trx1->insert_record(table, record));
+  ASSERT_EQ(RC::SUCCESS, trx1->commit());
+
+  // 两个事务同时删除同一条记录，后删除的事务等待前面的事务结束，而不是直接失败
+  ASSERT_EQ(RC::SUCCESS, trx1->start_if_need());
+  ASSERT_EQ(RC::SUCCESS, trx2->start_if_need());
+  ASSERT_EQ(RC::SUCCESS, trx1->delete_record(table, record));
+
+  atomic<RC> rc2(RC::INTERNAL);
+  thread     deleter([&]() { rc2 = trx2->delete_record(table, record); });
+  this_thread::sleep_for(chrono::milliseconds(50));
+  ASSERT_EQ(RC::INTERNAL, rc2.load());
+  ASSERT_EQ(RC::SUCCESS, trx1->commit());
+  deleter.join();
+  ASSERT_EQ(RC::SUCCESS, rc2.load());
+  ASSERT_EQ(RC::SUCCESS, trx2->commit());
+
+  trx_kit.destroy_trx(trx1);
+  trx_kit.destroy_trx(trx2);
+  db.reset();
+  filesystem::remove_all(test_path);
+}
+#endif  // CONCURRENCY
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  filesystem::path log_filename = filesystem::path(argv[0]).filename();
+  LoggerFactory::init_default(log_filename.string() + ".log", LOG_LEVEL_INFO);
+  return RUN_ALL_TESTS();
+}
@@ -18,6 +18,8 @@ See the Mulan PSL v2 for more details. */
 #define protected public
 #include "storage/clog/log_buffer.h"
 #include "storage/clog/log_file.h"
+#include "storage/clog/log_entry.h"
+#include "common/lang/thread.h"
 
 using namespace std;
 using namespace common;
@@ -66,6 +68,68 @@ TEST(LogEntryBuffer, test_append)
   filesystem::remove("test_log_entry_buffer.log");
 }
 
+TEST(LogEntryBuffer, test_multi_thread_append)
+{
+  // several threads append log entries while one thread flushes them.
+  // The total size is larger than the buffer, so the ring buffer wraps around several times.
+  const char    *filename = "test_log_entry_buffer_multi_thread.log";
+  LogEntryBuffer buffer;
+  ASSERT_EQ(RC::SUCCESS, buffer.init(0));
+  filesystem::remove(filename);
+
+  const int     thread_num        = 4;
+  const int     entry_per_thread  = 20000;
+  const int32_t total_entry_count = thread_num * entry_per_thread;
+
+  LogFileWriter writer;
+  ASSERT_EQ(RC::SUCCESS, writer.open(filename, total_entry_count));
+
+  atomic<bool> appending{true};
+  thread       flusher([&]() {
+    int count = 0;
+    while (appending.load() || buffer.entry_number() > 0) {
+      ASSERT_EQ(RC::SUCCESS, buffer.flush(writer, count));
+    }
+  });
+
+  vector<thread> appenders;
+  for (int t = 0; t < thread_num; t++) {
+    appenders.emplace_back([&buffer, t]() {
+      for (int i = 0; i < entry_per_thread; i++) {
+        vector<char> data(1 + (i % 512), static_cast<char>('a' + t));
+        LSN          lsn = 0;
+        ASSERT_EQ(RC::SUCCESS, buffer.append(lsn, LogModule::Id::BUFFER_POOL, data));
+      }
+    });
+  }
+
+  for (thread &appender : appenders) {
+    appender.join();
+  }
+  appending.store(false);
+  flusher.join();
+
+  ASSERT_EQ(buffer.current_lsn(), total_entry_count);
+  ASSERT_EQ(buffer.flushed_lsn(), total_entry_count);
+  ASSERT_EQ(buffer.bytes(), 0);
+  writer.close();
+
+  LogFileReader reader;
+  ASSERT_EQ(RC::SUCCESS, reader.open(filename));
+  LSN expected_lsn = 1;
+  ASSERT_EQ(RC::SUCCESS, reader.iterate([&expected_lsn](LogEntry &entry) -> RC {
+    EXPECT_EQ(entry.lsn(), expected_lsn++);
+    EXPECT_GT(entry.payload_size(), 0);
+    for (int i = 1; i < entry.payload_size(); i++) {
+      EXPECT_EQ(entry.data()[i], entry.data()[0]);
+    }
+    return RC::SUCCESS;
+  }));
+  ASSERT_EQ(expected_lsn, total_entry_count + 1);
+  reader.close();
+  filesystem::remove(filename);
+}
+
 int main(int argc, char **argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -295,6 +295,52 @@ TEST(LogFileManager, init_with_files)
   ASSERT_TRUE(filesystem::remove_all(directory));
 }
 
+TEST(LogFileManager, remove_files_before)
+{
+  const char *directory                 = "remove_files_before";
+  int         max_entry_number_per_file = 1000;
+
+  filesystem::remove_all(directory);
+
+  ASSERT_TRUE(filesystem::create_directory(directory));
+
+  LSN lsns[] = {1000, 2000, 3000};
+  for (LSN lsn : lsns) {
+    string   filename = string(LogFileManager::file_prefix_) + to_string(lsn) + LogFileManager::file_suffix_;
+    ofstream ofs(filesystem::path(directory) / filename);
+    ofs.close();
+  }
+
+  LogFileManager manager;
+  ASSERT_EQ(RC::SUCCESS, manager.init(directory, max_entry_number_per_file));
+
+  // 检查点还在第一个文件中，不能删除任何文件
+  int            removed_count = 0;
+  vector<string> result_files;
+  ASSERT_EQ(RC::SUCCESS, manager.remove_files_before(1500, removed_count));
+  ASSERT_EQ(0, removed_count);
+  ASSERT_EQ(RC::SUCCESS, manager.list_files(result_files, 0));
+  ASSERT_EQ(3, result_files.size());
+
+  // 第一个文件的日志都在检查点之前
+  ASSERT_EQ(RC::SUCCESS, manager.remove_files_before(2000, removed_count));
+  ASSERT_EQ(1, removed_count);
+  ASSERT_FALSE(filesystem::exists(filesystem::path(directory) /
+                                  (string(LogFileManager::file_prefix_) + "1000" + LogFileManager::file_suffix_)));
+  ASSERT_EQ(RC::SUCCESS, manager.list_files(result_files, 0));
+  ASSERT_EQ(2, result_files.size());
+
+  // 最后一个文件还要继续写日志，永远不会删除
+  ASSERT_EQ(RC::SUCCESS, manager.remove_files_before(10000, removed_count));
+  ASSERT_EQ(1, removed_count);
+  ASSERT_EQ(RC::SUCCESS, manager.list_files(result_files, 0));
+  ASSERT_EQ(1, result_files.size());
+  ASSERT_EQ(string(LogFileManager::file_prefix_) + "3000" + LogFileManager::file_suffix_,
+      filesystem::path(result_files[0]).filename());
+
+  ASSERT_TRUE(filesystem::remove_all(directory));
+}
+
 TEST(LogFileManager, last_file)
 {
   // create an empty directory and try to open last file
@@ -0,0 +1,216 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <filesystem>
+
+#include "common/lang/atomic.h"
+#include "common/lang/thread.h"
+#include "common/log/log.h"
+#include "sql/parser/parse_defs.h"
+#include "storage/db/db.h"
+#include "storage/record/record_scanner.h"
+#include "storage/table/table.h"
+#include "storage/trx/active_trx_table.h"
+#include "storage/trx/mvcc_trx.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace common;
+
+TEST(ActiveTrxTable, read_view)
+{
+  ActiveTrxTable table;
+  ReadView       view1, view2, view3, view4;
+  int            slot1 = -1, slot2 = -1, slot3 = -1, slot4 = -1;
+
+  const int32_t trx_id1 = table.begin(nullptr, 100 /*begin_lsn*/, slot1, view1);
+  const int32_t trx_id2 = table.begin(nullptr, 200 /*begin_lsn*/, slot2, view2);
+  ASSERT_NE(slot1, slot2);
+  ASSERT_LT(trx_id1, trx_id2);
+  ASSERT_FALSE(view1.is_committed(trx_id2));
+  ASSERT_EQ(100, table.min_begin_lsn());
+
+  // 提交过程中的事务号对新的读视图也是没有提交的
+  const int32_t commit_id = table.begin_commit(slot2);
+  ASSERT_GT(commit_id, trx_id2);
+  table.begin(nullptr, 300 /*begin_lsn*/, slot3, view3);
+  ASSERT_FALSE(view3.is_committed(commit_id));
+  ASSERT_LE(table.low_watermark(), view1.low());
+
+  table.end(slot2);
+  table.begin(nullptr, 400 /*begin_lsn*/, slot4, view4);
+  ASSERT_TRUE(view4.is_committed(commit_id));
+  ASSERT_FALSE(view1.is_committed(commit_id));
+  ASSERT_FALSE(view3.is_committed(commit_id));
+
+  // view3 创建时 commit_id 还在提交过程中，提交完成以后也不能回收 view3 看不到的修改
+  table.end(slot1);
+  ASSERT_LE(table.low_watermark(), view3.low());
+  ASSERT_EQ(300, table.min_begin_lsn());
+
+  table.end(slot3);
+  table.end(slot4);
+  ASSERT_EQ(table.current_trx_id() + 1, table.low_watermark());
+  ASSERT_EQ(-1, table.min_begin_lsn());
+}
+
+class MvccReadViewTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    filesystem::remove_all(test_path_);
+    filesystem::create_directories(test_path_);
+    db_ = make_unique<Db>();
+    ASSERT_EQ(RC::SUCCESS, db_->init("db", test_path_.c_str(), "mvcc", "disk"));
+
+    AttrInfoSqlNode attrs[] = {{AttrType::INTS, "id", 4}};
+    ASSERT_EQ(RC::SUCCESS, db_->create_table("t", attrs, {}));
+    table_ = db_->find_table("t");
+    ASSERT_NE(nullptr, table_);
+  }
+
+  void TearDown() override
+  {
+    table_ = nullptr;
+    db_.reset();
+    filesystem::remove_all(test_path_);
+  }
+
+  Trx *begin_trx()
+  {
+    Trx *trx = db_->trx_kit().create_trx(db_->log_handler());
+    EXPECT_EQ(RC::SUCCESS, trx->start_if_need());
+    return trx;
+  }
+
+  void end_trx(Trx *trx)
+  {
+    EXPECT_EQ(RC::SUCCESS, trx->commit());
+    db_->trx_kit().destroy_trx(trx);
+  }
+
+  RID insert_record(Trx *trx, int id)
+  {
+    Value  values[] = {Value(id)};
+    Record record;
+    EXPECT_EQ(RC::SUCCESS, table_->make_record(1, values, record));
+    EXPECT_EQ(RC::SUCCESS, trx->insert_record(table_, record));
+    return record.rid();
+  }
+
+  RC delete_record(Trx *trx, const RID &rid)
+  {
+    Record record;
+    RC     rc = table_->get_record(rid, record);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+    return trx->delete_record(table_, record);
+  }
+
+  int count_records(Trx *trx)
+  {
+    RecordScanner *scanner = nullptr;
+    EXPECT_EQ(RC::SUCCESS, table_->get_record_scanner(scanner, trx, ReadWriteMode::READ_ONLY));
+
+    int    count = 0;
+    Record record;
+    while (OB_SUCC(scanner->next(record))) {
+      count++;
+    }
+    scanner->close_scan();
+    delete scanner;
+    return count;
+  }
+
+protected:
+  filesystem::path test_path_ = "mvcc_read_view_test_dir";
+  unique_ptr<Db>   db_;
+  Table           *table_ = nullptr;
+};
+
+TEST_F(MvccReadViewTest, snapshot_visibility)
+{
+  Trx *writer = begin_trx();
+  RID  rid1   = insert_record(writer, 1);
+  RID  rid2   = insert_record(writer, 2);
+
+  Trx *reader1 = begin_trx();
+  ASSERT_EQ(2, count_records(writer));
+  ASSERT_EQ(0, count_records(reader1));
+  end_trx(writer);
+
+  // 提交之前开始的事务看不到提交的数据，提交以后开始的可以看到
+  Trx *reader2 = begin_trx();
+  ASSERT_EQ(0, count_records(reader1));
+  ASSERT_EQ(2, count_records(reader2));
+
+  // 删除在 reader2 开始以后提交，reader2 仍然能看到，再删除时按照最新的状态，什么也不做
+  Trx *deleter = begin_trx();
+  ASSERT_EQ(RC::SUCCESS, delete_record(deleter, rid1));
+  end_trx(deleter);
+  ASSERT_EQ(2, count_records(reader2));
+  ASSERT_EQ(RC::SUCCESS, delete_record(reader2, rid1));
+  ASSERT_EQ(RC::SUCCESS, delete_record(reader2, rid2));
+  ASSERT_EQ(1, count_records(reader2));
+
+  Trx *reader3 = begin_trx();
+  ASSERT_EQ(1, count_records(reader3));
+  end_trx(reader2);
+  ASSERT_EQ(1, count_records(reader3));
+  ASSERT_EQ(RC::RECORD_INVISIBLE, delete_record(reader3, rid1));
+
+  end_trx(reader1);
+  end_trx(reader3);
+}
+
+#ifdef CONCURRENCY
+TEST_F(MvccReadViewTest, atomic_commit)
+{
+  // 每个事务插入 batch_size 条数据，任何时候开始的事务看到的数据条数都是 batch_size 的倍数
+  const int    batch_size = 50;
+  const int    batch_num  = 200;
+  atomic<bool> stop(false);
+  thread       writer([&]() {
+    for (int i = 0; i < batch_num; i++) {
+      Trx *trx = begin_trx();
+      for (int j = 0; j < batch_size; j++) {
+        insert_record(trx, i * batch_size + j);
+      }
+      end_trx(trx);
+    }
+    stop.store(true);
+  });
+
+  int check_num = 0;
+  while (!stop.load()) {
+    Trx *trx   = begin_trx();
+    int  count = count_records(trx);
+    end_trx(trx);
+    ASSERT_EQ(0, count % batch_size) << "count=" << count;
+    check_num++;
+  }
+  writer.join();
+  ASSERT_GT(check_num, 0);
+
+  Trx *trx = begin_trx();
+  ASSERT_EQ(batch_size * batch_num, count_records(trx));
+  end_trx(trx);
+}
+#endif  // CONCURRENCY
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  filesystem::path log_filename = filesystem::path(argv[0]).filename();
+  LoggerFactory::init_default(log_filename.string() + ".log", LOG_LEVEL_INFO);
+  return RUN_ALL_TESTS();
+}
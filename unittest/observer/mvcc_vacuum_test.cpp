@@ -0,0 +1,188 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <filesystem>
+
+#include "common/log/log.h"
+#include "sql/parser/parse_defs.h"
+#include "storage/db/db.h"
+#include "storage/index/index.h"
+#include "storage/record/record_scanner.h"
+#include "storage/table/table.h"
+#include "storage/trx/mvcc_trx.h"
+#include "storage/trx/vacuous_trx.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace common;
+
+class MvccVacuumTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    filesystem::remove_all(test_path_);
+    filesystem::create_directories(test_path_);
+    db_ = make_unique<Db>();
+    ASSERT_EQ(RC::SUCCESS, db_->init("db", test_path_.c_str(), "mvcc", "disk"));
+
+    AttrInfoSqlNode attrs[] = {{AttrType::INTS, "id", 4}, {AttrType::INTS, "value", 4}};
+    ASSERT_EQ(RC::SUCCESS, db_->create_table("t", attrs, {}));
+    table_ = db_->find_table("t");
+    ASSERT_NE(nullptr, table_);
+
+    vector<const FieldMeta *> fields{table_->table_meta().field("id")};
+    IndexMeta                 index_meta;
+    VacuousTrx                trx;
+    ASSERT_EQ(RC::SUCCESS, index_meta.init("id_index", fields, IndexType::BPLUS_TREE, {}));
+    ASSERT_EQ(RC::SUCCESS, table_->create_index(&trx, fields, index_meta));
+  }
+
+  void TearDown() override
+  {
+    table_ = nullptr;
+    db_.reset();
+    filesystem::remove_all(test_path_);
+  }
+
+  Trx *begin_trx()
+  {
+    Trx *trx = db_->trx_kit().create_trx(db_->log_handler());
+    EXPECT_EQ(RC::SUCCESS, trx->start_if_need());
+    return trx;
+  }
+
+  void end_trx(Trx *trx, bool commit)
+  {
+    EXPECT_EQ(RC::SUCCESS, commit ? trx->commit() : trx->rollback());
+    db_->trx_kit().destroy_trx(trx);
+  }
+
+  RID insert_record(Trx *trx, int id)
+  {
+    Value  values[] = {Value(id), Value(id * 10)};
+    Record record;
+    EXPECT_EQ(RC::SUCCESS, table_->make_record(2, values, record));
+    EXPECT_EQ(RC::SUCCESS, trx->insert_record(table_, record));
+    return record.rid();
+  }
+
+  void delete_record(Trx *trx, const RID &rid)
+  {
+    Record record;
+    ASSERT_EQ(RC::SUCCESS, table_->get_record(rid, record));
+    ASSERT_EQ(RC::SUCCESS, trx->delete_record(table_, record));
+  }
+
+  /// trx 为空时返回表中所有的记录条数，包括旧版本
+  int count_records(Trx *trx)
+  {
+    RecordScanner *scanner = nullptr;
+    EXPECT_EQ(RC::SUCCESS, table_->get_record_scanner(scanner, trx, ReadWriteMode::READ_ONLY));
+
+    int    count = 0;
+    Record record;
+    while (OB_SUCC(scanner->next(record))) {
+      count++;
+    }
+    scanner->close_scan();
+    delete scanner;
+    return count;
+  }
+
+  int index_entry_num(int id)
+  {
+    const char   *key     = reinterpret_cast<const char *>(&id);
+    IndexScanner *scanner = table_->find_index("id_index")->create_scanner(key, sizeof(id), true, key, sizeof(id), true);
+    EXPECT_NE(nullptr, scanner);
+
+    int count = 0;
+    RID rid;
+    while (OB_SUCC(scanner->next_entry(&rid))) {
+      count++;
+    }
+    scanner->destroy();
+    return count;
+  }
+
+  int vacuum()
+  {
+    EXPECT_EQ(RC::SUCCESS, db_->vacuum());
+    return count_records(nullptr);
+  }
+
+protected:
+  filesystem::path test_path_ = "mvcc_vacuum_test_dir";
+  unique_ptr<Db>   db_;
+  Table           *table_ = nullptr;
+};
+
+TEST_F(MvccVacuumTest, reclaim_invisible_versions)
+{
+  const int   record_num = 4000;
+  vector<RID> rids;
+  Trx        *trx = begin_trx();
+  for (int i = 0; i < record_num; i++) {
+    rids.push_back(insert_record(trx, i));
+  }
+  end_trx(trx, true /*commit*/);
+
+  PageNum max_page_num = 0;
+  for (const RID &rid : rids) {
+    max_page_num = max(max_page_num, rid.page_num);
+  }
+
+  // 删除前一半数据，这样前面的页面会被清空
+  Trx *reader = begin_trx();
+  trx         = begin_trx();
+  for (int i = 0; i < record_num / 2; i++) {
+    delete_record(trx, rids[i]);
+  }
+  end_trx(trx, true /*commit*/);
+
+  // 还在删除没有提交的数据不能回收
+  Trx *deleter = begin_trx();
+  delete_record(deleter, rids[record_num - 1]);
+
+  // 删除之前开始的事务还能看到删除的数据，不能回收
+  ASSERT_EQ(record_num, vacuum());
+  ASSERT_EQ(record_num, count_records(reader));
+  ASSERT_EQ(1, index_entry_num(0));
+
+  end_trx(reader, true /*commit*/);
+  ASSERT_EQ(record_num / 2, vacuum());
+  for (int i = 0; i < record_num; i++) {
+    ASSERT_EQ(i < record_num / 2 ? 0 : 1, index_entry_num(i)) << "id=" << i;
+  }
+
+  end_trx(deleter, false /*commit*/);
+  ASSERT_EQ(record_num / 2, vacuum());
+
+  reader = begin_trx();
+  ASSERT_EQ(record_num / 2, count_records(reader));
+  end_trx(reader, true /*commit*/);
+
+  // 回收的空间可以重新使用
+  trx = begin_trx();
+  for (int i = 0; i < record_num / 2; i++) {
+    RID rid = insert_record(trx, record_num + i);
+    ASSERT_LE(rid.page_num, max_page_num);
+  }
+  end_trx(trx, true /*commit*/);
+  ASSERT_EQ(record_num, vacuum());
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  filesystem::path log_filename = filesystem::path(argv[0]).filename();
+  LoggerFactory::init_default(log_filename.string() + ".log", LOG_LEVEL_INFO);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,193 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <filesystem>
+
+#include "common/lang/atomic.h"
+#include "common/lang/thread.h"
+#include "common/log/log.h"
+#include "sql/parser/parse_defs.h"
+#include "storage/db/db.h"
+#include "storage/index/hash_index.h"
+#include "storage/index/index_build_log.h"
+#include "storage/table/table.h"
+#include "storage/trx/vacuous_trx.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace common;
+
+class OnlineIndexTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    filesystem::remove_all(test_path_);
+    filesystem::create_directories(test_path_);
+    db_ = make_unique<Db>();
+    ASSERT_EQ(RC::SUCCESS, db_->init("db", test_path_.c_str(), "vacuous", "disk"));
+
+    AttrInfoSqlNode attrs[] = {{AttrType::INTS, "id", 4}, {AttrType::INTS, "value", 4}};
+    ASSERT_EQ(RC::SUCCESS, db_->create_table("t", attrs, {}));
+    table_ = db_->find_table("t");
+    ASSERT_NE(nullptr, table_);
+  }
+
+  void TearDown() override
+  {
+    db_.reset();
+    filesystem::remove_all(test_path_);
+  }
+
+  RC create_index(const char *name, IndexType type)
+  {
+    vector<const FieldMeta *> fields{table_->table_meta().field("id")};
+    IndexMeta                 index_meta;
+    VacuousTrx                trx;
+    RC                        rc = index_meta.init(name, fields, type, {});
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+    return table_->create_index(&trx, fields, index_meta);
+  }
+
+  Record make_record(int id)
+  {
+    Record record;
+    EXPECT_EQ(RC::SUCCESS, record.new_record(table_->table_meta().record_size()));
+    const int value = id * 10;
+    memcpy(record.data() + table_->table_meta().field("id")->offset(), &id, sizeof(id));
+    memcpy(record.data() + table_->table_meta().field("value")->offset(), &value, sizeof(value));
+    return record;
+  }
+
+  RID insert_record(int id)
+  {
+    Record record = make_record(id);
+    EXPECT_EQ(RC::SUCCESS, table_->insert_record(record));
+    return record.rid();
+  }
+
+  void delete_record(const RID &rid)
+  {
+    Record record;
+    ASSERT_EQ(RC::SUCCESS, table_->get_record(rid, record));
+    ASSERT_EQ(RC::SUCCESS, table_->delete_record(record));
+  }
+
+  vector<RID> lookup(Index *index, int id)
+  {
+    vector<RID>   rids;
+    const char   *key     = reinterpret_cast<const char *>(&id);
+    IndexScanner *scanner = index->create_scanner(key, sizeof(id), true, key, sizeof(id), true);
+    EXPECT_NE(nullptr, scanner);
+    if (scanner == nullptr) {
+      return rids;
+    }
+
+    RID rid;
+    while (OB_SUCC(scanner->next_entry(&rid))) {
+      rids.push_back(rid);
+    }
+    scanner->destroy();
+    return rids;
+  }
+
+protected:
+  filesystem::path test_path_ = "online_index_test_dir";
+  unique_ptr<Db>   db_;
+  Table           *table_ = nullptr;
+};
+
+TEST_F(OnlineIndexTest, apply_build_log)
+{
+  RID rid1 = insert_record(1);
+  RID rid2 = insert_record(2);
+  ASSERT_EQ(RC::SUCCESS, create_index("id_hash", IndexType::HASH));
+  Index *index = table_->find_index("id_hash");
+  ASSERT_NE(nullptr, index);
+
+  // 模拟扫描时已经看到的修改和没有看到的修改，重复应用的结果也是正确的
+  IndexBuildLog build_log(*index);
+  const int     record_size = table_->table_meta().record_size();
+  Record        record1     = make_record(1);
+  Record        record2     = make_record(2);
+  Record        record3     = make_record(3);
+  Record        record4     = make_record(4);
+  RID           rid3(100, 0);
+  RID           rid4(100, 1);
+  build_log.append(IndexBuildLog::OpType::INSERT, record1.data(), record_size, rid1);  // 扫描已经看到了
+  build_log.append(IndexBuildLog::OpType::DELETE, record2.data(), record_size, rid2);  // 扫描已经看到了
+  build_log.append(IndexBuildLog::OpType::INSERT, record3.data(), record_size, rid3);  // 扫描没有看到
+  build_log.append(IndexBuildLog::OpType::DELETE, record4.data(), record_size, rid4);  // 扫描没有看到插入
+  // RID 被复用
+  build_log.append(IndexBuildLog::OpType::DELETE, record3.data(), record_size, rid3);
+  build_log.append(IndexBuildLog::OpType::INSERT, record4.data(), record_size, rid3);
+  ASSERT_EQ(6, static_cast<int>(build_log.size()));
+
+  ASSERT_EQ(RC::SUCCESS, build_log.apply());
+  ASSERT_EQ(0, static_cast<int>(build_log.size()));
+
+  ASSERT_EQ(vector<RID>{rid1}, lookup(index, 1));
+  ASSERT_TRUE(lookup(index, 2).empty());
+  ASSERT_TRUE(lookup(index, 3).empty());
+  ASSERT_EQ(vector<RID>{rid3}, lookup(index, 4));
+}
+
+#ifdef CONCURRENCY
+TEST_F(OnlineIndexTest, concurrent_writes)
+{
+  const int   init_num = 20000;
+  vector<RID> rids;
+  for (int i = 0; i < init_num; i++) {
+    rids.push_back(insert_record(i));
+  }
+
+  // 创建索引的同时插入新数据，并删除一部分旧数据
+  atomic<bool> stop(false);
+  atomic<int>  insert_num(0);
+  thread       writer([&]() {
+    for (int i = 0; i < init_num && !stop.load(); i++) {
+      if (i % 3 == 0) {
+        delete_record(rids[i]);
+      }
+      insert_record(init_num + i);
+      insert_num.store(i + 1);
+    }
+  });
+
+  ASSERT_EQ(RC::SUCCESS, create_index("id_bplus", IndexType::BPLUS_TREE));
+  ASSERT_EQ(RC::SUCCESS, create_index("id_hash", IndexType::HASH));
+  stop.store(true);
+  writer.join();
+  ASSERT_GT(insert_num.load(), 0);
+
+  for (const char *index_name : {"id_bplus", "id_hash"}) {
+    Index *index = table_->find_index(index_name);
+    ASSERT_NE(nullptr, index);
+    for (int i = 0; i < init_num + insert_num.load(); i++) {
+      vector<RID> result = lookup(index, i);
+      if (i < insert_num.load() && i % 3 == 0) {
+        ASSERT_TRUE(result.empty()) << "index=" << index_name << ", key=" << i;
+      } else {
+        ASSERT_EQ(1, static_cast<int>(result.size())) << "index=" << index_name << ", key=" << i;
+      }
+    }
+  }
+}
+#endif  // CONCURRENCY
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  filesystem::path log_filename = filesystem::path(argv[0]).filename();
+  LoggerFactory::init_default(log_filename.string() + ".log", LOG_LEVEL_INFO);
+  return RUN_ALL_TESTS();
+}
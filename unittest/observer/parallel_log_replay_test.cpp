@@ -0,0 +1,210 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <string.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#include "storage/buffer/disk_buffer_pool.h"
+#include "storage/buffer/double_write_buffer.h"
+#include "storage/record/record_manager.h"
+#include "storage/clog/disk_log_handler.h"
+#include "storage/clog/integrated_log_replayer.h"
+#include "common/math/integer_generator.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace common;
+
+static const int record_size = 100;
+
+using RecordMap = unordered_map<RID, string, RIDHash>;
+
+static string read_file(const filesystem::path &path)
+{
+  ifstream ifs(path, ios::binary);
+  return string(istreambuf_iterator<char>(ifs), istreambuf_iterator<char>());
+}
+
+/**
+ * @brief 使用指定的回放线程数，从日志中恢复数据文件，并校验记录
+ */
+static void replay_and_check(const filesystem::path &log_directory, const vector<filesystem::path> &files,
+    const vector<RecordMap> &record_maps, int replay_thread_num)
+{
+  DiskLogHandler    log_handler;
+  BufferPoolManager bpm;
+  ASSERT_EQ(bpm.init(make_unique<VacuousDoubleWriteBuffer>()), RC::SUCCESS);
+
+  vector<DiskBufferPool *> buffer_pools;
+  for (const filesystem::path &file : files) {
+    DiskBufferPool *buffer_pool = nullptr;
+    ASSERT_EQ(bpm.open_file(log_handler, file.c_str(), buffer_pool), RC::SUCCESS);
+    buffer_pools.push_back(buffer_pool);
+  }
+
+  IntegratedLogReplayer log_replayer(bpm, replay_thread_num);
+  ASSERT_EQ(log_handler.init(log_directory.c_str()), RC::SUCCESS);
+  ASSERT_EQ(log_handler.replay(log_replayer, 0), RC::SUCCESS);
+  ASSERT_EQ(log_replayer.on_done(), RC::SUCCESS);
+  ASSERT_EQ(log_handler.start(), RC::SUCCESS);
+
+  for (size_t i = 0; i < files.size(); i++) {
+    RecordFileHandler record_file_handler(StorageFormat::ROW_FORMAT);
+    ASSERT_EQ(record_file_handler.init(*buffer_pools[i], log_handler, nullptr), RC::SUCCESS);
+    for (const auto &[rid, record] : record_maps[i]) {
+      Record record_data;
+      ASSERT_EQ(record_file_handler.get_record(rid, record_data), RC::SUCCESS);
+      ASSERT_EQ(memcmp(record_data.data(), record.c_str(), record.size()), 0);
+    }
+    record_file_handler.close();
+  }
+
+  ASSERT_EQ(log_handler.stop(), RC::SUCCESS);
+  ASSERT_EQ(log_handler.await_termination(), RC::SUCCESS);
+
+  // 关闭文件时会把所有脏页写到磁盘
+  for (const filesystem::path &file : files) {
+    ASSERT_EQ(bpm.close_file(file.c_str()), RC::SUCCESS);
+  }
+}
+
+TEST(ParallelLogReplay, same_as_serial_replay)
+{
+  /*
+   * 测试场景：
+   * 1. 创建两个数据文件，随机进行插入、更新、删除操作，操作记录在日志中
+   * 2. 在脏页写回磁盘之前，把数据文件复制两份
+   * 3. 分别使用串行回放和并行回放在副本上恢复数据，恢复出的文件应该完全相同
+   */
+  filesystem::path directory("parallel_log_replay");
+  filesystem::remove_all(directory);
+  filesystem::path log_directory      = directory / "clog";
+  filesystem::path serial_directory   = directory / "serial";
+  filesystem::path parallel_directory = directory / "parallel";
+  ASSERT_TRUE(filesystem::create_directories(log_directory));
+  ASSERT_TRUE(filesystem::create_directories(serial_directory));
+  ASSERT_TRUE(filesystem::create_directories(parallel_directory));
+
+  const vector<string> file_names = {"table1.bp", "table2.bp"};
+
+  DiskLogHandler    log_handler;
+  BufferPoolManager bpm;
+  ASSERT_EQ(bpm.init(make_unique<VacuousDoubleWriteBuffer>()), RC::SUCCESS);
+
+  IntegratedLogReplayer log_replayer(bpm);
+  ASSERT_EQ(log_handler.init(log_directory.c_str()), RC::SUCCESS);
+  ASSERT_EQ(log_handler.replay(log_replayer, 0), RC::SUCCESS);
+  ASSERT_EQ(log_handler.start(), RC::SUCCESS);
+
+  vector<unique_ptr<RecordFileHandler>> record_file_handlers;
+  for (const string &file_name : file_names) {
+    filesystem::path file = directory / file_name;
+    ASSERT_EQ(bpm.create_file(file.c_str()), RC::SUCCESS);
+
+    DiskBufferPool *buffer_pool = nullptr;
+    ASSERT_EQ(bpm.open_file(log_handler, file.c_str(), buffer_pool), RC::SUCCESS);
+
+    auto record_file_handler = make_unique<RecordFileHandler>(StorageFormat::ROW_FORMAT);
+    ASSERT_EQ(record_file_handler->init(*buffer_pool, log_handler, nullptr), RC::SUCCESS);
+    record_file_handlers.push_back(std::move(record_file_handler));
+  }
+
+  const char        record_data[record_size] = "hello, world!";
+  vector<RecordMap> record_maps(file_names.size());
+  IntegerGenerator  file_random(0, static_cast<int>(file_names.size()) - 1);
+  IntegerGenerator  operation_random(0, 3);
+  IntegerGenerator  record_suffix_random(0, 1000000000);
+
+  const int operation_num = 5000;
+  for (int i = 0; i < operation_num; i++) {
+    const int          file_index          = file_random.next();
+    RecordFileHandler &record_file_handler = *record_file_handlers[file_index];
+    RecordMap         &record_map          = record_maps[file_index];
+
+    int operation_type = operation_random.next();
+    if (record_map.empty()) {
+      operation_type = 0;
+    }
+
+    switch (operation_type) {
+      case 0:
+      case 1: {  // insert
+        RID rid;
+        ASSERT_EQ(record_file_handler.insert_record(record_data, record_size, &rid), RC::SUCCESS);
+        record_map.emplace(rid, string(record_data, record_size));
+      } break;
+
+      case 2: {  // update
+        string new_record = string(record_data) + to_string(record_suffix_random.next());
+
+        IntegerGenerator record_random(0, record_map.size() - 1);
+        auto             iter = record_map.begin();
+        advance(iter, record_random.next());
+        ASSERT_EQ(record_file_handler.visit_record(iter->first,
+                      [&new_record](Record &record) {
+                        memcpy(record.data(), new_record.c_str(), new_record.size());
+                        return true;
+                      }),
+            RC::SUCCESS);
+        iter->second = new_record;
+      } break;
+
+      case 3: {  // delete
+        IntegerGenerator record_random(0, record_map.size() - 1);
+        auto             iter = record_map.begin();
+        advance(iter, record_random.next());
+        RID rid = iter->first;
+        ASSERT_EQ(record_file_handler.delete_record(&rid), RC::SUCCESS);
+        record_map.erase(iter);
+      } break;
+    }
+  }
+
+  for (auto &record_file_handler : record_file_handlers) {
+    record_file_handler->close();
+  }
+  for (const string &file_name : file_names) {
+    filesystem::copy_file(directory / file_name, serial_directory / file_name);
+    filesystem::copy_file(directory / file_name, parallel_directory / file_name);
+  }
+  ASSERT_EQ(log_handler.stop(), RC::SUCCESS);
+  ASSERT_EQ(log_handler.await_termination(), RC::SUCCESS);
+  for (const string &file_name : file_names) {
+    bpm.close_file((directory / file_name).c_str());
+  }
+
+  vector<filesystem::path> serial_files;
+  vector<filesystem::path> parallel_files;
+  for (const string &file_name : file_names) {
+    serial_files.push_back(serial_directory / file_name);
+    parallel_files.push_back(parallel_directory / file_name);
+  }
+
+  replay_and_check(log_directory, serial_files, record_maps, 0 /*replay_thread_num*/);
+  replay_and_check(log_directory, parallel_files, record_maps, 4 /*replay_thread_num*/);
+
+  for (size_t i = 0; i < file_names.size(); i++) {
+    string serial_data   = read_file(serial_files[i]);
+    string parallel_data = read_file(parallel_files[i]);
+    ASSERT_FALSE(serial_data.empty());
+    ASSERT_EQ(serial_data.size(), parallel_data.size());
+    ASSERT_TRUE(serial_data == parallel_data) << "file " << file_names[i] << " differs";
+  }
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  filesystem::path log_filename = filesystem::path(argv[0]).filename();
+  LoggerFactory::init_default(log_filename.string() + ".log", LOG_LEVEL_INFO);
+  return RUN_ALL_TESTS();
+}
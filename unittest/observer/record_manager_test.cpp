@@ -16,6 +16,7 @@ See the Mulan PSL v2 for more details. */
 #include <sstream>
 #include <filesystem>
 #include <utility>
+#include <algorithm>
 
 #include "storage/buffer/disk_buffer_pool.h"
 #include "storage/record/record_manager.h"
@@ -212,6 +213,76 @@ TEST(RecordScanner, test_record_file_iterator)
   delete bpm;
 }
 
+TEST(RecordFileHandler, visit_records)
+{
+  VacuousLogHandler log_handler;
+
+  const char *record_manager_file = "record_manager_visit.bp";
+  filesystem::remove(record_manager_file);
+
+  BufferPoolManager bpm;
+  ASSERT_EQ(RC::SUCCESS, bpm.init(make_unique<VacuousDoubleWriteBuffer>()));
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(record_manager_file));
+  DiskBufferPool *bp = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, record_manager_file, bp));
+
+  RecordFileHandler file_handler(StorageFormat::ROW_FORMAT);
+  ASSERT_EQ(RC::SUCCESS, file_handler.init(*bp, log_handler, nullptr));
+
+  // 记录的内容就是插入的序号，插入足够多的记录占用多个页面
+  const int   record_num = 2000;
+  vector<RID> rids;
+  for (int i = 0; i < record_num; i++) {
+    char record_data[20] = {0};
+    memcpy(record_data, &i, sizeof(i));
+    RID rid;
+    ASSERT_EQ(RC::SUCCESS, file_handler.insert_record(record_data, sizeof(record_data), &rid));
+    rids.push_back(rid);
+  }
+  ASSERT_NE(rids.front().page_num, rids.back().page_num);
+
+  // 模拟索引扫描：乱序的RID按照页面排序后批量访问
+  vector<RID> sorted_rids;
+  for (int i = 0; i < record_num; i += 3) {
+    sorted_rids.push_back(rids[(i * 7) % record_num]);
+  }
+  sort(sorted_rids.begin(), sorted_rids.end(), [](const RID &left, const RID &right) {
+    return RID::compare(&left, &right) < 0;
+  });
+
+  vector<RID> visited;
+  RC rc = file_handler.visit_records(
+      sorted_rids.data(), static_cast<int>(sorted_rids.size()), ReadWriteMode::READ_ONLY, [&](Record &record) {
+        const int value = *reinterpret_cast<const int *>(record.data());
+        EXPECT_EQ(rids[value], record.rid());
+        visited.push_back(record.rid());
+        return RC::SUCCESS;
+      });
+  ASSERT_EQ(RC::SUCCESS, rc);
+  ASSERT_EQ(sorted_rids, visited);
+
+  // visitor 返回错误时停止访问
+  int count = 0;
+  rc        = file_handler.visit_records(
+      sorted_rids.data(), static_cast<int>(sorted_rids.size()), ReadWriteMode::READ_ONLY, [&](Record &) {
+        return ++count == 10 ? RC::INTERNAL : RC::SUCCESS;
+      });
+  ASSERT_EQ(RC::INTERNAL, rc);
+  ASSERT_EQ(10, count);
+
+  // 已经删除的记录
+  ASSERT_EQ(RC::SUCCESS, file_handler.delete_record(&sorted_rids[1]));
+  rc = file_handler.visit_records(
+      sorted_rids.data(), static_cast<int>(sorted_rids.size()), ReadWriteMode::READ_ONLY, [](Record &) {
+        return RC::SUCCESS;
+      });
+  ASSERT_EQ(RC::RECORD_NOT_EXIST, rc);
+
+  file_handler.close();
+  bpm.close_file(record_manager_file);
+  filesystem::remove(record_manager_file);
+}
+
 TEST(RecordManager, durability)
 {
   /*